@@ -122,8 +122,9 @@ int  Helper::findInterfaceByAddress(const InetAddr *addr,
 #endif
 
     Firewall *fw = compiler->fw;
-    list<FWObject*> l2 = fw->getByTypeDeep(Interface::TYPENAME);
-    for (list<FWObject*>::iterator i=l2.begin(); i!=l2.end(); ++i)
+    vector<FWObject*> l2 =
+        fw->getByTypeDeepCached(Interface::typeId());
+    for (vector<FWObject*>::const_iterator i=l2.begin(); i!=l2.end(); ++i)
     {
 	Interface *iface = Interface::cast(*i);
         if (iface->isDedicatedFailover()) continue;
@@ -226,8 +227,9 @@ int  Helper::findInterfaceByNetzone(const InetAddr *addr, const InetAddr *nm)
 
     Firewall *fw = compiler->fw;
     map<int,FWObject*> zones;
-    list<FWObject*> l2 = fw->getByTypeDeep(Interface::TYPENAME);
-    for (list<FWObject*>::iterator i=l2.begin(); i!=l2.end(); ++i)
+    vector<FWObject*> l2 =
+        fw->getByTypeDeepCached(Interface::typeId());
+    for (vector<FWObject*>::const_iterator i=l2.begin(); i!=l2.end(); ++i)
     {
         Interface *iface = Interface::cast(*i);
         if (iface->isDedicatedFailover()) continue;
@@ -46,10 +46,13 @@
 #include "interfaceProperties.h"
 #include "interfacePropertiesObjectFactory.h"
 
+#include "fwbuilder/AddressTableLoader.h"
 #include "fwbuilder/Cluster.h"
 #include "fwbuilder/ClusterGroup.h"
+#include "fwbuilder/DatabaseCache.h"
 #include "fwbuilder/FWException.h"
 #include "fwbuilder/FWObject.h"
+#include "fwbuilder/FWObjectArena.h"
 #include "fwbuilder/FWObjectDatabase.h"
 #include "fwbuilder/FailoverClusterGroup.h"
 #include "fwbuilder/Firewall.h"
@@ -57,6 +60,7 @@
 #include "fwbuilder/IPv6.h"
 #include "fwbuilder/Interface.h"
 #include "fwbuilder/Library.h"
+#include "fwbuilder/MemoryStats.h"
 #include "fwbuilder/NAT.h"
 #include "fwbuilder/Policy.h"
 #include "fwbuilder/Resources.h"
@@ -88,6 +92,7 @@ CompilerDriver::CompilerDriver(FWObjectDatabase *db) : BaseCompiler()
     drp = -1;
     drn = -1;
     drr = -1;
+    alloc_profiling_on = false;
     verbose = 0;
     have_dynamic_interfaces = false;
     ipv4_run = true;
@@ -138,6 +143,20 @@ CompilerDriver::~CompilerDriver()
         }
     }
 
+    if (alloc_profiling_on)
+    {
+        FWObjectArena::stopProfiling();
+        AllocationProfile profile;
+        FWObjectArena::getProfile(profile);
+        cerr << "Object allocations while compiling" << endl;
+        profile.print(cerr);
+        cerr << endl;
+
+        MemoryStats stats;
+        objdb->getMemoryStats(stats);
+        stats.print(cerr);
+    }
+
     delete objdb;
 }
 
@@ -149,6 +168,34 @@ CompilerDriver* CompilerDriver::clone()
     return new_cd;
 }
 
+void CompilerDriver::prepareLoad(FWObjectDatabase *db,
+                                 const QStringList &args)
+{
+    QString load_target;
+    for (int idx=0; idx < args.size(); idx++)
+    {
+        if (idx + 1 >= args.size()) break;
+        if (args.at(idx) == "-C")
+        {
+            // the same directory keeps cached address tables, see
+            // configure()
+            DatabaseCache::setCacheDirectory(
+                args.at(++idx).toUtf8().constData());
+        }
+        if (args.at(idx) == "-s")
+        {
+            // in single rule mode the rule tells which firewall or
+            // cluster has to be loaded
+            load_target = args.at(++idx);
+        }
+    }
+
+    // firewall or cluster to compile is the last argument
+    if (load_target.isEmpty() && !args.isEmpty()) load_target = args.last();
+
+    db->setPartialLoadTarget(load_target.toUtf8().constData());
+}
+
 bool CompilerDriver::configure(const QStringList &args)
 {
     QString last_arg;
@@ -193,6 +240,16 @@ bool CompilerDriver::configure(const QStringList &args)
             FWObject::setDataDir(args.at(idx).toUtf8().constData());
             continue;
         }
+        if (arg == "-C")
+        {
+            // directory for the cache of parsed address table files;
+            // prepareLoad() passes it to DatabaseCache before the
+            // data file is loaded
+            idx++;
+            AddressTableLoader::setCacheDirectory(
+                args.at(idx).toUtf8().constData());
+            continue;
+        }
         if (arg == "-f")
         {
             idx++;
@@ -275,6 +332,20 @@ bool CompilerDriver::configure(const QStringList &args)
             continue;
         }
 
+        if (arg == "-xm")
+        {
+            // profile object allocations made by the compiler, sample
+            // size of every N-th one; report is printed to stderr
+            // when the driver is destroyed
+            idx++;
+            bool ok = false;
+            int sample_interval = args.at(idx).toInt(&ok);
+            if (!ok) return false;
+            alloc_profiling_on = true;
+            FWObjectArena::startProfiling(sample_interval);
+            continue;
+        }
+
         if (arg == "-s")
         {
             idx++;
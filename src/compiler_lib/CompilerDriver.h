@@ -117,6 +117,7 @@ protected:
         int drn;
         int drr;
         bool rule_debug_on;
+        bool alloc_profiling_on;
         bool single_rule_compile_on;
         bool prepend_cluster_name_to_output_file;
         std::string single_rule_id;
@@ -195,6 +196,17 @@ public:
          */
         virtual bool configure(const QStringList &args);
 
+        /**
+         * Applies command line arguments that affect loading of the
+         * data file before load() is called. -C sets the directory
+         * of the binary cache of data files (see DatabaseCache). Only
+         * objects used by the firewall or cluster being compiled are
+         * loaded into db; it is the last argument or the rule given
+         * with -s in single rule compile mode.
+         */
+        static void prepareLoad(libfwbuilder::FWObjectDatabase *db,
+                                const QStringList &args);
+
         /**
          * Assign target object by its id
          */
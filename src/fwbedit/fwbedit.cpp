@@ -214,6 +214,7 @@ void usage()
     cout << "      merge       merge one data file into another" << endl;
     cout << "      import      import firewall configuration (iptables, CIsco IOS," << endl;
     cout << "                  Cisco PIX, ASA and FWSM)" << endl;
+    cout << "      stats       print memory footprint of the object tree" << endl;
     cout << endl;
     cout << "Type   'fwbedit command' to get summary of options for the command"
          << endl;
@@ -306,9 +307,14 @@ void usage_remove()
 void usage_upgrade()
 {
     cout <<
-        "   upgrade -f file.fwb\n"
+        "   upgrade -f file.fwb [-j N] [file2.fwb ...]\n"
         "\n"
-        "          -f file.fwb: data file\n";
+        "          -f file.fwb: data file\n"
+        "          file2.fwb ...: more data files. If more than one file\n"
+        "             is given, files are upgraded without confirmation\n"
+        "             by several worker processes\n"
+        "          -j N: number of worker processes, default is the\n"
+        "             number of CPUs\n";
     cout << endl;
 }
 
@@ -397,6 +403,20 @@ void findObjects(const string &obj_path, FWObject *obj, list<FWObject*> &res)
     }
 
     string path = fixPath(obj_path);
+
+    if (obj->getRoot() == obj)
+    {
+        // fall back to the scan if the path is ambiguous to keep
+        // objects in the tree order
+        list<FWObject*> found;
+        obj->getRoot()->findObjectsByPath(path, found);
+        if (found.size() < 2)
+        {
+            res.splice(res.end(), found);
+            return;
+        }
+    }
+
     _findObjects(path, obj, res);
 }
 
@@ -437,6 +457,18 @@ bool getBool(string s)
 }
 
 
+void usage_stats()
+{
+    cout <<
+        "   stats -f file.fwb [-s N] [-a]\n"
+        "\n"
+        "          -f file.fwb: data file\n"
+        "          -s N: record size of every N-th object allocation\n"
+        "             made while the file is loaded\n"
+        "          -a: allocate objects from an arena, as compilers do\n";
+    cout << endl;
+}
+
 
 int main(int argc, char * const *argv)
 {   
@@ -454,6 +486,10 @@ int main(int argc, char * const *argv)
     bool full_dump = false;
     string import_config;
     bool deduplicate = false;
+    vector<string> upgrade_files;
+    int upgrade_jobs = 0;
+    int sample_interval = 0;
+    bool use_arena = false;
 
     if (argc<=1)
     {
@@ -480,6 +516,7 @@ int main(int argc, char * const *argv)
     if (cmd_str=="checktree") cmd = STRUCT;
     if (cmd_str=="merge") cmd = MERGE;
     if (cmd_str=="import") cmd = IMPORT;
+    if (cmd_str=="stats") cmd = STATS;
 
     char * const *args = argv;
     args++;
@@ -622,21 +659,24 @@ int main(int argc, char * const *argv)
         break;
 
     case UPGRADE:
-        // -f file.fwb
+        // -f file.fwb [-j N] [file2.fwb ...]
         autoupgrade_flag = true;
-        while( (opt=getopt(argc, args, "f:")) != EOF )
+        while( (opt=getopt(argc, args, "f:j:")) != EOF )
         {
             switch(opt)
             {
-            case 'f': filename = optarg; break;
+            case 'f': upgrade_files.push_back(optarg); break;
+            case 'j': upgrade_jobs = atoi(optarg); break;
             }
         }
+        for (int i=optind; i<argc; ++i) upgrade_files.push_back(args[i]);
 
-        if (filename.empty())
+        if (upgrade_files.empty())
         {
             usage_upgrade();
             exit(1);
         }
+        filename = upgrade_files.front();
 
         break;
 
@@ -699,6 +739,26 @@ int main(int argc, char * const *argv)
 
         break;
 
+    case STATS:
+        // -f file.fwb [-s N] [-a]
+        while( (opt=getopt(argc, args, "f:s:a")) != EOF )
+        {
+            switch(opt)
+            {
+            case 'f': filename = optarg; break;
+            case 's': sample_interval = atoi(optarg); break;
+            case 'a': use_arena = true; break;
+            }
+        }
+
+        if (filename.empty())
+        {
+            usage_stats();
+            exit(1);
+        }
+
+        break;
+
     case NONE:
         break;
     }
@@ -715,6 +775,12 @@ int main(int argc, char * const *argv)
     {
         new Resources(Constants::getResourcesFilePath());
 
+        if (cmd == UPGRADE && upgrade_files.size() > 1)
+            return upgradeFiles(upgrade_files, upgrade_jobs);
+
+        if (cmd == STATS)
+            return printStats(filename, sample_interval, use_arena);
+
         /* create database */
         objdb = new FWObjectDatabase();
 
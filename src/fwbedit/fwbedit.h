@@ -37,7 +37,7 @@
 
 // can't use 'DELETE' in this enum because it is degined somewhere on windows
 typedef enum { NONE, ADDGRP, REMGRP, DELOBJECT, NEWOBJECT, MODOBJECT,
-               LIST, STRUCT, UPGRADE, MERGE, IMPORT} command;
+               LIST, STRUCT, UPGRADE, MERGE, IMPORT, STATS} command;
 
 class OperandsError : public std::exception {};
 
@@ -69,6 +69,11 @@ extern void modObject(libfwbuilder::FWObjectDatabase *objdb,
 
 extern void checkAndRepairTree(libfwbuilder::FWObjectDatabase *objdb);
 
+extern int upgradeFiles(const std::vector<std::string> &files, int jobs);
+
+extern int printStats(const std::string &file_name, int sample_interval,
+                      bool use_arena);
+
 extern void mergeTree(libfwbuilder::FWObjectDatabase *objdb,
                       const std::string &mergefile, int conflict_res);
 
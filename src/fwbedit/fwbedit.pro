@@ -8,7 +8,7 @@ TEMPLATE = app
 QT += network
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets printsupport
 
-SOURCES	 = fwbedit.cpp new_object.cpp repair_tree.cpp list_object.cpp merge.cpp import.cpp
+SOURCES	 = fwbedit.cpp new_object.cpp repair_tree.cpp list_object.cpp merge.cpp import.cpp upgrade.cpp stats.cpp
 HEADERS	 = ../../config.h fwbedit.h upgradePredicate.h
 
 INCLUDEPATH += ../libfwbuilder/src ../import ../compiler_lib ../libgui
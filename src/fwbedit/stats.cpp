@@ -0,0 +1,74 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  $Id$
+
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#include "../../config.h"
+#include "fwbuilder/libfwbuilder-config.h"
+#include "fwbuilder/Constants.h"
+#include "fwbuilder/FWObjectArena.h"
+#include "fwbuilder/MemoryStats.h"
+
+#include "fwbedit.h"
+#include "upgradePredicate.h"
+
+#include <iostream>
+
+using namespace libfwbuilder;
+using namespace std;
+
+
+/*
+ * Loads the data file and prints where memory goes. Allocations of
+ * objects made while the file is loaded are counted, and sampled if
+ * sample_interval is greater than zero. The file is never upgraded
+ * or saved.
+ */
+int printStats(const string &file_name, int sample_interval, bool use_arena)
+{
+    FWObjectDatabase *db = new FWObjectDatabase();
+    if (use_arena) db->setUseArena(true);
+
+    UpgradePredicate upgrade_predicate(false);
+
+    FWObjectArena::startProfiling(sample_interval);
+    db->load(file_name, &upgrade_predicate, Constants::getDTDDirectory());
+    FWObjectArena::stopProfiling();
+
+    AllocationProfile profile;
+    FWObjectArena::getProfile(profile);
+
+    MemoryStats stats;
+    db->getMemoryStats(stats);
+
+    cout << "Data file: " << file_name << endl;
+    cout << endl;
+    cout << "Object allocations while loading" << endl;
+    profile.print(cout);
+    cout << endl;
+    stats.print(cout);
+
+    delete db;
+    return 0;
+}
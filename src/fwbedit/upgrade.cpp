@@ -0,0 +1,152 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  $Id$
+
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#include "../../config.h"
+#include "fwbuilder/libfwbuilder-config.h"
+#include "fwbuilder/Constants.h"
+#include "fwbuilder/XMLTools.h"
+
+#include "fwbedit.h"
+
+#include <iostream>
+
+#ifndef _WIN32
+#  include <unistd.h>
+#  include <sys/types.h>
+#  include <sys/wait.h>
+#endif
+
+using namespace libfwbuilder;
+using namespace std;
+
+
+/*
+ * Upgrades one data file. The file is converted while it is loaded,
+ * the original is kept with extension .bak, then the object tree is
+ * saved back just like "fwbedit upgrade -f file.fwb" does. There is
+ * nobody to ask for confirmation in batch mode, base class of the
+ * upgrade predicate always agrees.
+ */
+static bool upgradeFile(const string &file_name)
+{
+    FWObjectDatabase *db = new FWObjectDatabase();
+    XMLTools::UpgradePredicate upgrade_predicate;
+    bool res = true;
+    try
+    {
+        db->load(file_name, &upgrade_predicate, Constants::getDTDDirectory());
+        db->saveFile(file_name);
+        cout << file_name << ": upgraded" << endl;
+    } catch (FWException &ex)
+    {
+        cerr << file_name << ": " << ex.toString() << endl;
+        res = false;
+    }
+    delete db;
+    return res;
+}
+
+/*
+ * Upgrades every files[i] with i = first, first+step, ... Stylesheets
+ * compiled for the first file are reused for the rest.
+ * Returns the number of files that could not be upgraded.
+ */
+static int upgradeStripe(const vector<string> &files, int first, int step)
+{
+    int failed = 0;
+    for (size_t i=first; i<files.size(); i+=step)
+        if (!upgradeFile(files[i])) failed++;
+    return failed;
+}
+
+int upgradeFiles(const vector<string> &files, int jobs)
+{
+    if (jobs < 1)
+    {
+#ifndef _WIN32
+        jobs = int(sysconf(_SC_NPROCESSORS_ONLN));
+#endif
+        if (jobs < 1) jobs = 1;
+    }
+    if (jobs > int(files.size())) jobs = int(files.size());
+
+    int failed = 0;
+
+#ifndef _WIN32
+    if (jobs > 1)
+    {
+        // each worker process takes its share of the files
+        cout << flush;
+        cerr << flush;
+        vector<pid_t> workers(jobs, -1);
+        for (int w=0; w<jobs; ++w)
+        {
+            pid_t pid = fork();
+            if (pid == 0)
+            {
+                int res = upgradeStripe(files, w, jobs);
+                cout << flush;
+                cerr << flush;
+                _exit((res > 255) ? 255 : res);
+            }
+            if (pid < 0)
+            {
+                // could not start worker, do its share here
+                failed += upgradeStripe(files, w, jobs);
+                continue;
+            }
+            workers[w] = pid;
+        }
+
+        for (int w=0; w<jobs; ++w)
+        {
+            if (workers[w] < 0) continue;
+            int status = 0;
+            if (waitpid(workers[w], &status, 0) == workers[w] &&
+                WIFEXITED(status))
+            {
+                failed += WEXITSTATUS(status);
+                continue;
+            }
+            // worker died, its files are in unknown state
+            int share = 0;
+            for (size_t i=w; i<files.size(); i+=jobs) share++;
+            cerr << "Worker process terminated abnormally, "
+                 << share << " files may not have been upgraded" << endl;
+            failed += share;
+        }
+    } else
+        failed = upgradeStripe(files, 0, 1);
+#else
+    failed = upgradeStripe(files, 0, 1);
+#endif
+
+    cout << "Upgraded " << (int(files.size()) - failed)
+         << " of " << files.size() << " files; current data format version: "
+         << Constants::getDataFormatVersion() << endl;
+
+    return (failed == 0) ? 0 : 1;
+}
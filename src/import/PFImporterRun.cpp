@@ -27,6 +27,8 @@
 
 #include "PFImporter.h"
 
+#include "fwbuilder/InetAddrParser.h"
+
 #include <QString>
 #include <QStringList>
 #include <QRegExp>
@@ -159,16 +161,17 @@ void PFImporter::run()
                 qDebug() << "Item:" << item;
                 if (!item.isEmpty() && (item.contains(':') || item.contains('.')))
                 {
-                    try
+                    QByteArray ba = item.toLatin1();
+                    InetAddr addr;
+                    InetAddr netmask;
+                    if (InetAddrParser::parseAddressMask(
+                            AF_INET, ba.constData(), ba.size(),
+                            addr, netmask) == InetAddrParser::OK)
                     {
-                        InetAddr(item.toStdString());
                         // stop the loop if string successfully
                         // converts to an ip address
                         has_address = true;
                         break;
-                    } catch(FWException &ex)
-                    {
-                        ;
                     }
                 }
             }
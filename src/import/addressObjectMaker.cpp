@@ -29,6 +29,7 @@
 #include "fwbuilder/DNSName.h"
 #include "fwbuilder/FWObject.h"
 #include "fwbuilder/FWObjectDatabase.h"
+#include "fwbuilder/InetAddrParser.h"
 #include "fwbuilder/Network.h"
 #include "fwbuilder/IPv4.h"
 #include "fwbuilder/IPv6.h"
@@ -46,6 +47,22 @@ using namespace libfwbuilder;
 using namespace std;
 
 
+/*
+ * Converts string to ipv4 address without throwing exception. Strings
+ * we get here are often host names rather than addresses, and an
+ * exception per host name is expensive when importing large configs.
+ */
+static bool convertAddress(const QString &str, InetAddr &addr)
+{
+    // parser accepts "10" as 10.0.0.0, but here it is more likely
+    // to be a host name
+    if ( ! str.contains('.')) return false;
+    QByteArray ba = str.toLatin1();
+    return (InetAddrParser::parseAddress(
+                AF_INET, ba.constData(), ba.size(), addr) ==
+            InetAddrParser::OK);
+}
+
 AddressObjectMaker::~AddressObjectMaker() {}
 
 FWObject* AddressObjectMaker::createObject(ObjectSignature &sig)
@@ -92,38 +109,36 @@ FWObject* AddressObjectMaker::createAddress(ObjectSignature &sig)
     if ( netmask == InetAddr::getAllOnes() )
     {
         QString name;
-        try
+        InetAddr obj_addr;
+        if (convertAddress(sig.address, obj_addr))
         {
             signature.type_name = IPv4::TYPENAME;
 
             FWObject *obj = findMatchingObject(signature);
             if (obj) return obj;
 
-            InetAddr obj_addr(sig.address.toStdString()); // testing if string converts to an address
             name = QString("h-") + sig.address;
             Address *a = Address::cast(
                 ObjectMaker::createObject(IPv4::TYPENAME, name.toStdString()));
             a->setAddress(obj_addr);
             a->setNetmask(InetAddr(InetAddr::getAllOnes()));
             return a;
+        }
 
-        } catch(FWException &ex)
-        {
-            // address text line can not be converted to ipv4 address.
-            // Since parsers do not understand ipv6 yet, assume this
-            // is a host address and create DNSName object
+        // address text line can not be converted to ipv4 address.
+        // Since parsers do not understand ipv6 yet, assume this
+        // is a host address and create DNSName object
 
-            signature.type_name = DNSName::TYPENAME;
-            FWObject *obj = findMatchingObject(signature);
-            if (obj) return obj;
+        signature.type_name = DNSName::TYPENAME;
+        FWObject *obj = findMatchingObject(signature);
+        if (obj) return obj;
 
-            name = sig.address;
-            DNSName *da = DNSName::cast(
-                ObjectMaker::createObject(DNSName::TYPENAME, name.toStdString()));
-            da->setSourceName(sig.address.toStdString());
-            da->setRunTime(true);
-            return da;
-        }
+        name = sig.address;
+        DNSName *da = DNSName::cast(
+            ObjectMaker::createObject(DNSName::TYPENAME, name.toStdString()));
+        da->setSourceName(sig.address.toStdString());
+        da->setRunTime(true);
+        return da;
 
     } else
     {
@@ -136,14 +151,12 @@ FWObject* AddressObjectMaker::createAddress(ObjectSignature &sig)
             .arg(signature.address).arg(signature.netmask);
         Network *net = Network::cast(
             ObjectMaker::createObject(Network::TYPENAME, name.toStdString()));
-        try
-        {
-            net->setAddress( InetAddr(sig.address.toStdString()) );
-        } catch (FWException &ex)
-        {
+        InetAddr net_addr;
+        if (convertAddress(sig.address, net_addr))
+            net->setAddress(net_addr);
+        else
             error_tracker->registerError(
                 QString("Error converting address '%1'").arg(sig.address));
-        }
 
         // we have already verified netmask above
         net->setNetmask(netmask);
@@ -165,23 +178,19 @@ FWObject* AddressObjectMaker::createAddressRange(ObjectSignature &sig)
     AddressRange *ar = AddressRange::cast(
         ObjectMaker::createObject(AddressRange::TYPENAME, name.toStdString()));
 
-    try
-    {
-        ar->setRangeStart( InetAddr(addr1.toStdString()) );
-    } catch (FWException &ex)
-    {
+    InetAddr range_start;
+    if (convertAddress(addr1, range_start))
+        ar->setRangeStart(range_start);
+    else
         error_tracker->registerError(
             QString("Error converting address '%1'").arg(addr1));
-    }
 
-    try
-    {
-        ar->setRangeEnd( InetAddr(addr2.toStdString()) );
-    } catch (FWException &ex)
-    {
+    InetAddr range_end;
+    if (convertAddress(addr2, range_end))
+        ar->setRangeEnd(range_end);
+    else
         error_tracker->registerError(
             QString("Error converting address '%1'").arg(addr2));
-    }
 
     return ar;
 }
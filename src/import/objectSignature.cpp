@@ -39,6 +39,7 @@
 #include "fwbuilder/IPService.h"
 #include "fwbuilder/IPv4.h"
 #include "fwbuilder/IPv6.h"
+#include "fwbuilder/InetAddrParser.h"
 #include "fwbuilder/Library.h"
 #include "fwbuilder/Network.h"
 #include "fwbuilder/NetworkIPv6.h"
@@ -370,36 +371,35 @@ void ObjectSignature::setNetmask(const QString &netm, bool inverted_netmask)
 {
     InetAddr inetaddr_nm;
 
-    try
+    if (netm.contains('.'))
     {
-        inetaddr_nm = InetAddr(netm.toStdString());
-        if (inverted_netmask) inetaddr_nm = ~inetaddr_nm;
-
-    } catch (FWException &ex)
-    {
-        if (netm.contains('.'))
+        QByteArray ba = netm.toLatin1();
+        if (InetAddrParser::parseAddress(
+                AF_INET, ba.constData(), ba.size(), inetaddr_nm) ==
+            InetAddrParser::OK)
+        {
+            if (inverted_netmask) inetaddr_nm = ~inetaddr_nm;
+        } else
         {
             // netmask has '.' in it but conversion failed.
-//            throw ObjectMakerException(
             error_tracker->registerError(
                 QString("Error converting netmask '%1'").arg(netm));
+        }
+    } else
+    {
+        // no dot in netmask, perhaps it is specified by its length?
+        // Empty netmask has always been converted to 0.0.0.0
+        bool ok = netm.isEmpty();
+        int nm_len = (ok) ? 0 : netm.toInt(&ok);
+        if (ok && nm_len >= 0 && nm_len <= 32)
+        {
+            inetaddr_nm = InetAddr(nm_len);
+            if (inverted_netmask) inetaddr_nm = ~inetaddr_nm;
         } else
         {
-            // no dot in netmask, perhaps it is specified by its length?
-            // If netmask is specified by length, need to use special
-            // constructor for class Netmask to convert
-            bool ok = false;
-            int nm_len = netm.toInt(&ok);
-            if (ok)
-            {
-                inetaddr_nm = InetAddr(nm_len);
-            } else
-            {
-                // could not convert netmask as simple integer
-//                throw ObjectMakerException(
-                error_tracker->registerError(
-                    QString("Error converting netmask '%1'").arg(netm));
-            }
+            // could not convert netmask as simple integer
+            error_tracker->registerError(
+                QString("Error converting netmask '%1'").arg(netm));
         }
     }
 
@@ -139,6 +139,7 @@ int main(int argc, char **argv)
  
         /* create database */
         objdb = new FWObjectDatabase();
+        objdb->setUseArena(true);
 
         /* load the data file */
         UpgradePredicate upgrade_predicate; 
@@ -146,6 +147,8 @@ int main(int argc, char **argv)
         cout << " *** Loading data ...";
 
         objdb->setReadOnly( false );
+        // cache directory and objects used by the firewall being compiled
+        CompilerDriver::prepareLoad(objdb, args);
         objdb->load( filename, &upgrade_predicate, Constants::getDTDDirectory());
         objdb->setFileName(filename);
         objdb->reIndex();
@@ -143,6 +143,7 @@ int main(int argc, char **argv)
 
 	/* create database */
 	objdb = new FWObjectDatabase();
+	objdb->setUseArena(true);
 
 	/* load the data file */
 	UpgradePredicate upgrade_predicate; 
@@ -150,10 +151,13 @@ int main(int argc, char **argv)
 	cout << " *** Loading data ...";
 
         objdb->setReadOnly( false );
+        FWObjectDatabase *ndb = new FWObjectDatabase();
+        // cache directory and objects used by the firewall being
+        // compiled; the cache is used for the standard objects too
+        CompilerDriver::prepareLoad(ndb, args);
         objdb->load( Constants::getStandardObjectsFilePath(),
                      &upgrade_predicate, Constants::getDTDDirectory());
         objdb->setFileName("");
-        FWObjectDatabase *ndb = new FWObjectDatabase();
         ndb->load(filename, &upgrade_predicate,  Constants::getDTDDirectory());
         objdb->merge(ndb, NULL);
         delete ndb;
@@ -71,7 +71,7 @@ void usage(const char *name)
     cout << "Version " << VERSION << endl;
     cout << "Usage: " << name
          << " [-x level] [-v] [-V] [-q] [-f filename.xml] [-d destdir] "
-            "[-D datadir ] [-m] [-4|-6] firewall_object_name" << endl;
+            "[-D datadir ] [-C cachedir ] [-m] [-4|-6] firewall_object_name" << endl;
 }
 
 int main(int argc, char **argv)
@@ -133,6 +133,7 @@ int main(int argc, char **argv)
 
 	/* create database */
 	objdb = new FWObjectDatabase();
+	objdb->setUseArena(true);
 
 	/* load the data file */
 	UpgradePredicate upgrade_predicate; 
@@ -141,6 +142,8 @@ int main(int argc, char **argv)
         cerr << flush;
 
         objdb->setReadOnly( false );
+        // cache directory and objects used by the firewall being compiled
+        CompilerDriver::prepareLoad(objdb, args);
         objdb->load( filename, &upgrade_predicate, Constants::getDTDDirectory());
         objdb->setFileName(filename);
         objdb->reIndex();
@@ -28,6 +28,7 @@
 #include "Configlet.h"
 #include "CompilerDriver_ipt.h"
 #include "PolicyCompiler_ipt.h"
+#include "ipt_utils.h"
 #include "PolicyCompiler_secuwall.h"
 
 #include "fwbuilder/Address.h"
@@ -84,7 +85,7 @@ void CompilerDriver_ipt::assignRuleSetChain(RuleSet *ruleset)
         if (rule->isDisabled()) continue;
 
         if (!ruleset->isTop())
-            rule->setStr("ipt_chain", branch_name);
+            rule->setStr(iptChainKey(), branch_name);
 // ???
 //        rule->setUniqueId( FWObjectDatabase::getStringId(rule->getId()) );
     }
@@ -25,6 +25,7 @@
 
 #include "NATCompiler_ipt.h"
 #include "OSConfigurator_linux24.h"
+#include "ipt_utils.h"
 
 #include "fwbuilder/AddressRange.h"
 #include "fwbuilder/RuleElement.h"
@@ -226,7 +227,7 @@ string NATCompiler_ipt::PrintRule::_printChainDirectionAndInterface(NATRule *rul
     if (rule->getStr(".iface_in") == "nil") iface_in_name = "";
     if (rule->getStr(".iface_out") == "nil") iface_out_name = "";
 
-    res << rule->getStr("ipt_chain").c_str();
+    res << rule->getStr(iptChainKey()).c_str();
 
     if ( ! iface_in_name.isEmpty())
     {
@@ -632,7 +633,7 @@ bool NATCompiler_ipt::PrintRule::processNext()
 
     FWOptions *ropt = rule->getOptionsObject();
 
-    string chain = rule->getStr("ipt_chain");
+    string chain = rule->getStr(iptChainKey());
     if (ipt_comp->chain_usage_counter[chain] == 0)
     {
         return true;
@@ -645,8 +646,8 @@ bool NATCompiler_ipt::PrintRule::processNext()
     string s;
     std::ostringstream  cmdout;
 
-    compiler->output << _createChain(rule->getStr("ipt_chain"));
-    compiler->output << _createChain(rule->getStr("ipt_target"));
+    compiler->output << _createChain(rule->getStr(iptChainKey()));
+    compiler->output << _createChain(rule->getStr(iptTargetKey()));
 
 
     RuleElementOSrc *osrcrel = rule->getOSrc();
@@ -725,7 +726,7 @@ bool NATCompiler_ipt::PrintRule::processNext()
     cmdout << " ";
     cmdout << _printDstService(osrvrel);
 
-    cmdout << "-j " << rule->getStr("ipt_target") << " ";
+    cmdout << "-j " << rule->getStr(iptTargetKey()) << " ";
 
     switch (rule->getRuleType())
     {
@@ -734,7 +735,7 @@ bool NATCompiler_ipt::PrintRule::processNext()
         break;
 
     case NATRule::SNAT:  
-	if (rule->getStr("ipt_target")=="SNAT")
+	if (rule->getStr(iptTargetKey())=="SNAT")
         {
 	    cmdout << "--to-source ";
             // if TSrc is "any" and this is SNAT rule, then this rule only
@@ -767,7 +768,7 @@ bool NATCompiler_ipt::PrintRule::processNext()
  *  to do the right thing.
  */
     case NATRule::DNAT:  
-	if (rule->getStr("ipt_target")=="DNAT")
+	if (rule->getStr(iptTargetKey())=="DNAT")
         {
 	    cmdout << "--to-destination ";
             // if TDst is "any" and this is DNAT rule, then this rule only
@@ -793,7 +794,7 @@ bool NATCompiler_ipt::PrintRule::processNext()
 	break;
 
     case NATRule::SNetnat:
-	if (rule->getStr("ipt_target")=="NETMAP")
+	if (rule->getStr(iptTargetKey())=="NETMAP")
         {
             cmdout << "--to ";
             cmdout << _printAddr(tsrc,true,false);
@@ -801,7 +802,7 @@ bool NATCompiler_ipt::PrintRule::processNext()
         break;
   
     case NATRule::DNetnat:
-	if (rule->getStr("ipt_target")=="NETMAP")
+	if (rule->getStr(iptTargetKey())=="NETMAP")
         {
             cmdout << "--to ";
             cmdout << _printAddr(tdst,true,false);
@@ -809,7 +810,7 @@ bool NATCompiler_ipt::PrintRule::processNext()
         break;
   
     case NATRule::Redirect: 
-	if (rule->getStr("ipt_target")=="REDIRECT")
+	if (rule->getStr(iptTargetKey())=="REDIRECT")
         {
 	    string ports=_printDNATPorts(tsrv);
 	    if (!ports.empty()) cmdout << "--to-ports " << ports;
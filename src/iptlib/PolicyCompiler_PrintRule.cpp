@@ -25,6 +25,7 @@
 
 #include "PolicyCompiler_ipt.h"
 #include "OSConfigurator_linux24.h"
+#include "ipt_utils.h"
 
 #include "fwbuilder/RuleElement.h"
 #include "fwbuilder/IPService.h"
@@ -231,7 +232,7 @@ string PolicyCompiler_ipt::PrintRule::_printRuleLabel(PolicyRule *rule)
  */
 string PolicyCompiler_ipt::PrintRule::_printChain(PolicyRule *rule)
 {
-    string s = rule->getStr("ipt_chain");
+    string s = rule->getStr(iptChainKey());
     if (s.empty()) s = "UNKNOWN";
     // check chain name length per bug report #2507239
     if (s.length() > 30)
@@ -249,7 +250,7 @@ string PolicyCompiler_ipt::PrintRule::_printModules(PolicyRule *rule)
 {
     std::ostringstream ostr;
 
-    string target=rule->getStr("ipt_target");
+    string target=rule->getStr(iptTargetKey());
     if (target.empty()) target="UNKNOWN";
 
     FWOptions *ruleopt =rule->getOptionsObject();
@@ -383,7 +384,7 @@ string PolicyCompiler_ipt::PrintRule::_printTarget(PolicyRule *rule)
     PolicyCompiler_ipt *ipt_comp = dynamic_cast<PolicyCompiler_ipt*>(compiler);
     std::ostringstream ostr;
 
-    string target=rule->getStr("ipt_target");
+    string target=rule->getStr(iptTargetKey());
     if (target.empty()) target="UNKNOWN";
 
     FWOptions *ruleopt =rule->getOptionsObject();
@@ -690,7 +691,7 @@ string PolicyCompiler_ipt::PrintRule::_printLogPrefix(PolicyRule *rule,
     return _printLogPrefix(s1.str(),
                            action.toStdString(),
                            rule_iface_name,
-                           rule->getStr("ipt_chain"),
+                           rule->getStr(iptChainKey()),
                            ruleset->getName(),
                            rule->getLabel(),
                            prefix);
@@ -1524,15 +1525,15 @@ bool  PolicyCompiler_ipt::PrintRule::processNext()
     PolicyRule         *rule    =getNext(); 
     if (rule==NULL) return false;
 
-    string chain = rule->getStr("ipt_chain");
+    string chain = rule->getStr(iptChainKey());
     if (ipt_comp->chain_usage_counter[chain] > 0)
     {
         tmp_queue.push_back(rule);
 
         compiler->output << _printRuleLabel(rule);
-        compiler->output << _createChain(rule->getStr("ipt_chain"));
+        compiler->output << _createChain(rule->getStr(iptChainKey()));
 
-        string target = rule->getStr("ipt_target");
+        string target = rule->getStr(iptTargetKey());
         if (target[0] != '.') compiler->output << _createChain(target);
 
         compiler->output 
@@ -157,8 +157,8 @@ string PolicyCompiler_ipt::findUpstreamChain(const string &chain_name)
 
 void PolicyCompiler_ipt::setChain(PolicyRule *rule, const string &chain_name)
 {
-    rule->setStr("ipt_chain", chain_name);
-    string target = rule->getStr("ipt_target");
+    rule->setStr(iptChainKey(), chain_name);
+    string target = rule->getStr(iptTargetKey());
     if (!target.empty())
     {
         registerChain(target);
@@ -168,7 +168,7 @@ void PolicyCompiler_ipt::setChain(PolicyRule *rule, const string &chain_name)
 
 string PolicyCompiler_ipt::printChains(PolicyRule *rule)
 {
-    string chain_name = rule->getStr("ipt_chain");
+    string chain_name = rule->getStr(iptChainKey());
     map<string, chain_list*>::iterator i = chains.find(chain_name);
     if (i==chains.end() || i->second->size()==0) return chain_name;
     ostringstream res;
@@ -510,8 +510,8 @@ bool  PolicyCompiler_ipt::SkipActionContinueWithNoLogging::processNext()
 {
     PolicyRule *rule=getNext(); if (rule==NULL) return false;
 
-    if ( ! rule->getStr("ipt_target").empty() &&
-         rule->getStr("ipt_target") == ".CONTINUE" &&
+    if ( ! rule->getStr(iptTargetKey()).empty() &&
+         rule->getStr(iptTargetKey()) == ".CONTINUE" &&
          ! rule->getLogging() &&
          ! rule->getTagging() &&
          ! rule->getClassification() &&
@@ -528,7 +528,7 @@ bool  PolicyCompiler_ipt::SkipActionContinueWithNoLogging::processNext()
 bool  PolicyCompiler_ipt::dropTerminatingTargets::processNext()
 {
     PolicyRule *rule=getNext(); if (rule==NULL) return false;
-    string tgt = rule->getStr("ipt_target");
+    string tgt = rule->getStr(iptTargetKey());
 
     if (tgt=="CLASSIFY" || tgt=="MARK") tmp_queue.push_back(rule);
     return true;
@@ -610,7 +610,7 @@ bool PolicyCompiler_ipt::splitIfTagClassifyOrRoute::processNext()
         Q_UNUSED(r);
         Q_UNUSED(r2);
 
-        string this_chain = rule->getStr("ipt_chain");
+        string this_chain = rule->getStr(iptChainKey());
         string new_chain  = this_chain;
 
         nsrc = rule->getSrc();
@@ -628,7 +628,7 @@ bool PolicyCompiler_ipt::splitIfTagClassifyOrRoute::processNext()
             compiler->temp_ruleset->add(r);
             r->duplicate(rule);
             r->setStr("subrule_suffix", "ntt");
-            r->setStr("ipt_target", new_chain);
+            r->setStr(iptTargetKey(), new_chain);
             r->setClassification(false);
             r->setRouting(false);
             r->setTagging(false);
@@ -657,7 +657,7 @@ bool PolicyCompiler_ipt::splitIfTagClassifyOrRoute::processNext()
             r->setClassification(false);
             r->setRouting(false);
             rule->setTagging(false);
-            r->setStr("ipt_chain", new_chain);
+            r->setStr(iptChainKey(), new_chain);
             r->setStr("upstream_rule_chain", this_chain);
             r->setAction(PolicyRule::Continue);
             tmp_queue.push_back(r);
@@ -671,7 +671,7 @@ bool PolicyCompiler_ipt::splitIfTagClassifyOrRoute::processNext()
             rule->setClassification(false);
             r->setRouting(false);
             r->setTagging(false);
-            r->setStr("ipt_chain", new_chain);
+            r->setStr(iptChainKey(), new_chain);
             r->setStr("upstream_rule_chain", this_chain);
             r->setAction(PolicyRule::Continue);
             tmp_queue.push_back(r);
@@ -688,7 +688,7 @@ bool PolicyCompiler_ipt::splitIfTagClassifyOrRoute::processNext()
         {
             rule->setClassification(false);
             rule->setTagging(false);
-            rule->setStr("ipt_chain", new_chain);
+            rule->setStr(iptChainKey(), new_chain);
             rule->setStr("upstream_rule_chain", this_chain);
             tmp_queue.push_back(rule);
         }
@@ -936,7 +936,7 @@ bool PolicyCompiler_ipt::Logging2::processNext()
               ! rule->getClassification() &&
               ! rule->getRouting()))
         {
-            rule->setStr("ipt_target", "LOG");
+            rule->setStr(iptTargetKey(), "LOG");
             tmp_queue.push_back(rule);
             return true;
         }
@@ -944,7 +944,7 @@ bool PolicyCompiler_ipt::Logging2::processNext()
 /* 
  * chain could have been assigned if we split this rule before
  */
-        string this_chain = rule->getStr("ipt_chain");
+        string this_chain = rule->getStr(iptChainKey());
 	string new_chain  = ipt_comp->getNewChainName(rule, NULL); //rule_iface);
 
 	PolicyRule *r;
@@ -976,7 +976,7 @@ bool PolicyCompiler_ipt::Logging2::processNext()
             compiler->temp_ruleset->add(r);
             r->duplicate(rule);
             ruleopt =r->getOptionsObject();
-            r->setStr("ipt_target",new_chain);
+            r->setStr(iptTargetKey(),new_chain);
             r->setClassification(false);
             r->setRouting(false);
             r->setTagging(false);
@@ -1006,12 +1006,12 @@ bool PolicyCompiler_ipt::Logging2::processNext()
 	nsrv=r->getSrv();      nsrv->reset();
         nitfre=r->getItf();    nitfre->reset();
 	if ( (nint=r->getWhen())!=NULL )  nint->reset();
-	r->setStr("ipt_chain",new_chain);
+	r->setStr(iptChainKey(),new_chain);
         r->setStr("upstream_rule_chain",this_chain);
         ipt_comp->registerChain(new_chain);
         ipt_comp->insertUpstreamChain(this_chain, new_chain);
 
-	r->setStr("ipt_target","LOG");
+	r->setStr(iptTargetKey(),"LOG");
         r->setAction(PolicyRule::Continue);    // ###
 	r->setDirection( PolicyRule::Both );
 	r->setLogging(false);
@@ -1050,7 +1050,7 @@ bool PolicyCompiler_ipt::Logging2::processNext()
             nsrv->reset();
         }
 
-	r->setStr("ipt_chain",new_chain);
+	r->setStr(iptChainKey(),new_chain);
         r->setStr("upstream_rule_chain",this_chain);
         ipt_comp->registerChain(new_chain);
         ipt_comp->insertUpstreamChain(this_chain, new_chain);
@@ -1175,7 +1175,7 @@ bool PolicyCompiler_ipt::SrcNegation::processNext()
         FWOptions      *ruleopt;
 
 /*chain could have been assigned if we split this rule before */
-        string this_chain  = rule->getStr("ipt_chain");
+        string this_chain  = rule->getStr(iptChainKey());
 	string new_chain   = ipt_comp->getNewTmpChainName(rule);
 	srcrel->setNeg(false);
 
@@ -1191,7 +1191,7 @@ bool PolicyCompiler_ipt::SrcNegation::processNext()
         r->setRouting(false);
         r->setTagging(false);
 	r->setLogging(false);
-	r->setStr("ipt_target",new_chain);
+	r->setStr(iptTargetKey(),new_chain);
         ruleopt =r->getOptionsObject();
         ruleopt->setInt("limit_value",-1);
         ruleopt->setInt("limit_value",-1);
@@ -1219,8 +1219,8 @@ bool PolicyCompiler_ipt::SrcNegation::processNext()
         r->setRouting(false);
         r->setTagging(false);
 	r->setLogging(false);
- 	r->setStr("ipt_chain",new_chain);
-	r->setStr("ipt_target","");
+ 	r->setStr(iptChainKey(),new_chain);
+	r->setStr(iptTargetKey(),"");
         r->setStr("upstream_rule_chain",this_chain);
         ipt_comp->registerChain(new_chain);
         ipt_comp->insertUpstreamChain(this_chain, new_chain);
@@ -1263,13 +1263,13 @@ bool PolicyCompiler_ipt::SrcNegation::processNext()
                 nsrv->reset();
             }
         }
-	r->setStr("ipt_chain",new_chain);
+	r->setStr(iptChainKey(),new_chain);
         r->setStr("upstream_rule_chain",this_chain);
         ipt_comp->registerChain(new_chain);
         ipt_comp->insertUpstreamChain(this_chain, new_chain);
 
-	if ( ! rule->getStr("ipt_target").empty() )
-	    r->setStr("ipt_target",rule->getStr("ipt_target"));
+	if ( ! rule->getStr(iptTargetKey()).empty() )
+	    r->setStr(iptTargetKey(),rule->getStr(iptTargetKey()));
 
 //	r->setInterfaceStr("nil");
         r->setBool("final",true);
@@ -1305,7 +1305,7 @@ bool PolicyCompiler_ipt::DstNegation::processNext()
         FWOptions      *ruleopt;
 
 /*chain could have been assigned if we split this rule before */
-        string this_chain  = rule->getStr("ipt_chain");
+        string this_chain  = rule->getStr(iptChainKey());
 	string new_chain   = ipt_comp->getNewTmpChainName(rule);
 	dstrel->setNeg(false);
 
@@ -1321,7 +1321,7 @@ bool PolicyCompiler_ipt::DstNegation::processNext()
         r->setRouting(false);
         r->setTagging(false);
 	r->setLogging(false);
-	r->setStr("ipt_target",new_chain);
+	r->setStr(iptTargetKey(),new_chain);
         ruleopt =r->getOptionsObject();
         ruleopt->setInt("limit_value",-1);
         ruleopt->setInt("limit_value",-1);
@@ -1349,8 +1349,8 @@ bool PolicyCompiler_ipt::DstNegation::processNext()
         r->setRouting(false);
         r->setTagging(false);
 	r->setLogging(false);
-	r->setStr("ipt_chain",new_chain);
-	r->setStr("ipt_target","");
+	r->setStr(iptChainKey(),new_chain);
+	r->setStr(iptTargetKey(),"");
         r->setStr("upstream_rule_chain",this_chain);
         ipt_comp->registerChain(new_chain);
         ipt_comp->insertUpstreamChain(this_chain, new_chain);
@@ -1395,14 +1395,14 @@ bool PolicyCompiler_ipt::DstNegation::processNext()
                 nsrv->reset();
             }
         }
-	r->setStr("ipt_chain",new_chain);
-	r->setStr("ipt_target","");
+	r->setStr(iptChainKey(),new_chain);
+	r->setStr(iptTargetKey(),"");
         r->setStr("upstream_rule_chain",this_chain);
         ipt_comp->registerChain(new_chain);
         ipt_comp->insertUpstreamChain(this_chain, new_chain);
 
-	if ( ! rule->getStr("ipt_target").empty() )
-	    r->setStr("ipt_target",rule->getStr("ipt_target"));
+	if ( ! rule->getStr(iptTargetKey()).empty() )
+	    r->setStr(iptTargetKey(),rule->getStr(iptTargetKey()));
 
 //	r->setInterfaceStr("nil");
         r->setBool("final",true);
@@ -1439,7 +1439,7 @@ bool PolicyCompiler_ipt::SrvNegation::processNext()
         FWOptions      *ruleopt;
 
 /*chain could have been assigned if we split this rule before */
-        string this_chain = rule->getStr("ipt_chain");
+        string this_chain = rule->getStr(iptChainKey());
 	string new_chain  = ipt_comp->getNewTmpChainName(rule);
 	srvrel->setNeg(false);
 
@@ -1454,7 +1454,7 @@ bool PolicyCompiler_ipt::SrvNegation::processNext()
         r->setRouting(false);
         r->setTagging(false);
 	r->setLogging(false);
-	r->setStr("ipt_target",new_chain);
+	r->setStr(iptTargetKey(),new_chain);
         ruleopt =r->getOptionsObject();
         ruleopt->setInt("limit_value",-1);
         ruleopt->setInt("limit_value",-1);
@@ -1481,8 +1481,8 @@ bool PolicyCompiler_ipt::SrvNegation::processNext()
         r->setRouting(false);
         r->setTagging(false);
 	r->setLogging(false);
-	r->setStr("ipt_chain",new_chain);
-	r->setStr("ipt_target","");
+	r->setStr(iptChainKey(),new_chain);
+	r->setStr(iptTargetKey(),"");
         r->setStr("upstream_rule_chain",this_chain);
         ipt_comp->registerChain(new_chain);
         ipt_comp->insertUpstreamChain(this_chain, new_chain);
@@ -1513,14 +1513,14 @@ bool PolicyCompiler_ipt::SrvNegation::processNext()
             if ( (nint=r->getWhen())!=NULL )  nint->reset();
         }
 
-	r->setStr("ipt_chain",new_chain);
+	r->setStr(iptChainKey(),new_chain);
         r->setStr("upstream_rule_chain",this_chain);
         ipt_comp->registerChain(new_chain);
         ipt_comp->insertUpstreamChain(this_chain, new_chain);
 
         r->setBool("upstream_rule_neg",true);
-	if ( ! rule->getStr("ipt_target").empty() )
-	    r->setStr("ipt_target",rule->getStr("ipt_target"));
+	if ( ! rule->getStr(iptTargetKey()).empty() )
+	    r->setStr(iptTargetKey(),rule->getStr(iptTargetKey()));
         
 //	r->setInterfaceStr("nil");
         r->setBool("final",true);
@@ -1557,7 +1557,7 @@ bool PolicyCompiler_ipt::TimeNegation::processNext()
         FWOptions           *ruleopt;
 
 /*chain could have been assigned if we split this rule before */
-        string this_chain = rule->getStr("ipt_chain");
+        string this_chain = rule->getStr(iptChainKey());
 	string new_chain  = ipt_comp->getNewTmpChainName(rule);
 	intrel->setNeg(false);
 
@@ -1573,7 +1573,7 @@ bool PolicyCompiler_ipt::TimeNegation::processNext()
         r->setRouting(false);
         r->setTagging(false);
 	r->setLogging(false);
-	r->setStr("ipt_target",new_chain);
+	r->setStr(iptTargetKey(),new_chain);
         ruleopt =r->getOptionsObject();
         ruleopt->setInt("limit_value",-1);
         ruleopt->setInt("limit_value",-1);
@@ -1601,8 +1601,8 @@ bool PolicyCompiler_ipt::TimeNegation::processNext()
         r->setRouting(false);
         r->setTagging(false);
 	r->setLogging(false);
-	r->setStr("ipt_chain",new_chain);
-	r->setStr("ipt_target","");
+	r->setStr(iptChainKey(),new_chain);
+	r->setStr(iptTargetKey(),"");
         r->setStr("upstream_rule_chain",this_chain);
         ipt_comp->registerChain(new_chain);
         ipt_comp->insertUpstreamChain(this_chain, new_chain);
@@ -1648,13 +1648,13 @@ bool PolicyCompiler_ipt::TimeNegation::processNext()
                 nsrv->reset();
             }
         }
-	r->setStr("ipt_chain",new_chain);
+	r->setStr(iptChainKey(),new_chain);
         r->setStr("upstream_rule_chain",this_chain);
         ipt_comp->registerChain(new_chain);
         ipt_comp->insertUpstreamChain(this_chain, new_chain);
 
-	if ( ! rule->getStr("ipt_target").empty() )
-	    r->setStr("ipt_target",rule->getStr("ipt_target"));
+	if ( ! rule->getStr(iptTargetKey()).empty() )
+	    r->setStr(iptTargetKey(),rule->getStr(iptTargetKey()));
 
 //	r->setInterfaceStr("nil");
         r->setBool("final",true);
@@ -1745,7 +1745,7 @@ bool PolicyCompiler_ipt::setChainPreroutingForTag::processNext()
     RuleElementItf *itf_re = rule->getItf(); assert(itf_re!=NULL);
 
     if ( (rule->getTagging() || rule->getBool("originated_from_a_rule_with_tagging")) &&
-          rule->getStr("ipt_chain").empty() &&
+          rule->getStr(iptChainKey()).empty() &&
          (rule->getDirection()==PolicyRule::Both ||
           rule->getDirection()==PolicyRule::Inbound) &&
          itf_re->isAny())
@@ -1765,7 +1765,7 @@ bool PolicyCompiler_ipt::setChainPostroutingForTag::processNext()
     RuleElementItf *itf_re = rule->getItf(); assert(itf_re!=NULL);
 
     if ( (rule->getTagging()  || rule->getBool("originated_from_a_rule_with_tagging")) &&
-          rule->getStr("ipt_chain").empty() &&
+          rule->getStr(iptChainKey()).empty() &&
          (rule->getDirection()==PolicyRule::Both ||
           rule->getDirection()==PolicyRule::Outbound) &&
          itf_re->isAny())
@@ -1783,7 +1783,7 @@ bool PolicyCompiler_ipt::checkForRestoreMarkInOutput::processNext()
 
     if ( (rule->getTagging()  || rule->getBool("originated_from_a_rule_with_tagging")) &&
          ruleopt->getBool("ipt_mark_connections") &&
-         rule->getStr("ipt_chain")=="OUTPUT")
+         rule->getStr(iptChainKey())=="OUTPUT")
         ipt_comp->have_connmark_in_output = true;
 
     tmp_queue.push_back(rule);
@@ -1796,7 +1796,7 @@ bool PolicyCompiler_ipt::setChainForMangle::processNext()
     PolicyCompiler_ipt *ipt_comp=dynamic_cast<PolicyCompiler_ipt*>(compiler);
     PolicyRule *rule=getNext(); if (rule==NULL) return false;
 
-    if (ipt_comp->my_table=="mangle" && rule->getStr("ipt_chain").empty())
+    if (ipt_comp->my_table=="mangle" && rule->getStr(iptChainKey()).empty())
     {
         if (rule->getDirection()==PolicyRule::Inbound)
             ipt_comp->setChain(rule, "PREROUTING");
@@ -1834,7 +1834,7 @@ bool PolicyCompiler_ipt::splitIfTagAndConnmark::processNext()
 	PolicyRule *r1 = compiler->dbcopy->createPolicyRule();
 	compiler->temp_ruleset->add(r1);
 	r1->duplicate(rule);
-	r1->setStr("ipt_target", "CONNMARK");
+	r1->setStr(iptTargetKey(), "CONNMARK");
         r1->setAction(PolicyRule::Continue);    // ###
         r1->setClassification(false);
         r1->setRouting(false);
@@ -1865,7 +1865,7 @@ bool PolicyCompiler_ipt::splitIfIfaceAndDirectionBoth::processNext()
 
         // If this rule has been assigned to chain POSTROUTING,
         // direction 'inbound' does not make sense for it.
-        if (rule->getStr("ipt_chain") != "POSTROUTING")
+        if (rule->getStr(iptChainKey()) != "POSTROUTING")
         {
             r = compiler->dbcopy->createPolicyRule();
             compiler->temp_ruleset->add(r);
@@ -1876,7 +1876,7 @@ bool PolicyCompiler_ipt::splitIfIfaceAndDirectionBoth::processNext()
 
         // If this rule has been assigned to chain PREROUTING,
         // direction 'Outbound' does not make sense for it.
-        if (rule->getStr("ipt_chain") != "PREROUTING")
+        if (rule->getStr(iptChainKey()) != "PREROUTING")
         {
             r= compiler->dbcopy->createPolicyRule();
             compiler->temp_ruleset->add(r);
@@ -1965,7 +1965,7 @@ bool PolicyCompiler_ipt::bridgingFw::processNext()
 //    Address        *src=compiler->getFirstSrc(rule);
     Address *dst = compiler->getFirstDst(rule);
 
-    if ( rule->getStr("ipt_chain")=="INPUT" )
+    if ( rule->getStr(iptChainKey())=="INPUT" )
     {
         if ( checkForMatchingBroadcastAndMulticast(dst) )
         {
@@ -2011,7 +2011,7 @@ bool PolicyCompiler_ipt::splitIfSrcNegAndFw::processNext()
     PolicyCompiler_ipt *ipt_comp = dynamic_cast<PolicyCompiler_ipt*>(compiler);
     PolicyRule *rule=getNext(); if (rule==NULL) return false;
 
-    if ( ! rule->getStr("ipt_chain").empty() ) 
+    if ( ! rule->getStr(iptChainKey()).empty() ) 
     {
 	tmp_queue.push_back(rule);
 	return true;
@@ -2066,7 +2066,7 @@ bool PolicyCompiler_ipt::splitIfSrcNegAndFw::processNext()
                 nsrc->addRef(*m);
             tmp_queue.push_back(r);
 
-//            rule->setStr("ipt_chain","FORWARD");
+//            rule->setStr(iptChainKey(),"FORWARD");
             nsrc=rule->getSrc();
             nsrc->reset();   // resets negation flag
             for (list<FWObject*>::iterator m=notFwLikes.begin(); m!=notFwLikes.end(); ++m) 
@@ -2089,7 +2089,7 @@ bool PolicyCompiler_ipt::splitIfDstNegAndFw::processNext()
     PolicyCompiler_ipt *ipt_comp = dynamic_cast<PolicyCompiler_ipt*>(compiler);
     PolicyRule *rule=getNext(); if (rule==NULL) return false;
 
-    if ( ! rule->getStr("ipt_chain").empty() ) 
+    if ( ! rule->getStr(iptChainKey()).empty() ) 
     {
 	tmp_queue.push_back(rule);
 	return true;
@@ -2147,7 +2147,7 @@ bool PolicyCompiler_ipt::splitIfDstNegAndFw::processNext()
             // the second rule goes into FORWARD chain, but if source
             // is (or contains) firewall, we may also need OUTPUT chain
 
-//            rule->setStr("ipt_chain","FORWARD");
+//            rule->setStr(iptChainKey(),"FORWARD");
             ndst=rule->getDst();
             ndst->reset();   // resets negation flag
             for (list<FWObject*>::iterator m=notFwLikes.begin(); m!=notFwLikes.end(); ++m) 
@@ -2199,7 +2199,7 @@ bool PolicyCompiler_ipt::splitIfSrcAny::processNext()
 	return true;
     }
 
-    if ( ! rule->getStr("ipt_chain").empty() ) 
+    if ( ! rule->getStr(iptChainKey()).empty() ) 
     {
 	tmp_queue.push_back(rule);
 	return true;
@@ -2268,7 +2268,7 @@ bool PolicyCompiler_ipt::splitIfDstAny::processNext()
 	return true;
     }
 
-    if ( ! rule->getStr("ipt_chain").empty() ) 
+    if ( ! rule->getStr(iptChainKey()).empty() ) 
     {
 	tmp_queue.push_back(rule);
 	return true;
@@ -2538,7 +2538,7 @@ bool PolicyCompiler_ipt::splitIfSrcFWNetwork::processNext()
 	return true;
     }
 
-    if ( ! rule->getStr("ipt_chain").empty() || srcrel->isAny() ) 
+    if ( ! rule->getStr(iptChainKey()).empty() || srcrel->isAny() ) 
     {
 	tmp_queue.push_back(rule);
 	return true;
@@ -2611,7 +2611,7 @@ bool PolicyCompiler_ipt::splitIfDstFWNetwork::processNext()
 	return true;
     }
 
-    if ( ! rule->getStr("ipt_chain").empty() || dstrel->isAny() ) 
+    if ( ! rule->getStr(iptChainKey()).empty() || dstrel->isAny() ) 
     {
 	tmp_queue.push_back(rule);
 	return true;
@@ -2757,7 +2757,7 @@ bool PolicyCompiler_ipt::specialCaseWithFWInDstAndOutbound::processNext()
     RuleElementSrc *srcrel = rule->getSrc();
     Address *src =compiler->getFirstSrc(rule);
     Address *dst =compiler->getFirstDst(rule);
-    string chain  = rule->getStr("ipt_chain");
+    string chain  = rule->getStr(iptChainKey());
 
     if (rule->getDirection()== PolicyRule::Outbound &&
         itf!=NULL && itf->isChildOf(compiler->fw) &&
@@ -2928,7 +2928,7 @@ bool PolicyCompiler_ipt::specialCaseWithUnnumberedInterface::processNext()
         keep_rule=dropUnnumberedInterface( rule->getSrc() );
         break;
     case PolicyRule::Outbound:
-        if ( rule->getStr("ipt_chain")=="OUTPUT" ) 
+        if ( rule->getStr(iptChainKey())=="OUTPUT" ) 
             keep_rule=dropUnnumberedInterface( rule->getDst() );
         else
             keep_rule=dropUnnumberedInterface( rule->getSrc() );
@@ -3073,7 +3073,7 @@ bool PolicyCompiler_ipt::decideOnChainIfSrcFW::processNext()
     PolicyCompiler_ipt *ipt_comp = dynamic_cast<PolicyCompiler_ipt*>(compiler);
     PolicyRule *rule=getNext(); if (rule==NULL) return false;
 
-    if ( ! rule->getStr("ipt_chain").empty() || rule->getClassification())
+    if ( ! rule->getStr(iptChainKey()).empty() || rule->getClassification())
     {
         tmp_queue.push_back(rule);
         return true;
@@ -3174,7 +3174,7 @@ bool PolicyCompiler_ipt::decideOnChainIfDstFW::processNext()
     PolicyCompiler_ipt *ipt_comp = dynamic_cast<PolicyCompiler_ipt*>(compiler);
     PolicyRule *rule=getNext(); if (rule==NULL) return false;
 
-    if ( ! rule->getStr("ipt_chain").empty() || rule->getClassification())
+    if ( ! rule->getStr(iptChainKey()).empty() || rule->getClassification())
     {
         tmp_queue.push_back(rule);
         return true;
@@ -3317,7 +3317,7 @@ bool PolicyCompiler_ipt::decideOnChainIfLoopback::processNext()
     RuleElementDst *dstrel=rule->getDst();
 
     if (srcrel->isAny() && dstrel->isAny() && 
-        rule->getStr("ipt_chain").empty()  &&
+        rule->getStr(iptChainKey()).empty()  &&
         rule_iface!=NULL &&
         rule_iface->isLoopback() )
     {
@@ -3349,7 +3349,7 @@ bool PolicyCompiler_ipt::decideOnChainForClassify::processNext()
 	return true;
     }
 
-    if (rule->getStr("ipt_chain").empty())
+    if (rule->getStr(iptChainKey()).empty())
     {
         if (rule->getTagging())
         {
@@ -3378,7 +3378,7 @@ bool PolicyCompiler_ipt::finalizeChain::processNext()
 
 //    tmp_queue.push_back(rule);
 
-    if ( ! rule->getStr("ipt_chain").empty() )
+    if ( ! rule->getStr(iptChainKey()).empty() )
     {
         tmp_queue.push_back(rule);
         return true;
@@ -3487,7 +3487,7 @@ bool PolicyCompiler_ipt::finalizeChain::processNext()
          ip_forward_option=="Off" ||
          ip_forward_option=="off")) ipforw = false;
 
-    if (rule->getStr("ipt_chain")=="FORWARD" && !ipforw) return true;
+    if (rule->getStr(iptChainKey())=="FORWARD" && !ipforw) return true;
 
     tmp_queue.push_back(rule);
     return true;
@@ -3499,22 +3499,22 @@ bool PolicyCompiler_ipt::decideOnTarget::processNext()
 
     tmp_queue.push_back(rule);
 
-    if ( ! rule->getStr("ipt_target").empty() ) return true; // already defined
+    if ( ! rule->getStr(iptTargetKey()).empty() ) return true; // already defined
 
     // note that we use pseudo-target for action Continue
     switch (rule->getAction())
     {
-    case PolicyRule::Accept:   rule->setStr("ipt_target", "ACCEPT");    break;
-    case PolicyRule::Deny:     rule->setStr("ipt_target", "DROP");      break;
-    case PolicyRule::Reject:   rule->setStr("ipt_target", "REJECT");    break;
-    case PolicyRule::Return:   rule->setStr("ipt_target", "RETURN");    break;
-//    case PolicyRule::Tag:      rule->setStr("ipt_target", "MARK");      break;
-    case PolicyRule::Pipe:     rule->setStr("ipt_target", "QUEUE");     break;
-//    case PolicyRule::Classify: rule->setStr("ipt_target", "CLASSIFY");  break;
-//    case PolicyRule::Route:    rule->setStr("ipt_target", "ROUTE");     break;
+    case PolicyRule::Accept:   rule->setStr(iptTargetKey(), "ACCEPT");    break;
+    case PolicyRule::Deny:     rule->setStr(iptTargetKey(), "DROP");      break;
+    case PolicyRule::Reject:   rule->setStr(iptTargetKey(), "REJECT");    break;
+    case PolicyRule::Return:   rule->setStr(iptTargetKey(), "RETURN");    break;
+//    case PolicyRule::Tag:      rule->setStr(iptTargetKey(), "MARK");      break;
+    case PolicyRule::Pipe:     rule->setStr(iptTargetKey(), "QUEUE");     break;
+//    case PolicyRule::Classify: rule->setStr(iptTargetKey(), "CLASSIFY");  break;
+//    case PolicyRule::Route:    rule->setStr(iptTargetKey(), "ROUTE");     break;
 
-    case PolicyRule::Continue: rule->setStr("ipt_target", ".CONTINUE"); break;
-    case PolicyRule::Custom:   rule->setStr("ipt_target", ".CUSTOM");   break;
+    case PolicyRule::Continue: rule->setStr(iptTargetKey(), ".CONTINUE"); break;
+    case PolicyRule::Custom:   rule->setStr(iptTargetKey(), ".CUSTOM");   break;
 
     case PolicyRule::Branch:
     {
@@ -3525,7 +3525,7 @@ bool PolicyCompiler_ipt::decideOnTarget::processNext()
                 string("Branching rule ") + rule->getLabel() +
                 " refers ruleset that does not exist");
         else
-            rule->setStr("ipt_target", ruleset->getName());
+            rule->setStr(iptTargetKey(), ruleset->getName());
         break;
     }
     default: ;
@@ -3579,7 +3579,7 @@ bool PolicyCompiler_ipt::removeFW::processNext()
             return true;
         }
 
-        string chain = rule->getStr("ipt_chain");
+        string chain = rule->getStr(iptChainKey());
 
         if (( chain=="INPUT" || 
               ipt_comp->isChainDescendantOfInput(chain)) &&
@@ -3604,7 +3604,7 @@ bool PolicyCompiler_ipt::checkMACinOUTPUTChain::processNext()
 {
     PolicyRule *rule=getNext(); if (rule==NULL) return false;
 
-    if ( rule->getStr("ipt_chain")=="OUTPUT" )
+    if ( rule->getStr(iptChainKey())=="OUTPUT" )
     {
 //        RuleElementSrc *srcrel=rule->getSrc();
         Address *src = compiler->getFirstSrc(rule);
@@ -3637,7 +3637,7 @@ bool PolicyCompiler_ipt::checkUserServiceInWrongChains::processNext()
     PolicyCompiler_ipt *ipt_comp = dynamic_cast<PolicyCompiler_ipt*>(compiler);
     PolicyRule *rule=getNext(); if (rule==NULL) return false;
     Service *srv = compiler->getFirstSrv(rule);  assert(srv);
-    string chain = rule->getStr("ipt_chain");
+    string chain = rule->getStr(iptChainKey());
 
     if (UserService::cast(srv) != NULL &&
         chain != "OUTPUT" &&
@@ -4109,9 +4109,9 @@ bool PolicyCompiler_ipt::accounting::processNext()
     FWOptions  *ruleopt = rule->getOptionsObject();
 
     if (rule->getAction()==PolicyRule::Accounting &&
-        rule->getStr("ipt_target").empty())
+        rule->getStr(iptTargetKey()).empty())
     {
-        string this_chain = rule->getStr("ipt_chain");
+        string this_chain = rule->getStr(iptChainKey());
 	string new_chain  = ipt_comp->getNewChainName(rule, rule_iface);
         string rule_name_accounting = ruleopt->getStr("rule_name_accounting");
         if (!rule_name_accounting.empty())
@@ -4119,7 +4119,7 @@ bool PolicyCompiler_ipt::accounting::processNext()
 
         if (new_chain==this_chain)
         {
-            rule->setStr("ipt_target", "RETURN");
+            rule->setStr(iptTargetKey(), "RETURN");
             rule->setAction(PolicyRule::Continue);
         } else
         {
@@ -4138,17 +4138,17 @@ bool PolicyCompiler_ipt::accounting::processNext()
             nsrc=r->getSrc();  nsrc->reset();
             ndst=r->getDst();  ndst->reset();
             nsrv=r->getSrv();  nsrv->reset();
-            r->setStr("ipt_chain",new_chain);
+            r->setStr(iptChainKey(),new_chain);
             r->setStr("upstream_rule_chain",this_chain);
             ipt_comp->registerChain(new_chain);
             ipt_comp->insertUpstreamChain(this_chain, new_chain);
 
-            r->setStr("ipt_target", "RETURN");
+            r->setStr(iptTargetKey(), "RETURN");
             r->setLogging(false);
             r->setAction(PolicyRule::Continue);
             tmp_queue.push_back(r);
 
-            rule->setStr("ipt_target", new_chain);
+            rule->setStr(iptTargetKey(), new_chain);
             rule->setLogging(false);
             ruleopt = rule->getOptionsObject();
             ruleopt->setInt("limit_value",-1);
@@ -4170,7 +4170,7 @@ bool PolicyCompiler_ipt::countChainUsage::processNext()
     for (deque<Rule*>::iterator k=tmp_queue.begin(); k!=tmp_queue.end(); ++k) 
     {
         PolicyRule *rule = PolicyRule::cast( *k );
-        ipt_comp->chain_usage_counter[rule->getStr("ipt_target")] += 1;
+        ipt_comp->chain_usage_counter[rule->getStr(iptTargetKey())] += 1;
     }
 
     // second pass: if chain the rule belongs to has never been used as a target
@@ -4178,8 +4178,8 @@ bool PolicyCompiler_ipt::countChainUsage::processNext()
     for (deque<Rule*>::iterator k=tmp_queue.begin(); k!=tmp_queue.end(); ++k) 
     {
         PolicyRule *rule = PolicyRule::cast( *k );
-        if (ipt_comp->chain_usage_counter[rule->getStr("ipt_chain")] == 0)
-            ipt_comp->chain_usage_counter[rule->getStr("ipt_target")] = 0;
+        if (ipt_comp->chain_usage_counter[rule->getStr(iptChainKey())] == 0)
+            ipt_comp->chain_usage_counter[rule->getStr(iptTargetKey())] = 0;
     }
 
     return true;
@@ -4806,7 +4806,7 @@ string PolicyCompiler_ipt::debugPrintRule(Rule *r)
 
     str << " c=" << printChains(rule);
 
-    str << " t=" << rule->getStr("ipt_target");
+    str << " t=" << rule->getStr(iptTargetKey());
 
     if ( ! rule->getStr(".iface").empty())
         str << " .iface=" << rule->getStr(".iface");
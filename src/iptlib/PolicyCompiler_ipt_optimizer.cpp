@@ -24,6 +24,7 @@
 */
 
 #include "PolicyCompiler_ipt.h"
+#include "ipt_utils.h"
 
 #include "fwbuilder/FWObjectDatabase.h"
 #include "fwbuilder/RuleElement.h"
@@ -68,7 +69,7 @@ void PolicyCompiler_ipt::optimize1::optimizeForRuleElement(
     PolicyCompiler_ipt *ipt_comp=dynamic_cast<PolicyCompiler_ipt*>(compiler);
     PolicyRule     *r;
 
-    string this_chain = rule->getStr("ipt_chain");
+    string this_chain = rule->getStr(iptChainKey());
     string new_chain  = ipt_comp->getNewTmpChainName(rule);
 
     r= compiler->dbcopy->createPolicyRule();
@@ -122,7 +123,7 @@ void PolicyCompiler_ipt::optimize1::optimizeForRuleElement(
             }      
         }
     }
-    r->setStr("ipt_target",new_chain);
+    r->setStr(iptTargetKey(),new_chain);
 
     r->setClassification(false);
     r->setRouting(false);
@@ -135,7 +136,7 @@ void PolicyCompiler_ipt::optimize1::optimizeForRuleElement(
     ruleopt->setInt("limit_value",-1);
     ruleopt->setInt("connlimit_value",-1);
     ruleopt->setInt("hashlimit_value",-1);
-    rule->setStr("ipt_chain",new_chain);
+    rule->setStr(iptChainKey(),new_chain);
     rule->setBool("force_state_check",false);
     rule->setStr("upstream_rule_chain", this_chain);
     ipt_comp->registerChain(new_chain);
@@ -158,15 +159,12 @@ bool PolicyCompiler_ipt::optimize1::processNext()
     RuleElementSrv      *srvrel;
     RuleElementInterval *intrel;
 
-    FWObject::iterator i1 = rule->begin();
-    srcrel = RuleElementSrc::cast(*i1);
-    i1++;
-    dstrel = RuleElementDst::cast(*i1);
-    i1++;
-    srvrel = RuleElementSrv::cast(*i1);
-    i1++;
-    i1++;
-    intrel = RuleElementInterval::cast(*i1);
+    FWObject* const *children = rule->getChildArray();
+    srcrel = RuleElementSrc::cast(children[0]);
+    dstrel = RuleElementDst::cast(children[1]);
+    srvrel = RuleElementSrv::cast(children[2]);
+    intrel = (rule->size() > 4) ?
+        RuleElementInterval::cast(children[4]) : NULL;
 
     bool srcany = srcrel->isAny();
     bool dstany = dstrel->isAny();
@@ -180,9 +178,10 @@ bool PolicyCompiler_ipt::optimize1::processNext()
     if (intrel!=NULL) intn = intrel->size();
 
     bool all_tcp_or_udp = true;
-    for (FWObject::iterator i=srvrel->begin(); i!=srvrel->end(); i++)
+    FWObject* const *services = srvrel->getChildArray();
+    for (int i=0; i<srvn; i++)
     {
-        FWObject *o= *i;
+        FWObject *o = services[i];
         if (FWReference::cast(o)!=NULL) o=FWReference::cast(o)->getPointer();
 	    
         Service *service_object = Service::cast( o );
@@ -329,7 +328,7 @@ bool PolicyCompiler_ipt::optimizeForMinusIOPlus::processNext()
         return true;
     }
 
-    string chain = rule->getStr("ipt_chain");
+    string chain = rule->getStr(iptChainKey());
 
     if (iface_name == "*" && (chain == "INPUT" || chain == "OUTPUT"))
         itf_re->reset();
@@ -26,6 +26,7 @@
 
 #include "fwbuilder/Interface.h"
 #include "fwbuilder/AttachedNetworks.h"
+#include "fwbuilder/MultiAddress.h"
 
 
 using namespace libfwbuilder;
@@ -33,6 +34,13 @@ using namespace fwcompiler;
 using namespace std;
 
 
+/*
+ * Addresses of compile-time MultiAddress objects stay in their prefix
+ * arrays, which are aggregated here. Network objects are created by
+ * Compiler::_expand_group_recursive() when a rule element that has
+ * the object is expanded, and only for the entries left after
+ * aggregation.
+ */
 void Preprocessor_ipt::convertObject(FWObject *obj)
 {
     if ( AttachedNetworks::isA(obj))
@@ -43,8 +51,21 @@ void Preprocessor_ipt::convertObject(FWObject *obj)
         {
             att->setCompileTime(true);
             att->loadFromSource(ipv6, getCachedFwOpt(), inTestMode());
+            att->aggregatePrefixes(ipv6);
         } else att->setRunTime(true);
-    } else
-        Preprocessor::convertObject(obj);
+        return;
+    }
+
+    MultiAddress *adt = MultiAddress::cast(obj);
+    if (adt!=NULL && adt->isCompileTime())
+    {
+        // if the source could not be read completely, entries read
+        // so far stay in the array
+        adt->loadFromSource(ipv6, getCachedFwOpt(), inTestMode());
+        adt->aggregatePrefixes(ipv6);
+        return;
+    }
+
+    Preprocessor::convertObject(obj);
 }
 
@@ -23,6 +23,7 @@
 
 #include "ipt_utils.h"
 
+#include "fwbuilder/AttributeStore.h"
 #include "fwbuilder/FWObjectDatabase.h"
 #include "fwbuilder/Firewall.h"
 #include "fwbuilder/IPv4.h"
@@ -43,6 +44,18 @@ using namespace fwcompiler;
 using namespace std;
 
 
+const AttributeKey& iptChainKey()
+{
+    static AttributeKey key("ipt_chain");
+    return key;
+}
+
+const AttributeKey& iptTargetKey()
+{
+    static AttributeKey key("ipt_target");
+    return key;
+}
+
 void build_interface_groups(
     FWObjectDatabase *dbcopy, Library *persistent_objects, Firewall *fw, bool ipv6,
     QMap<QString, libfwbuilder::FWObject*> &regular_interfaces)
@@ -27,6 +27,7 @@
 
 namespace libfwbuilder
 {
+    class AttributeKey;
     class FWObject;
     class FWObjectDatabase;
     class Firewall;
@@ -54,3 +55,12 @@ extern void expand_interface_with_phys_address(
     libfwbuilder::Interface *iface,
     std::list<libfwbuilder::FWObject*> &list_temp,
     std::list<libfwbuilder::FWObject*> &list_result);
+
+
+/*
+ * keys of the attributes that rule processors read and write most
+ * often; using them instead of attribute names avoids looking up the
+ * name on every call
+ */
+extern const libfwbuilder::AttributeKey& iptChainKey();
+extern const libfwbuilder::AttributeKey& iptTargetKey();
@@ -130,11 +130,13 @@ const InetAddr* Address::getBroadcastAddressPtr() const
 
 void Address::setAddress(const InetAddr& a)
 {
+    _aboutToChange();
     inet_addr_mask->setAddress(a);
 }
 
 void Address::setNetmask(const InetAddr& nm)
 {
+    _aboutToChange();
     inet_addr_mask->setNetmask(nm);
 }
 
@@ -49,8 +49,10 @@ class AddressRange : public Address
     const InetAddr &getRangeStart() const { return start_address; }
     const InetAddr &getRangeEnd() const   { return end_address;   }
 
-    void setRangeStart(const InetAddr &o) { start_address = o; }
-    void setRangeEnd(const InetAddr &o)   { end_address = o;   }
+    void setRangeStart(const InetAddr &o)
+    { _aboutToChange(); start_address = o; }
+    void setRangeEnd(const InetAddr &o)
+    { _aboutToChange(); end_address = o; }
 
     /**
      * virtual methods inherited from Address
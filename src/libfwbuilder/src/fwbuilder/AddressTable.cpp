@@ -30,6 +30,7 @@
 
 
 #include "fwbuilder/AddressTable.h"
+#include "fwbuilder/AddressTableLoader.h"
 #include "fwbuilder/FWException.h"
 #include "fwbuilder/FWObjectReference.h"
 #include "fwbuilder/FWObjectDatabase.h"
@@ -117,11 +118,13 @@ string AddressTable::getFilename(FWOptions *options) throw (FWException)
 
 /*
  * read file specified by the "filename" attribute and interpret lines
- * as addresses. Create corresponding address or network objects, add
- * them to the object database and add references to them to @this. If
- * file does not exist and we run in test mode, create dummy object
- * and add it to the database and referece to it, then throw
- * exception.
+ * as addresses. Addresses are stored in the prefix array in the order
+ * they appear in the file; the file is read by AddressTableLoader,
+ * which caches parsed tables. Call materialize() to create corresponding
+ * network objects in the object database and add references to them
+ * to @this. If file does not exist and we run in test mode, create
+ * dummy object and add it to the database and referece to it, then
+ * throw exception.
  *
  * TODO: new objects should be added to some kind of special group in
  * the object tree, something with the name "tmp" or similar.
@@ -130,88 +133,12 @@ void AddressTable::loadFromSource(bool ipv6, FWOptions *options,
                                   bool test_mode) throw(FWException)
 {
     string path = getFilename(options);
-    ifstream fs(path.c_str());
     ostringstream exmess;
-    string buf;
-    size_type pos;
-    int line = 1;
-    int cntr = 0;
-
     Address *new_addr;
 
-    if(fs)
-    {
-       while(!fs.eof())
-       {
-            getline(fs,buf);
+    clearPrefixes(ipv6);
 
-            pos = buf.find_first_not_of(" \t");
-            if (pos!=string::npos)
-            {
-                buf = buf.substr(pos);
-                pos = buf.find_first_not_of("0123456789abcdef:/.");
-                buf = buf.substr(0,pos);
-            }
-            else
-            {
-                buf="";
-            }
-            if (!buf.empty())
-            {
-                new_addr = NULL;
-                if (ipv6 && buf.find(":")!=string::npos)
-                {
-                    try
-                    {
-                        InetAddr(AF_INET6, buf); // to test address
-
-                        NetworkIPv6 *net = getRoot()->createNetworkIPv6();
-                        net->setAddressNetmask(buf);
-                        new_addr = net;
-                    } catch (FWException &ex)
-                    {
-                        exmess << "Invalid address: "
-                               << path << ":"
-                               << line
-                               << " \"" << buf << "\"";
-                        throw FWException(exmess.str());
-                    }
-                }
-
-                if (!ipv6 && buf.find(".")!=string::npos)
-                {
-                    try
-                    {
-                        InetAddr(AF_INET, buf); // to test address
-
-                        Network *net = getRoot()->createNetwork();
-                        net->setAddressNetmask(buf);
-                        new_addr = net;
-                    } catch (FWException &ex)
-                    {
-                        exmess << "Invalid address: "
-                               << path << ":"
-                               << line
-                               << " \"" << buf << "\"";
-                        throw FWException(exmess.str());
-                    }
-                }
-
-                if (new_addr)
-                {
-                    new_addr->setName(buf);
-                    if (validateChild(new_addr))
-                    {
-                        getRoot()->add(new_addr);
-                        addRef(new_addr);
-                        cntr++;
-                    }
-                }
-            }
-            line++;
-       }
-    }
-    else
+    if (!AddressTableLoader::load(path, ipv6, prefixes))
     {
         // in test mode we use dummy address but still throw exception.
         // Compiler should print error message but continue.
@@ -232,12 +159,11 @@ void AddressTable::loadFromSource(bool ipv6, FWOptions *options,
                 net->setAddressNetmask("192.0.2.0/24");
                 new_addr = net;
             }
-            new_addr->setName(buf);
+            new_addr->setName("");
             if (validateChild(new_addr))
             {
                 getRoot()->add(new_addr);
                 addRef(new_addr);
-                cntr++;
             }
             new_addr->setBool(".rule_error", true);
             new_addr->setStr(".error_msg", exmess.str());
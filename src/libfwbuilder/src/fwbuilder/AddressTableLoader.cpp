@@ -0,0 +1,421 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  $Id$
+
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#include "config.h"
+#include "fwbuilder/libfwbuilder-config.h"
+
+#include "fwbuilder/AddressTableLoader.h"
+#include "fwbuilder/InetAddrParser.h"
+#include "fwbuilder/MappedFile.h"
+#include "fwbuilder/ThreadTools.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#ifndef _WIN32
+#  include <unistd.h>
+#else
+#  include <process.h>
+#  define getpid _getpid
+#endif
+
+#include <map>
+#include <sstream>
+#include <vector>
+
+using namespace std;
+using namespace libfwbuilder;
+
+
+/*
+ * files smaller than this are parsed by the calling thread
+ */
+static const size_t MIN_CHUNK_SIZE = 256 * 1024;
+static const int MAX_CHUNKS = 16;
+
+static Mutex loader_mutex;
+static string cache_directory;
+static int max_threads = 0;
+
+struct CacheEntry
+{
+    off_t size;
+    time_t mtime;
+    // time when the file was examined, mtime of the file can be
+    // trusted only if it is older than this
+    time_t checked;
+    uint64_t hash;
+    PrefixArray prefixes;
+};
+
+typedef map<pair<string, bool>, CacheEntry> cache_map;
+static cache_map memory_cache;
+
+
+/*
+ * Part of the file parsed by one thread. Parsing stops at the first
+ * invalid line, addresses found before it are kept.
+ */
+struct ChunkJob
+{
+    const char *begin;
+    const char *end;
+    bool ipv6;
+
+    PrefixArray prefixes;
+    int lines;
+
+    InetAddrParser::Status status;
+    int error_line;
+    size_t error_pos;
+    string error_text;
+
+    void parse();
+};
+
+static bool address_chars[256];
+
+static void init_address_chars()
+{
+    const char *chars = "0123456789abcdef:/.";
+    for (const char *c=chars; *c; ++c) address_chars[(unsigned char)(*c)] = true;
+}
+
+/*
+ * Interpretation of a line is the same as it has always been: leading
+ * white space is skipped, the address is the longest sequence of
+ * characters that can appear in an address or netmask, the rest of
+ * the line is ignored. Lines without ':' (ipv6) or '.' (ipv4) in the
+ * address are skipped.
+ */
+void ChunkJob::parse()
+{
+    int af = (ipv6) ? AF_INET6 : AF_INET;
+    char family_char = (ipv6) ? ':' : '.';
+
+    lines = 0;
+    status = InetAddrParser::OK;
+
+    const char *p = begin;
+    while (p < end)
+    {
+        const char *nl = (const char*)(memchr(p, '\n', end - p));
+        const char *eol = (nl != NULL) ? nl : end;
+
+        while (p < eol && (*p == ' ' || *p == '\t')) p++;
+        const char *tok_end = p;
+        while (tok_end < eol && address_chars[(unsigned char)(*tok_end)])
+            tok_end++;
+        size_t len = tok_end - p;
+
+        if (len > 0 && memchr(p, family_char, len) != NULL)
+        {
+            InetAddr addr;
+            InetAddr netmask;
+            size_t pos = 0;
+            InetAddrParser::Status s = InetAddrParser::parseAddressMask(
+                af, p, len, addr, netmask, &pos);
+
+            PrefixArray::Notation notation = PrefixArray::BARE;
+            const char *slash = (const char*)(memchr(p, '/', len));
+            if (slash != NULL)
+            {
+                if (memchr(slash, '.', tok_end - slash) != NULL)
+                    notation = PrefixArray::NETMASK;
+                else
+                    notation = PrefixArray::LENGTH;
+            }
+
+            if (s == InetAddrParser::OK &&
+                !prefixes.add(addr, netmask, notation, p, len))
+            {
+                s = InetAddrParser::INVALID_NETMASK;
+                pos = (slash != NULL) ? size_t(slash - p + 1) : 0;
+            }
+
+            if (s != InetAddrParser::OK)
+            {
+                status = s;
+                error_line = lines;
+                error_pos = pos;
+                error_text = string(p, len);
+                return;
+            }
+        }
+
+        if (nl == NULL) break;
+        lines++;
+        p = nl + 1;
+    }
+}
+
+static void* parse_chunk_thread(void *arg)
+{
+    ((ChunkJob*)(arg))->parse();
+    return NULL;
+}
+
+static int number_of_threads()
+{
+    loader_mutex.lock();
+    int n = max_threads;
+    loader_mutex.unlock();
+    if (n > 0) return n;
+#ifdef _SC_NPROCESSORS_ONLN
+    n = int(sysconf(_SC_NPROCESSORS_ONLN));
+#endif
+    return (n > 0) ? n : 1;
+}
+
+/*
+ * splits the data at line boundaries and parses chunks in parallel.
+ * Throws FWException if there is an invalid line, after adding
+ * addresses that precede it to res.
+ */
+static void parse_file(const string &path, const char *data, size_t size,
+                       bool ipv6, PrefixArray &res) throw(FWException)
+{
+    static pthread_once_t init_once = PTHREAD_ONCE_INIT;
+    pthread_once(&init_once, init_address_chars);
+
+    int n_chunks = int(size / MIN_CHUNK_SIZE);
+    int n_threads = number_of_threads();
+    if (n_chunks > n_threads) n_chunks = n_threads;
+    if (n_chunks > MAX_CHUNKS) n_chunks = MAX_CHUNKS;
+    if (n_chunks < 1) n_chunks = 1;
+
+    vector<ChunkJob> jobs(n_chunks);
+    const char *end = data + size;
+    const char *p = data;
+    for (int i=0; i<n_chunks; ++i)
+    {
+        const char *chunk_end = data + size / n_chunks * (i + 1);
+        if (i == n_chunks - 1 || chunk_end >= end) chunk_end = end;
+        else
+        {
+            const char *nl = (const char*)(memchr(chunk_end, '\n',
+                                                  end - chunk_end));
+            chunk_end = (nl != NULL) ? nl + 1 : end;
+        }
+        if (chunk_end < p) chunk_end = p;
+        jobs[i].begin = p;
+        jobs[i].end = chunk_end;
+        jobs[i].ipv6 = ipv6;
+        p = chunk_end;
+    }
+
+    vector<pthread_t> threads(n_chunks);
+    vector<bool> started(n_chunks, false);
+    for (int i=1; i<n_chunks; ++i)
+        started[i] = (pthread_create(&threads[i], NULL,
+                                     parse_chunk_thread, &jobs[i]) == 0);
+    jobs[0].parse();
+    for (int i=1; i<n_chunks; ++i)
+    {
+        if (started[i]) pthread_join(threads[i], NULL);
+        else jobs[i].parse();
+    }
+
+    int line = 1;
+    for (int i=0; i<n_chunks; ++i)
+    {
+        ChunkJob &job = jobs[i];
+        res.append(job.prefixes);
+        if (job.status != InetAddrParser::OK)
+        {
+            ostringstream exmess;
+            exmess << "Invalid address: "
+                   << path << ":"
+                   << line + job.error_line
+                   << " \"" << job.error_text << "\": "
+                   << InetAddrParser::statusString(job.status)
+                   << " at position " << job.error_pos + 1;
+            throw FWException(exmess.str());
+        }
+        line += job.lines;
+    }
+}
+
+static string disk_cache_file(const string &dir, uint64_t hash, bool ipv6)
+{
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%016llx", (unsigned long long)(hash));
+    return dir + "/" + buf + ((ipv6) ? ".v6" : ".v4");
+}
+
+static bool read_disk_cache(const string &file_name, PrefixArray &res)
+{
+    FILE *f = fopen(file_name.c_str(), "rb");
+    if (f == NULL) return false;
+    bool ok = res.read(f);
+    fclose(f);
+    return ok;
+}
+
+/*
+ * the file is written under a temporary name and renamed so that a
+ * program running at the same time never sees it incomplete. Errors
+ * are ignored, the table will be parsed again next time.
+ */
+static void write_disk_cache(const string &file_name, const PrefixArray &pa)
+{
+    ostringstream tmp_name;
+    tmp_name << file_name << "." << getpid() << ".tmp";
+    FILE *f = fopen(tmp_name.str().c_str(), "wb");
+    if (f == NULL) return;
+    bool ok = pa.write(f);
+    ok = (fclose(f) == 0) && ok;
+    if (ok)
+    {
+// on windows rename fails if target file already exists
+        unlink(file_name.c_str());
+        ok = (rename(tmp_name.str().c_str(), file_name.c_str()) == 0);
+    }
+    if (!ok) unlink(tmp_name.str().c_str());
+}
+
+
+uint64_t AddressTableLoader::hash(const char *data, size_t len)
+{
+    uint64_t h = 14695981039346656037ULL;
+    const unsigned char *p = (const unsigned char*)(data);
+    const unsigned char *end = p + len;
+    for ( ; p < end; ++p)
+    {
+        h ^= *p;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+bool AddressTableLoader::load(const string &path, bool ipv6, PrefixArray &res)
+    throw(FWException)
+{
+    pair<string, bool> key(path, ipv6);
+    time_t now = time(NULL);
+
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) return false;
+
+    loader_mutex.lock();
+    cache_map::iterator it = memory_cache.find(key);
+    if (it != memory_cache.end() &&
+        it->second.size == st.st_size &&
+        it->second.mtime == st.st_mtime &&
+        it->second.mtime < it->second.checked)
+    {
+        res.append(it->second.prefixes);
+        loader_mutex.unlock();
+        return true;
+    }
+    string dir = cache_directory;
+    loader_mutex.unlock();
+
+    MappedFile file;
+    if (!file.open(path)) return false;
+    uint64_t h = hash(file.data, file.size);
+
+    CacheEntry entry;
+    entry.size = st.st_size;
+    entry.mtime = st.st_mtime;
+    entry.checked = now;
+    entry.hash = h;
+
+    bool found = false;
+    loader_mutex.lock();
+    it = memory_cache.find(key);
+    if (it != memory_cache.end() && it->second.hash == h)
+    {
+        it->second.size = entry.size;
+        it->second.mtime = entry.mtime;
+        it->second.checked = entry.checked;
+        res.append(it->second.prefixes);
+        found = true;
+    }
+    loader_mutex.unlock();
+    if (found) return true;
+
+    string cache_file;
+    if (!dir.empty())
+    {
+        cache_file = disk_cache_file(dir, h, ipv6);
+        found = read_disk_cache(cache_file, entry.prefixes);
+    }
+
+    if (!found)
+    {
+        // results of files with errors are not cached
+        try
+        {
+            parse_file(path, file.data, file.size, ipv6, entry.prefixes);
+        } catch (FWException&)
+        {
+            res.append(entry.prefixes);
+            throw;
+        }
+        if (!cache_file.empty()) write_disk_cache(cache_file, entry.prefixes);
+    }
+
+    res.append(entry.prefixes);
+
+    loader_mutex.lock();
+    memory_cache[key] = entry;
+    loader_mutex.unlock();
+    return true;
+}
+
+void AddressTableLoader::setCacheDirectory(const string &dir)
+{
+    loader_mutex.lock();
+    cache_directory = dir;
+    loader_mutex.unlock();
+}
+
+string AddressTableLoader::getCacheDirectory()
+{
+    loader_mutex.lock();
+    string res = cache_directory;
+    loader_mutex.unlock();
+    return res;
+}
+
+void AddressTableLoader::setMaxThreads(int n)
+{
+    loader_mutex.lock();
+    max_threads = n;
+    loader_mutex.unlock();
+}
+
+void AddressTableLoader::clearCache()
+{
+    loader_mutex.lock();
+    memory_cache.clear();
+    loader_mutex.unlock();
+}
@@ -0,0 +1,95 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  $Id$
+
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#ifndef  __ADDRESSTABLELOADER_HH_FLAG__
+#define  __ADDRESSTABLELOADER_HH_FLAG__
+
+#include <string>
+
+#include "fwbuilder/FWException.h"
+#include "fwbuilder/PrefixArray.h"
+
+
+namespace libfwbuilder
+{
+
+/**
+ * Reads address table files for AddressTable::loadFromSource().
+ *
+ * The file is mapped into memory and, if it is large, split into
+ * chunks at line boundaries that are parsed by several threads at
+ * once. Results are kept in a process-wide cache keyed by the path
+ * and address family and validated by the size and modification time
+ * of the file and, when these can not be trusted, by the hash of its
+ * contents. The preprocessor loads the same tables for every firewall
+ * and for both ipv4 and ipv6 runs, all but the first load of each
+ * table come from the cache.
+ *
+ * If cache directory is set, parsed tables are also saved there in
+ * binary form, in files named after the content hash, so that the
+ * next run of the program does not have to parse them either.
+ */
+class AddressTableLoader
+{
+public:
+
+    /**
+     * appends addresses of the given family read from the file to
+     * res. Returns false if the file can not be opened. Throws
+     * FWException if the file has a line that is not a valid
+     * address; addresses that precede this line are still appended
+     * to res.
+     */
+    static bool load(const std::string &path, bool ipv6, PrefixArray &res)
+        throw(FWException);
+
+    /**
+     * directory for the on-disk cache, empty string (the default)
+     * disables it. The directory must exist.
+     */
+    static void setCacheDirectory(const std::string &dir);
+    static std::string getCacheDirectory();
+
+    /**
+     * maximum number of threads used to parse one file. 0 (the
+     * default) means the number of processors.
+     */
+    static void setMaxThreads(int n);
+
+    /**
+     * drops the in-memory cache
+     */
+    static void clearCache();
+
+    /**
+     * 64 bit FNV-1a hash used to identify file contents
+     */
+    static uint64_t hash(const char *data, size_t len);
+};
+
+}
+
+#endif
@@ -72,45 +72,15 @@ xmlNodePtr AttachedNetworks::toXML(xmlNodePtr parent) throw(FWException)
 }
 
 
-void AttachedNetworks::addNetworkObject(const InetAddrMask &addr_mask)
+string AttachedNetworks::getMaterializedName(int af, size_t n) const
 {
-    const InetAddr *ip_addr = addr_mask.getAddressPtr();
-    const InetAddr *ip_netm = addr_mask.getNetmaskPtr();
-
-    FWObject *new_obj = NULL;
-
-    if (ip_addr->isV4())
-    {
-        Network *net = getRoot()->createNetwork();
-        net->setAddress(*ip_addr);
-        net->setNetmask(*ip_netm);
-        ostringstream str;
-        str << "net-" << ip_addr->toString() << "/" << ip_netm->toString();
-        net->setName(str.str());
-        new_obj = net;
-    }
-
-    if (ip_addr->isV6())
-    {
-        NetworkIPv6 *net = getRoot()->createNetworkIPv6();
-        net->setAddress(*ip_addr);
-        net->setNetmask(*ip_netm);
-        ostringstream str;
-        str << "net-" << ip_addr->toString() << "/" << ip_netm->getLength();
-        net->setName(str.str());
-        new_obj = net;
-    }
-
-    if (validateChild(new_obj))
-    {
-        getRoot()->add(new_obj);
-        addRef(new_obj);
-    }
+    return "net-" + prefixes.toString(af, n);
 }
 
 /*
- * Read addresses of the parent interface and build a group of
- * corresponding networks.
+ * Read addresses of the parent interface and build a list of
+ * corresponding networks. Call materialize() to turn it into a group
+ * of network objects.
  */
 void AttachedNetworks::loadFromSource(bool ipv6, FWOptions*, bool)
     throw(FWException)
@@ -140,9 +110,14 @@ void AttachedNetworks::loadFromSource(bool ipv6, FWOptions*, bool)
         networks[net.str()] = InetAddrMask(*ip_net_addr, *ip_netm);
     }
 
+    clearPrefixes(ipv6);
+
     for (map<string, InetAddrMask>::iterator it=networks.begin(); it!=networks.end(); ++it)
     {
-        addNetworkObject(it->second);
+        prefixes.add(*(it->second.getAddressPtr()),
+                     *(it->second.getNetmaskPtr()),
+                     (ipv6) ? PrefixArray::LENGTH : PrefixArray::NETMASK,
+                     it->first.data(), it->first.size());
     }
 }
 
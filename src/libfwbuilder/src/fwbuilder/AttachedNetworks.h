@@ -32,9 +32,9 @@ namespace libfwbuilder
 
 class AttachedNetworks : public MultiAddress
 {
-    private:
-    
-    void addNetworkObject(const InetAddrMask &addr_mask);
+    protected:
+
+    virtual std::string getMaterializedName(int af, size_t n) const;
     
     public:
 
@@ -0,0 +1,519 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  $Id$
+
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#include "config.h"
+#include "fwbuilder/libfwbuilder-config.h"
+
+#include "fwbuilder/AttributeStore.h"
+#include "fwbuilder/ThreadTools.h"
+#include "fwbuilder/Tools.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <map>
+#include <deque>
+#include <algorithm>
+
+using namespace std;
+using namespace libfwbuilder;
+
+
+/*
+ * Dictionary of attribute names. Names are never removed from it,
+ * so ids stay valid for the lifetime of the program and can be
+ * shared by all FWObjectDatabase objects. Names are stored in a
+ * deque so that references returned by AttributeKey::name() do not
+ * move when new names are added.
+ *
+ * Attribute names are looked up every time getStr() or setStr() is
+ * called with a string, so lookups do not lock the dictionary. They
+ * use an immutable snapshot of it (a vector sorted by name plus
+ * vectors indexed by id) that is replaced, never modified, when new
+ * names have been registered. A name or id that is not in the
+ * snapshot is looked up under the mutex. The snapshot is rebuilt
+ * after SNAPSHOT_REBUILD_MISSES such lookups found the name, so it
+ * catches up with new names quickly without being rebuilt for each
+ * of them while a data file or a compiler registers names in bulk.
+ * Old snapshots can still be in use by other threads and are never
+ * freed; there are only as many of them as there were batches of
+ * new attribute names.
+ *
+ * The dictionary is created on first use because AttributeKey
+ * objects can be static members of other translation units.
+ */
+static const int SNAPSHOT_REBUILD_MISSES = 256;
+
+class AttributeKeySnapshot
+{
+public:
+    vector< pair<const string*, int> > ids;
+    vector<const string*> names;
+    vector<bool> internal;
+};
+
+class SnapshotNameLess
+{
+public:
+    bool operator()(const pair<const string*, int> &a,
+                    const pair<const string*, int> &b) const
+    { return *(a.first) < *(b.first); }
+    bool operator()(const pair<const string*, int> &a,
+                    const string &name) const
+    { return *(a.first) < name; }
+};
+
+class AttributeKeyRegistry
+{
+public:
+    Mutex mutex;
+    map<string, int> ids;
+    deque<string> names;
+    deque<bool> internal;
+
+    AttributeKeySnapshot * volatile snapshot;
+    vector<AttributeKeySnapshot*> old_snapshots;
+    int misses;
+
+    AttributeKeyRegistry() : snapshot(new AttributeKeySnapshot()), misses(0) {}
+
+    // mutex must be locked
+    int find(const string &name)
+    {
+        map<string, int>::iterator it = ids.find(name);
+        return (it != ids.end()) ? it->second : -1;
+    }
+
+    // mutex must be locked
+    void missed();
+};
+
+void AttributeKeyRegistry::missed()
+{
+    if (++misses < SNAPSHOT_REBUILD_MISSES) return;
+    misses = 0;
+    if (snapshot->names.size() == names.size()) return;
+
+    AttributeKeySnapshot *s = new AttributeKeySnapshot();
+    s->ids.reserve(names.size());
+    s->names.reserve(names.size());
+    s->internal.reserve(names.size());
+    for (size_t i=0; i<names.size(); ++i)
+    {
+        s->ids.push_back(make_pair(&(names[i]), int(i)));
+        s->names.push_back(&(names[i]));
+        s->internal.push_back(internal[i]);
+    }
+    std::sort(s->ids.begin(), s->ids.end(), SnapshotNameLess());
+
+    // the snapshot must be complete before other threads can see it
+    __sync_synchronize();
+    old_snapshots.push_back((AttributeKeySnapshot*)(snapshot));
+    snapshot = s;
+}
+
+static AttributeKeyRegistry& registry()
+{
+    static AttributeKeyRegistry *reg = new AttributeKeyRegistry();
+    return *reg;
+}
+
+static int findInSnapshot(const AttributeKeySnapshot *s, const string &name)
+{
+    vector< pair<const string*, int> >::const_iterator it =
+        std::lower_bound(s->ids.begin(), s->ids.end(), name,
+                         SnapshotNameLess());
+    if (it != s->ids.end() && *(it->first) == name) return it->second;
+    return -1;
+}
+
+int AttributeKey::intern(const string &name)
+{
+    AttributeKeyRegistry &reg = registry();
+    int res = findInSnapshot(reg.snapshot, name);
+    if (res >= 0) return res;
+
+    reg.mutex.lock();
+    res = reg.find(name);
+    if (res < 0)
+    {
+        res = int(reg.names.size());
+        reg.names.push_back(name);
+        reg.internal.push_back(!name.empty() && name[0] == '.');
+        reg.ids[name] = res;
+    }
+    reg.missed();
+    reg.mutex.unlock();
+    return res;
+}
+
+int AttributeKey::lookup(const string &name)
+{
+    AttributeKeyRegistry &reg = registry();
+    int res = findInSnapshot(reg.snapshot, name);
+    if (res >= 0) return res;
+
+    reg.mutex.lock();
+    res = reg.find(name);
+    if (res >= 0) reg.missed();
+    reg.mutex.unlock();
+    return res;
+}
+
+const string& AttributeKey::name(int key_id)
+{
+    AttributeKeyRegistry &reg = registry();
+    const AttributeKeySnapshot *s = reg.snapshot;
+    if (key_id < int(s->names.size())) return *(s->names[key_id]);
+
+    reg.mutex.lock();
+    const string &res = reg.names[key_id];
+    reg.missed();
+    reg.mutex.unlock();
+    return res;
+}
+
+bool AttributeKey::isInternal(int key_id)
+{
+    AttributeKeyRegistry &reg = registry();
+    const AttributeKeySnapshot *s = reg.snapshot;
+    if (key_id < int(s->internal.size())) return s->internal[key_id];
+
+    reg.mutex.lock();
+    bool res = reg.internal[key_id];
+    reg.missed();
+    reg.mutex.unlock();
+    return res;
+}
+
+int AttributeKey::count()
+{
+    AttributeKeyRegistry &reg = registry();
+    reg.mutex.lock();
+    int res = int(reg.names.size());
+    reg.mutex.unlock();
+    return res;
+}
+
+
+/*
+ * Integer and boolean interpretation of the string value. This
+ * reproduces what FWObject::getInt() and FWObject::getBool() used to
+ * do on every call: white space anywhere in the value is ignored.
+ */
+void AttributeStore::Slot::parse()
+{
+    const char *ws = " \n\r\t";
+    if (value.find_first_of(ws) == string::npos)
+    {
+        int_value = (value.empty()) ? -1 : int(atol(value.c_str()));
+        bool_value = (value == "1" ||
+                      cxx_strcasecmp(value.c_str(), "true") == 0);
+        return;
+    }
+
+    string val;
+    val.reserve(value.size());
+    for (string::const_iterator i=value.begin(); i!=value.end(); ++i)
+        if (strchr(ws, *i) == NULL) val.push_back(*i);
+
+    int_value = (val.empty()) ? -1 : int(atol(val.c_str()));
+    bool_value = (val == "1" || cxx_strcasecmp(val.c_str(), "true") == 0);
+}
+
+bool AttributeStore::Slot::setValue(const string &v)
+{
+    if (value == v) return false;
+    value = v;
+    parse();
+    return true;
+}
+
+bool AttributeStore::Slot::setIntValue(int v)
+{
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%d", v);
+    if (value == buf) return false;
+    value = buf;
+    int_value = v;
+    bool_value = (v == 1);
+    return true;
+}
+
+bool AttributeStore::Slot::setBoolValue(bool v)
+{
+    const char *str = (v) ? "True" : "False";
+    if (value == str) return false;
+    value = str;
+    int_value = 0;
+    bool_value = v;
+    return true;
+}
+
+
+/*
+ * Pool of slots. Every thread keeps its own list of free slots and
+ * exchanges them with the shared list in batches of SLOT_BATCH, so
+ * the mutex is locked at most once per SLOT_BATCH allocations or
+ * deallocations. When the shared list is empty, a chunk of
+ * SLOTS_PER_CHUNK slots is allocated at once. Chunks are never
+ * returned to the system, memory of deleted objects is reused for
+ * new ones. Free slots cached by a thread go back to the shared
+ * list when the thread exits.
+ */
+static const int SLOTS_PER_CHUNK = 256;
+static const int SLOT_BATCH = 64;
+
+class FreeSlot
+{
+public:
+    FreeSlot *next;
+};
+
+class SlotPool
+{
+public:
+    Mutex mutex;
+    FreeSlot *free_list;
+
+    SlotPool() : free_list(NULL) {}
+};
+
+static SlotPool& slotPool()
+{
+    static SlotPool *pool = new SlotPool();
+    return *pool;
+}
+
+static __thread FreeSlot *thread_free_list = NULL;
+static __thread int thread_free_count = 0;
+
+static pthread_key_t thread_exit_key;
+static pthread_once_t thread_exit_key_once = PTHREAD_ONCE_INIT;
+
+/*
+ * called when a thread that has allocated slots exits; __thread
+ * variables of the thread are still valid at this point
+ */
+static void returnThreadFreeList(void*)
+{
+    if (thread_free_list == NULL) return;
+    FreeSlot *last = thread_free_list;
+    while (last->next != NULL) last = last->next;
+    SlotPool &pool = slotPool();
+    pool.mutex.lock();
+    last->next = pool.free_list;
+    pool.free_list = thread_free_list;
+    pool.mutex.unlock();
+    thread_free_list = NULL;
+    thread_free_count = 0;
+}
+
+static void createThreadExitKey()
+{
+    pthread_key_create(&thread_exit_key, returnThreadFreeList);
+}
+
+static void refillThreadFreeList()
+{
+    // the value only makes the key call returnThreadFreeList() on
+    // thread exit
+    pthread_once(&thread_exit_key_once, createThreadExitKey);
+    if (pthread_getspecific(thread_exit_key) == NULL)
+        pthread_setspecific(thread_exit_key, &thread_exit_key);
+
+    SlotPool &pool = slotPool();
+    pool.mutex.lock();
+    if (pool.free_list == NULL)
+    {
+        size_t size = sizeof(AttributeStore::Slot);
+        char *chunk = (char*)(::operator new(size * SLOTS_PER_CHUNK));
+        for (int i=SLOTS_PER_CHUNK-1; i>=0; --i)
+        {
+            FreeSlot *b = (FreeSlot*)(chunk + i * size);
+            b->next = thread_free_list;
+            thread_free_list = b;
+        }
+        thread_free_count += SLOTS_PER_CHUNK;
+    } else
+    {
+        for (int i=0; i<SLOT_BATCH && pool.free_list!=NULL; ++i)
+        {
+            FreeSlot *b = pool.free_list;
+            pool.free_list = b->next;
+            b->next = thread_free_list;
+            thread_free_list = b;
+            thread_free_count++;
+        }
+    }
+    pool.mutex.unlock();
+}
+
+static void drainThreadFreeList()
+{
+    SlotPool &pool = slotPool();
+    pool.mutex.lock();
+    for (int i=0; i<SLOT_BATCH; ++i)
+    {
+        FreeSlot *b = thread_free_list;
+        thread_free_list = b->next;
+        b->next = pool.free_list;
+        pool.free_list = b;
+    }
+    thread_free_count -= SLOT_BATCH;
+    pool.mutex.unlock();
+}
+
+void* AttributeStore::Slot::operator new(size_t)
+{
+    if (thread_free_list == NULL) refillThreadFreeList();
+    FreeSlot *b = thread_free_list;
+    thread_free_list = b->next;
+    thread_free_count--;
+    return b;
+}
+
+void AttributeStore::Slot::operator delete(void *ptr)
+{
+    if (ptr == NULL) return;
+    FreeSlot *b = (FreeSlot*)(ptr);
+    b->next = thread_free_list;
+    thread_free_list = b;
+    if (++thread_free_count > SLOTS_PER_CHUNK + SLOT_BATCH)
+        drainThreadFreeList();
+}
+
+
+class SlotKeyLess
+{
+public:
+    bool operator()(const pair<int, AttributeStore::Slot*> &a, int key) const
+    { return a.first < key; }
+};
+
+class SlotNameLess
+{
+public:
+    bool operator()(const AttributeStore::Slot *a,
+                    const AttributeStore::Slot *b) const
+    { return a->getName() < b->getName(); }
+};
+
+AttributeStore::AttributeStore(const AttributeStore &other)
+{
+    *this = other;
+}
+
+AttributeStore::~AttributeStore()
+{
+    clear();
+}
+
+AttributeStore& AttributeStore::operator=(const AttributeStore &other)
+{
+    if (this == &other) return *this;
+    clear();
+    slots.reserve(other.slots.size());
+    for (const_iterator i=other.slots.begin(); i!=other.slots.end(); ++i)
+        slots.push_back(make_pair(i->first, new Slot(*(i->second))));
+    return *this;
+}
+
+bool AttributeStore::operator==(const AttributeStore &other) const
+{
+    if (slots.size() != other.slots.size()) return false;
+    const_iterator j = other.slots.begin();
+    for (const_iterator i=slots.begin(); i!=slots.end(); ++i, ++j)
+    {
+        if (i->first != j->first) return false;
+        if (i->second->value != j->second->value) return false;
+    }
+    return true;
+}
+
+AttributeStore::slot_list::iterator AttributeStore::lowerBound(int key)
+{
+    return std::lower_bound(slots.begin(), slots.end(), key, SlotKeyLess());
+}
+
+AttributeStore::slot_list::const_iterator AttributeStore::lowerBound(
+    int key) const
+{
+    return std::lower_bound(slots.begin(), slots.end(), key, SlotKeyLess());
+}
+
+const AttributeStore::Slot* AttributeStore::find(int key) const
+{
+    if (key < 0) return NULL;
+    const_iterator i = lowerBound(key);
+    if (i != slots.end() && i->first == key) return i->second;
+    return NULL;
+}
+
+AttributeStore::Slot* AttributeStore::find(int key)
+{
+    if (key < 0) return NULL;
+    slot_list::iterator i = lowerBound(key);
+    if (i != slots.end() && i->first == key) return i->second;
+    return NULL;
+}
+
+AttributeStore::Slot* AttributeStore::findOrCreate(int key)
+{
+    slot_list::iterator i = lowerBound(key);
+    if (i != slots.end() && i->first == key) return i->second;
+    Slot *s = new Slot(key);
+    slots.insert(i, make_pair(key, s));
+    return s;
+}
+
+bool AttributeStore::erase(int key)
+{
+    if (key < 0) return false;
+    slot_list::iterator i = lowerBound(key);
+    if (i == slots.end() || i->first != key) return false;
+    delete i->second;
+    slots.erase(i);
+    return true;
+}
+
+void AttributeStore::clear()
+{
+    for (slot_list::iterator i=slots.begin(); i!=slots.end(); ++i)
+        delete i->second;
+    slots.clear();
+}
+
+void AttributeStore::getSortedByName(vector<const Slot*> &res) const
+{
+    res.clear();
+    res.reserve(slots.size());
+    for (const_iterator i=slots.begin(); i!=slots.end(); ++i)
+        res.push_back(i->second);
+    std::sort(res.begin(), res.end(), SlotNameLess());
+}
@@ -0,0 +1,207 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  $Id$
+
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#ifndef  __ATTRIBUTESTORE_HH_FLAG__
+#define  __ATTRIBUTESTORE_HH_FLAG__
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+#include <utility>
+
+
+namespace libfwbuilder
+{
+
+/**
+ * Interned attribute name. Attribute names are registered in a
+ * process-wide dictionary once and are represented by a small integer
+ * after that. Code that reads the same attribute over and over again
+ * (rule position, "disabled" flag, compiler attributes like
+ * "ipt_chain") should keep a static AttributeKey and use methods of
+ * FWObject that take it instead of the name.
+ */
+class AttributeKey
+{
+    int key_id;
+    bool internal;
+
+public:
+
+    explicit AttributeKey(const std::string &name) :
+        key_id(intern(name)), internal(!name.empty() && name[0] == '.') {}
+    explicit AttributeKey(const char *name) :
+        key_id(intern(name)), internal(name[0] == '.') {}
+
+    int getId() const { return key_id; }
+    const std::string& getName() const { return name(key_id); }
+    bool isInternal() const { return internal; }
+
+    /**
+     * returns id of the attribute name, registering it if necessary
+     */
+    static int intern(const std::string &name);
+
+    /**
+     * returns id of the attribute name or -1 if this name has never
+     * been registered. Never registers new names.
+     */
+    static int lookup(const std::string &name);
+
+    static const std::string& name(int key_id);
+
+    /**
+     * attribute with name that starts with "." is considered "hidden"
+     * or "internal". Such attribute is not saved to the data file and
+     * does not trigger "dirty" flag.
+     */
+    static bool isInternal(int key_id);
+
+    /**
+     * number of attribute names registered so far
+     */
+    static int count();
+};
+
+/**
+ * Storage for object attributes. Attributes are kept in a vector
+ * sorted by interned key id, lookup is a binary search over integers.
+ * String value of an attribute is always stored so that getStr() can
+ * return a reference to it; integer and boolean interpretation of the
+ * value is computed once when the value is assigned rather than on
+ * every read.
+ *
+ * Each value lives in its own slot so that references returned by
+ * FWObject::getStr() stay valid when other attributes are added or
+ * removed, just like they did when attributes were stored in
+ * std::map. Slots are carved from large chunks and recycled through
+ * per-thread free lists rather than allocated one by one on the heap.
+ */
+class AttributeStore
+{
+public:
+
+    class Slot
+    {
+        friend class AttributeStore;
+
+        int key;
+        int int_value;
+        bool bool_value;
+        std::string value;
+
+        void parse();
+
+    public:
+
+        Slot(int k) : key(k), int_value(-1), bool_value(false), value() {}
+
+        static void* operator new(size_t size);
+        static void operator delete(void *ptr);
+
+        int getKey() const { return key; }
+        const std::string& getName() const { return AttributeKey::name(key); }
+        const std::string& getValue() const { return value; }
+
+        /**
+         * value interpreted as integer, the same way
+         * FWObject::getInt() always did it: white space is ignored,
+         * empty value is -1
+         */
+        int getIntValue() const { return int_value; }
+
+        /**
+         * value interpreted as boolean: "1" or "true" (case insensitive)
+         */
+        bool getBoolValue() const { return bool_value; }
+
+        /**
+         * these return true if the string value has changed
+         */
+        bool setValue(const std::string &v);
+        bool setIntValue(int v);
+        bool setBoolValue(bool v);
+    };
+
+    typedef std::vector< std::pair<int, Slot*> > slot_list;
+    typedef slot_list::const_iterator const_iterator;
+
+private:
+
+    slot_list slots;
+
+    slot_list::iterator lowerBound(int key);
+    slot_list::const_iterator lowerBound(int key) const;
+
+public:
+
+    AttributeStore() {}
+    AttributeStore(const AttributeStore &other);
+    ~AttributeStore();
+
+    AttributeStore& operator=(const AttributeStore &other);
+
+    /**
+     * compares keys and string values of all attributes
+     */
+    bool operator==(const AttributeStore &other) const;
+    bool operator!=(const AttributeStore &other) const
+    { return ! (*this == other); }
+
+    /**
+     * returns NULL if attribute is not present
+     */
+    const Slot* find(int key) const;
+    Slot* find(int key);
+
+    /**
+     * returns existing slot or creates new one with empty value
+     */
+    Slot* findOrCreate(int key);
+
+    bool erase(int key);
+    void clear();
+
+    bool empty() const { return slots.empty(); }
+    int size() const { return int(slots.size()); }
+
+    /**
+     * iteration goes in the order of key ids, which is the order in
+     * which attribute names were first seen by the program.
+     */
+    const_iterator begin() const { return slots.begin(); }
+    const_iterator end() const { return slots.end(); }
+
+    /**
+     * fills res with slots sorted by attribute name. Use this where
+     * order matters, e.g. when attributes are written to XML.
+     */
+    void getSortedByName(std::vector<const Slot*> &res) const;
+};
+
+}
+
+#endif
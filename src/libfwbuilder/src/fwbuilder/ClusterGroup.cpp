@@ -72,6 +72,24 @@ void ClusterGroup::replaceReferenceInternal(int old_id, int new_id, int &counter
     }
 }
 
+void ClusterGroup::replaceReferencesInternal(const map<int,int> &id_map,
+                                             int &counter)
+{
+    FWObject::replaceReferencesInternal(id_map, counter);
+
+    string master_iface_id = getStr("master_iface");
+    if (!master_iface_id.empty())
+    {
+        map<int,int>::const_iterator it =
+            id_map.find(FWObjectDatabase::getIntId(master_iface_id));
+        if (it != id_map.end() && it->second != it->first)
+        {
+            setStr("master_iface", FWObjectDatabase::getStringId(it->second));
+            counter++;
+        }
+    }
+}
+
 void ClusterGroup::fromXML(xmlNodePtr parent) throw(FWException)
 {
     FWObject::fromXML(parent);
@@ -131,6 +149,7 @@ FWObject& ClusterGroup::duplicateForUndo(const FWObject *obj) throw(FWException)
 {
     if (ClusterGroup::constcast(obj)==NULL) return *this;
 
+    _aboutToChange();
     setRO(false);
 
     ClusterGroupOptions *their_opts = ClusterGroupOptions::cast(
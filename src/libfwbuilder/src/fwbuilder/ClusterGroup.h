@@ -33,6 +33,8 @@ namespace libfwbuilder
 protected:
 
         virtual void replaceReferenceInternal(int oldfw_id, int newfw_id, int &counter);
+        virtual void replaceReferencesInternal(const std::map<int,int> &id_map,
+                                               int &counter);
 
 public:
         ClusterGroup();
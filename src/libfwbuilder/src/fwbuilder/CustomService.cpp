@@ -175,6 +175,7 @@ bool CustomService::cmp(const FWObject *obj, bool recursive) throw(FWException)
 void  CustomService::setCodeForPlatform(const string& platform,
                                         const string& code)
 {
+    _aboutToChange();
     codes[platform]=code;
 }
 
@@ -198,6 +199,7 @@ list<string> CustomService::getAllKnownPlatforms()
 
 void  CustomService::setProtocol(const string& proto)
 {
+    _aboutToChange();
     protocol = proto;
 }
 
@@ -209,6 +211,7 @@ const string& CustomService::getProtocol()
 
 void  CustomService::setAddressFamily(int af)
 {
+    _aboutToChange();
     address_family = af;
 }
 
@@ -112,7 +112,8 @@ xmlNodePtr DNSName::toXML(xmlNodePtr parent) throw(FWException)
 
 /*
  * take domain name from the "dnsrec" attribute and try to run DNS
- * query. If successful, create corresponding IPv4 or IPv6 object, add
+ * query. Results are taken from the DNS cache if the name has been
+ * resolved recently. If successful, create corresponding IPv4 or IPv6 object, add
  * it to the object database and add reference to it to @this. If
  * unsuccessful, create dummy object and add it to the database and
  * referece to it, then throw exception.
@@ -126,7 +127,7 @@ void DNSName::loadFromSource(bool ipv6, FWOptions *options,
     int af_type = (ipv6)?AF_INET6:AF_INET;
     try
     {
-        list<InetAddr> v = DNS::getHostByName(getSourceName(), af_type);
+        list<InetAddr> v = DNS::getHostByNameCached(getSourceName(), af_type);
         for (list<InetAddr>::iterator i=v.begin(); i!=v.end(); ++i)
         {
             //Address *a = Address::cast(
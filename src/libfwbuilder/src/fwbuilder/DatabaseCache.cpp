@@ -0,0 +1,412 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  $Id$
+
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+
+#include "config.h"
+#include "fwbuilder/libfwbuilder-config.h"
+
+#include "fwbuilder/DatabaseCache.h"
+#include "fwbuilder/AddressTableLoader.h"
+#include "fwbuilder/MappedFile.h"
+#include "fwbuilder/ThreadTools.h"
+#include "fwbuilder/XMLTools.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#ifndef _WIN32
+#  include <unistd.h>
+#else
+#  include <process.h>
+#  define getpid _getpid
+#endif
+
+#include <map>
+#include <sstream>
+#include <vector>
+
+using namespace std;
+using namespace libfwbuilder;
+
+
+static Mutex cache_mutex;
+static string cache_directory;
+
+static const char CACHE_MAGIC[8] = { 'F','W','B','D','B','C','1','\n' };
+static const uint32_t BYTE_ORDER_MARK = 0x01020304;
+static const uint32_t NO_STRING = 0xffffffff;
+
+/*
+ * Layout of the cache file:
+ *
+ *   CacheHeader
+ *   uint32_t string_offsets[n_strings]
+ *   char strings[string_bytes]     NUL terminated, padded to 4 bytes
+ *   CacheElement elements[n_elements]   in document order
+ *   CacheAttribute attributes[n_attributes]
+ *
+ * Numbers are in the byte order of the machine that wrote the file,
+ * files written on a machine with different byte order are ignored.
+ */
+struct CacheHeader
+{
+    char magic[8];
+    uint32_t byte_order;
+    uint32_t header_size;
+    uint64_t source_hash;
+    uint64_t source_size;
+    char xml_version[16];
+    uint32_t n_strings;
+    uint32_t string_bytes;
+    uint32_t n_elements;
+    uint32_t n_attributes;
+};
+
+struct CacheElement
+{
+    uint32_t name;
+    uint32_t first_attribute;
+    uint32_t n_attributes;
+    uint32_t n_children;
+    // contents of elements that have text and no child elements
+    uint32_t text;
+};
+
+struct CacheAttribute
+{
+    uint32_t name;
+    uint32_t value;
+};
+
+
+static string cache_file_name(const string &dir, uint64_t hash)
+{
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%016llx", (unsigned long long)(hash));
+    return dir + "/" + buf + ".fwbc";
+}
+
+
+/*
+ * Collects string table, elements and attributes of the document
+ */
+class CacheWriter
+{
+    map<string, uint32_t> string_index;
+
+public:
+
+    vector<uint32_t> string_offsets;
+    string strings;
+    vector<CacheElement> elements;
+    vector<CacheAttribute> attributes;
+
+    uint32_t addString(const char *str);
+    void addElement(xmlNodePtr node);
+    bool write(FILE *f, const CacheHeader &header);
+};
+
+uint32_t CacheWriter::addString(const char *str)
+{
+    string s = (str) ? str : "";
+    map<string, uint32_t>::iterator it = string_index.find(s);
+    if (it != string_index.end()) return it->second;
+    uint32_t res = uint32_t(string_offsets.size());
+    string_offsets.push_back(uint32_t(strings.size()));
+    strings.append(s);
+    strings.push_back('\0');
+    string_index[s] = res;
+    return res;
+}
+
+void CacheWriter::addElement(xmlNodePtr node)
+{
+    size_t n = elements.size();
+    elements.push_back(CacheElement());
+
+    CacheElement el;
+    el.name = addString(FROMXMLCAST(node->name));
+    el.first_attribute = uint32_t(attributes.size());
+    el.n_attributes = 0;
+    el.n_children = 0;
+    el.text = NO_STRING;
+
+    for (xmlAttrPtr attr=node->properties; attr; attr=attr->next)
+    {
+        xmlChar *value = xmlNodeGetContent((xmlNodePtr)(attr));
+        CacheAttribute a;
+        a.name = addString(FROMXMLCAST(attr->name));
+        a.value = addString(FROMXMLCAST(value));
+        attributes.push_back(a);
+        el.n_attributes++;
+        if (value) xmlFree(value);
+    }
+
+    string text;
+    for (xmlNodePtr cur=node->children; cur; cur=cur->next)
+    {
+        if (cur->type == XML_ELEMENT_NODE)
+        {
+            addElement(cur);
+            el.n_children++;
+        } else if ((cur->type == XML_TEXT_NODE ||
+                    cur->type == XML_CDATA_SECTION_NODE) && cur->content)
+            text += FROMXMLCAST(cur->content);
+    }
+    // text between child elements is only white space
+    if (el.n_children == 0 && !text.empty()) el.text = addString(text.c_str());
+
+    elements[n] = el;
+}
+
+bool CacheWriter::write(FILE *f, const CacheHeader &header)
+{
+    static const char padding[4] = { 0, 0, 0, 0 };
+    size_t pad = header.string_bytes - strings.size();
+
+    if (fwrite(&header, sizeof(header), 1, f) != 1) return false;
+    if (!string_offsets.empty() &&
+        fwrite(&string_offsets[0], sizeof(uint32_t), string_offsets.size(), f)
+        != string_offsets.size()) return false;
+    if (fwrite(strings.data(), 1, strings.size(), f) != strings.size())
+        return false;
+    if (pad > 0 && fwrite(padding, 1, pad, f) != pad) return false;
+    if (!elements.empty() &&
+        fwrite(&elements[0], sizeof(CacheElement), elements.size(), f)
+        != elements.size()) return false;
+    if (!attributes.empty() &&
+        fwrite(&attributes[0], sizeof(CacheAttribute), attributes.size(), f)
+        != attributes.size()) return false;
+    return true;
+}
+
+
+/*
+ * Checks that the cache file is complete and consistent and rebuilds
+ * the document from it. Anything that does not look right makes the
+ * entry unusable, the data file is parsed instead.
+ */
+class CacheReader
+{
+    const char *data;
+    size_t size;
+    CacheHeader header;
+    const uint32_t *string_offsets;
+    const char *strings;
+    const CacheElement *elements;
+    const CacheAttribute *attributes;
+
+    const xmlChar* str(uint32_t n) const
+    { return (const xmlChar*)(strings + string_offsets[n]); }
+
+public:
+
+    CacheReader(const char *_data, size_t _size) : data(_data), size(_size) {}
+
+    bool check(uint64_t source_hash, uint64_t source_size);
+    xmlDocPtr buildDocument();
+};
+
+bool CacheReader::check(uint64_t source_hash, uint64_t source_size)
+{
+    if (size < sizeof(header)) return false;
+    memcpy(&header, data, sizeof(header));
+
+    if (memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 ||
+        header.byte_order != BYTE_ORDER_MARK ||
+        header.header_size != sizeof(header) ||
+        header.source_hash != source_hash ||
+        header.source_size != source_size ||
+        strncmp(header.xml_version, FWBUILDER_XML_VERSION,
+                sizeof(header.xml_version)) != 0) return false;
+
+    uint64_t expected_size = uint64_t(sizeof(header)) +
+        uint64_t(header.n_strings) * sizeof(uint32_t) +
+        uint64_t(header.string_bytes) +
+        uint64_t(header.n_elements) * sizeof(CacheElement) +
+        uint64_t(header.n_attributes) * sizeof(CacheAttribute);
+    if (expected_size != size || header.string_bytes % 4 != 0 ||
+        header.string_bytes == 0 || header.n_elements == 0) return false;
+
+    const char *p = data + sizeof(header);
+    string_offsets = (const uint32_t*)(p);
+    p += size_t(header.n_strings) * sizeof(uint32_t);
+    strings = p;
+    p += header.string_bytes;
+    elements = (const CacheElement*)(p);
+    p += size_t(header.n_elements) * sizeof(CacheElement);
+    attributes = (const CacheAttribute*)(p);
+
+    // every string ends before the end of the table
+    if (strings[header.string_bytes - 1] != '\0') return false;
+    for (uint32_t i=0; i<header.n_strings; ++i)
+        if (string_offsets[i] >= header.string_bytes) return false;
+
+    for (uint32_t i=0; i<header.n_elements; ++i)
+    {
+        const CacheElement &el = elements[i];
+        if (el.name >= header.n_strings ||
+            (el.text != NO_STRING && el.text >= header.n_strings) ||
+            el.first_attribute > header.n_attributes ||
+            el.n_attributes > header.n_attributes - el.first_attribute ||
+            el.n_children >= header.n_elements) return false;
+    }
+    for (uint32_t i=0; i<header.n_attributes; ++i)
+    {
+        if (attributes[i].name >= header.n_strings ||
+            attributes[i].value >= header.n_strings) return false;
+    }
+    return true;
+}
+
+xmlDocPtr CacheReader::buildDocument()
+{
+    xmlDocPtr doc = xmlNewDoc(TOXMLCAST("1.0"));
+
+    // elements that still expect children and how many
+    vector< pair<xmlNodePtr, uint32_t> > parents;
+
+    for (uint32_t i=0; i<header.n_elements; ++i)
+    {
+        const CacheElement &el = elements[i];
+
+        if (i > 0 && parents.empty())
+        {
+            // more than one root element
+            xmlFreeDoc(doc);
+            return NULL;
+        }
+
+        xmlNodePtr node = xmlNewDocNode(doc, NULL, str(el.name), NULL);
+        for (uint32_t a=el.first_attribute;
+             a<el.first_attribute + el.n_attributes; ++a)
+            xmlNewProp(node, str(attributes[a].name), str(attributes[a].value));
+        if (el.text != NO_STRING)
+            xmlAddChild(node, xmlNewDocText(doc, str(el.text)));
+
+        if (i == 0) xmlDocSetRootElement(doc, node);
+        else
+        {
+            xmlAddChild(parents.back().first, node);
+            parents.back().second--;
+        }
+
+        if (el.n_children > 0) parents.push_back(make_pair(node, el.n_children));
+        while (!parents.empty() && parents.back().second == 0)
+            parents.pop_back();
+    }
+
+    if (!parents.empty())
+    {
+        // file ends before all children have been seen
+        xmlFreeDoc(doc);
+        return NULL;
+    }
+    return doc;
+}
+
+
+void DatabaseCache::setCacheDirectory(const string &dir)
+{
+    cache_mutex.lock();
+    cache_directory = dir;
+    cache_mutex.unlock();
+}
+
+string DatabaseCache::getCacheDirectory()
+{
+    cache_mutex.lock();
+    string res = cache_directory;
+    cache_mutex.unlock();
+    return res;
+}
+
+xmlDocPtr DatabaseCache::load(const string &data_file)
+{
+    string dir = getCacheDirectory();
+    if (dir.empty()) return NULL;
+
+    MappedFile source;
+    if (!source.open(data_file)) return NULL;
+    uint64_t hash = AddressTableLoader::hash(source.data, source.size);
+
+    MappedFile cache;
+    if (!cache.open(cache_file_name(dir, hash))) return NULL;
+
+    CacheReader reader(cache.data, cache.size);
+    if (!reader.check(hash, source.size)) return NULL;
+    return reader.buildDocument();
+}
+
+/*
+ * the file is written under a temporary name and renamed so that a
+ * program running at the same time never sees it incomplete.
+ */
+bool DatabaseCache::save(const string &data_file, xmlDocPtr doc)
+{
+    string dir = getCacheDirectory();
+    if (dir.empty()) return false;
+
+    xmlNodePtr root = xmlDocGetRootElement(doc);
+    if (root == NULL) return false;
+
+    MappedFile source;
+    if (!source.open(data_file)) return false;
+
+    CacheWriter writer;
+    writer.addElement(root);
+
+    CacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.byte_order = BYTE_ORDER_MARK;
+    header.header_size = sizeof(header);
+    header.source_hash = AddressTableLoader::hash(source.data, source.size);
+    header.source_size = source.size;
+    strncpy(header.xml_version, FWBUILDER_XML_VERSION,
+            sizeof(header.xml_version) - 1);
+    header.n_strings = uint32_t(writer.string_offsets.size());
+    header.string_bytes = uint32_t((writer.strings.size() + 3) & ~size_t(3));
+    header.n_elements = uint32_t(writer.elements.size());
+    header.n_attributes = uint32_t(writer.attributes.size());
+
+    string file_name = cache_file_name(dir, header.source_hash);
+    ostringstream tmp_name;
+    tmp_name << file_name << "." << getpid() << ".tmp";
+    FILE *f = fopen(tmp_name.str().c_str(), "wb");
+    if (f == NULL) return false;
+    bool ok = writer.write(f, header);
+    ok = (fclose(f) == 0) && ok;
+    if (ok)
+    {
+// on windows rename fails if target file already exists
+        unlink(file_name.c_str());
+        ok = (rename(tmp_name.str().c_str(), file_name.c_str()) == 0);
+    }
+    if (!ok) unlink(tmp_name.str().c_str());
+    return ok;
+}
@@ -0,0 +1,463 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  $Id$
+
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#include "config.h"
+#include "fwbuilder/libfwbuilder-config.h"
+
+#include "fwbuilder/DatabaseSaver.h"
+#include "fwbuilder/FWObjectDatabase.h"
+#include "fwbuilder/FWObjectSnapshot.h"
+#include "fwbuilder/FWReference.h"
+#include "fwbuilder/IntervalGroup.h"
+#include "fwbuilder/Library.h"
+#include "fwbuilder/ObjectGroup.h"
+#include "fwbuilder/ServiceGroup.h"
+#include "fwbuilder/ThreadTools.h"
+#include "fwbuilder/XMLTools.h"
+
+#include <libxml/tree.h>
+#include <libxml/xmlIO.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <set>
+#include <sstream>
+
+using namespace std;
+using namespace libfwbuilder;
+
+
+static const char *FRAGMENT_PI = "fwb-fragment";
+
+/*
+ * Groups that hold references are written as units, otherwise every
+ * reference in every user group would be a unit of its own.
+ */
+static bool isFolder(FWObject *o)
+{
+    const string &type = o->getTypeName();
+    if (type == FWObjectDatabase::TYPENAME || type == Library::TYPENAME)
+        return true;
+    if (type != ObjectGroup::TYPENAME && type != ServiceGroup::TYPENAME &&
+        type != IntervalGroup::TYPENAME)
+        return false;
+    for (FWObject::iterator i=o->begin(); i!=o->end(); ++i)
+        if (FWReference::cast(*i) != NULL) return false;
+    return true;
+}
+
+
+/*
+ * Records ids of objects that changed since the last save together
+ * with ids of all their parents: a change anywhere in the subtree of
+ * a unit makes its text invalid. Ids are recorded right away because
+ * the object may be moved or deleted before the next save. Nothing
+ * is copied, FWObjectSnapshot only serves as a way to get notified.
+ */
+class DatabaseSaver::ChangeLog : public FWObjectSnapshot
+{
+public:
+
+    set<int> changed_ids;
+
+    ChangeLog(FWObjectDatabase *db) : FWObjectSnapshot(db) {}
+    virtual ~ChangeLog() { detach(); }
+
+    virtual void save(FWObject *o)
+    {
+        for ( ; o!=NULL; o=o->getParent()) changed_ids.insert(o->getId());
+    }
+    virtual void detached(FWObject*) {}
+    virtual void destroyed(FWObject *o) { changed_ids.insert(o->getId()); }
+};
+
+
+/*
+ * Stands for a unit in the private copy of the tree. Its XML is a
+ * processing instruction that is replaced with the text of the unit
+ * when the file is written.
+ */
+class SavedFragment : public FWObject
+{
+    int unit_id;
+
+public:
+
+    SavedFragment(int id) : FWObject(), unit_id(id) {}
+
+    virtual xmlNodePtr toXML(xmlNodePtr parent) throw(FWException)
+    {
+        ostringstream str;
+        str << unit_id;
+        xmlNodePtr pi = xmlNewPI(TOXMLCAST(FRAGMENT_PI),
+                                 STRTOXMLCAST(str.str()));
+        return xmlAddChild(parent, pi);
+    }
+};
+
+
+/*
+ * Everything the thread that writes the file needs. The copy of the
+ * tree and the map of fragments are not touched by anybody else
+ * while the job runs.
+ */
+class DatabaseSaver::Job
+{
+public:
+
+    FWObjectDatabase *copy;
+    map<int, Fragment> *fragments;
+    // units converted to XML by this job, by id
+    map<int, FWObject*> units;
+    string file_name;
+    string dtd_file;
+    int compression;
+    int written;
+    int reused;
+
+    SyncFlag done;
+    bool ok;
+    string error;
+
+    Job() : copy(NULL), fragments(NULL),
+            compression(0), written(0), reused(0), done(false), ok(false) {}
+    ~Job() { delete copy; }
+
+    void copyTree(FWObjectDatabase *db);
+    void copyFolder(FWObject *src, FWObject *dst, int level);
+    void run();
+    void cutUnits(xmlDocPtr doc, xmlNodePtr parent, int level);
+    void splice(const char *buf, int size, string &res);
+    void write(const string &text) throw(FWException);
+};
+
+/*
+ * toXML() of some objects (e.g. Management) modifies them, this must
+ * work in read-only libraries of the copy too
+ */
+void DatabaseSaver::Job::copyTree(FWObjectDatabase *db)
+{
+    copy = new FWObjectDatabase();
+    copy->setIgnoreReadOnlyFlag(true);
+    copy->shallowDuplicate(db, false);
+    copyFolder(db, copy, 1);
+    // copying has changed it
+    copy->resetTimeLastModified(db->getTimeLastModified());
+}
+
+void DatabaseSaver::Job::copyFolder(FWObject *src, FWObject *dst, int level)
+{
+    for (FWObject::iterator i=src->begin(); i!=src->end(); ++i)
+    {
+        FWObject *c = *i;
+        if (isFolder(c))
+        {
+            FWObject *n = copy->create(c->getTypeName(), -1, false);
+            dst->add(n, false);
+            n->shallowDuplicate(c, false);
+            copyFolder(c, n, level + 1);
+            continue;
+        }
+
+        int id = c->getId();
+        map<int, Fragment>::iterator f = fragments->find(id);
+        if (id != -1 && f != fragments->end() &&
+            f->second.object == c && f->second.level == level)
+        {
+            dst->add(new SavedFragment(id), false);
+            reused++;
+        } else
+        {
+            dst->addCopyOf(c, false);
+            if (id != -1) units[id] = c;
+            written++;
+        }
+    }
+}
+
+/*
+ * Units that have just been converted to XML are cut out of the
+ * document and replaced with processing instructions like the ones
+ * SavedFragment makes; their text is dumped at the indentation level
+ * they have in the file.
+ */
+void DatabaseSaver::Job::cutUnits(xmlDocPtr doc, xmlNodePtr parent, int level)
+{
+    xmlNodePtr next;
+    for (xmlNodePtr cur=parent->children; cur!=NULL; cur=next)
+    {
+        next = cur->next;
+        if (cur->type != XML_ELEMENT_NODE) continue;
+
+        int id = -1;
+        xmlChar *s_id = xmlGetProp(cur, TOXMLCAST("id"));
+        if (s_id != NULL)
+        {
+            id = FWObjectDatabase::getIntId(FROMXMLCAST(s_id));
+            xmlFree(s_id);
+        }
+        map<int, FWObject*>::iterator u = units.find(id);
+        if (id == -1 || u == units.end())
+        {
+            cutUnits(doc, cur, level + 1);
+            continue;
+        }
+
+        xmlBufferPtr buf = xmlBufferCreate();
+        xmlOutputBufferPtr out = xmlOutputBufferCreateBuffer(buf, NULL);
+        xmlNodeDumpOutput(out, doc, cur, level, 1, "utf-8");
+        xmlOutputBufferClose(out);
+        Fragment &frag = (*fragments)[id];
+        frag.object = u->second;
+        frag.level = level;
+        frag.text.assign(FROMXMLCAST(xmlBufferContent(buf)),
+                           xmlBufferLength(buf));
+        xmlBufferFree(buf);
+
+        ostringstream str;
+        str << id;
+        xmlNodePtr pi = xmlNewPI(TOXMLCAST(FRAGMENT_PI),
+                                 STRTOXMLCAST(str.str()));
+        xmlReplaceNode(cur, pi);
+        xmlFreeNode(cur);
+    }
+}
+
+/*
+ * Processing instructions can not come from the data: "<" in
+ * attribute values and text is always escaped.
+ */
+void DatabaseSaver::Job::splice(const char *buf, int size, string &res)
+{
+    string pi_start = string("<?") + FRAGMENT_PI + " ";
+    const char *end = buf + size;
+    const char *p = buf;
+
+    res.reserve(size);
+    while (p < end)
+    {
+        const char *pi = std::search(p, end, pi_start.begin(), pi_start.end());
+        res.append(p, pi);
+        if (pi == end) break;
+        const char *id_start = pi + pi_start.size();
+        const char *pi_end = strstr(id_start, "?>");
+        int id = atoi(string(id_start, pi_end).c_str());
+        res.append((*fragments)[id].text);
+        p = pi_end + 2;
+    }
+}
+
+void DatabaseSaver::Job::write(const string &text) throw(FWException)
+{
+    xmlOutputBufferPtr out = xmlOutputBufferCreateFilename(
+        file_name.c_str(), NULL, compression);
+    if (out == NULL ||
+        xmlOutputBufferWrite(out, int(text.size()), text.data()) < 0 ||
+        xmlOutputBufferClose(out) < 0)
+        throw FWException("Error saving XML file: " + file_name);
+}
+
+void DatabaseSaver::Job::run()
+{
+    try
+    {
+        xmlDocPtr doc = xmlNewDoc(TOXMLCAST("1.0"));
+        xmlNodePtr node = xmlNewNode(NULL, STRTOXMLCAST(copy->getName()));
+        xmlDocSetRootElement(doc, node);
+        xmlNewNs(node, TOXMLCAST("http://www.fwbuilder.org/1.0/"), NULL);
+
+        copy->toXML(node);
+
+        // without encoding of the document xmlNodeDumpOutput() writes
+        // non-ASCII characters in attribute values as character
+        // references, saveFile() does not
+        doc->encoding = xmlStrdup(TOXMLCAST("utf-8"));
+        cutUnits(doc, node, 1);
+
+        xmlChar *buf = NULL;
+        int size = 0;
+        XMLTools::dumpToMemory(doc, &buf, &size,
+                               FWObjectDatabase::TYPENAME, dtd_file);
+        xmlFreeDoc(doc);
+
+        string text;
+        splice(FROMXMLCAST(buf), size, text);
+        xmlFree(buf);
+
+        write(text);
+        ok = true;
+    } catch (FWException &ex)
+    {
+        error = ex.toString();
+        ok = false;
+    }
+    done.set(true);
+}
+
+void* DatabaseSaver::runJob(void *arg)
+{
+    DatabaseSaver::Job *job = (DatabaseSaver::Job*)arg;
+    job->run();
+    return NULL;
+}
+
+
+DatabaseSaver::DatabaseSaver(FWObjectDatabase *_db) : db(_db)
+{
+    changes = new ChangeLog(db);
+    job = NULL;
+    running = false;
+    written = 0;
+    reused = 0;
+}
+
+DatabaseSaver::~DatabaseSaver()
+{
+    try
+    {
+        finish();
+    } catch (FWException&)
+    {
+    }
+    delete changes;
+}
+
+/*
+ * Runs in the calling thread: drops text of the units that changed
+ * and copies folders and the units that need to be converted to a new
+ * database.
+ */
+DatabaseSaver::Job* DatabaseSaver::prepare(const string &file_name)
+    throw(FWException)
+{
+    if (db->isPartiallyLoaded())
+        throw FWException(
+            "Partially loaded object tree can not be saved to file " +
+            file_name);
+
+    for (set<int>::iterator i=changes->changed_ids.begin();
+         i!=changes->changed_ids.end(); ++i)
+        fragments.erase(*i);
+    changes->changed_ids.clear();
+
+    Job *j = new Job();
+    j->file_name = file_name;
+    j->dtd_file = FWObjectDatabase::DTD_FILE_NAME;
+    j->compression = xmlGetCompressMode();
+    j->fragments = &fragments;
+    try
+    {
+        j->copyTree(db);
+    } catch (FWException &ex)
+    {
+        delete j;
+        throw(ex);
+    }
+
+    written = j->written;
+    reused = j->reused;
+    return j;
+}
+
+/*
+ * Collects the background job. Text of units converted by a job that
+ * failed is still correct, only the file has not been written.
+ */
+void DatabaseSaver::finish() throw(FWException)
+{
+    if (job == NULL) return;
+    if (running) pthread_join(thread, NULL);
+    running = false;
+
+    bool ok = job->ok;
+    string error = job->error;
+    delete job;
+    job = NULL;
+
+    if (!ok)
+    {
+        db->setDirty(true);
+        throw FWException(error);
+    }
+}
+
+void DatabaseSaver::save(const string &file_name) throw(FWException)
+{
+    try
+    {
+        finish();
+    } catch (FWException&)
+    {
+        // we are going to save the tree again anyway
+    }
+
+    Job *j = prepare(file_name);
+    j->run();
+    bool ok = j->ok;
+    string error = j->error;
+    delete j;
+    if (!ok) throw FWException(error);
+    db->setDirty(false);
+}
+
+void DatabaseSaver::start(const string &file_name) throw(FWException)
+{
+    try
+    {
+        finish();
+    } catch (FWException&)
+    {
+    }
+
+    job = prepare(file_name);
+    db->setDirty(false);
+    running = (pthread_create(&thread, NULL,
+                              runJob, job) == 0);
+    if (!running) job->run();
+}
+
+bool DatabaseSaver::isRunning()
+{
+    return (running && !job->done.get());
+}
+
+void DatabaseSaver::wait() throw(FWException)
+{
+    finish();
+}
+
+void DatabaseSaver::clear()
+{
+    try
+    {
+        finish();
+    } catch (FWException&)
+    {
+    }
+    fragments.clear();
+}
@@ -0,0 +1,158 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  $Id$
+
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+
+#ifndef  __DATABASESAVER_HH_FLAG__
+#define  __DATABASESAVER_HH_FLAG__
+
+#include <string>
+#include <map>
+
+#include <pthread.h>
+
+#include "fwbuilder/FWException.h"
+
+
+namespace libfwbuilder
+{
+
+class FWObject;
+class FWObjectDatabase;
+
+/**
+ * Saves the object tree of a database to the data file incrementally
+ * and, if asked, in a background thread.
+ *
+ * Libraries and folders (groups that hold objects rather than
+ * references to them) are written to the file every time. Every
+ * other child of a folder is a "unit" of the file: a firewall, a
+ * host, an address, a service or a user group together with
+ * everything inside it. The saver keeps XML text of every unit it
+ * has written and watches changes in the tree the same way
+ * FWObjectSnapshot does. Units that did not change since they were
+ * written are spliced into the file as they are; units that changed
+ * and units that are new to the saver are converted to XML again.
+ * The file is the same as the one FWObjectDatabase::saveFile() would
+ * have written.
+ *
+ * save() does all the work in the calling thread. start() copies
+ * folders and the units that need to be converted to a private
+ * database and returns right away; the copy is converted to XML and
+ * the file is written by a background thread while the program keeps
+ * modifying the tree. Only one background save can run at a time,
+ * all methods wait for it to finish. Both clear "dirty" flag of the
+ * database; if a background save fails, wait() sets the flag again
+ * and throws the error.
+ *
+ * Like saveFile(), the saver writes compressed file if compression
+ * has been turned on with xmlSetCompressMode(). The saver must be
+ * deleted before the database.
+ */
+class DatabaseSaver
+{
+    class ChangeLog;
+    class Job;
+
+    /**
+     * XML text of a unit, indented for the given level of the tree
+     */
+    class Fragment
+    {
+    public:
+        FWObject *object;
+        int level;
+        std::string text;
+
+        Fragment() : object(NULL), level(0) {}
+    };
+
+    FWObjectDatabase *db;
+    ChangeLog *changes;
+    std::map<int, Fragment> fragments;
+
+    Job *job;
+    pthread_t thread;
+    bool running;
+
+    int written;
+    int reused;
+
+    DatabaseSaver(const DatabaseSaver&);
+    DatabaseSaver& operator=(const DatabaseSaver&);
+
+    Job* prepare(const std::string &file_name) throw(FWException);
+    void finish() throw(FWException);
+
+    static void* runJob(void *job);
+
+public:
+
+    DatabaseSaver(FWObjectDatabase *db);
+
+    /**
+     * waits for the background save, if there is one
+     */
+    ~DatabaseSaver();
+
+    /**
+     * saves the tree to the file in the calling thread
+     */
+    void save(const std::string &file_name) throw(FWException);
+
+    /**
+     * starts saving the tree to the file in the background. If the
+     * thread can not be created, saves in the calling thread.
+     */
+    void start(const std::string &file_name) throw(FWException);
+
+    /**
+     * true while background save is running
+     */
+    bool isRunning();
+
+    /**
+     * waits for the background save to finish, throws FWException if
+     * it has failed. Does nothing if there is no background save.
+     */
+    void wait() throw(FWException);
+
+    /**
+     * forgets XML text of all units so that the next save converts
+     * the whole tree
+     */
+    void clear();
+
+    /**
+     * number of units converted to XML and number of units copied
+     * from the saved text by the last save
+     */
+    int getWrittenCount() const { return written; }
+    int getReusedCount() const { return reused; }
+};
+
+}
+
+#endif
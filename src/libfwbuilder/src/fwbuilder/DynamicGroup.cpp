@@ -30,6 +30,7 @@
 #include "fwbuilder/RuleElement.h"
 
 #include <cstring>
+#include <algorithm>
 
 using namespace std;
 using namespace libfwbuilder;
@@ -145,22 +146,103 @@ bool DynamicGroup::isCompileTime() const
 }
 
 
+/*
+ * Objects that can match the filter according to the type/keyword
+ * index of the database. Returns false if some filter matches objects
+ * of any type with any keyword, in which case the whole tree has to
+ * be scanned anyway.
+ */
+bool DynamicGroup::findCandidates(set<FWObject*> &res)
+{
+    SearchIndex *index = getRoot()->getSearchIndex();
+
+    list<string>::const_iterator iter;
+    for (iter = m_filter.begin(); iter != m_filter.end(); ++iter) {
+        string type, keyword;
+        splitFilter(*iter, type, keyword);
+
+        if (keyword == KEYWORD_ANY) {
+            if (type == TYPE_ANY) return false;
+            const SearchIndex::posting_list &lst =
+                index->getObjectsOfType(type);
+            res.insert(lst.begin(), lst.end());
+            continue;
+        }
+
+        const SearchIndex::posting_list &kw_lst =
+            index->getObjectsWithKeyword(keyword);
+        if (type == TYPE_ANY) {
+            res.insert(kw_lst.begin(), kw_lst.end());
+            continue;
+        }
+
+        // intersection: walk the shorter list and check the other
+        // condition on the object itself
+        const SearchIndex::posting_list &type_lst =
+            index->getObjectsOfType(type);
+        SearchIndex::posting_list::const_iterator i;
+        if (kw_lst.size() < type_lst.size()) {
+            for (i = kw_lst.begin(); i != kw_lst.end(); ++i) {
+                if ((*i)->getTypeName() == type) res.insert(*i);
+            }
+        } else {
+            for (i = type_lst.begin(); i != type_lst.end(); ++i) {
+                if ((*i)->getKeywords().count(keyword)) res.insert(*i);
+            }
+        }
+    }
+    return true;
+}
+
 void DynamicGroup::loadFromSource(bool ipv6, FWOptions *options, bool test_mode)
     throw (FWException)
 {
     FWObjectDatabase *root = getRoot();
 
-    FWObject::tree_iterator tree_iter;
-    for (tree_iter = root->tree_begin();
-         tree_iter != root->tree_end(); ++tree_iter) {
-        FWObject *elem = (*tree_iter);
-        if (elem == root) continue;
+    set<FWObject*> candidates;
+    if (!findCandidates(candidates)) {
+        FWObject::tree_iterator tree_iter;
+        for (tree_iter = root->tree_begin();
+             tree_iter != root->tree_end(); ++tree_iter) {
+            FWObject *elem = (*tree_iter);
+            if (elem == root) continue;
+
+            if (!isMemberOfGroup(elem)) continue;
+            addRef(elem);
+        }
+        return;
+    }
 
+    /* The index also has objects that are not in the tree (removed
+       but not deleted yet), only keep those that can be reached from
+       the root. References are added in the order in which
+       tree_iterator would find the members, which is the order of
+       their paths of child positions from the root. */
+    vector<pair<vector<int>, FWObject*> > members;
+    set<FWObject*>::iterator iter;
+    for (iter = candidates.begin(); iter != candidates.end(); ++iter) {
+        FWObject *elem = *iter;
         if (!isMemberOfGroup(elem)) continue;
-        addRef(elem);
+
+        vector<int> path;
+        FWObject *p = elem;
+        while (p != root) {
+            FWObject *parent = p->getParent();
+            if (parent == NULL) break;
+            int pos = parent->indexOf(p);
+            if (pos < 0) break;
+            path.push_back(pos);
+            p = parent;
+        }
+        if (p != root) continue;
+
+        std::reverse(path.begin(), path.end());
+        members.push_back(make_pair(path, elem));
     }
-}
 
+    std::sort(members.begin(), members.end());
+    for (unsigned i = 0; i < members.size(); ++i) addRef(members[i].second);
+}
 
 static bool isInDeletedObjs(FWObject *obj)
 {
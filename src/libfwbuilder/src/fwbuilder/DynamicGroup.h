@@ -33,6 +33,8 @@ class DynamicGroup : public MultiAddress
 {
     std::list<std::string> m_filter;
 
+    bool findCandidates(std::set<FWObject*> &res);
+
  public:
     DynamicGroup();
     virtual ~DynamicGroup();
@@ -45,7 +47,8 @@ class DynamicGroup : public MultiAddress
 
     /* Each list entry is comma-separated list of matching criteria */
     const std::list<std::string> &getFilter() { return m_filter; }
-    void setFilter(const std::list<std::string> &filter) { m_filter = filter; }
+    void setFilter(const std::list<std::string> &filter)
+    { _aboutToChange(); m_filter = filter; }
 
     static bool splitFilter(const std::string &str, std::string &type,
                             std::string &keyword);
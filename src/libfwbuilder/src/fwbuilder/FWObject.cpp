@@ -32,6 +32,7 @@
 #include "fwbuilder/XMLTools.h"
 #include "fwbuilder/FWObject.h"
 #include "fwbuilder/FWObjectDatabase.h"
+#include "fwbuilder/FWObjectSnapshot.h"
 #include "fwbuilder/FWObjectReference.h"
 #include "fwbuilder/Library.h"
 
@@ -41,6 +42,7 @@
 #include "fwbuilder/Rule.h"
 #include "fwbuilder/Host.h"
 #include "fwbuilder/Interface.h"
+#include "fwbuilder/ThreadTools.h"
 
 #include <stdlib.h>
 #include <stdio.h>
@@ -61,6 +63,34 @@ using namespace libfwbuilder;
 const char *FWObject::TYPENAME={"UNDEF"};
 string FWObject::NOT_FOUND="";
 string FWObject::dataDir;
+int FWObject::active_snapshots = 0;
+
+static Mutex type_id_mutex;
+static int type_id_seed = 0;
+
+static map<string, int>& type_ids_by_name()
+{
+    static map<string, int> *ids = new map<string, int>();
+    return *ids;
+}
+
+int FWObject::allocateTypeId(const char *type_name)
+{
+    type_id_mutex.lock();
+    int res = type_id_seed++;
+    type_ids_by_name()[type_name] = res;
+    type_id_mutex.unlock();
+    return res;
+}
+
+int FWObject::getTypeIdByName(const string &type_name)
+{
+    type_id_mutex.lock();
+    map<string, int>::iterator it = type_ids_by_name().find(type_name);
+    int res = (it == type_ids_by_name().end()) ? -1 : it->second;
+    type_id_mutex.unlock();
+    return res;
+}
 
 
 //#define FWB_DEBUG
@@ -95,8 +125,8 @@ void FWObject::fromXML(xmlNodePtr root) throw(FWException)
 
     n = FROMXMLCAST(xmlGetProp(root, TOXMLCAST("keywords")));
     if (n != 0) {
-        keywords = stringToSet(n);
-        dbroot->keywords.insert(keywords.begin(), keywords.end());
+        _setKeywords(stringToSet(n));
+        _registerKeywords();
         FREEXMLBUFF(n);
     }
 
@@ -177,10 +207,13 @@ xmlNodePtr FWObject::toXML(xmlNodePtr parent, bool process_children)
                    STRTOXMLCAST(setToString(keywords)));
     }
 
-    for(map<string, string>::const_iterator i=data.begin(); i!=data.end(); ++i) 
+    vector<const AttributeStore::Slot*> attributes;
+    data.getSortedByName(attributes);
+    for(vector<const AttributeStore::Slot*>::const_iterator i=attributes.begin();
+        i!=attributes.end(); ++i) 
     {
-        const string &name  = (*i).first;
-        const string &value = (*i).second;
+        const string &name  = (*i)->getName();
+        const string &value = (*i)->getValue();
 
         if (name[0]=='.') continue;
         if (name == "folder" && value.empty()) continue;
@@ -204,6 +237,15 @@ FWObject::FWObject()
     ref_counter = 0;
     parent = NULL;
     dbroot = NULL;
+    usage_record = NULL;
+    for (int i=0; i<VISIT_MARK_SLOTS; ++i) visit_marks[i] = 0;
+    search_index = NULL;
+    search_index_type = -1;
+    search_type_pos = -1;
+    search_name_pos = -1;
+    subtree_types = 0;
+    subtree_version = 0;
+    subtree_index = NULL;
     name = "";
     comment = "";
     id = -1;
@@ -222,6 +264,15 @@ FWObject::FWObject(bool new_id)
     ref_counter = 0;
     parent = NULL;
     dbroot = NULL;
+    usage_record = NULL;
+    for (int i=0; i<VISIT_MARK_SLOTS; ++i) visit_marks[i] = 0;
+    search_index = NULL;
+    search_index_type = -1;
+    search_type_pos = -1;
+    search_name_pos = -1;
+    subtree_types = 0;
+    subtree_version = 0;
+    subtree_index = NULL;
     name = "";
     comment = "";
     id = -1;
@@ -235,9 +286,18 @@ FWObject::FWObject(bool new_id)
     storeCreationTime();
 }
 
-FWObject::FWObject(const FWObject &c) : list<FWObject*>(c)
+FWObject::FWObject(const FWObject &c) : FWObjectList(c)
 {
     busy = false;
+    usage_record = NULL;
+    for (int i=0; i<VISIT_MARK_SLOTS; ++i) visit_marks[i] = 0;
+    search_index = NULL;
+    search_index_type = -1;
+    search_type_pos = -1;
+    search_name_pos = -1;
+    subtree_types = 0;
+    subtree_version = 0;
+    subtree_index = NULL;
     *this = c;
     storeCreationTime();
 }
@@ -245,6 +305,10 @@ FWObject::FWObject(const FWObject &c) : list<FWObject*>(c)
 FWObject::~FWObject() 
 {
     busy = true;  // ignore read-only
+    if (active_snapshots != 0) FWObjectSnapshot::objectDestroyed(this);
+    if (usage_record) UsageIndex::forget(this);
+    if (search_index) SearchIndex::update(this, NULL);
+    if (subtree_index) subtree_index->forget(this);
     if (size() > 0) destroyChildren();
     data.clear();
     private_data.clear();
@@ -252,7 +316,65 @@ FWObject::~FWObject()
 
 void FWObject::init(FWObjectDatabase *root)
 {
-    dbroot = (FWObjectDatabase*)root;
+    setRoot(root);
+}
+
+/*
+ * Children of an object that has been detached from the tree are
+ * covered by the frozen copy the snapshots made of it, see
+ * FWObjectSnapshot::detached()
+ */
+void FWObject::_saveForSnapshots()
+{
+    if (busy && dbroot != this) return;
+    FWObjectSnapshot::objectChanging(this);
+}
+
+void FWObject::_updateUsageIndex()
+{
+    if (dbroot != NULL || usage_record != NULL) UsageIndex::update(this);
+}
+
+/*
+ * The database itself is not indexed: its keywords are keywords of
+ * all objects, see getAllKeywords()
+ */
+void FWObject::_updateSearchIndex()
+{
+    SearchIndex::update(
+        this, (dbroot && dbroot != this) ? dbroot->getSearchIndex() : NULL);
+}
+
+void FWObject::_setKeywords(const set<string> &kw)
+{
+    if (search_index)
+    {
+        for (set<string>::const_iterator i=keywords->begin();
+             i!=keywords->end(); ++i)
+            search_index->removeKeyword(this, *i);
+        for (set<string>::const_iterator i=kw.begin(); i!=kw.end(); ++i)
+            search_index->addKeyword(this, *i);
+    }
+    keywords = kw;
+}
+
+/*
+ * Keywords of the database object are keywords of all its objects
+ * (see getAllKeywords()). The set is shared and immutable, so it is
+ * replaced only when this object has a keyword the database does not
+ * know yet.
+ */
+void FWObject::_registerKeywords()
+{
+    if (dbroot == NULL || keywords.empty()) return;
+    const set<string> &all = dbroot->keywords;
+    set<string>::const_iterator i;
+    for (i=keywords->begin(); i!=keywords->end(); ++i)
+        if (all.count(*i) == 0) break;
+    if (i == keywords->end()) return;
+    set<string> res = all;
+    res.insert(keywords->begin(), keywords->end());
+    dbroot->keywords = res;
 }
 
 void FWObject::setPrivateData(const string &key, void *data)
@@ -317,6 +439,37 @@ FWObject* FWObject::findObjectByName(const string &type,
 {
     if (getTypeName()==type && getName()==name) return this;
 
+    /*
+     * Objects with this name are taken from the search index of the
+     * database and checked by walking up to this object. This is
+     * cheaper than the scan below when there are only a few such
+     * objects or when we search the whole database. The first one in
+     * the tree order is returned, so if more than one object
+     * matches we still scan. Objects with empty names are not in the
+     * index.
+     */
+    if (dbroot != NULL && !name.empty() &&
+        (search_index != NULL || dbroot == this))
+    {
+        const SearchIndex::posting_list &lst =
+            dbroot->getSearchIndex()->getObjectsWithName(name);
+        if (dbroot == this || lst.size() <= NAME_INDEX_MAX_CANDIDATES)
+        {
+            FWObject *found = NULL;
+            int matches = 0;
+            for (SearchIndex::posting_list::const_iterator i=lst.begin();
+                 i!=lst.end(); ++i)
+            {
+                if ((*i)->isChildOf(this) && (*i)->getTypeName() == type)
+                {
+                    found = *i;
+                    matches++;
+                }
+            }
+            if (matches < 2) return found;
+        }
+    }
+
     list<FWObject*>::iterator j;
     for(j=begin(); j!=end(); ++j)     
     {
@@ -353,19 +506,9 @@ bool FWObject::cmp(const FWObject *obj, bool recursive) throw(FWException)
     if (getTypeName() != obj->getTypeName() || name != obj->name || comment != obj->comment || ro != obj->ro)
         return false;
 
-    if (data.size() != obj->data.size())
+    if (data != obj->data)
         return false;
 
-    for(map<string, string>::const_iterator i=data.begin(); i!=data.end(); ++i) 
-    {
-        const string &name  = (*i).first;
-        const string &value = (*i).second;
-// 10/21/2008 --vk
-        map<string,string>::const_iterator j=obj->data.find(name);
-        if (j==obj->data.end()) return false;
-        if (j->second!=value) return false;
-    }
-
     if (keywords.empty() != obj->keywords.empty() || keywords != obj->keywords)
         return false;
 
@@ -408,6 +551,7 @@ FWObject& FWObject::duplicate(const FWObject *x, bool preserve_id)
     throw(FWException)
 {
     checkReadOnly();
+    _aboutToChange();
     bool xro = x->ro;
 
     shallowDuplicate(x, preserve_id);
@@ -462,21 +606,21 @@ FWObject& FWObject::shallowDuplicate(const FWObject *x, bool preserve_id)
     throw(FWException)
 {
     checkReadOnly();
+    _aboutToChange();
 
     int old_id = getId();
 
     id = x->id;
+    if (search_index && name != x->name)
+        search_index->rename(this, name, x->name);
     name = x->name;
     comment = x->comment;
     ro = x->ro;
     data = x->data;
     private_data = x->private_data;
 
-    keywords = x->keywords;
-    set<string>::const_iterator iter;
-    for (iter = keywords.begin(); iter != keywords.end(); ++iter) {
-        dbroot->keywords.insert(*iter);
-    }
+    _setKeywords(x->keywords);
+    _registerKeywords();
 
     setReadOnly(false);
 
@@ -495,6 +639,9 @@ FWObject& FWObject::shallowDuplicate(const FWObject *x, bool preserve_id)
     if (dbroot==NULL) setRoot(x->getRoot());
     if (dbroot!=NULL) dbroot->addToIndex(this);
 
+    // attributes that refer to other objects could have changed
+    _updateUsageIndex();
+
     setReadOnly(x->ro);
     setDirty(true);
     return *this;
@@ -512,6 +659,7 @@ class InheritsFWOptions: public std::unary_function<FWObject*, bool>
 
 FWObject& FWObject::duplicateForUndo(const FWObject *obj) throw(FWException)
 {
+    _aboutToChange();
     setRO(false);
     InheritsFWOptions pred;
     FWObject::const_iterator mine_opts_iter = std::find_if(begin(), end(), pred);
@@ -534,6 +682,8 @@ void FWObject::setName(const string &n)
 {
     if (name != n)
     {
+        _aboutToChange();
+        if (search_index) search_index->rename(this, name, n);
         name = n;
         setDirty(true);
     }
@@ -608,6 +758,7 @@ void FWObject::setComment(const string &c)
 {
     if (comment != c)
     {
+        _aboutToChange();
         comment = c;
         setDirty(true);
     }
@@ -625,6 +776,7 @@ void FWObject::setId(int c)
 {
     if (id != c)
     {
+        _aboutToChange();
         id = c;
         setDirty(true);
         if (dbroot!=NULL) dbroot->addToIndex(this);
@@ -633,80 +785,145 @@ void FWObject::setId(int c)
 
 bool FWObject::exists(const string &name) const 
 {
-    return data.count(name)!=0; 
+    return data.find(AttributeKey::lookup(name)) != NULL;
+}
+
+bool FWObject::exists(const AttributeKey &key) const 
+{
+    return data.find(key.getId()) != NULL;
 }
 
 const string &FWObject::getStr(const string &name) const
 {
-    map<string,string>::const_iterator i=data.find(name);
-    if (i==data.end())
+    const AttributeStore::Slot *s = data.find(AttributeKey::lookup(name));
+    if (s==NULL)
         return NOT_FOUND;
     else
-        return (*i).second;
+        return s->getValue();
 }
 
+const string &FWObject::getStr(const AttributeKey &key) const
+{
+    const AttributeStore::Slot *s = data.find(key.getId());
+    if (s==NULL)
+        return NOT_FOUND;
+    else
+        return s->getValue();
+}
+
+/*
+ * Does not register the name: an attribute whose name is not known
+ * does not exist in any object
+ */
 void FWObject::remStr(const string &name)
+{
+    int key_id = AttributeKey::lookup(name);
+    if (key_id < 0)
+    {
+        checkReadOnly();
+        return;
+    }
+    _remStr(key_id, AttributeKey::isInternal(key_id));
+}
+
+void FWObject::remStr(const AttributeKey &key)
+{
+    _remStr(key.getId(), key.isInternal());
+}
+
+void FWObject::_remStr(int key_id, bool internal)
 {
     checkReadOnly();
-    map<string, string>::iterator m=data.find(name);
-    if(m != data.end()) 
+    if (!internal && data.find(key_id) != NULL) _aboutToChange();
+    if (data.erase(key_id))
     {
-        data.erase(m);
         setDirty(true);
+        if (UsageIndex::isReferenceAttribute(key_id)) _updateUsageIndex();
     }
 }
 
 void FWObject::setStr(const string &name, const string &val)
 {
-    if (name[0]!='.' && name != "folder") checkReadOnly();
-    string old_val = data[name];
-    if (old_val != val)
+    setStr(AttributeKey(name), val);
+}
+
+/*
+ * attribute "folder" can be changed in read-only objects, as well as
+ * internal attributes
+ */
+static bool isReadOnlyExempt(const AttributeKey &key)
+{
+    static AttributeKey folder_key("folder");
+    return key.isInternal() || key.getId() == folder_key.getId();
+}
+
+void FWObject::setStr(const AttributeKey &key, const string &val)
+{
+    if (!isReadOnlyExempt(key)) checkReadOnly();
+    if (!key.isInternal()) _aboutToChange();
+    // attribute with name that starts with "." is considered "hidden"
+    // or "internal". Such attribute is not saved to the data file and
+    // should not trigger "dirty" flag.
+    if (data.findOrCreate(key.getId())->setValue(val) && !key.isInternal())
     {
-        data[name] = val;
-        // attribute with name that starts with "." is considered "hidden"
-        // or "internal". Such attribute is not saved to the data file and
-        // should not trigger "dirty" flag.
-        if (name[0]!='.') setDirty(true);
+        setDirty(true);
+        if (UsageIndex::isReferenceAttribute(key.getId())) _updateUsageIndex();
     }
 }
 
+/*
+ * Integer and boolean values are parsed when attribute is assigned,
+ * see AttributeStore::Slot. Missing attribute reads as -1 and false
+ * respectively, as it always did.
+ */
 int FWObject::getInt(const string &name) const
 {
-    string val = getStr(name);
-    size_t n = val.find_first_of(" \n\r\t");
-    while (n != string::npos)
-    {
-        val = val.erase(n, 1);
-        n = val.find_first_of(" \n\r\t");
-    }
-    if (val != "") return( atol(val.c_str()) );
-    else return(-1);
+    const AttributeStore::Slot *s = data.find(AttributeKey::lookup(name));
+    return (s==NULL) ? -1 : s->getIntValue();
+}
+
+int FWObject::getInt(const AttributeKey &key) const
+{
+    const AttributeStore::Slot *s = data.find(key.getId());
+    return (s==NULL) ? -1 : s->getIntValue();
 }
 
 void FWObject::setInt(const string &name, int val)
 {
-    ostringstream str;
-    str << val;
-    setStr(name, str.str());
+    setInt(AttributeKey(name), val);
+}
+
+void FWObject::setInt(const AttributeKey &key, int val)
+{
+    if (!isReadOnlyExempt(key)) checkReadOnly();
+    if (!key.isInternal()) _aboutToChange();
+    if (data.findOrCreate(key.getId())->setIntValue(val) && !key.isInternal())
+        setDirty(true);
 }
 
 bool FWObject::getBool(const string &name) const
 {
-// 10/21/2008 --vk
-    string val = getStr(name);
-    size_t n = val.find_first_of(" \n\r\t");
-    while (n != string::npos)
-    {
-        val = val.erase(n, 1);
-        n = val.find_first_of(" \n\r\t");
-    }
-    return (val=="1" || cxx_strcasecmp(val.c_str() , "true")==0);
+    const AttributeStore::Slot *s = data.find(AttributeKey::lookup(name));
+    return (s==NULL) ? false : s->getBoolValue();
+}
+
+bool FWObject::getBool(const AttributeKey &key) const
+{
+    const AttributeStore::Slot *s = data.find(key.getId());
+    return (s==NULL) ? false : s->getBoolValue();
 }
 
 void FWObject::setBool(const string &name, bool val)
 {
-    setStr(name, (val)?"True":"False");
-    //if (name[0]!='.') setDirty(true);
+    setBool(AttributeKey(name), val);
+}
+
+void FWObject::setBool(const AttributeKey &key, bool val)
+{
+    if (!isReadOnlyExempt(key)) checkReadOnly();
+    if (!key.isInternal()) _aboutToChange();
+    if (data.findOrCreate(key.getId())->setBoolValue(val) && !key.isInternal())
+        setDirty(true);
 }
 
 void FWObject::setBool(const string &name, const string &val)
@@ -776,11 +993,13 @@ void FWObject::dump(std::ostream &f,bool recursive,bool brief,int offset) const
 	  << "  name=" << n << endl;
 	f << string(offset,' ') << "Root:   " << getRoot() << endl;
 
-	map<string, string>::const_iterator d;
-	for (d=data.begin(); d!=data.end(); ++d)
+	vector<const AttributeStore::Slot*> attributes;
+	data.getSortedByName(attributes);
+	vector<const AttributeStore::Slot*>::const_iterator d;
+	for (d=attributes.begin(); d!=attributes.end(); ++d)
         {
 	    f << string(offset,' ');
-	    f << (*d).first << ": " << (*d).second << endl;
+	    f << (*d)->getName() << ": " << (*d)->getValue() << endl;
 	}
 	if (recursive)
         {
@@ -809,6 +1028,30 @@ void FWObject::_adopt(FWObject *obj)
  *
  */
     obj->setRoot(getRoot());
+    _subtreeChanged(obj);
+}
+
+/*
+ * obj has been added to this object. Types found in its subtree
+ * are now found in subtrees of this object and all its parents.
+ */
+void FWObject::_subtreeChanged(FWObject *obj)
+{
+    obj->subtree_types |= SubtreeTypeIndex::typeBit(obj->getTypeId());
+    unsigned int mask = obj->subtree_types;
+    for (FWObject *p=this; p!=NULL && (p->subtree_types & mask)!=mask;
+         p=p->parent)
+        p->subtree_types |= mask;
+    _invalidateSubtreeTypes(mask);
+}
+
+/*
+ * children of this object have been added, removed or reordered
+ */
+void FWObject::_invalidateSubtreeTypes(unsigned int type_mask)
+{
+    for (FWObject *p=this; p!=NULL; p=p->parent) p->subtree_version++;
+    SubtreeTypeIndex::invalidate(type_mask);
 }
 
 void FWObject::addAt(int where_id, FWObject *obj)
@@ -856,6 +1099,7 @@ void FWObject::add(FWObject *obj, bool validate)
 
     if (!validate || validateChild(obj)) 
     {
+        _aboutToChange();
 	push_back(obj);
 	_adopt(obj);
 	setDirty(true);
@@ -891,6 +1135,7 @@ void FWObject::addRef(FWObject *obj)
 	FWReference *oref = obj->createRef();
 	obj->ref();
 
+        _aboutToChange();
 	push_back(oref);
 	_adopt(oref);
 	setDirty(true);
@@ -906,6 +1151,7 @@ void FWObject::insert_before(FWObject *o1, FWObject *obj)
     if (obj == NULL) return;
     if (o1 == NULL)
     {
+        _aboutToChange();
         insert(begin(), obj);
         _adopt(obj);
         setDirty(true);
@@ -915,6 +1161,7 @@ void FWObject::insert_before(FWObject *o1, FWObject *obj)
     list<FWObject*>::iterator m = find(begin(), end(), o1);
     if (m != end())
     {
+        _aboutToChange();
         insert(m, obj);
         _adopt(obj);
         setDirty(true);
@@ -930,6 +1177,7 @@ void FWObject::insert_after(FWObject *o1, FWObject *obj)
     list<FWObject*>::iterator m = find(begin(), end(), o1);
     if (m != end())
     {
+        _aboutToChange();
         insert(++m, obj);
         _adopt(obj);
         setDirty(true);
@@ -939,6 +1187,7 @@ void FWObject::insert_after(FWObject *o1, FWObject *obj)
 void FWObject::swapObjects(FWObject *o1, FWObject *o2)
 {
     checkReadOnly();
+    _aboutToChange();
 
     for(list<FWObject*>::iterator m=begin(); m!=end(); ++m) 
     {
@@ -950,6 +1199,8 @@ void FWObject::swapObjects(FWObject *o1, FWObject *o2)
             *m=o1;
         }
     }
+    invalidateChildArray();
+    _invalidateSubtreeTypes(subtree_types);
     setDirty(true);
 }
 
@@ -959,10 +1210,14 @@ void FWObject::remove(FWObject *obj, bool delete_if_last)
     if (fi!=end())
     {
         checkReadOnly();
+        _aboutToChange();
+        if (active_snapshots != 0) FWObjectSnapshot::objectDetached(obj);
 
         erase(fi);
         setDirty(true);
         obj->unref();
+        _invalidateSubtreeTypes(obj->subtree_types);
+        obj->parent = NULL;
 
         if (delete_if_last && obj->ref_counter <= 0)
         {
@@ -970,8 +1225,6 @@ void FWObject::remove(FWObject *obj, bool delete_if_last)
             if (db) db->removeFromIndex(obj->getId());
             delete obj;
         }
-
-        obj->parent = NULL;
     }
 }
 
@@ -1086,6 +1339,11 @@ void FWObject::destroyChildren()
 #endif
 
     FWObjectDatabase *dbr = getRoot();
+    if (size() > 0)
+    {
+        _invalidateSubtreeTypes(subtree_types);
+        _aboutToChange();
+    }
     while (size() > 0)
     {
         FWObject *o = front();
@@ -1100,6 +1358,12 @@ void FWObject::destroyChildren()
 
         if (o)
         {
+            // let snapshots copy the subtree before it is taken apart
+            if (active_snapshots != 0)
+            {
+                FWObjectSnapshot::objectDetached(o);
+                o->busy = true;
+            }
             if (o->size()) o->destroyChildren();
             if (dbr && !dbr->busy) dbr->removeFromIndex( o->getId() );
 
@@ -1120,8 +1384,10 @@ void FWObject::destroyChildren()
 
 void FWObject::sortChildrenByName(bool follow_references)
 {
+    _aboutToChange();
     if (!follow_references)
         sort(FWObjectNameCmpPredicate());
+    _invalidateSubtreeTypes(subtree_types);
 
 }
 
@@ -1224,13 +1490,23 @@ void FWObject::clearChildren(bool recursive)
     int referenced_children = 0;
     int total_children = 0;
 
+    _invalidateSubtreeTypes(subtree_types);
+    _aboutToChange();
+
     for(list<FWObject*>::iterator m=begin(); m!=end(); ++m) 
     {
         FWObject *o = *m;
 
         total_children++;
 
+        bool o_busy = o->busy;
+        if (active_snapshots != 0)
+        {
+            FWObjectSnapshot::objectDetached(o);
+            o->busy = true;
+        }
         if (recursive) o->clearChildren(recursive);
+        o->busy = o_busy;
         o->unref();
         if(o->ref_counter==0) 
         {
@@ -1321,6 +1597,13 @@ list<FWObject*> FWObject::getByType(const string &type_name) const
 
 list<FWObject*> FWObject::getByTypeDeep(const string &type_name) const
 {
+    int type_id = getTypeIdByName(type_name);
+    if (type_id >= 0)
+    {
+        vector<FWObject*> objects = getByTypeDeepCached(type_id);
+        return list<FWObject*>(objects.begin(), objects.end());
+    }
+
     list<FWObject*> res = getByType(type_name); // direct children
     for (const_iterator i=begin(); i!=end(); ++i)
     {
@@ -1330,6 +1613,15 @@ list<FWObject*> FWObject::getByTypeDeep(const string &type_name) const
     return res;
 }
 
+vector<FWObject*> FWObject::getByTypeDeepCached(int type_id) const
+{
+    FWObjectDatabase *db = getRoot();
+    if (db != NULL) return db->getSubtreeTypeIndex()->get(this, type_id);
+    vector<FWObject*> res;
+    SubtreeTypeIndex::scan(this, type_id, res);
+    return res;
+}
+
 FWObjectTypedChildIterator FWObject::findByType(const std::string &type_name) const
 {
     return FWObjectTypedChildIterator(this, type_name);
@@ -1360,6 +1652,7 @@ bool FWObject::isDirty()
  */
 void FWObject::setReadOnly(bool f)
 {
+    if (ro != f) _aboutToChange();
     ro = f;
     FWObjectDatabase *dbr = getRoot();
     if (dbr)
@@ -1612,26 +1905,52 @@ void FWObject::replaceReferenceInternal(int old_id, int new_id, int &counter)
     }
 }
 
+int FWObject::replaceRefs(const map<int,int> &id_map)
+{
+    int ref_replacement_counter = 0;
+    if (!id_map.empty())
+        replaceReferencesInternal(id_map, ref_replacement_counter);
+    return ref_replacement_counter;
+}
+
+void FWObject::replaceReferencesInternal(const map<int,int> &id_map,
+                                         int &counter)
+{
+    FWReference *ref = FWReference::cast(this);
+    if (ref==NULL)
+    {
+        for (FWObject::iterator j1=begin(); j1!=end(); ++j1)
+            (*j1)->replaceReferencesInternal(id_map, counter);
+    } else
+    { 
+        map<int,int>::const_iterator it = id_map.find(ref->getPointerId());
+        if (it!=id_map.end() && it->second!=it->first)
+        {
+            ref->setPointerId(it->second);
+            counter++;
+        }
+    }
+}
+
 void FWObject::findDependencies(list<FWObject*> &deps)
 {
-    int loop_id = time(NULL);
-    _findDependencies_internal(this, deps, loop_id);
+    VisitMark visited;
+    _findDependencies_internal(this, deps, visited);
 }
 
 void FWObject::_findDependencies_internal(FWObject *obj,
                                           list<FWObject*> &deps,
-                                          int anti_loop_id)
+                                          VisitMark &visited)
 {
     if (obj==NULL) return;
     if (FWOptions::cast(obj)) return;
     if (FWReference::cast(obj)!=NULL)
     {
         _findDependencies_internal(FWReference::cast(obj)->getPointer(),
-                                   deps, anti_loop_id);
+                                   deps, visited);
     } else
     {
-        if (obj->getInt(".anti_loop")==anti_loop_id) return;
-        obj->setInt(".anti_loop", anti_loop_id);
+        if (!visited.visit(obj)) return;
 
         if (!RuleElement::cast(obj) && !Rule::cast(obj) && !RuleSet::cast(obj))
             deps.push_back(obj);
@@ -1641,7 +1960,7 @@ void FWObject::_findDependencies_internal(FWObject *obj,
             for (FWObject::iterator j1=obj->begin(); j1!=obj->end(); ++j1)
             {
                 FWObject *o = *j1;
-                _findDependencies_internal(o, deps, anti_loop_id);
+                _findDependencies_internal(o, deps, visited);
             }
         }
     }
@@ -1656,18 +1975,33 @@ const set<string> &FWObject::getAllKeywords()
 
 void FWObject::addKeyword(const string &keyword)
 {
-    keywords.insert(keyword);
-    dbroot->keywords.insert(keyword);
+    if (keywords->count(keyword) == 0)
+    {
+        _aboutToChange();
+        set<string> kw = keywords;
+        kw.insert(keyword);
+        keywords = kw;
+        if (search_index) search_index->addKeyword(this, keyword);
+    }
+    _registerKeywords();
 }
 
 void FWObject::removeKeyword(const string &keyword)
 {
-    keywords.erase(keyword);
+    if (keywords->count(keyword) != 0)
+    {
+        _aboutToChange();
+        set<string> kw = keywords;
+        kw.erase(keyword);
+        keywords = kw;
+        if (search_index) search_index->removeKeyword(this, keyword);
+    }
 }
 
 void FWObject::clearKeywords()
 {
-    keywords.clear();
+    if (!keywords.empty()) _aboutToChange();
+    _setKeywords(set<string>());
 }
 
 FWObjectNameCmpPredicate::FWObjectNameCmpPredicate(bool follow_refs)
@@ -1681,3 +2015,46 @@ bool FWObjectNameCmpPredicate::operator()(FWObject *a, FWObject *b)
     FWObject *o2 = (follow_references) ? FWReference::getObject(b) : b;
     return o1->getName() < o2->getName();
 }
+
+
+/*
+ * Slots in use and the last epoch handed out for each slot. Epoch 0
+ * is never used so that objects that have never been visited are not
+ * marked.
+ */
+static Mutex visit_mark_mutex;
+static unsigned int visit_slots_in_use = 0;
+static unsigned int visit_epochs[FWObject::VISIT_MARK_SLOTS] = { 0 };
+
+VisitMark::VisitMark()
+{
+    slot = -1;
+    epoch = 0;
+    visited = NULL;
+
+    visit_mark_mutex.lock();
+    for (int i=0; i<FWObject::VISIT_MARK_SLOTS; ++i)
+    {
+        if (visit_slots_in_use & (1U << i)) continue;
+        visit_slots_in_use |= (1U << i);
+        if (++visit_epochs[i] == 0) ++visit_epochs[i];
+        slot = i;
+        epoch = visit_epochs[i];
+        break;
+    }
+    visit_mark_mutex.unlock();
+
+    if (slot < 0) visited = new set<const FWObject*>();
+}
+
+VisitMark::~VisitMark()
+{
+    if (slot < 0)
+    {
+        delete visited;
+        return;
+    }
+    visit_mark_mutex.lock();
+    visit_slots_in_use &= ~(1U << slot);
+    visit_mark_mutex.unlock();
+}
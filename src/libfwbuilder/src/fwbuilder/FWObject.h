@@ -31,6 +31,7 @@
 #include "fwbuilder/libfwbuilder-config.h"
 
 #include <time.h>
+#include <stdint.h>
 #include <string>
 #include <list>
 #include <map>
@@ -44,6 +45,13 @@
 #include <cstdlib>
 
 #include "fwbuilder/FWException.h"
+#include "fwbuilder/AttributeStore.h"
+#include "fwbuilder/FWObjectArena.h"
+#include "fwbuilder/FWObjectList.h"
+#include "fwbuilder/Interned.h"
+#include "fwbuilder/UsageIndex.h"
+#include "fwbuilder/SearchIndex.h"
+#include "fwbuilder/SubtreeTypeIndex.h"
 #include "fwbuilder/ObjectMatcher.h"
 #include "fwbuilder/Dispatch.h"
 
@@ -56,13 +64,60 @@ class FWObjectDatabase;
 class FWReference;
 class FWObjectTypedChildIterator;
 class FWObjectFindPredicate;
+class VisitMark;
+class FWObjectSnapshot;
 
+/**
+ * Cache of dynamic_cast results. For every type id of the object
+ * being cast the table holds either "not a T" or the offset that
+ * dynamic_cast applied to the pointer. Offset depends only on the
+ * most derived class of the object, so it can be reused for all
+ * objects with the same type id even though some classes inherit
+ * FWObject virtually.
+ *
+ * Each table entry is a single word so that other threads see either
+ * 0 or the complete value. It is set once with compare-and-swap;
+ * threads that compute the same value concurrently just lose the
+ * race. The offset can be negative, it is kept as an unsigned
+ * number and added to the pointer with unsigned arithmetic. Offsets
+ * of polymorphic subobjects are multiples of the pointer size, so
+ * the lowest bit is free for the "is a T" flag.
+ */
+template <class T> class FWObjectCaster
+{
+    enum { TABLE_SIZE = 256 };
+
+    // 0 - not checked yet, 2 - not a T, offset | 1 - is a T
+    static volatile uintptr_t table[TABLE_SIZE];
+
+public:
+
+    static T* cast(FWObject *o);
+};
+
+template <class T> volatile uintptr_t FWObjectCaster<T>::table[FWObjectCaster<T>::TABLE_SIZE];
+
+/*
+ * Besides its string type name, each class derived from FWObject gets
+ * small integer type id. Ids are allocated on first use and are only
+ * meaningful within one process, XML and GUI keep using string type
+ * names. isA() compares type ids and cast() goes through
+ * FWObjectCaster which remembers the result of dynamic_cast for each
+ * (target class, type of the object) pair.
+ */
 #define DECLARE_FWOBJECT_SUBTYPE(name) \
    static    const char *TYPENAME; \
    virtual   std::string getTypeName() const { return TYPENAME; } \
-   static bool isA(const FWObject *o) { return o && o->getTypeName()==TYPENAME; }  \
-   static name* cast(FWObject *o) { return dynamic_cast<name*>(o); } \
-   static const name* constcast(const FWObject *o) { return dynamic_cast<const name*>(o); }
+   static int typeId() \
+   { static int type_id = FWObject::allocateTypeId(TYPENAME); return type_id; } \
+   virtual int getTypeId() const { return name::typeId(); } \
+   virtual size_t getObjectSize() const { return sizeof(name); } \
+   static bool isA(const FWObject *o) \
+   { return o && o->getTypeId()==name::typeId(); } \
+   static name* cast(FWObject *o) \
+   { return libfwbuilder::FWObjectCaster<name>::cast(o); } \
+   static const name* constcast(const FWObject *o) \
+   { return libfwbuilder::FWObjectCaster<name>::cast(const_cast<FWObject*>(o)); }
 
 #define DECLARE_DISPATCH_METHODS(classname) \
     virtual void* dispatch(Dispatch* _d, void* _a1) \
@@ -86,9 +141,28 @@ class FWObjectFindPredicate;
  * FWObject can have children, that is other objects of the same class
  * or derived classes which are included in this one
  */
-class FWObject : public std::list<FWObject*>
+class FWObject : public FWObjectList
 {
     friend class libfwbuilder::FWObjectDatabase;
+    friend class libfwbuilder::UsageIndex;
+    friend class libfwbuilder::SearchIndex;
+    friend class libfwbuilder::SubtreeTypeIndex;
+    friend class libfwbuilder::VisitMark;
+    friend class libfwbuilder::FWObjectSnapshot;
+
+public:
+
+    /**
+     * number of traversals that can mark objects at the same time
+     * without falling back to a set, see VisitMark
+     */
+    enum { VISIT_MARK_SLOTS = 4 };
+
+    /**
+     * findObjectByName() scans the subtree if there are more objects
+     * with the name in the database than this
+     */
+    enum { NAME_INDEX_MAX_CANDIDATES = 16 };
 
 private:
 
@@ -113,25 +187,60 @@ private:
      * dbroot is assigned by method FWObjectDatabase::create 
      */
     FWObjectDatabase *dbroot;
+
+    /**
+     * what this object is registered for in the reverse reference
+     * index of its database, NULL if it does not refer to anything.
+     * See UsageIndex
+     */
+    UsageIndex::Record *usage_record;
+
+    /**
+     * epochs of the traversals that visited this object, one per
+     * VisitMark slot. See VisitMark
+     */
+    unsigned int visit_marks[VISIT_MARK_SLOTS];
+
+    /**
+     * type/keyword index of the database this object is registered
+     * in, the type id it has been registered with and positions of
+     * the object in the lists of its type and name. See SearchIndex
+     */
+    SearchIndex *search_index;
+    int search_index_type;
+    int search_type_pos;
+    int search_name_pos;
+
+    /**
+     * SubtreeTypeIndex buckets of the types of this object and its
+     * descendants. Bits are added as children are added but never
+     * removed. subtree_version changes when children are added,
+     * removed or reordered anywhere in the subtree. subtree_index is
+     * the index that has cached results for this object.
+     */
+    unsigned int subtree_types;
+    unsigned int subtree_version;
+    mutable SubtreeTypeIndex *subtree_index;
+
     int id;
     bool ro;
-    std::string name;
-    std::string comment;
+    InternedString name;
+    InternedString comment;
 
     static std::string NOT_FOUND;
 
     time_t creation_time;
-    std::set<std::string> keywords;
+    InternedStringSet keywords;
 
     static std::string dataDir;
 
 protected:
 
-    std::string xml_name;
+    InternedString xml_name;
     bool busy;
     bool dirty;
     
-    std::map<std::string, std::string> data;
+    AttributeStore data;
     std::map<std::string, void*> private_data;
 
     void clearRefCounter() { ref_counter=0; }
@@ -139,13 +248,31 @@ protected:
     void _removeAll(FWObject *rm);
     void _removeAllRef(FWObject *rm);
     void _adopt(FWObject *obj);   // increments reference
+    void _subtreeChanged(FWObject *obj);
+    void _invalidateSubtreeTypes(unsigned int type_mask);
+    unsigned int _getSubtreeTypes() const { return subtree_types; }
+
+    /**
+     * number of FWObjectSnapshot objects in the program
+     */
+    static int active_snapshots;
+
+    /**
+     * must be called before attributes or the list of children of
+     * the object change, see FWObjectSnapshot
+     */
+    void _aboutToChange() { if (active_snapshots != 0) _saveForSnapshots(); }
+    void _saveForSnapshots();
+    void _remStr(int key_id, bool internal);
     void _findDependencies_internal(FWObject *obj,
                                     std::list<FWObject*> &deps,
-                                    int anti_loop_id);
+                                    VisitMark &visited);
 
     void setRO(bool f) { ro = f; }
 
     virtual void replaceReferenceInternal(int oldfw_id, int newfw_id, int &counter);
+    virtual void replaceReferencesInternal(const std::map<int,int> &id_map,
+                                           int &counter);
 
     /**
      * Finds direct child of this object with given name.
@@ -182,6 +309,27 @@ public:
 
     DECLARE_DISPATCH_METHODS(FWObject);
 
+    /**
+     * allocates next integer type id, used by DECLARE_FWOBJECT_SUBTYPE
+     */
+    static int allocateTypeId(const char *type_name);
+
+    /**
+     * returns integer type id of the class with given type name or -1
+     * if no object of this class has asked for its type id yet
+     */
+    static int getTypeIdByName(const std::string &type_name);
+
+    /**
+     * Objects are allocated from the arena of the database that
+     * creates them if that database uses one, otherwise from the
+     * heap, see FWObjectArena
+     */
+    static void* operator new(size_t size)
+    { return FWObjectArena::allocate(size); }
+    static void operator delete(void *ptr, size_t size)
+    { FWObjectArena::deallocate(ptr, size); }
+
     class tree_iterator
     {
         friend class libfwbuilder::FWObject;
@@ -315,6 +463,21 @@ public:
     void setBool(const std::string &name, bool val);
     void setBool(const std::string &name, const std::string &val);
 
+    /**
+     * Variants of the attribute accessors that take interned
+     * attribute name. These avoid looking the name up in the
+     * dictionary and should be used in code that reads the same
+     * attribute of many objects, such as rule processors.
+     */
+    bool exists(const AttributeKey &key) const;
+    void remStr(const AttributeKey &key);
+    const std::string &getStr(const AttributeKey &key) const;
+    void setStr(const AttributeKey &key, const std::string &val);
+    int getInt(const AttributeKey &key) const;
+    void setInt(const AttributeKey &key, int val);
+    bool getBool(const AttributeKey &key) const;
+    void setBool(const AttributeKey &key, bool val);
+
     const std::string &getName() const;
     void setName(const std::string& n);
     
@@ -351,7 +514,35 @@ public:
      * Sets pointer to the database root
      */
     void setRoot(const FWObjectDatabase *_dbroot)
-    { dbroot = (FWObjectDatabase*)_dbroot; }
+    {
+        if (dbroot == _dbroot) return;
+        dbroot = (FWObjectDatabase*)_dbroot;
+        _updateUsageIndex();
+        _updateSearchIndex();
+    }
+
+    /**
+     * Registers this object in the reverse reference index of its
+     * database if it refers to other objects. Called whenever
+     * something that determines what the object refers to changes.
+     */
+    void _updateUsageIndex();
+
+    /**
+     * Moves this object to the type/keyword index of its database
+     */
+    void _updateSearchIndex();
+
+    /**
+     * Replaces keywords, keeping the type/keyword index current
+     */
+    void _setKeywords(const std::set<std::string> &kw);
+
+    /**
+     * Adds keywords of this object to the set of all keywords kept
+     * by the database
+     */
+    void _registerKeywords();
 
     /**
      *   Returns a string that represents a path to the object
@@ -496,6 +687,13 @@ public:
      */
     virtual std::list<FWObject*> getByTypeDeep(const std::string &type_name) const;
 
+    /**
+     * Same objects as getByTypeDeep() returns, but taken from the
+     * cache of the database (see SubtreeTypeIndex) instead of
+     * scanning the tree every time.
+     */
+    std::vector<FWObject*> getByTypeDeepCached(int type_id) const;
+
     /**
      * Returns list of direct children of current object
      * whose getTypeName() same as given.
@@ -511,7 +709,10 @@ public:
     virtual FWObject* getFirstByType(const std::string &type_name) const;
 
     /**
-     * finds a child object of a given type with a given name
+     * finds a child object of a given type with a given name. If the
+     * object belongs to a database, candidates are taken from the
+     * name index of its SearchIndex as long as there are no more
+     * than NAME_INDEX_MAX_CANDIDATES of them.
      */
     FWObject* findObjectByName(const std::string &type,
                                const std::string &name) throw(FWException);
@@ -535,6 +736,13 @@ public:
      */
     virtual int replaceRef(int oldfw_id, int newfw_id);
 
+    /**
+     * same as replaceRef() but replaces all IDs found in id_map (old
+     * id -> new id) in one pass over the subtree. Returns the number
+     * of replaced references.
+     */
+    int replaceRefs(const std::map<int,int> &id_map);
+
     /**
      * recursively find all FWReference objects that are children of
      * this and generate list of pointers to the objects these
@@ -566,10 +774,8 @@ public:
     virtual bool isPrimaryObject() const;
 
     // Attributes iterator
-    std::map<std::string, std::string>::const_iterator dataBegin()
-    { return data.begin(); }
-    std::map<std::string, std::string>::const_iterator dataEnd()
-    { return data.end();   }
+    AttributeStore::const_iterator dataBegin() { return data.begin(); }
+    AttributeStore::const_iterator dataEnd()   { return data.end();   }
 
     const std::set<std::string> &getKeywords() { return keywords; }
     const std::set<std::string> &getAllKeywords();
@@ -581,6 +787,73 @@ public:
     static void setDataDir(const std::string &dir) { dataDir = dir; }
 };
 
+template <class T> T* FWObjectCaster<T>::cast(FWObject *o)
+{
+    if (o == NULL) return NULL;
+
+    int type_id = o->getTypeId();
+    if (type_id >= TABLE_SIZE) return dynamic_cast<T*>(o);
+
+    uintptr_t entry = table[type_id];
+    if (entry == 0)
+    {
+        T *res = dynamic_cast<T*>(o);
+        if (res == NULL) entry = 2;
+        else entry = ((uintptr_t)(res) - (uintptr_t)(o)) | 1;
+        __sync_bool_compare_and_swap(&(table[type_id]), 0, entry);
+    }
+
+    if (entry == 2) return NULL;
+    return (T*)((uintptr_t)(o) + (entry & ~(uintptr_t)(1)));
+}
+
+/**
+ * Marks objects visited by a graph traversal to break loops (groups
+ * that include each other, rule set branches) without modifying
+ * attributes of the objects. Each traversal creates its own VisitMark
+ * which gets a fresh epoch number; the object is visited if the
+ * number stored in it matches the epoch. Starting a new traversal
+ * "clears" all marks at once.
+ *
+ * Objects have a few slots for the epochs, VisitMark takes one for
+ * its lifetime, so several traversals can run at the same time,
+ * nested or in different threads, as long as each one uses its own
+ * VisitMark. When all slots are taken, VisitMark falls back to
+ * keeping visited objects in a set.
+ */
+class VisitMark
+{
+    int slot;
+    unsigned int epoch;
+    std::set<const FWObject*> *visited;
+
+    VisitMark(const VisitMark&);
+    VisitMark& operator=(const VisitMark&);
+
+public:
+
+    VisitMark();
+    ~VisitMark();
+
+    bool isVisited(const FWObject *o) const
+    {
+        if (slot < 0) return visited->count(o) != 0;
+        return o->visit_marks[slot] == epoch;
+    }
+
+    /**
+     * marks the object; returns false if it has been marked already
+     */
+    bool visit(const FWObject *o)
+    {
+        if (slot < 0) return visited->insert(o).second;
+        unsigned int &mark = const_cast<FWObject*>(o)->visit_marks[slot];
+        if (mark == epoch) return false;
+        mark = epoch;
+        return true;
+    }
+};
+
 class FWObjectTypedChildIterator
 {
     public:
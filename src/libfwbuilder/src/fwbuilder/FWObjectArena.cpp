@@ -0,0 +1,334 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  $Id$
+
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#include "config.h"
+#include "fwbuilder/libfwbuilder-config.h"
+
+#include "fwbuilder/FWObjectArena.h"
+#include "fwbuilder/MemoryStats.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <new>
+
+using namespace std;
+using namespace libfwbuilder;
+
+
+/*
+ * Blocks carved from slabs start at addresses that are 8 modulo 16,
+ * blocks allocated from the heap are aligned at 16, which is how
+ * deallocate() tells them apart. Objects only need 8 byte alignment.
+ */
+enum { ARENA_BLOCK_TAG = 8,
+       HEAP_BLOCK_ALIGNMENT = 2 * ARENA_BLOCK_TAG };
+
+/*
+ * Header at the start of every slab. Its size is 8 modulo
+ * GRANULARITY, and block sizes are multiples of GRANULARITY, so that
+ * all blocks of the slab carry the tag.
+ */
+union SlabHeader
+{
+    struct
+    {
+        FWObjectArena *arena;
+        int size_class;
+    } h;
+    char pad[FWObjectArena::GRANULARITY + ARENA_BLOCK_TAG];
+};
+
+static inline bool isArenaBlock(const void *ptr)
+{
+    return ((uintptr_t)ptr & ARENA_BLOCK_TAG) != 0;
+}
+
+static inline SlabHeader* slabOf(const void *ptr)
+{
+    return (SlabHeader*)((uintptr_t)ptr &
+                         ~(uintptr_t)(FWObjectArena::SLAB_SIZE - 1));
+}
+
+static __thread FWObjectArena *current_arena = NULL;
+
+/*
+ * Allocation profile. The flag is read atomically without locking so
+ * that allocate() and deallocate() cost nothing extra when profiling
+ * is off; it is changed and counters are touched only under the
+ * mutex, which is why relaxed loads and stores are enough.
+ */
+static int profiling_flag = 0;
+
+static inline bool profiling()
+{
+    return __atomic_load_n(&profiling_flag, __ATOMIC_RELAXED) != 0;
+}
+
+static inline void setProfiling(bool f)
+{
+    __atomic_store_n(&profiling_flag, (f) ? 1 : 0, __ATOMIC_RELAXED);
+}
+
+static Mutex profile_mutex;
+static AllocationProfile current_profile;
+static long allocations_to_next_sample = 0;
+
+static void recordAllocation(size_t size)
+{
+    profile_mutex.lock();
+    if (profiling())
+    {
+        AllocationProfile &p = current_profile;
+        p.allocations++;
+        p.allocated_bytes += size;
+        p.live_bytes += long(size);
+        if (p.live_bytes > p.peak_live_bytes) p.peak_live_bytes = p.live_bytes;
+        if (p.sample_interval > 0 && --allocations_to_next_sample <= 0)
+        {
+            p.samples[size]++;
+            allocations_to_next_sample = p.sample_interval;
+        }
+    }
+    profile_mutex.unlock();
+}
+
+static void recordDeallocation(size_t size)
+{
+    profile_mutex.lock();
+    if (profiling())
+    {
+        current_profile.deallocations++;
+        current_profile.live_bytes -= long(size);
+    }
+    profile_mutex.unlock();
+}
+
+void FWObjectArena::startProfiling(int sample_interval)
+{
+    profile_mutex.lock();
+    current_profile = AllocationProfile();
+    current_profile.sample_interval = sample_interval;
+    allocations_to_next_sample = sample_interval;
+    setProfiling(true);
+    profile_mutex.unlock();
+}
+
+void FWObjectArena::stopProfiling()
+{
+    profile_mutex.lock();
+    setProfiling(false);
+    profile_mutex.unlock();
+}
+
+bool FWObjectArena::isProfiling()
+{
+    return profiling();
+}
+
+void FWObjectArena::getProfile(AllocationProfile &profile)
+{
+    profile_mutex.lock();
+    profile = current_profile;
+    profile_mutex.unlock();
+}
+
+
+FWObjectArena::Scope::Scope(FWObjectArena *arena)
+{
+    previous = current_arena;
+    current_arena = arena;
+}
+
+FWObjectArena::Scope::~Scope()
+{
+    current_arena = previous;
+}
+
+FWObjectArena* FWObjectArena::current()
+{
+    return current_arena;
+}
+
+FWObjectArena::FWObjectArena()
+{
+    for (int i=0; i<NUM_SIZE_CLASSES; ++i)
+    {
+        free_lists[i] = NULL;
+        slab_ptr[i] = NULL;
+        slab_left[i] = 0;
+    }
+    live_blocks = 1;
+    total_blocks = 0;
+    released = false;
+}
+
+FWObjectArena::~FWObjectArena()
+{
+    for (vector<char*>::iterator i=slabs.begin(); i!=slabs.end(); ++i)
+        free(*i);
+}
+
+/*
+ * live_blocks is changed under the mutex until the arena is released
+ * and atomically after that, see freeBlock()
+ */
+void FWObjectArena::release()
+{
+    mutex.lock();
+    released = true;
+    bool done = (__sync_sub_and_fetch(&live_blocks, 1) == 0);
+    mutex.unlock();
+    if (done) delete this;
+}
+
+long FWObjectArena::getLiveBlocks()
+{
+    mutex.lock();
+    long res = live_blocks - ((released) ? 0 : 1);
+    mutex.unlock();
+    return res;
+}
+
+long FWObjectArena::getTotalBlocks()
+{
+    mutex.lock();
+    long res = total_blocks;
+    mutex.unlock();
+    return res;
+}
+
+int FWObjectArena::getSlabCount()
+{
+    mutex.lock();
+    int res = int(slabs.size());
+    mutex.unlock();
+    return res;
+}
+
+size_t FWObjectArena::getSlabBytes()
+{
+    return size_t(getSlabCount()) * SLAB_SIZE;
+}
+
+void* FWObjectArena::allocateBlock(int size_class)
+{
+    size_t block_size = size_t(size_class + 1) * GRANULARITY;
+
+    mutex.lock();
+
+    void *block = free_lists[size_class];
+    if (block != NULL)
+    {
+        free_lists[size_class] = *((void**)block);
+    } else
+    {
+        if (slab_left[size_class] < block_size)
+        {
+            // whatever is left in the current slab is wasted
+            void *slab = NULL;
+            if (posix_memalign(&slab, SLAB_SIZE, SLAB_SIZE) != 0)
+            {
+                mutex.unlock();
+                throw std::bad_alloc();
+            }
+            SlabHeader *header = (SlabHeader*)slab;
+            header->h.arena = this;
+            header->h.size_class = size_class;
+            slabs.push_back((char*)slab);
+            slab_ptr[size_class] = (char*)(header + 1);
+            slab_left[size_class] = SLAB_SIZE - sizeof(SlabHeader);
+        }
+        block = slab_ptr[size_class];
+        slab_ptr[size_class] += block_size;
+        slab_left[size_class] -= block_size;
+    }
+    live_blocks++;
+    total_blocks++;
+
+    mutex.unlock();
+    return block;
+}
+
+/*
+ * Once the arena has been released nothing is allocated from it
+ * anymore, so freed blocks are just counted and slabs go away all at
+ * once with the last one.
+ */
+bool FWObjectArena::freeBlock(void *block, int size_class)
+{
+    if (!released)
+    {
+        mutex.lock();
+        if (!released)
+        {
+            *((void**)block) = free_lists[size_class];
+            free_lists[size_class] = block;
+            live_blocks--;
+            mutex.unlock();
+            return false;
+        }
+        mutex.unlock();
+    }
+    return (__sync_sub_and_fetch(&live_blocks, 1) == 0);
+}
+
+void* FWObjectArena::allocate(size_t size)
+{
+    void *block;
+    FWObjectArena *arena = current_arena;
+    if (arena != NULL && size <= MAX_BLOCK_SIZE)
+    {
+        int size_class = int((size + GRANULARITY - 1) / GRANULARITY) - 1;
+        if (size_class < 0) size_class = 0;
+        block = arena->allocateBlock(size_class);
+    } else
+    {
+        if (posix_memalign(&block, HEAP_BLOCK_ALIGNMENT, size) != 0)
+            throw std::bad_alloc();
+    }
+    if (profiling()) recordAllocation(size);
+    return block;
+}
+
+void FWObjectArena::deallocate(void *ptr, size_t size)
+{
+    if (ptr == NULL) return;
+    if (profiling()) recordDeallocation(size);
+    if (!isArenaBlock(ptr))
+    {
+        free(ptr);
+        return;
+    }
+    SlabHeader *header = slabOf(ptr);
+    FWObjectArena *arena = header->h.arena;
+    if (arena->freeBlock(ptr, header->h.size_class)) delete arena;
+}
+
+size_t FWObjectArena::getAllocatedSize(const void *ptr)
+{
+    if (ptr == NULL || !isArenaBlock(ptr)) return 0;
+    return size_t(slabOf(ptr)->h.size_class + 1) * GRANULARITY;
+}
@@ -0,0 +1,159 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  $Id$
+
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#ifndef  __FWOBJECTARENA_HH_FLAG__
+#define  __FWOBJECTARENA_HH_FLAG__
+
+#include <stddef.h>
+#include <vector>
+
+#include "fwbuilder/ThreadTools.h"
+
+
+namespace libfwbuilder
+{
+
+class AllocationProfile;
+
+/**
+ * Slab allocator for FWObject and derived classes.
+ *
+ * FWObject defines class specific operator new and operator delete
+ * that call FWObjectArena::allocate() and FWObjectArena::deallocate().
+ * If an arena is "current" in the calling thread, memory is carved
+ * from its slabs, otherwise it comes from the heap. Objects can be
+ * deleted at any time, in any order and in any thread, including
+ * after they have been moved to a different object tree.
+ *
+ * Blocks have no header. Slabs are aligned at SLAB_SIZE and every
+ * slab holds blocks of one size class, so deallocate() finds the
+ * arena and the size of a block in the header at the start of its
+ * slab. Blocks carved from slabs and blocks allocated from the heap
+ * are told apart by their alignment: heap blocks are aligned at 16,
+ * slab blocks are not.
+ *
+ * Freed blocks go to per-size free lists and are reused. Once the
+ * owner of the arena (normally FWObjectDatabase) calls release(),
+ * freed blocks are only counted, and all slabs are returned to the
+ * system at once when the last block allocated from the arena has
+ * been freed.
+ */
+class FWObjectArena
+{
+public:
+
+    enum { SLAB_SIZE = 64 * 1024,
+           GRANULARITY = 16,
+           MAX_BLOCK_SIZE = 1024,
+           NUM_SIZE_CLASSES = MAX_BLOCK_SIZE / GRANULARITY };
+
+    /**
+     * makes given arena current in the calling thread for the
+     * lifetime of the Scope object. Scopes can be nested.
+     */
+    class Scope
+    {
+        FWObjectArena *previous;
+    public:
+        Scope(FWObjectArena *arena);
+        ~Scope();
+    };
+
+private:
+
+    Mutex mutex;
+    std::vector<char*> slabs;
+    void *free_lists[NUM_SIZE_CLASSES];
+    char *slab_ptr[NUM_SIZE_CLASSES];
+    size_t slab_left[NUM_SIZE_CLASSES];
+    // live blocks plus one for the owner until release() is called
+    volatile long live_blocks;
+    long total_blocks;
+    volatile bool released;
+
+    FWObjectArena(const FWObjectArena&);
+    FWObjectArena& operator=(const FWObjectArena&);
+
+    ~FWObjectArena();
+
+    void* allocateBlock(int size_class);
+    // returns true if arena should be destroyed by the caller
+    bool freeBlock(void *block, int size_class);
+
+public:
+
+    FWObjectArena();
+
+    /**
+     * called by the owner when it is done with the arena. Slabs are
+     * freed right away if there are no live blocks, otherwise when
+     * the last one is freed.
+     */
+    void release();
+
+    long getLiveBlocks();
+    long getTotalBlocks();
+    int getSlabCount();
+    size_t getSlabBytes();
+
+    /**
+     * arena that is current in the calling thread, NULL if none
+     */
+    static FWObjectArena* current();
+
+    static void* allocate(size_t size);
+
+    /**
+     * size must be the size passed to allocate() for this block
+     */
+    static void deallocate(void *ptr, size_t size);
+
+    /**
+     * returns the size of the block ptr points to, which is the size
+     * requested from allocate() rounded up to GRANULARITY, or 0 if
+     * the block came from the heap. ptr must be the address
+     * returned by allocate(), which for an object of a class with
+     * virtual base classes is not necessarily the same as the address
+     * of its FWObject part; use dynamic_cast<void*>() to get it.
+     */
+    static size_t getAllocatedSize(const void *ptr);
+
+    /**
+     * Process-wide profiling of the calls to allocate() and
+     * deallocate(), see AllocationProfile. If sample_interval is
+     * greater than zero, size of every sample_interval-th
+     * allocation is recorded as well. Counters are reset every time
+     * profiling is started.
+     */
+    static void startProfiling(int sample_interval=0);
+    static void stopProfiling();
+    static bool isProfiling();
+    static void getProfile(AllocationProfile &profile);
+};
+
+}
+
+#endif
@@ -41,6 +41,10 @@
 
 #include "fwbuilder/FWObject.h"
 #include "fwbuilder/FWObjectDatabase.h"
+#include "fwbuilder/FWObjectSnapshot.h"
+#include "fwbuilder/DatabaseCache.h"
+#include "fwbuilder/FWObjectArena.h"
+#include "fwbuilder/IdRegistry.h"
 
 #include "fwbuilder/AttachedNetworks.h"
 #include "fwbuilder/Library.h"
@@ -92,28 +96,12 @@ using namespace std;
 using namespace libfwbuilder;
 
 // each program invocation tracks its own set of object ids (as int)
-// we just increment this counter to get new id. We also keep a dictionary
-// that maps integer ids to strings. This dictionary is populated when
-// objects are loaded from xml file and then used to write string ids
-// when objects are written back to file. Internally we operate with
-// integer ids all the time, string ids are only used in xml file.
-// "System" objects use ids < 1000.
-
-int id_seed = 1000;
-#ifdef _WIN32
-static int cached_pid = _getpid();
-#  ifndef __GNUC__
-#define snprintf sprintf_s
-#  endif
-#else
-static int cached_pid = getpid();
-#endif
-
-// these two dictionaries must be static to ensure uniqueness of integer
-// ids across multiple FWObjectDatabase objects
-
-map<int, string> id_dict;
-map<string, int> id_dict_reverse;
+// allocated by IdRegistry::generateUniqueId(). We also
+// keep a dictionary that maps integer ids to strings. This dictionary is
+// populated when objects are loaded from xml file and then used to write
+// string ids when objects are written back to file. Internally we
+// operate with integer ids all the time, string ids are only used in
+// xml file. See IdRegistry.
 
 const char*  FWObjectDatabase::TYPENAME  = {"FWObjectDatabase"};
 const string FWObjectDatabase::DTD_FILE_NAME  = "fwbuilder.dtd"    ;
@@ -125,11 +113,11 @@ FWObjectDatabase::FWObjectDatabase() : FWObject(false), data_file(), obj_index()
 
     setRoot(this);
     index_hits = index_misses = 0;
-    init_id_dict();
     predictable_id_tracker = 0;
     ignore_read_only = false;
+    arena = NULL;
+    partially_loaded = false;
 
-    searchId =0;
     lastModified = 0;
 
     setName(TYPENAME);
@@ -145,20 +133,24 @@ FWObjectDatabase::FWObjectDatabase(FWObjectDatabase& d) :
 
     setRoot(this);
     index_hits = index_misses = 0;
-    init_id_dict();
     predictable_id_tracker = 0;
     ignore_read_only = false;
+    partially_loaded = false;
+    FWObjectArena *own_arena = (d.arena) ? new FWObjectArena() : NULL;
+    arena = own_arena;
 
     data_file = d.data_file;
 
     setName(TYPENAME);
 
-    searchId =0;
-
     busy = true;
     *this = d;  // copies entire tree
     setId( ROOT_ID );
 
+// implicit operator= copies data members of d after the tree has been
+// copied, including pointer to its arena
+    arena = own_arena;
+
 // I do not understand why do I need to reindex the whole database
 // after operator=. It calls FWobject::duplicate, which in turn
 // uses FWObject::shallowDuplicate, which calls addToIndex
@@ -172,60 +164,46 @@ FWObjectDatabase::FWObjectDatabase(FWObjectDatabase& d) :
 
 FWObjectDatabase::~FWObjectDatabase()
 {
+    if (active_snapshots != 0) FWObjectSnapshot::databaseDestroyed(this);
     busy = true;
     //verifyTree(); // debugging
+    // objects do not need to unregister one by one
+    usage_index.clear();
+    search_index.clear();
+    subtree_type_index.clear();
+    // children are freed in bulk once the arena is released
+    if (arena) arena->release();
     destroyChildren();
 }
 
-void FWObjectDatabase::init_id_dict()
+void FWObjectDatabase::setUseArena(bool f)
 {
-    if (id_dict.size()==0)
+    if (f && arena == NULL) arena = new FWObjectArena();
+    if (!f && arena != NULL)
     {
-        id_dict[ROOT_ID] = "root";
-        id_dict[ANY_ADDRESS_ID] = "sysid0";
-        id_dict[ANY_SERVICE_ID] = "sysid1";
-        id_dict[ANY_INTERVAL_ID] = "sysid2";
-        id_dict[STANDARD_LIB_ID] = "syslib000";
-        id_dict[TEMPLATE_LIB_ID] = "syslib100";
-        id_dict[DELETED_OBJECTS_ID] = "sysid99";
-        id_dict[DUMMY_ADDRESS_ID] = "dummyaddressid0";
-        id_dict[DUMMY_SERVICE_ID] = "dummyserviceid0";
-        id_dict[DUMMY_INTERFACE_ID] = "dummyinterfaceid0";
-
-        for (map<int,string>::iterator i=id_dict.begin(); i!=id_dict.end(); ++i)
-            id_dict_reverse[i->second] = i->first;
+        arena->release();
+        arena = NULL;
     }
 }
 
 int FWObjectDatabase::registerStringId(const std::string &s_id)
 {
-    int i_id = -1;
-
-    if (id_dict_reverse.count(s_id) > 0)
-        return id_dict_reverse[s_id];
-
-    i_id = ++id_seed;
-    id_dict[i_id] = s_id;
-    id_dict_reverse[s_id] = i_id;
-    return i_id;
+    return IdRegistry::global()->registerStringId(s_id);
 }
 
 int FWObjectDatabase::getIntId(const std::string &s_id)
 {
-    if (id_dict_reverse.count(s_id) > 0) return id_dict_reverse[s_id];
-    return -1;
+    return IdRegistry::global()->getIntId(s_id);
 }
 
 string FWObjectDatabase::getStringId(int i_id)
 {
-    if (id_dict.count(i_id) > 0) return id_dict[i_id];
+    return IdRegistry::global()->getStringId(i_id);
+}
 
-    // TODO: Use proper GUID algorithm here
-    char id_buf[64];
-    snprintf(id_buf, sizeof(id_buf), "id%dX%d", i_id, cached_pid);
-    id_dict[i_id] = string(id_buf);
-    id_dict_reverse[string(id_buf)] = i_id;
-    return id_dict[i_id];
+string FWObjectDatabase::findStringId(int i_id)
+{
+    return IdRegistry::global()->findStringId(i_id);
 }
 
 string FWObjectDatabase::getPredictableId(const string &prefix)
@@ -249,8 +227,7 @@ void FWObjectDatabase::_setPredictableStrIdsRecursively(FWObject *obj)
        string new_id = getPredictableId("id");
        int int_id = obj->getId();
 
-       id_dict[int_id] = new_id;
-       id_dict_reverse[new_id] = int_id;
+       IdRegistry::global()->setStringId(int_id, new_id);
 
        obj->setBool(".seen_this", true);
    }
@@ -280,7 +257,7 @@ void FWObjectDatabase::setPredictableIds()
 
 int FWObjectDatabase::generateUniqueId()
 {
-    return ++id_seed;
+    return IdRegistry::generateUniqueId();
 }
 
 void FWObjectDatabase::setFileName(const string &filename)
@@ -307,15 +284,40 @@ const string FWObjectDatabase::getFileDir()
 	return data_file.substr(0,i);
 }
 
+/*
+ * Number of elements in the XML tree. Not every element is an object
+ * (there are options, references etc) but this is a good enough upper
+ * bound to size the index before objects are created.
+ */
+static size_t countElements(xmlNodePtr node)
+{
+    size_t res = 0;
+    for (xmlNodePtr cur=node; cur; cur=cur->next)
+    {
+        if (cur->type != XML_ELEMENT_NODE) continue;
+        res += 1 + countElements(cur->children);
+    }
+    return res;
+}
+
 void FWObjectDatabase::load(const string &f,
                             XMLTools::UpgradePredicate *upgrade,
                             const std::string &template_dir) throw(FWException)
 {
     if(f=="") return;
 
-    xmlDocPtr doc = XMLTools::loadFile(f, FWObjectDatabase::TYPENAME,
-                                       FWObjectDatabase::DTD_FILE_NAME,
-                                       upgrade, template_dir);
+    xmlDocPtr doc = NULL;
+    bool from_cache = false;
+    if (f != "-")
+    {
+        doc = DatabaseCache::load(f);
+        from_cache = (doc != NULL);
+    }
+
+    if (doc == NULL)
+        doc = XMLTools::loadFile(f, FWObjectDatabase::TYPENAME,
+                                 FWObjectDatabase::DTD_FILE_NAME,
+                                 upgrade, template_dir);
     
     xmlNodePtr root = xmlDocGetRootElement(doc);
     
@@ -326,6 +328,11 @@ void FWObjectDatabase::load(const string &f,
         throw FWException("Data file has invalid structure: "+f);
     }
     
+    // the file has been validated and converted to the current
+    // version, next time it can be loaded from the cache. This must
+    // be done before the tree is pruned for partial load.
+    if (!from_cache && f != "-") DatabaseCache::save(f, doc);
+
     try
     {
         busy = true;
@@ -333,6 +340,12 @@ void FWObjectDatabase::load(const string &f,
         destroyChildren();
         clearIndex();
 
+        partially_loaded = false;
+        if (!partial_load_target.empty())
+            partially_loaded = _pruneForPartialLoad(root);
+
+        obj_index.reserve(countElements(root));
+
         fromXML(root);
 
         setDirty(false);
@@ -350,6 +363,11 @@ void FWObjectDatabase::load(const string &f,
 
 void FWObjectDatabase::saveFile(const string &filename) throw(FWException)
 {
+    if (partially_loaded)
+        throw FWException(
+            "Partially loaded object tree can not be saved to file " +
+            filename);
+
 /* need to set flag 'busy' so we ignore read-only status. Some objects
  * modify themselves in toXML() (e.g. Management) so if they belong to
  * a read-only library, we can't save them to a file. It should be
@@ -444,9 +462,9 @@ xmlNodePtr FWObjectDatabase::toXML(xmlNodePtr parent) throw(FWException)
     //NOTUSED xmlAttrPtr pr =
     xmlNewProp(parent,
                TOXMLCAST("id") , 
-               STRTOXMLCAST(id_dict[rootid]));
+               STRTOXMLCAST(getStringId(rootid)));
 
-    //xmlAddID(NULL, parent->doc, STRTOXMLCAST(id_dict[rootid]), pr);
+    //xmlAddID(NULL, parent->doc, STRTOXMLCAST(getStringId(rootid)), pr);
 
     for(list<FWObject*>::const_iterator j=begin(); j!=end(); ++j) 
     {
@@ -466,7 +484,7 @@ void FWObjectDatabase::addToIndex(FWObject* o)
     if (o)
     {
         o->setRoot( this );
-        if (o->getId() > -1 ) obj_index[o->getId()] = o;
+        if (o->getId() > -1 ) obj_index.insert(o->getId(), o);
     }
 }
 
@@ -477,8 +495,7 @@ void FWObjectDatabase::removeFromIndex(int id)
 
 FWObject* FWObjectDatabase::checkIndex(int id)
 {
-    if (obj_index.count(id)==0) return NULL;
-    return obj_index[id];
+    return obj_index.find(id);
 }
 
 FWObject* FWObjectDatabase::findInIndex(int id)
@@ -505,18 +522,19 @@ void FWObjectDatabase::buildIndex()
 
 void FWObjectDatabase::validateIndex()
 {
-    std::map<int, FWObject*>::iterator it;
-    for (it=obj_index.begin(); it!=obj_index.end(); ++it)
+    for (ObjectIndex::const_iterator it=obj_index.begin();
+         it!=obj_index.end(); ++it)
     {
-        if (it->second->getRoot() != this)
+        FWObject *o = it.getObject();
+        if (o->getRoot() != this)
         {
-            cerr << "Object '" << it->second->getName() << "'"
+            cerr << "Object '" << o->getName() << "'"
                  << " ( "
-                 << it->second 
-                 << " type " << it->second->getTypeName() << ")"
+                 << o
+                 << " type " << o->getTypeName() << ")"
                  << " in index of db " << this
                  << " has incorrect db root ptr " 
-                 << it->second->getRoot()
+                 << o->getRoot()
                  << endl;
         }
     }
@@ -568,6 +586,97 @@ void FWObjectDatabase::getIndexStats(int &index_size,
     miss_counter = index_misses;
 }
 
+void FWObjectDatabase::getIndexStats(ObjectIndexStats &stats)
+{
+    obj_index.getStats(stats);
+    stats.hits = index_hits;
+    stats.misses = index_misses;
+}
+
+static size_t keywordSetBytes(const set<string> &keywords)
+{
+    size_t res = sizeof(set<string>);
+    for (set<string>::const_iterator i=keywords.begin();
+         i!=keywords.end(); ++i)
+        res += MemoryStats::treeNodeBytes(0) + MemoryStats::stringBytes(*i);
+    return res;
+}
+
+void FWObjectDatabase::getMemoryStats(MemoryStats &stats)
+{
+    stats = MemoryStats();
+
+    // interned values are counted once per value, see Interned
+    set<const void*> seen_values;
+    set<int> referenced;
+
+    for (FWObject::tree_iterator it=tree_begin(); it!=tree_end(); ++it)
+    {
+        FWObject *obj = *it;
+        MemoryStats::TypeStats &ts = stats.types[obj->getTypeName()];
+
+        stats.objects++;
+        ts.objects++;
+        // objects allocated from the heap are counted by the size of
+        // their class
+        size_t size = FWObjectArena::getAllocatedSize(
+            dynamic_cast<void*>(obj));
+        ts.object_bytes += (size != 0) ? size : obj->getObjectSize();
+
+        for (AttributeStore::const_iterator i=obj->data.begin();
+             i!=obj->data.end(); ++i)
+        {
+            const string &value = i->second->getValue();
+            size_t bytes = sizeof(*i) + sizeof(AttributeStore::Slot) -
+                sizeof(string) + MemoryStats::stringBytes(value);
+            MemoryStats::AttributeStats &as =
+                stats.attributes[AttributeKey::name(i->first)];
+            as.count++;
+            as.bytes += bytes;
+            ts.attribute_bytes += bytes;
+        }
+
+        ts.child_bytes += obj->getStorageBytes();
+
+        const string *values[] = { &(obj->getName()), &(obj->getComment()) };
+        for (int n=0; n<2; ++n)
+        {
+            if (values[n]->empty()) continue;
+            size_t bytes = MemoryStats::stringBytes(*(values[n]));
+            stats.unshared_string_bytes += bytes;
+            if (seen_values.insert(values[n]).second)
+            {
+                stats.unique_strings++;
+                stats.string_bytes += bytes;
+            }
+        }
+        if (!obj->keywords.empty())
+        {
+            const set<string> &kw = obj->getKeywords();
+            size_t bytes = keywordSetBytes(kw);
+            stats.unshared_string_bytes += bytes;
+            if (seen_values.insert(&kw).second)
+            {
+                stats.unique_strings++;
+                stats.string_bytes += bytes;
+            }
+        }
+
+        FWReference *ref = FWReference::cast(obj);
+        if (ref)
+        {
+            stats.references++;
+            referenced.insert(ref->getPointerId());
+        }
+    }
+
+    stats.referenced_objects = int(referenced.size());
+    stats.object_index_bytes = obj_index.getBytes();
+    stats.usage_index_bytes = usage_index.getBytes();
+    stats.search_index_bytes = search_index.getBytes();
+    stats.arena_bytes = (arena) ? arena->getSlabBytes() : 0;
+}
+
 void FWObjectDatabase::addToIndexRecursive(FWObject *o)
 {
     addToIndex(o);
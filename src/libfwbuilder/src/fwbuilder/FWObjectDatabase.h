@@ -30,6 +30,8 @@
 #include "fwbuilder/FWObject.h"
 #include "fwbuilder/FWException.h"
 #include "fwbuilder/ThreadTools.h"
+#include "fwbuilder/ObjectIndex.h"
+#include "fwbuilder/MemoryStats.h"
 #include "fwbuilder/XMLTools.h"
 
 #ifdef _WIN32
@@ -203,6 +205,7 @@ public:
     };
 
     class FWObjectDatabase;
+    class DatabaseSaver;
     typedef FWObject*(*create_function_ptr)(int);
 
     /**
@@ -210,6 +213,7 @@ public:
      */
     class FWObjectDatabase : public FWObject
     {
+        friend class DatabaseSaver;
 
 private:
         void _clearReferenceCounters(FWObject *o);
@@ -221,26 +225,32 @@ private:
         /*         libfwbuilder::FWObject *p, */
         /*         std::set<libfwbuilder::FWObject *> &resset); */
 
-        bool _findWhereObjectIsUsed(libfwbuilder::FWObject *o,
-                                    libfwbuilder::FWObject *p,
-                                    std::set<libfwbuilder::FWObject *> &resset,
-                                    int search_id);
+        bool _isReachableFrom(libfwbuilder::FWObject *o,
+                              libfwbuilder::FWObject *top);
+        void _findClustersUsingFirewall(
+            libfwbuilder::FWObject *fw,
+            libfwbuilder::FWObject *p,
+            std::set<libfwbuilder::FWObject *> &resset);
     
         void _findObjectsInGroup(
             libfwbuilder::Group *g,
-            std::set<libfwbuilder::FWObject *> &res);
+            std::set<libfwbuilder::FWObject *> &res,
+            VisitMark &visited);
         Firewall* _findFirewallByNameRecursive(
             FWObject* db, const std::string &name) throw(FWException);
+        class SubtreeCopyIndex;
         FWObject* _recursively_copy_subtree(FWObject *target,
                                             FWObject *source,
                                             std::map<int,int> &id_map,
-                                            const std::string &dedup_attribute);
+                                            SubtreeCopyIndex &copies);
         void _copy_foreign_obj_aux(FWObject *target, FWObject *source,
                                    std::map<int,int> &id_map,
-                                   const std::string &dedup_attribute);
+                                   SubtreeCopyIndex &copies);
 
         void _setPredictableStrIdsRecursively(FWObject *obj);
         void _updateNonStandardObjectReferencesRecursively(FWObject *obj);
+
+        bool _pruneForPartialLoad(xmlNodePtr root);
         
 protected:
 
@@ -250,13 +260,17 @@ protected:
         int index_hits;
         int index_misses;
         std::string data_file;
-        std::map<int, FWObject*> obj_index;
-        int searchId;
+        ObjectIndex obj_index;
         int predictable_id_tracker;
         bool ignore_read_only;
+        FWObjectArena *arena;
+        UsageIndex usage_index;
+        SearchIndex search_index;
+        SubtreeTypeIndex subtree_type_index;
+        std::string partial_load_target;
+        bool partially_loaded;
         
         void init_create_methods_table();
-        void init_id_dict();
 
 public:
 
@@ -338,11 +352,53 @@ public:
          */
         void getIndexStats(int &index_size, int &hit_counter, int &miss_counter);
 
+        /**
+         * return index usage statistics together with information
+         * about the hash table: its capacity and probe lengths
+         */
+        void getIndexStats(ObjectIndexStats &stats);
+
+        /**
+         * fills stats with the number of objects and estimated memory
+         * taken by objects of each type, by attributes, strings and
+         * indexes of this database. See MemoryStats
+         */
+        void getMemoryStats(MemoryStats &stats);
+
         /**
          * this function is intended for debugging.
          */
         void validateIndex();
         
+        /**
+         * If arena is used, objects created by this database are
+         * allocated from slabs that are released all at once when the
+         * database is destroyed. Only affects objects created after
+         * the call. Copy of the database made with the copy
+         * constructor uses arena if the original did.
+         */
+        void setUseArena(bool f);
+        FWObjectArena* getArena() { return arena; }
+
+        /**
+         * reverse reference index of this database, maintained
+         * automatically as objects are created, changed and deleted
+         */
+        UsageIndex* getUsageIndex() { return &usage_index; }
+
+        /**
+         * type and keyword index of this database, also maintained
+         * automatically
+         */
+        SearchIndex* getSearchIndex() { return &search_index; }
+
+        /**
+         * cache of the results of getByTypeDeep() for the objects of
+         * this database
+         */
+        SubtreeTypeIndex* getSubtreeTypeIndex()
+        { return &subtree_type_index; }
+
         /**
          * Some operations, such as object tree merging, should ignore
          * read-only flag on individual objects.
@@ -367,8 +423,42 @@ public:
                            const std::string &template_dir) throw(FWException);
         virtual void setDirty(bool f);
 
+        /**
+         * Makes load() build only the objects needed to compile one
+         * firewall or cluster: the target itself, objects its rules
+         * refer to (directly or through other objects), clusters the
+         * target is a member of and the Standard library. Libraries
+         * and folders on the way to these objects are created, other
+         * objects are not. The target is given by name or by string
+         * id; id of a rule selects the firewall or cluster the rule
+         * belongs to. If the target is not found or the objects it
+         * needs include dynamic groups, the whole file is loaded.
+         * Empty string (the default) turns partial loading off.
+         *
+         * Database loaded this way can not be saved.
+         */
+        void setPartialLoadTarget(const std::string &target)
+        { partial_load_target = target; }
+
+        /**
+         * true if the last call to load() built only a part of the
+         * tree (see setPartialLoadTarget())
+         */
+        bool isPartiallyLoaded() { return partially_loaded; }
+
         Firewall* findFirewallByName(const std::string &name) throw(FWException);
 
+        /**
+         * finds objects whose getPath() is equal to path, e.g.
+         * "/FWObjectDatabase/User/Firewalls/fw1". Objects are looked
+         * up by name in the search index, so this does not scan the
+         * tree. If more than one object is found, they are added to
+         * res in no particular order. Objects with empty names are
+         * not in the index and are never found.
+         */
+        void findObjectsByPath(const std::string &path,
+                               std::list<FWObject*> &res);
+
         FWObjectDatabase* exportSubtree( FWObject *lib );
         FWObjectDatabase* exportSubtree( const std::list<FWObject*> &libs );
 
@@ -384,6 +474,10 @@ public:
          * reference to a group that in turn has reference to <o>. Search
          * also includes references to objects used in rule actions Tag
          * and Branch.
+         *
+         * Uses reverse reference index (see UsageIndex), so the time
+         * it takes depends on the number of objects found rather than
+         * on the size of the subtree.
          */
         void findWhereObjectIsUsed(
             libfwbuilder::FWObject *o,
@@ -460,6 +554,13 @@ public:
         static int getIntId(const std::string &s_id);
         static std::string getStringId(int i_id);
 
+        /**
+         * returns string id for the integer id or empty string if
+         * the integer id has never been given a string id. Unlike
+         * getStringId(), does not generate one.
+         */
+        static std::string findStringId(int i_id);
+
         /**
          * generate predictable ID based on given prefix by adding sequential
          * suffix to it.
@@ -112,6 +112,7 @@ FWObject* libfwbuilder::create_##classname(int id) \
 \
 classname * FWObjectDatabase::create##classname(int id) \
 { \
+    FWObjectArena::Scope arena_scope(arena); \
     classname * nobj = classname::cast(create_##classname(id)); \
     addToIndex(nobj); \
     nobj->init(this); \
@@ -274,6 +275,10 @@ void FWObjectDatabase::init_create_methods_table()
 
 FWObject *FWObjectDatabase::create(const string &type_name, int id, bool init)
 {
+    // objects and children they create in constructors and init()
+    // are allocated from the arena of this database, if any
+    FWObjectArena::Scope arena_scope(arena);
+
     create_function_ptr fn = create_methods[type_name];
     if (fn == NULL)
     {
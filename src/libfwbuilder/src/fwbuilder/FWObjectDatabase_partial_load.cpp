@@ -0,0 +1,321 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  $Id$
+
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#include "config.h"
+#include "fwbuilder/libfwbuilder-config.h"
+
+#include "fwbuilder/FWObjectDatabase.h"
+#include "fwbuilder/XMLTools.h"
+
+#include "fwbuilder/Library.h"
+#include "fwbuilder/Firewall.h"
+#include "fwbuilder/Cluster.h"
+#include "fwbuilder/ObjectGroup.h"
+#include "fwbuilder/ServiceGroup.h"
+#include "fwbuilder/IntervalGroup.h"
+#include "fwbuilder/DynamicGroup.h"
+
+#include <string.h>
+
+#include <map>
+#include <set>
+#include <list>
+#include <deque>
+
+using namespace std;
+using namespace libfwbuilder;
+
+
+/*
+ * Libraries and folders only hold other objects. When an object that
+ * sits in a folder is needed, the folder is kept but its other
+ * children are not.
+ */
+static bool isFolder(xmlNodePtr node)
+{
+    const char *name = FROMXMLCAST(node->name);
+    return (strcmp(name, FWObjectDatabase::TYPENAME) == 0 ||
+            strcmp(name, Library::TYPENAME) == 0 ||
+            strcmp(name, ObjectGroup::TYPENAME) == 0 ||
+            strcmp(name, ServiceGroup::TYPENAME) == 0 ||
+            strcmp(name, IntervalGroup::TYPENAME) == 0);
+}
+
+static bool isElement(xmlNodePtr node)
+{
+    return (node != NULL && node->type == XML_ELEMENT_NODE);
+}
+
+static bool isFirewall(xmlNodePtr node)
+{
+    const char *name = FROMXMLCAST(node->name);
+    return (strcmp(name, Firewall::TYPENAME) == 0 ||
+            strcmp(name, Cluster::TYPENAME) == 0);
+}
+
+static string attrValue(xmlAttrPtr attr)
+{
+    xmlNodePtr text = attr->children;
+    if (text && text->type == XML_TEXT_NODE && text->next == NULL)
+        return FROMXMLCAST(text->content);
+    xmlChar *v = xmlNodeListGetString(attr->doc, attr->children, 1);
+    string res = (v) ? FROMXMLCAST(v) : "";
+    xmlFree(v);
+    return res;
+}
+
+static string getAttr(xmlNodePtr node, const char *name)
+{
+    for (xmlAttrPtr attr=node->properties; attr; attr=attr->next)
+        if (strcmp(FROMXMLCAST(attr->name), name) == 0) return attrValue(attr);
+    return "";
+}
+
+static xmlNodePtr enclosingFirewall(xmlNodePtr node)
+{
+    for (xmlNodePtr p=node; isElement(p); p=p->parent)
+        if (isFirewall(p)) return p;
+    return NULL;
+}
+
+
+/*
+ * Finds elements of the XML tree that are needed to build the target
+ * firewall or cluster. Objects are kept or dropped as a whole: if a
+ * rule refers to an interface of another firewall, that firewall is
+ * kept with all its children. References are found by looking up
+ * every attribute value and every piece of text in the index of
+ * string ids. This catches the references that are not ObjectRef
+ * elements as well, such as the branch ruleset of a rule or the
+ * network zone of an interface, and may keep an object or two that
+ * is not really used, which is harmless.
+ */
+class ReferenceClosure
+{
+    map<string, xmlNodePtr> ids;
+    list<xmlNodePtr> clusters;
+    list<xmlNodePtr> named_targets;
+    set<xmlNodePtr> whole;
+    set<xmlNodePtr> skeleton;
+    deque<xmlNodePtr> queue;
+    bool uses_dynamic_groups;
+
+    void indexTree(xmlNodePtr node, const string &target);
+    xmlNodePtr find(const string &id);
+    void keepPath(xmlNodePtr node);
+    void addObject(xmlNodePtr node);
+    void scanReferences(xmlNodePtr node);
+    bool usesFirewall(xmlNodePtr node, const set<xmlNodePtr> &targets);
+    void prune(xmlNodePtr node);
+
+public:
+
+    ReferenceClosure() : uses_dynamic_groups(false) {}
+
+    /*
+     * returns false if the whole tree has to be loaded: the target
+     * was not found or the closure includes dynamic groups, which
+     * pick their members from the whole database
+     */
+    bool build(xmlNodePtr root, const string &target);
+    void pruneTree(xmlNodePtr root) { prune(root); }
+};
+
+void ReferenceClosure::indexTree(xmlNodePtr node, const string &target)
+{
+    for (xmlNodePtr cur=node->children; cur; cur=cur->next)
+    {
+        if (!isElement(cur)) continue;
+        string id = getAttr(cur, "id");
+        if (!id.empty()) ids[id] = cur;
+        if (isFirewall(cur))
+        {
+            if (strcmp(FROMXMLCAST(cur->name), Cluster::TYPENAME) == 0)
+                clusters.push_back(cur);
+            if (getAttr(cur, "name") == target) named_targets.push_back(cur);
+        }
+        indexTree(cur, target);
+    }
+}
+
+xmlNodePtr ReferenceClosure::find(const string &id)
+{
+    map<string, xmlNodePtr>::iterator i = ids.find(id);
+    return (i != ids.end()) ? i->second : NULL;
+}
+
+void ReferenceClosure::keepPath(xmlNodePtr node)
+{
+    for (xmlNodePtr p=node; isElement(p); p=p->parent)
+        if (!skeleton.insert(p).second) break;
+}
+
+void ReferenceClosure::addObject(xmlNodePtr node)
+{
+    xmlNodePtr top = node;
+    while (isElement(top->parent) && !isFolder(top->parent)) top = top->parent;
+
+    for (xmlNodePtr p=top; isElement(p); p=p->parent)
+        if (whole.count(p)) return;
+
+    whole.insert(top);
+    queue.push_back(top);
+    keepPath(top->parent);
+}
+
+void ReferenceClosure::scanReferences(xmlNodePtr node)
+{
+    if (strcmp(FROMXMLCAST(node->name), DynamicGroup::TYPENAME) == 0)
+    {
+        uses_dynamic_groups = true;
+        return;
+    }
+
+    for (xmlAttrPtr attr=node->properties; attr; attr=attr->next)
+    {
+        if (strcmp(FROMXMLCAST(attr->name), "id") == 0) continue;
+        xmlNodePtr obj = find(attrValue(attr));
+        if (obj) addObject(obj);
+    }
+
+    for (xmlNodePtr cur=node->children; cur && !uses_dynamic_groups;
+         cur=cur->next)
+    {
+        if (isElement(cur))
+        {
+            scanReferences(cur);
+            continue;
+        }
+        if (cur->type != XML_TEXT_NODE || cur->content == NULL) continue;
+        string text = FROMXMLCAST(cur->content);
+        string::size_type b = text.find_first_not_of(" \t\r\n");
+        if (b == string::npos) continue;
+        string::size_type e = text.find_last_not_of(" \t\r\n");
+        xmlNodePtr obj = find(text.substr(b, e - b + 1));
+        if (obj) addObject(obj);
+    }
+}
+
+/*
+ * cluster uses a firewall if its failover or state synchronization
+ * groups refer to interfaces of that firewall
+ */
+bool ReferenceClosure::usesFirewall(xmlNodePtr node,
+                                    const set<xmlNodePtr> &targets)
+{
+    for (xmlNodePtr cur=node->children; cur; cur=cur->next)
+    {
+        if (!isElement(cur)) continue;
+        xmlNodePtr obj = find(getAttr(cur, "ref"));
+        if (obj && targets.count(enclosingFirewall(obj))) return true;
+        if (usesFirewall(cur, targets)) return true;
+    }
+    return false;
+}
+
+bool ReferenceClosure::build(xmlNodePtr root, const string &target)
+{
+    indexTree(root, target);
+
+    // target can be given by name or by string id, the id can also be
+    // that of a rule when a single rule is compiled
+    list<xmlNodePtr> candidates = named_targets;
+    xmlNodePtr by_id = find(target);
+    if (by_id) candidates.push_back(by_id);
+    if (candidates.empty()) return false;
+
+    set<xmlNodePtr> targets;
+    for (list<xmlNodePtr>::iterator i=candidates.begin();
+         i!=candidates.end(); ++i)
+    {
+        xmlNodePtr fw = enclosingFirewall(*i);
+        if (fw == NULL) return false;
+        targets.insert(fw);
+    }
+
+    skeleton.insert(root);
+    for (set<xmlNodePtr>::iterator i=targets.begin(); i!=targets.end(); ++i)
+        addObject(*i);
+
+    // member firewall is compiled in the context of its clusters
+    for (list<xmlNodePtr>::iterator i=clusters.begin(); i!=clusters.end(); ++i)
+    {
+        if (targets.count(*i) == 0 && usesFirewall(*i, targets))
+            addObject(*i);
+    }
+
+    // compilers use standard objects by id; libraries other than the
+    // Standard library only need to exist
+    for (int id=FWObjectDatabase::ANY_ADDRESS_ID;
+         id<=FWObjectDatabase::DUMMY_INTERFACE_ID; ++id)
+    {
+        string s_id = FWObjectDatabase::findStringId(id);
+        if (s_id.empty()) continue;
+        xmlNodePtr obj = find(s_id);
+        if (obj == NULL) continue;
+        if (id != FWObjectDatabase::STANDARD_LIB_ID && isFolder(obj))
+            keepPath(obj);
+        else
+            addObject(obj);
+    }
+
+    while (!queue.empty() && !uses_dynamic_groups)
+    {
+        xmlNodePtr obj = queue.front();
+        queue.pop_front();
+        scanReferences(obj);
+    }
+
+    return !uses_dynamic_groups;
+}
+
+void ReferenceClosure::prune(xmlNodePtr node)
+{
+    xmlNodePtr cur = node->children;
+    while (cur)
+    {
+        xmlNodePtr next = cur->next;
+        if (isElement(cur) && whole.count(cur) == 0)
+        {
+            if (skeleton.count(cur)) prune(cur);
+            else
+            {
+                xmlUnlinkNode(cur);
+                xmlFreeNode(cur);
+            }
+        }
+        cur = next;
+    }
+}
+
+
+bool FWObjectDatabase::_pruneForPartialLoad(xmlNodePtr root)
+{
+    ReferenceClosure closure;
+    if (!closure.build(root, partial_load_target)) return false;
+    closure.pruneTree(root);
+    return true;
+}
@@ -60,15 +60,15 @@ using namespace libfwbuilder;
  */
 void FWObjectDatabase::findObjectsInGroup(Group *g, set<FWObject *> &res)
 {
-    searchId++;
-    _findObjectsInGroup(g, res);
+    VisitMark visited;
+    _findObjectsInGroup(g, res, visited);
 }
 
-void FWObjectDatabase::_findObjectsInGroup(Group *g, set<FWObject *> &res)
+void FWObjectDatabase::_findObjectsInGroup(Group *g, set<FWObject *> &res,
+                                           VisitMark &visited)
 {
-    if (g->size()==0 || g->getInt(".searchId")==searchId) return;
-    
-    g->setInt(".searchId",searchId);
+    if (g->size()==0 || !visited.visit(g)) return;
+
     FWObjectReference *ref;
     Group *sg;
     FWObject *obj;
@@ -93,7 +93,7 @@ void FWObjectDatabase::_findObjectsInGroup(Group *g, set<FWObject *> &res)
            continue;
        }
        
-       _findObjectsInGroup(sg,res);
+       _findObjectsInGroup(sg, res, visited);
     }    
 }
 
@@ -126,11 +126,76 @@ Firewall* FWObjectDatabase::_findFirewallByNameRecursive(FWObject* db,
     return NULL; // not found
 }
 
+/*
+ * Candidates come from the name index. If more than one firewall has
+ * this name, the recursive scan decides which one comes first in the
+ * tree.
+ */
 Firewall* FWObjectDatabase::findFirewallByName(const string &name) throw(FWException)
 {
+    const SearchIndex::posting_list &lst = search_index.getObjectsWithName(name);
+    Firewall *found = NULL;
+    int matches = 0;
+    for (SearchIndex::posting_list::const_iterator i=lst.begin();
+         i!=lst.end(); ++i)
+    {
+        FWObject *o = *i;
+        if (Firewall::cast(o) && o->isChildOf(this) &&
+            o->getParent()->getId()!=FWObjectDatabase::DELETED_OBJECTS_ID)
+        {
+            found = static_cast<Firewall*>(o);
+            matches++;
+        }
+    }
+    if (matches == 1) return found;
     return _findFirewallByNameRecursive(this, name);
 }
 
+/*
+ * Same as o->getPath() == path but compares names of o and its
+ * parents with parts of the path in place instead of building the
+ * path string. Also checks that o is in the tree of root.
+ */
+static bool pathMatches(const FWObject *o, const FWObject *root,
+                        const string &path)
+{
+    string::size_type pos = path.length();
+    const FWObject *p = o;
+    for (; p != NULL; p = p->getParent())
+    {
+        const string &name = p->getName();
+        if (pos < name.length() + 1) return false;
+        pos -= name.length() + 1;
+        if (path[pos] != '/' ||
+            path.compare(pos + 1, name.length(), name) != 0) return false;
+        if (p->getParent() == NULL) break;
+    }
+    return (pos == 0 && p == root);
+}
+
+void FWObjectDatabase::findObjectsByPath(const string &path,
+                                         list<FWObject*> &res)
+{
+    /*
+     * Object names can contain '/', so every part of the path that
+     * follows a '/' can be the name of the object we are looking for.
+     */
+    for (string::size_type pos = path.rfind('/'); pos != string::npos;
+         pos = (pos == 0) ? string::npos : path.rfind('/', pos - 1))
+    {
+        const SearchIndex::posting_list &lst =
+            search_index.getObjectsWithName(path.substr(pos + 1));
+        for (SearchIndex::posting_list::const_iterator i=lst.begin();
+             i!=lst.end(); ++i)
+        {
+            FWObject *o = *i;
+            if (FWReference::cast(o)) continue;
+            if (pathMatches(o, this, path)) res.push_back(o);
+        }
+    }
+    if (pathMatches(this, this, path)) res.push_front(this);
+}
+
 //#define DEBUG_WHERE_USED 1
 
 bool FWObjectDatabase::_isInIgnoreList(FWObject *o)
@@ -145,12 +210,26 @@ bool FWObjectDatabase::_isInIgnoreList(FWObject *o)
  ***********************************************************************
  */
 
+/*
+ * true if object o is in the subtree rooted at top and is not inside
+ * of any object that findWhereObjectIsUsed skips (options, deleted
+ * objects library)
+ */
+bool FWObjectDatabase::_isReachableFrom(FWObject *o, FWObject *top)
+{
+    for (FWObject *p=o; p!=NULL; p=p->getParent())
+    {
+        if (_isInIgnoreList(p)) return false;
+        if (p == top) return true;
+    }
+    return false;
+}
+
 /**
  *  Finds references to object 'o' in a subtree rooted at object
- *  'p'. Skips 'deleted objects' library. Avoids circular group
- *  references using temporary flags set in objects this method
- *  visits. Results are placed in the set resset. This function
- *  returns the following objects as the results:
+ *  'p'. Skips 'deleted objects' library. Results are placed in the
+ *  set resset. This function returns the following objects as the
+ *  results:
  *
  *  - references that point to the object (FWObjectReference,
  * FWServiceReference objects). Note that the reference itself is
@@ -160,112 +239,94 @@ bool FWObjectDatabase::_isInIgnoreList(FWObject *o)
  * is returned as part of the resset.
  *
  * - group objects which are parents of the object <o>.
+ *
+ * - rules that use <o> as a branch rule set or tag object, interfaces
+ * that use it as network zone and clusters <o> is a member of.
+ *
+ * Candidates come from the reverse reference index, each one is then
+ * checked to be inside of <p>.
  */
 void FWObjectDatabase::findWhereObjectIsUsed(FWObject *o,
                                              FWObject *p,
                                              std::set<FWObject *> &resset)
 {
-    searchId++;
-    _findWhereObjectIsUsed(o, p, resset, searchId);
-}
+    set<FWObject*> users;
+    usage_index.getUsers(o->getId(), users);
+    if (RuleSet::cast(o)) usage_index.getUsersByName(o->getName(), users);
 
-bool FWObjectDatabase::_findWhereObjectIsUsed(FWObject *o,
-                                              FWObject *p,
-                                              std::set<FWObject *> &resset,
-                                              int search_id)
-{
-    bool res = false;
-    if ( _isInIgnoreList(p)) return res;
-    if (p->size()==0) return res;
-    if (p->getInt(".search_id")==search_id) return p->getBool(".searchResult");
-
-// set flags to break indefinite recursion in case we encounter circular groups
-    p->setInt(".search_id", search_id);
-    p->setBool(".searchResult", false);
-
-    Interface *intf = Interface::cast(p);
-    if (intf)
+    for (set<FWObject*>::iterator i=users.begin(); i!=users.end(); ++i)
     {
-        string netzone_id = intf->getStr("network_zone");
-        FWObject *netzone = findInIndex(FWObjectDatabase::getIntId(netzone_id));
-        if (netzone == o)
-        {
-            resset.insert(p);
-            res = true;
-        }
-    }
+        FWObject *user = *i;
 
-    PolicyRule *rule = PolicyRule::cast(p);
-    if (rule)
-    {
-        if (rule->getAction() == PolicyRule::Branch)
+        if (FWReference::cast(user))
         {
-            FWObject *ruleset = rule->getBranch();
-            if (o==ruleset)
-            {
-                resset.insert(p);
-                res = true;
-            }
+            if (_isReachableFrom(user->getParent(), p)) resset.insert(user);
+            continue;
         }
 
-        if (rule->getTagging())
+        Interface *intf = Interface::cast(user);
+        if (intf)
         {
-            FWObject *tagobj = rule->getTagObject();
-            if (o==tagobj)
-            {
-                resset.insert(p);
-                res = true;
-            }
+            if (intf->size() > 0 && _isReachableFrom(intf, p))
+                resset.insert(intf);
+            continue;
         }
-    }
 
-    NATRule *nat_rule = NATRule::cast(p);
-    if (nat_rule && nat_rule->getAction() == NATRule::Branch)
-    {
-        FWObject *ruleset = nat_rule->getBranch();
-        if (o==ruleset)
-        {
-            resset.insert(p);
-            res = true;
-        }
-    }
+        // branch rule set and tag object are stored in rule options
+        FWObject *rule = user->getParent();
+        if (!FWOptions::cast(user) || rule == NULL) continue;
+        if (!_isReachableFrom(rule, p)) continue;
 
-    if (Firewall::isA(o) && Cluster::isA(p))
-    {
-        if (Cluster::cast(p)->hasMember(Firewall::cast(o)))
+        PolicyRule *policy_rule = PolicyRule::cast(rule);
+        if (policy_rule)
         {
-            resset.insert(p);
-            res = true;
+            if (policy_rule->getAction() == PolicyRule::Branch &&
+                policy_rule->getBranch() == o)
+                resset.insert(rule);
+
+            if (policy_rule->getTagging() && policy_rule->getTagObject() == o)
+                resset.insert(rule);
         }
+
+        NATRule *nat_rule = NATRule::cast(rule);
+        if (nat_rule && nat_rule->getAction() == NATRule::Branch &&
+            nat_rule->getBranch() == o)
+            resset.insert(rule);
     }
-   
-    FWObject::iterator i1 = p->begin();
-    for ( ; i1!=p->end(); ++i1)
+
+    FWObject *parent = o->getParent();
+    if (parent && _isReachableFrom(parent, p)) resset.insert(parent);
+
+    if (Firewall::isA(o)) _findClustersUsingFirewall(o, p, resset);
+}
+
+/*
+ * Members of cluster groups are references to interfaces of member
+ * firewalls (or to firewalls in old data files)
+ */
+void FWObjectDatabase::_findClustersUsingFirewall(FWObject *fw,
+                                                  FWObject *p,
+                                                  std::set<FWObject *> &resset)
+{
+    list<FWObject*> targets = fw->getByTypeDeep(Interface::TYPENAME);
+    targets.push_back(fw);
+
+    for (list<FWObject*>::iterator i=targets.begin(); i!=targets.end(); ++i)
     {
-        FWReference  *ref = FWReference::cast(*i1);
-        if (ref!=NULL)
-        {  // child is a reference
-            FWObject *g = ref->getPointer();
-            if (o->getId() == g->getId())
-            {
-                resset.insert(*i1);
-                res = true;
-            }
-        }
-        else    // child is a regular object, not a reference
+        set<FWObject*> users;
+        usage_index.getUsers((*i)->getId(), users);
+        for (set<FWObject*>::iterator j=users.begin(); j!=users.end(); ++j)
         {
-            if (o->getId() == (*i1)->getId())
+            if (!FWReference::cast(*j)) continue;
+            for (FWObject *c=(*j)->getParent(); c!=NULL; c=c->getParent())
             {
-                resset.insert(p);
-                res = true;
-                // still run search recursively, the same object could be
-                // used in rules if it is a firewall
+                if (!Cluster::isA(c)) continue;
+                if (resset.count(c) == 0 && _isReachableFrom(c, p) &&
+                    Cluster::cast(c)->hasMember(Firewall::cast(fw)))
+                    resset.insert(c);
+                break;
             }
-            _findWhereObjectIsUsed(o, *i1, resset, search_id);
         }
     }
-
-    p->setBool(".searchResult", res);
-    return res;
 }
 
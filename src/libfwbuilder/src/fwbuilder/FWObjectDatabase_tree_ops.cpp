@@ -46,21 +46,142 @@
 
 #include <iostream>
 #include <sstream>
+#include <map>
 
 using namespace std;
 using namespace libfwbuilder;
 
 
+/*
+ * Content signature of an object subtree. Signatures are built only
+ * from the data FWObject::cmp() and its overloads look at, so objects
+ * that compare equal always have equal signatures. Signature of a
+ * parent includes signatures of its children regardless of their
+ * order because cmp() does not care about the order either. Two
+ * subtrees with different signatures are known to be different
+ * without calling cmp(), which is expensive because it compares
+ * children of a group pairwise.
+ */
+class ContentSignatures
+{
+    map<FWObject*, unsigned int> signatures;
+
+    static unsigned int hashString(unsigned int h, const string &str)
+    {
+        // FNV-1a
+        for (string::const_iterator i=str.begin(); i!=str.end(); ++i)
+        {
+            h ^= (unsigned char)(*i);
+            h *= 16777619U;
+        }
+        return hashInt(h, int(str.size()));
+    }
+
+    static unsigned int hashInt(unsigned int h, int val)
+    {
+        unsigned int v = (unsigned int)val;
+        for (int n=0; n<4; ++n)
+        {
+            h ^= (v & 0xff);
+            h *= 16777619U;
+            v >>= 8;
+        }
+        return h;
+    }
+
+    static unsigned int scramble(unsigned int h)
+    {
+        h ^= h >> 16;
+        h *= 0x85ebca6bU;
+        h ^= h >> 13;
+        h *= 0xc2b2ae35U;
+        h ^= h >> 16;
+        return h;
+    }
+
+public:
+
+    unsigned int get(FWObject *obj);
+
+    /*
+     * must be called when obj changes. Signatures of its parents
+     * change too.
+     */
+    void forget(FWObject *obj)
+    {
+        for (FWObject *p=obj; p!=NULL; p=p->getParent())
+            signatures.erase(p);
+    }
+
+    /*
+     * must be called before children of obj are deleted
+     */
+    void forgetChildren(FWObject *obj)
+    {
+        for (FWObject::iterator i=obj->begin(); i!=obj->end(); ++i)
+        {
+            signatures.erase(*i);
+            forgetChildren(*i);
+        }
+    }
+};
+
+unsigned int ContentSignatures::get(FWObject *obj)
+{
+    map<FWObject*, unsigned int>::iterator it = signatures.find(obj);
+    if (it != signatures.end()) return it->second;
+
+    unsigned int h = 2166136261U;
+
+    FWReference *ref = FWReference::cast(obj);
+    if (ref != NULL)
+    {
+        // FWReference::cmp() compares only the pointer
+        h = hashInt(h, ref->getPointerIdDirect());
+        h = hashString(h, ref->getPointerStrIdDirect());
+    } else
+    {
+        h = hashString(h, obj->getTypeName());
+        h = hashString(h, obj->getName());
+        h = hashString(h, obj->getComment());
+        h = hashInt(h, obj->getRO());
+        for (AttributeStore::const_iterator i=obj->dataBegin();
+             i!=obj->dataEnd(); ++i)
+        {
+            h = hashInt(h, i->first);
+            h = hashString(h, i->second->getValue());
+        }
+        const set<string> &keywords = obj->getKeywords();
+        for (set<string>::const_iterator i=keywords.begin();
+             i!=keywords.end(); ++i)
+            h = hashString(h, *i);
+        h = hashInt(h, obj->size());
+
+        unsigned int children = 0;
+        for (FWObject::iterator i=obj->begin(); i!=obj->end(); ++i)
+            children += scramble(get(*i));
+        h = hashInt(h, int(children));
+    }
+
+    signatures[obj] = h;
+    return h;
+}
+
+
 class FWObjectTreeScanner {
 
     FWObjectDatabase         *treeRoot;
-    map<int,FWObject*>        srcMap;
-    map<int,FWObject*>        dstMap;
+    ObjectIndex               srcMap;
+    ObjectIndex               dstMap;
+    ContentSignatures         srcSignatures;
+    ContentSignatures         dstSignatures;
     FWObjectDatabase::ConflictResolutionPredicate *crp;
     bool                         defaultCrp;
     int                          reference_object_id_offset;
-    void walkTree(map<int,FWObject*> &m,FWObject *root);
+    void walkTree(ObjectIndex &m,FWObject *root);
     void addRecursively(FWObject *src);
+    bool sameContent(FWObject *dst, FWObject *src);
+    bool equalTrees(FWObject *dst, FWObject *src);
 
     public:
 
@@ -90,10 +211,10 @@ class FWObjectTreeScanner {
  *
  * Here, in effect, I am artifically adding IDs to references.
  */
-void FWObjectTreeScanner::walkTree(map<int,FWObject*> &m,
+void FWObjectTreeScanner::walkTree(ObjectIndex &m,
                                    FWObject *root)
 {
-    if (root->haveId())  m[root->getId()]=root;
+    if (root->haveId())  m.insert(root->getId(), root);
 
     if (FWReference::cast(root)!=NULL)
     {
@@ -103,7 +224,7 @@ void FWObjectTreeScanner::walkTree(map<int,FWObject*> &m,
         // points to, plus some offset.
         // I can not just generate new uniq id because I need to be able
         // to find this object later, and for that its id must be predictable.
-        m[reference_object_id_offset+r->getPointerId()]=root;
+        m.insert(reference_object_id_offset+r->getPointerId(), root);
     }
 
     for (FWObject::iterator i=root->begin(); i!=root->end(); i++)
@@ -120,12 +241,12 @@ void FWObjectTreeScanner::addRecursively(FWObject *src)
 
     addRecursively(src->getParent());
 
-    if (dstMap[src->getId()]==NULL)
+    if (dstMap.find(src->getId())==NULL)
     {
         // last arg.==false : do not call method init() of the new object to
         // make sure it doesn't create its children
         FWObject *o1 = treeRoot->create(src->getTypeName(), -1, false);
-        FWObject *pdst = dstMap[src->getParent()->getId()];
+        FWObject *pdst = dstMap.find(src->getParent()->getId());
         assert(pdst!=NULL);
 
         // no validation is necessary - this copies existing tree
@@ -186,11 +307,11 @@ void FWObjectTreeScanner::scanAndAdd(FWObject *dst,FWObject *source)
         if (FWReference::cast(o1)!=NULL)
         {
             int pid   = FWReference::cast(o1)->getPointerId();
-            FWObject *o2   = dstMap[pid];
+            FWObject *o2   = dstMap.find(pid);
 
             if (o2==NULL)
             {
-                FWObject *osrc = srcMap[ pid ];
+                FWObject *osrc = srcMap.find(pid);
                 if (osrc==NULL)
                     cerr << "Object with ID=" << pid
                          << " (" << FWObjectDatabase::getStringId(pid) << ") "
@@ -213,10 +334,10 @@ void FWObjectTreeScanner::scanAndAdd(FWObject *dst,FWObject *source)
         if ( !sid.empty() )
         {
             int pid = FWObjectDatabase::getIntId(sid);
-            FWObject *o2 = dstMap[pid];
+            FWObject *o2 = dstMap.find(pid);
             if (o2==NULL)
             {
-                FWObject *osrc = srcMap[ pid ];
+                FWObject *osrc = srcMap.find(pid);
                 addRecursively( osrc);
             }
         }
@@ -224,6 +345,50 @@ void FWObjectTreeScanner::scanAndAdd(FWObject *dst,FWObject *source)
 
 }
 
+/*
+ * Same as dst->cmp(src, true) but uses content signatures to reject
+ * different subtrees right away and to find matching children without
+ * comparing them pairwise. Source tree does not change while we
+ * merge, signatures of the objects in destination tree are dropped
+ * whenever merge() modifies them.
+ */
+bool FWObjectTreeScanner::sameContent(FWObject *dst, FWObject *src)
+{
+    if (!dst->cmp(src, false)) return false;
+    if (dstSignatures.get(dst) != srcSignatures.get(src)) return false;
+    return equalTrees(dst, src);
+}
+
+bool FWObjectTreeScanner::equalTrees(FWObject *dst, FWObject *src)
+{
+    if (!dst->cmp(src, false)) return false;
+    if (FWReference::cast(dst)!=NULL) return true;
+    if (dst->size()!=src->size()) return false;
+
+    /*
+     * Children are not necessarily in the same order in two groups.
+     * Like FWObject::cmp(), match each child of dst with the first
+     * child of src that is equal to it and has not been matched yet,
+     * but only look at the children with the same signature.
+     */
+    multimap<unsigned int, FWObject*> candidates;
+    for (FWObject::iterator j=src->begin(); j!=src->end(); ++j)
+        candidates.insert(make_pair(srcSignatures.get(*j), *j));
+
+    for (FWObject::iterator i=dst->begin(); i!=dst->end(); ++i)
+    {
+        pair<multimap<unsigned int, FWObject*>::iterator,
+             multimap<unsigned int, FWObject*>::iterator> range =
+            candidates.equal_range(dstSignatures.get(*i));
+        multimap<unsigned int, FWObject*>::iterator k = range.first;
+        for ( ; k!=range.second; ++k)
+            if (equalTrees(*i, k->second)) break;
+        if (k==range.second) return false;
+        candidates.erase(k);
+    }
+    return true;
+}
+
 // #define DEBUG_MERGE 1
 
 void FWObjectTreeScanner::merge(FWObject *dst, FWObject *src)
@@ -256,14 +421,14 @@ void FWObjectTreeScanner::merge(FWObject *dst, FWObject *src)
         {
             for (FWObject::iterator i=dstdobj->begin(); i!=dstdobj->end(); i++)
             {
-                FWObject *sobj = srcMap[ (*i)->getId() ];
+                FWObject *sobj = srcMap.find((*i)->getId());
                 if(sobj!=NULL && sobj->getParent()->getId()!=dobjId)
                     deletedObjects.push_back(*i);
             }
             for (FWObject::iterator i=deletedObjects.begin(); i!=deletedObjects.end(); i++)
             {
+                dstMap.erase((*i)->getId());
                 dstroot->recursivelyRemoveObjFromTree( *i );
-                dstMap[ (*i)->getId() ] = NULL;
             }
         }
     }
@@ -287,19 +452,20 @@ void FWObjectTreeScanner::merge(FWObject *dst, FWObject *src)
         if (FWReference::cast( *i ))
         {
             FWReference *r=FWReference::cast(*i);
-            dobj= dstMap[reference_object_id_offset + r->getPointerId()];
-        } else dobj= dstMap[ (*i)->getId() ];
+            dobj= dstMap.find(reference_object_id_offset + r->getPointerId());
+        } else dobj= dstMap.find((*i)->getId());
 
         if (dobj==NULL)
         {
             sobj = *i;
             FWObject *o1 = treeRoot->create( sobj->getTypeName());
 
-            FWObject *pdst = dstMap[ src->getId() ];
+            FWObject *pdst = dstMap.find(src->getId());
             assert(pdst!=NULL);
 
             // no validation is necessary - this copies existing tree
             pdst->add(o1, false);
+            dstSignatures.forget(o1);
 
 #ifdef DEBUG_MERGE
             cerr << "--------------------------------" << endl;
@@ -328,7 +494,7 @@ void FWObjectTreeScanner::merge(FWObject *dst, FWObject *src)
  * objects with the same ID are equal. Here we specifically look for a
  * case when objects with the same ID have different attributes.
  */
-            if (dobj->cmp(*i, true)) continue; // compare recursively
+            if (sameContent(dobj, *i)) continue; // compare recursively
 
 /* such object exists in destination tree but is different Since we
  * traverse the tree from the root towards leaves, it won't help much
@@ -374,6 +540,8 @@ void FWObjectTreeScanner::merge(FWObject *dst, FWObject *src)
                             dobj->dump(true,true);
                             cerr << endl;
 #endif
+                            dstSignatures.forgetChildren(dobj);
+                            dstSignatures.forget(dobj);
                             dobj->duplicate( (*i), false );
                         }
                     } else merge( dobj , *i );
@@ -389,6 +557,8 @@ void FWObjectTreeScanner::merge(FWObject *dst, FWObject *src)
                     dobj->dump(true,true);
                     cerr << endl;
 #endif
+                    dstSignatures.forgetChildren(dobj);
+                    dstSignatures.forget(dobj);
                     dobj->duplicate( (*i), false );
                 }
             }
@@ -457,11 +627,11 @@ void FWObjectDatabase::findDuplicateIds(FWObjectDatabase *ndb, set<int> &dupids)
         db2 = ndb;
         db1 = this;
     }
-    for (map<int, FWObject*>::iterator it=db1->obj_index.begin();
+    for (ObjectIndex::const_iterator it=db1->obj_index.begin();
          it!=db1->obj_index.end(); ++it)
     {
-        int id = it->first;
-        if (db2->obj_index.count(id) != 0)
+        int id = it.getId();
+        if (db2->obj_index.contains(id))
         {
             // skip standard IDs
             if (id <= DELETED_OBJECTS_ID) continue;
@@ -487,6 +657,60 @@ void FWObjectDatabase::merge( FWObjectDatabase *ndb,
     busy = false;
 }
 
+/*
+ * Copies made by recursivelyCopySubtree() carry attribute
+ * ".copy_of_<source tree>" with id of the original object, this is
+ * how we avoid making another copy of the same object when it is
+ * referenced from several places or copied by several calls. This
+ * class maps ids of the originals to their copies so we do not have
+ * to search the whole tree for the attribute every time. The tree is
+ * scanned only once, when the first lookup is made.
+ */
+class FWObjectDatabase::SubtreeCopyIndex
+{
+    ObjectIndex copies;
+    bool scanned;
+
+    void scan(FWObject *obj)
+    {
+        string val = obj->getStr(dedup_attribute);
+        if (!val.empty()) add(atoi(val.c_str()), obj);
+        for (FWObject::iterator i=obj->begin(); i!=obj->end(); ++i)
+            scan(*i);
+    }
+
+public:
+
+    string dedup_attribute;
+
+    SubtreeCopyIndex(FWObject *source_root) : scanned(false)
+    {
+        char s[64];
+        snprintf(s, sizeof(s), ".copy_of_%p", source_root);
+        dedup_attribute = s;
+    }
+
+    /*
+     * if there are several copies of the same object, the one found
+     * first in the tree wins, just like with findObjectByAttribute()
+     */
+    void add(int source_id, FWObject *copy)
+    {
+        if (scanned && copies.find(source_id)==NULL)
+            copies.insert(source_id, copy);
+    }
+
+    FWObject* find(FWObjectDatabase *db, int source_id)
+    {
+        if (!scanned)
+        {
+            scanned = true;
+            scan(db);
+        }
+        return copies.find(source_id);
+    }
+};
+
 /**
  * Copy <source> object and all its children, recursively, into <this>
  * object tree starting from <target>. <target> is a parent of the copy
@@ -497,24 +721,30 @@ FWObject* FWObjectDatabase::recursivelyCopySubtree(FWObject *target,
                                                    FWObject *source,
                                                    std::map<int,int> &id_map)
 {
-    char s[64];
-    snprintf(s, sizeof(s), ".copy_of_%p", source->getRoot());
-    string dedup_attribute = s;
+    SubtreeCopyIndex copies(source->getRoot());
 
     FWObject *nobj = _recursively_copy_subtree(target, source, id_map,
-                                             dedup_attribute);
+                                               copies);
 
     fixReferences(nobj, id_map);
 
     // one more pass to fix references in other firewalls and groups
-    // we might have copied.
+    // we might have copied. Skip those that are inside of the subtree
+    // we have already fixed.
+    set<FWObject*> fixed;
+    fixed.insert(nobj);
     for (map<int,int>::const_iterator i=id_map.begin(); i!=id_map.end(); ++i)
     {
         int new_id = i->second;   // new id
         FWObject *new_obj = findInIndex(new_id);
         if (Firewall::cast(new_obj) || Group::cast(new_obj))
+        {
+            FWObject *p = new_obj;
+            while (p!=NULL && fixed.count(p)==0) p = p->getParent();
+            if (p!=NULL) continue;
             fixReferences(new_obj, id_map);
-
+            fixed.insert(new_obj);
+        }
     }
 
     return nobj;
@@ -526,15 +756,12 @@ FWObject* FWObjectDatabase::recursivelyCopySubtree(FWObject *target,
  */
 int FWObjectDatabase::fixReferences(FWObject *obj, const map<int,int> &map_ids)
 {
-    int total_counter = 0;
-    for (map<int,int>::const_iterator it=map_ids.begin(); it!=map_ids.end(); ++it)
-        total_counter += obj->replaceRef(it->first, it->second);
-    return total_counter;
+    return obj->replaceRefs(map_ids);
 }
 
 FWObject* FWObjectDatabase::_recursively_copy_subtree(
     FWObject *target, FWObject *source, std::map<int,int> &id_map,
-    const string &dedup_attribute)
+    SubtreeCopyIndex &copies)
 {
     target->checkReadOnly();
 
@@ -547,7 +774,7 @@ FWObject* FWObjectDatabase::_recursively_copy_subtree(
         {
             FWObject *netzone = source->getRoot()->findInIndex(nzid);
             if (netzone)
-                _copy_foreign_obj_aux(target, netzone, id_map, dedup_attribute);
+                _copy_foreign_obj_aux(target, netzone, id_map, copies);
         }
     }
 
@@ -555,14 +782,15 @@ FWObject* FWObjectDatabase::_recursively_copy_subtree(
     {
         int miface_id = FWObjectDatabase::getIntId(source->getStr("master_iface"));
         FWObject *miface = source->getRoot()->findInIndex(miface_id);
-        if (miface) _copy_foreign_obj_aux(target, miface, id_map, dedup_attribute);
+        if (miface) _copy_foreign_obj_aux(target, miface, id_map, copies);
     }
 
     FWObject *nobj = create(source->getTypeName());
     nobj->clearChildren();
     nobj->shallowDuplicate(source, true);
     id_map[source->getId()] = nobj->getId();
-    nobj->setInt(dedup_attribute, source->getId());
+    nobj->setInt(copies.dedup_attribute, source->getId());
+    copies.add(source->getId(), nobj);
     // no validation is necessary - this copies existing tree
     target->add(nobj, false);
 
@@ -572,7 +800,7 @@ FWObject* FWObjectDatabase::_recursively_copy_subtree(
         FWObject *old_obj = *m;
         if (RuleSet::cast(old_obj)!=NULL) continue;
         if (FWReference::cast(old_obj)!=NULL) continue;
-        _recursively_copy_subtree(nobj, old_obj, id_map, dedup_attribute);
+        _recursively_copy_subtree(nobj, old_obj, id_map, copies);
     }
 
     for(list<FWObject*>::iterator m=source->begin(); m!=source->end(); ++m) 
@@ -605,9 +833,7 @@ FWObject* FWObjectDatabase::_recursively_copy_subtree(
             }
 
             // Check if we have already copied the same object before
-            char s[64];
-            snprintf(s, sizeof(s), "%d", old_ptr_obj->getId());
-            n_ptr_obj = findObjectByAttribute(dedup_attribute, s);
+            n_ptr_obj = copies.find(this, old_ptr_obj->getId());
             if (n_ptr_obj)
             {
                 nobj->addRef(n_ptr_obj);
@@ -619,10 +845,10 @@ FWObject* FWObjectDatabase::_recursively_copy_subtree(
             // Problem: what if old_ptr_obj is interface or an address of
             // interface or a rule etc ? Check isPrimaryObject().
             // 
-            _copy_foreign_obj_aux(nobj, old_ptr_obj, id_map, dedup_attribute);
+            _copy_foreign_obj_aux(nobj, old_ptr_obj, id_map, copies);
 
         } else
-            _recursively_copy_subtree(nobj, old_obj, id_map, dedup_attribute);
+            _recursively_copy_subtree(nobj, old_obj, id_map, copies);
     }
 
     return nobj;
@@ -630,7 +856,7 @@ FWObject* FWObjectDatabase::_recursively_copy_subtree(
 
 void FWObjectDatabase::_copy_foreign_obj_aux(
     FWObject *target, FWObject *source,
-    map<int,int> &id_map, const std::string &dedup_attribute)
+    map<int,int> &id_map, SubtreeCopyIndex &copies)
 {
     FWObject *parent_obj = source;
     while (parent_obj && !parent_obj->isPrimaryObject())
@@ -654,7 +880,7 @@ void FWObjectDatabase::_copy_foreign_obj_aux(
         new_parent = _recursively_copy_subtree(new_parent,
                                                parent_obj,
                                                id_map,
-                                               dedup_attribute);
+                                               copies);
         // we just copied old object to the target data tree.
         // Copy of obj is either new_parent, or one of its
         // children. In the process of making this copy,
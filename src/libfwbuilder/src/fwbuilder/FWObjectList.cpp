@@ -0,0 +1,77 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  $Id$
+
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#include "config.h"
+#include "fwbuilder/libfwbuilder-config.h"
+
+#include "fwbuilder/FWObjectList.h"
+#include "fwbuilder/FWObject.h"
+
+using namespace std;
+using namespace libfwbuilder;
+
+
+void FWObjectList::buildChildArray() const
+{
+    int n = int(base_list::size());
+    if (n > array_capacity)
+    {
+        delete[] array;
+        // grow in steps so that a list that keeps growing one child
+        // at a time does not reallocate every time
+        array_capacity = (n > 2 * array_capacity) ? n : 2 * array_capacity;
+        array = new FWObject*[array_capacity];
+    }
+    FWObject **p = array;
+    for (const_iterator i=begin(); i!=end(); ++i)
+    {
+        (*i)->array_pos = int(p - array);
+        *p++ = *i;
+    }
+    array_size = n;
+}
+
+int FWObjectList::indexOf(const FWObject *o) const
+{
+    // array_pos of a child added by push_back() after the array was
+    // built, or of an object that has been moved to another list,
+    // may be stale; the check against the array catches both
+    const FWObject* const *a = getChildArray();
+    int pos = o->array_pos;
+    if (pos >= 0 && pos < array_size && a[pos] == o) return pos;
+    buildChildArray();
+    pos = o->array_pos;
+    if (pos >= 0 && pos < array_size && array[pos] == o) return pos;
+    return -1;
+}
+
+void FWObjectList::freeChildArray()
+{
+    delete[] array;
+    array = NULL;
+    array_capacity = 0;
+    array_size = -1;
+}
@@ -0,0 +1,290 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  $Id$
+
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#ifndef  __FWOBJECTLIST_HH_FLAG__
+#define  __FWOBJECTLIST_HH_FLAG__
+
+#include <stddef.h>
+#include <list>
+
+
+namespace libfwbuilder
+{
+
+class FWObject;
+
+/**
+ * List of children of FWObject.
+ *
+ * This is std::list<FWObject*> that can also provide the same
+ * pointers as a contiguous array, so that code that walks children of
+ * the same objects over and over again (rule elements of a rule,
+ * objects in a rule element) does not have to chase list nodes
+ * scattered over the heap. The array is allocated and filled when it
+ * is first needed after the list has changed; objects whose children
+ * are never accessed by index do not have it.
+ *
+ * std::list is a protected base. Iteration and read access are
+ * exposed as they are, methods that change the list are redefined to
+ * keep the array in sync. Methods that can not do that cheaply
+ * (merge, remove_if and others) are not available, and the object can
+ * not be passed where a reference to std::list is expected. The base
+ * is protected rather than private because classes derived from
+ * FWObject use the unqualified name "list" in their code, which
+ * refers to this base class there. The only change
+ * the array can not see is assignment to a child through an iterator
+ * or through front() and back() (*i = o); code that does this must
+ * call invalidateChildArray().
+ */
+class FWObjectList : protected std::list<FWObject*>
+{
+public:
+
+    typedef std::list<FWObject*> base_list;
+
+    typedef base_list::value_type value_type;
+    typedef base_list::reference reference;
+    typedef base_list::const_reference const_reference;
+    typedef base_list::size_type size_type;
+    typedef base_list::difference_type difference_type;
+    typedef base_list::iterator iterator;
+    typedef base_list::const_iterator const_iterator;
+    typedef base_list::reverse_iterator reverse_iterator;
+    typedef base_list::const_reverse_iterator const_reverse_iterator;
+
+    using base_list::begin;
+    using base_list::end;
+    using base_list::rbegin;
+    using base_list::rend;
+    using base_list::size;
+    using base_list::max_size;
+    using base_list::empty;
+    using base_list::front;
+    using base_list::back;
+
+private:
+
+    mutable FWObject **array;
+    mutable int array_size;   // -1 if array is out of date
+    mutable int array_capacity;
+
+    // position of this object in the child array of its parent, set
+    // when the parent builds the array; see indexOf()
+    int array_pos;
+
+    void buildChildArray() const;
+    void freeChildArray();
+
+public:
+
+    FWObjectList() :
+        base_list(), array(NULL), array_size(-1), array_capacity(0),
+        array_pos(-1) {}
+    FWObjectList(const FWObjectList &other) :
+        base_list(other), array(NULL), array_size(-1), array_capacity(0),
+        array_pos(-1) {}
+    ~FWObjectList() { freeChildArray(); }
+
+    FWObjectList& operator=(const FWObjectList &other)
+    {
+        base_list::operator=(other);
+        array_size = -1;
+        return *this;
+    }
+
+    /**
+     * lists are equal if they hold the same child pointers in the
+     * same order, as with std::list
+     */
+    bool operator==(const FWObjectList &other) const
+    { return (const base_list&)(*this) == (const base_list&)(other); }
+    bool operator!=(const FWObjectList &other) const
+    { return ! (*this == other); }
+
+    void invalidateChildArray() { array_size = -1; }
+
+    /**
+     * returns pointer to the contiguous array of children. The array
+     * stays valid until the list is changed.
+     */
+    FWObject* const* getChildArray() const
+    {
+        if (array_size < 0) buildChildArray();
+        return array;
+    }
+
+    /**
+     * memory taken by the list nodes and by the child array
+     */
+    size_t getStorageBytes() const
+    {
+        return base_list::size() * (2 * sizeof(void*) + sizeof(FWObject*)) +
+            array_capacity * sizeof(FWObject*);
+    }
+
+    /**
+     * returns n-th child; n must be less than size()
+     */
+    FWObject* getChild(int n) const { return getChildArray()[n]; }
+
+    /**
+     * returns position of child o in the list, or -1 if o is not in
+     * it. Children remember their position when the child array is
+     * built, so this takes constant time while the list does not
+     * change.
+     */
+    int indexOf(const FWObject *o) const;
+
+    void push_back(FWObject *o)
+    {
+        base_list::push_back(o);
+        if (array_size >= 0 && array_size < array_capacity)
+            array[array_size++] = o;
+        else
+            array_size = -1;
+    }
+
+    void pop_back()
+    {
+        base_list::pop_back();
+        if (array_size > 0) array_size--;
+    }
+
+    void push_front(FWObject *o)
+    {
+        base_list::push_front(o);
+        array_size = -1;
+    }
+
+    void pop_front()
+    {
+        base_list::pop_front();
+        array_size = -1;
+    }
+
+    iterator insert(iterator pos, FWObject *o)
+    {
+        array_size = -1;
+        return base_list::insert(pos, o);
+    }
+
+    void insert(iterator pos, size_type n, FWObject *o)
+    {
+        array_size = -1;
+        base_list::insert(pos, n, o);
+    }
+
+    template <class InputIterator>
+    void insert(iterator pos, InputIterator first, InputIterator last)
+    {
+        array_size = -1;
+        base_list::insert(pos, first, last);
+    }
+
+    iterator erase(iterator pos)
+    {
+        array_size = -1;
+        return base_list::erase(pos);
+    }
+
+    iterator erase(iterator first, iterator last)
+    {
+        array_size = -1;
+        return base_list::erase(first, last);
+    }
+
+    void clear()
+    {
+        base_list::clear();
+        array_size = -1;
+    }
+
+    void resize(size_type n, FWObject *o = NULL)
+    {
+        base_list::resize(n, o);
+        array_size = -1;
+    }
+
+    template <class InputIterator>
+    void assign(InputIterator first, InputIterator last)
+    {
+        base_list::assign(first, last);
+        array_size = -1;
+    }
+
+    void swap(base_list &other)
+    {
+        base_list::swap(other);
+        array_size = -1;
+    }
+
+    void splice(iterator pos, base_list &other)
+    {
+        base_list::splice(pos, other);
+        array_size = -1;
+    }
+
+    void splice(iterator pos, base_list &other, iterator i)
+    {
+        base_list::splice(pos, other, i);
+        array_size = -1;
+    }
+
+    void splice(iterator pos, base_list &other, iterator first, iterator last)
+    {
+        base_list::splice(pos, other, first, last);
+        array_size = -1;
+    }
+
+    void reverse()
+    {
+        base_list::reverse();
+        array_size = -1;
+    }
+
+    void unique()
+    {
+        base_list::unique();
+        array_size = -1;
+    }
+
+    void sort()
+    {
+        base_list::sort();
+        array_size = -1;
+    }
+
+    template <class Compare>
+    void sort(Compare cmp)
+    {
+        base_list::sort(cmp);
+        array_size = -1;
+    }
+};
+
+}
+
+#endif
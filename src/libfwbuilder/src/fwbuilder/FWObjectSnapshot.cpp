@@ -0,0 +1,278 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  $Id$
+
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#include "config.h"
+#include "fwbuilder/libfwbuilder-config.h"
+
+#include "fwbuilder/FWObjectSnapshot.h"
+#include "fwbuilder/FWObjectDatabase.h"
+#include "fwbuilder/ThreadTools.h"
+
+#include <algorithm>
+
+using namespace std;
+using namespace libfwbuilder;
+
+
+/*
+ * Snapshots registered for each database. FWObject checks
+ * FWObject::active_snapshots before it calls objectChanging() so
+ * that programs that never create snapshots (compilers) do not pay
+ * for the lookup.
+ */
+class SnapshotRegistry
+{
+public:
+    Mutex mutex;
+    map<const FWObjectDatabase*, list<FWObjectSnapshot*> > snapshots;
+};
+
+static SnapshotRegistry& registry()
+{
+    static SnapshotRegistry *reg = new SnapshotRegistry();
+    return *reg;
+}
+
+list<FWObjectSnapshot*> FWObjectSnapshot::getSnapshots(
+    const FWObjectDatabase *db)
+{
+    list<FWObjectSnapshot*> res;
+    if (db == NULL) return res;
+    SnapshotRegistry &reg = registry();
+    reg.mutex.lock();
+    map<const FWObjectDatabase*, list<FWObjectSnapshot*> >::iterator it =
+        reg.snapshots.find(db);
+    if (it != reg.snapshots.end()) res = it->second;
+    reg.mutex.unlock();
+    return res;
+}
+
+void FWObjectSnapshot::objectChanging(FWObject *o)
+{
+    list<FWObjectSnapshot*> snapshots = getSnapshots(o->getRoot());
+    for (list<FWObjectSnapshot*>::iterator i=snapshots.begin();
+         i!=snapshots.end(); ++i)
+        (*i)->save(o);
+}
+
+void FWObjectSnapshot::objectDetached(FWObject *o)
+{
+    list<FWObjectSnapshot*> snapshots = getSnapshots(o->getRoot());
+    for (list<FWObjectSnapshot*>::iterator i=snapshots.begin();
+         i!=snapshots.end(); ++i)
+        (*i)->detached(o);
+}
+
+void FWObjectSnapshot::objectDestroyed(FWObject *o)
+{
+    list<FWObjectSnapshot*> snapshots = getSnapshots(o->getRoot());
+    for (list<FWObjectSnapshot*>::iterator i=snapshots.begin();
+         i!=snapshots.end(); ++i)
+        (*i)->destroyed(o);
+}
+
+void FWObjectSnapshot::databaseDestroyed(FWObjectDatabase *db)
+{
+    list<FWObjectSnapshot*> snapshots = getSnapshots(db);
+    for (list<FWObjectSnapshot*>::iterator i=snapshots.begin();
+         i!=snapshots.end(); ++i)
+        (*i)->detach();
+}
+
+
+FWObjectSnapshot::FWObjectSnapshot(FWObjectDatabase *_db) : db(_db)
+{
+    // the store holds shadows and frozen copies. It keeps read-only
+    // objects read-only but lets us add children to them.
+    store = new FWObjectDatabase();
+    store->setIgnoreReadOnlyFlag(true);
+
+    SnapshotRegistry &reg = registry();
+    reg.mutex.lock();
+    reg.snapshots[db].push_back(this);
+    FWObject::active_snapshots++;
+    reg.mutex.unlock();
+}
+
+FWObjectSnapshot::~FWObjectSnapshot()
+{
+    detach();
+    for (list<FWObject*>::iterator i=owned.begin(); i!=owned.end(); ++i)
+        delete *i;
+    delete store;
+}
+
+void FWObjectSnapshot::detach()
+{
+    if (db == NULL) return;
+
+    SnapshotRegistry &reg = registry();
+    reg.mutex.lock();
+    list<FWObjectSnapshot*> &lst = reg.snapshots[db];
+    lst.remove(this);
+    if (lst.empty()) reg.snapshots.erase(db);
+    FWObject::active_snapshots--;
+    reg.mutex.unlock();
+
+    db = NULL;
+    saved.clear();
+    saved_parent.clear();
+}
+
+/*
+ * Attributes of the database object itself are saved in the store.
+ */
+void FWObjectSnapshot::save(FWObject *o)
+{
+    if (saved.find(o) != saved.end()) return;
+
+    FWObject *shadow = store;
+    if (o != db)
+    {
+        shadow = store->create(o->getTypeName(), -1, false);
+        if (shadow == NULL) return;
+        owned.push_back(shadow);
+    }
+    shadow->shallowDuplicate(o, false);
+
+    SavedState &state = saved[o];
+    state.shadow = shadow;
+    state.children.assign(o->begin(), o->end());
+    for (vector<FWObject*>::iterator i=state.children.begin();
+         i!=state.children.end(); ++i)
+        saved_parent[*i] = o;
+}
+
+/*
+ * Object is about to be removed from its parent. If it is in the
+ * saved list of children of its parent, the snapshot needs its
+ * subtree as it was, and the object may be deleted soon.
+ */
+void FWObjectSnapshot::detached(FWObject *o)
+{
+    map<FWObject*, FWObject*>::iterator p = saved_parent.find(o);
+    if (p == saved_parent.end()) return;
+    vector<FWObject*> &lst = saved[p->second].children;
+    saved_parent.erase(p);
+    std::replace(lst.begin(), lst.end(), o, freeze(o));
+}
+
+/*
+ * Called from the destructor of FWObject where the object can not be
+ * copied anymore. Normally it has been detached from its parent and
+ * frozen by now.
+ */
+void FWObjectSnapshot::destroyed(FWObject *o)
+{
+    map<FWObject*, FWObject*>::iterator p = saved_parent.find(o);
+    if (p != saved_parent.end())
+    {
+        vector<FWObject*> &lst = saved[p->second].children;
+        std::replace(lst.begin(), lst.end(), o, (FWObject*)NULL);
+        saved_parent.erase(p);
+    }
+    release(o);
+}
+
+/*
+ * drops saved state of the object when it is not needed anymore
+ */
+void FWObjectSnapshot::release(FWObject *o)
+{
+    saved_map::iterator s = saved.find(o);
+    if (s == saved.end()) return;
+    vector<FWObject*> &lst = s->second.children;
+    for (vector<FWObject*>::iterator i=lst.begin(); i!=lst.end(); ++i)
+    {
+        map<FWObject*, FWObject*>::iterator p = saved_parent.find(*i);
+        if (p != saved_parent.end() && p->second == o) saved_parent.erase(p);
+    }
+    saved.erase(s);
+}
+
+const FWObject* FWObjectSnapshot::stateOf(FWObject *o) const
+{
+    saved_map::const_iterator s = saved.find(o);
+    return (s == saved.end()) ? o : s->second.shadow;
+}
+
+/*
+ * Builds children of dst from the snapshot state of src. Frozen
+ * copies are already in that state and are copied as they are. If
+ * release is true, saved state of the objects is dropped once it has
+ * been copied: these objects can only be reached through the frozen
+ * copy we are building.
+ */
+void FWObjectSnapshot::copySubtree(FWObject *src, FWObject *dst, bool release)
+{
+    saved_map::iterator s = saved.find(src);
+    vector<FWObject*> children;
+    if (s != saved.end()) children = s->second.children;
+    else children.assign(src->begin(), src->end());
+    if (release) this->release(src);
+
+    FWObjectDatabase *root = dst->getRoot();
+    for (vector<FWObject*>::iterator i=children.begin();
+         i!=children.end(); ++i)
+    {
+        FWObject *c = *i;
+        if (c == NULL) continue;
+        if (c->getRoot() == store)
+        {
+            dst->addCopyOf(c, false);
+            continue;
+        }
+        FWObject *n = root->create(c->getTypeName(), -1, false);
+        if (n == NULL) continue;
+        dst->add(n, false);
+        n->shallowDuplicate(stateOf(c), false);
+        copySubtree(c, n, release);
+    }
+}
+
+FWObject* FWObjectSnapshot::freeze(FWObject *o)
+{
+    FWObject *copy = store->create(o->getTypeName(), -1, false);
+    copy->shallowDuplicate(stateOf(o), false);
+    copySubtree(o, copy, true);
+    owned.push_back(copy);
+    return copy;
+}
+
+FWObjectDatabase* FWObjectSnapshot::materialize()
+{
+    if (db == NULL) return NULL;
+
+    FWObjectDatabase *res = new FWObjectDatabase();
+    res->setIgnoreReadOnlyFlag(true);
+    res->shallowDuplicate(stateOf(db), false);
+    copySubtree(db, res, false);
+    res->setIgnoreReadOnlyFlag(false);
+    res->setFileName(db->getFileName());
+    res->reIndex();
+    res->setDirty(false);
+    return res;
+}
@@ -0,0 +1,151 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  $Id$
+
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#ifndef  __FWOBJECTSNAPSHOT_HH_FLAG__
+#define  __FWOBJECTSNAPSHOT_HH_FLAG__
+
+#include <stddef.h>
+#include <map>
+#include <list>
+#include <vector>
+
+
+namespace libfwbuilder
+{
+
+class FWObject;
+class FWObjectDatabase;
+
+/**
+ * Copy-on-write snapshot of the object tree of a database.
+ *
+ * Creating a snapshot copies nothing. The first time an object is
+ * about to change after that, FWObject asks the snapshot to save it:
+ * its attributes are copied to a "shadow" object (see
+ * FWObject::shallowDuplicate()) and the list of pointers to its
+ * children is copied as well. Objects that never change are shared
+ * with the live tree, so the snapshot costs memory and time
+ * proportional to the number of changed objects rather than to the
+ * size of the tree. When an object that was part of the snapshot is
+ * removed from its parent, the snapshot makes a frozen copy of its
+ * subtree.
+ *
+ * materialize() builds a regular FWObjectDatabase that looks the way
+ * the database looked when the snapshot was created, using the same
+ * object ids.
+ *
+ * Changes are detected by the methods of FWObject that modify
+ * attributes and children (setStr(), setName(), shallowDuplicate(),
+ * add(), remove() etc.). Data members of derived classes changed by
+ * their own setters outside of shallowDuplicate() and direct
+ * manipulation of the std::list of children are not noticed. An
+ * object deleted while it is still a child of another object is
+ * dropped from the snapshot.
+ *
+ * If the database is destroyed before the snapshot, the snapshot
+ * becomes invalid and materialize() returns NULL.
+ */
+class FWObjectSnapshot
+{
+    class SavedState
+    {
+    public:
+        FWObject *shadow;
+        // live objects or frozen copies that belong to the store
+        std::vector<FWObject*> children;
+
+        SavedState() : shadow(NULL) {}
+    };
+
+    typedef std::map<FWObject*, SavedState> saved_map;
+
+    FWObjectDatabase *db;
+    FWObjectDatabase *store;
+    saved_map saved;
+    // live object -> object whose saved list of children has it
+    std::map<FWObject*, FWObject*> saved_parent;
+    // shadows and frozen copies, do not have parents in the store
+    std::list<FWObject*> owned;
+
+    FWObjectSnapshot(const FWObjectSnapshot&);
+    FWObjectSnapshot& operator=(const FWObjectSnapshot&);
+
+    const FWObject* stateOf(FWObject *o) const;
+    void copySubtree(FWObject *src, FWObject *dst, bool release);
+    void release(FWObject *o);
+    FWObject* freeze(FWObject *o);
+
+    static std::list<FWObjectSnapshot*> getSnapshots(
+        const FWObjectDatabase *db);
+
+protected:
+
+    /**
+     * called when object o of the database is about to change, is
+     * removed from its parent and is destroyed. Derived classes can
+     * override these to track changes without saving anything (see
+     * DatabaseSaver).
+     */
+    virtual void save(FWObject *o);
+    virtual void detached(FWObject *o);
+    virtual void destroyed(FWObject *o);
+
+    /**
+     * stops tracking changes of the database
+     */
+    void detach();
+
+public:
+
+    FWObjectSnapshot(FWObjectDatabase *db);
+    virtual ~FWObjectSnapshot();
+
+    bool isValid() const { return db != NULL; }
+
+    /**
+     * number of objects saved because they have changed since the
+     * snapshot was created
+     */
+    int getSavedCount() const { return int(saved.size()); }
+
+    /**
+     * creates new database with the contents of the tree at the time
+     * the snapshot was created. Caller owns the returned object.
+     */
+    FWObjectDatabase* materialize();
+
+    /**
+     * these are called by FWObject and FWObjectDatabase
+     */
+    static void objectChanging(FWObject *o);
+    static void objectDetached(FWObject *o);
+    static void objectDestroyed(FWObject *o);
+    static void databaseDestroyed(FWObjectDatabase *db);
+};
+
+}
+
+#endif
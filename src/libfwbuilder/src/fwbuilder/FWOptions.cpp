@@ -78,10 +78,13 @@ xmlNodePtr FWOptions::toXML(xmlNodePtr root) throw(FWException)
         xml_name.empty() ? STRTOXMLCAST(getTypeName()) : STRTOXMLCAST(xml_name),
         NULL);
 
-    for(map<string, string>::const_iterator i=data.begin(); i!=data.end(); ++i)
+    vector<const AttributeStore::Slot*> attributes;
+    data.getSortedByName(attributes);
+    for(vector<const AttributeStore::Slot*>::const_iterator i=attributes.begin();
+        i!=attributes.end(); ++i)
     {
-        const string &name  = (*i).first;
-        const string &value = (*i).second;
+        const string &name  = (*i)->getName();
+        const string &value = (*i)->getValue();
 
         if (name[0]=='.') continue;
         
@@ -69,6 +69,7 @@ void FWReference::fromXML(xmlNodePtr root)  throw(FWException)
     // FWObjectDatabase::getIntId returns -1.
     int_ref = FWObjectDatabase::getIntId(str_ref);
     FREEXMLBUFF(n);
+    _updateUsageIndex();
 }
 
 // Note that XML elements represented by FWReference have only one
@@ -98,6 +99,7 @@ FWObject& FWReference::shallowDuplicate(const FWObject *_other,
     const FWReference *other = FWReference::constcast(_other);
     int_ref = other->int_ref;
     str_ref = other->str_ref;
+    _updateUsageIndex();
     return *this;
 }
 
@@ -119,20 +121,24 @@ void FWReference::setPointer(FWObject *p)
     if(p) setPointerId(p->getId());
     else
     {
+        _aboutToChange();
         int_ref = -1;
         str_ref = "";
+        _updateUsageIndex();
     }
 }
 
 void FWReference::setPointerId(int ref_id)
 {
     //setInt("ref" , ref_id );
+    _aboutToChange();
     int_ref = ref_id;
     // if object with id ref_id has not been loaded into database
     // yet, FWObjectDatabase::getStringId returns empty string.
     // This works as postponed initialization.
     // We really need string id only in toXML.
     str_ref = FWObjectDatabase::getStringId(int_ref);
+    _updateUsageIndex();
 }
 
 FWObject *FWReference::getPointer()
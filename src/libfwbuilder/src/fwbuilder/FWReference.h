@@ -90,6 +90,7 @@ public:
      * is used.
      */
     int getPointerIdDirect() const { return int_ref; }
+    const std::string& getPointerStrIdDirect() const { return str_ref; }
 
 };
 
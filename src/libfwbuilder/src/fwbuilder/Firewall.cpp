@@ -333,6 +333,7 @@ FWObject& Firewall::duplicate(const FWObject *obj,
 
 FWObject& Firewall::duplicateForUndo(const FWObject *obj) throw(FWException)
 {
+    _aboutToChange();
     setRO(false);
     FWObject *their_mgmt = obj->getFirstByType(Management::TYPENAME);
     if (their_mgmt)
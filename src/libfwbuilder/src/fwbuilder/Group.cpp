@@ -97,6 +97,7 @@ bool Group::hasMember(FWObject *o)
  */
 FWObject& Group::duplicateForUndo(const FWObject *obj) throw(FWException)
 {
+    _aboutToChange();
     setRO(false);
     if ((obj->size() && FWReference::cast(obj->front())!=NULL) ||
         (this->size() && FWReference::cast(this->front())!=NULL))
@@ -125,16 +125,19 @@ xmlNodePtr IPv4::toXML(xmlNodePtr xml_parent_node) throw(FWException)
 
 void IPv4::setAddress(const InetAddr &a)
 {
+    _aboutToChange();
     inet_addr_mask->setAddress(a);
 }
 
 void IPv4::setNetmask(const InetAddr &nm)
 {
+    _aboutToChange();
     inet_addr_mask->setNetmask(nm);
 }
 
 void IPv4::setAddressNetmask(const std::string& s)
 {
+    _aboutToChange();
     delete inet_addr_mask;
     inet_addr_mask = new InetAddrMask(s);
 }
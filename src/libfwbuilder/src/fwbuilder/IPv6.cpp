@@ -128,16 +128,19 @@ xmlNodePtr IPv6::toXML(xmlNodePtr xml_parent_node) throw(FWException)
 
 void IPv6::setAddress(const InetAddr &a)
 {
+    _aboutToChange();
     inet_addr_mask->setAddress(a);
 }
 
 void IPv6::setNetmask(const InetAddr &nm)
 {
+    _aboutToChange();
     inet_addr_mask->setNetmask(nm);
 }
 
 void IPv6::setAddressNetmask(const std::string& s)
 {
+    _aboutToChange();
     delete inet_addr_mask;
     inet_addr_mask = new Inet6AddrMask(s);
 }
@@ -0,0 +1,224 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  $Id$
+
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#include "config.h"
+#include "fwbuilder/libfwbuilder-config.h"
+
+#include "fwbuilder/IdRegistry.h"
+#include "fwbuilder/FWObjectDatabase.h"
+
+#ifdef _WIN32
+#  include <process.h>
+#else
+#  include <unistd.h>
+#endif
+#include <stdio.h>
+
+using namespace std;
+using namespace libfwbuilder;
+
+
+// "System" objects use ids < 1000.
+
+static int id_seed = 1000;
+static Mutex id_seed_mutex;
+
+#ifdef _WIN32
+static int cached_pid = _getpid();
+#  ifndef __GNUC__
+#define snprintf sprintf_s
+#  endif
+#else
+static int cached_pid = getpid();
+#endif
+
+IdRegistry* IdRegistry::global()
+{
+    static IdRegistry *registry = new IdRegistry();
+    return registry;
+}
+
+int IdRegistry::generateUniqueId()
+{
+#ifdef __GNUC__
+    return __sync_add_and_fetch(&id_seed, 1);
+#else
+    id_seed_mutex.lock();
+    int res = ++id_seed;
+    id_seed_mutex.unlock();
+    return res;
+#endif
+}
+
+/*
+ * FNV-1a
+ */
+unsigned int IdRegistry::hash(const string &s)
+{
+    unsigned int h = 2166136261U;
+    for (string::const_iterator i=s.begin(); i!=s.end(); ++i)
+    {
+        h ^= (unsigned char)(*i);
+        h *= 16777619U;
+    }
+    return h;
+}
+
+IdRegistry::IdRegistry()
+{
+    setStringId(FWObjectDatabase::ROOT_ID, "root");
+    setStringId(FWObjectDatabase::ANY_ADDRESS_ID, "sysid0");
+    setStringId(FWObjectDatabase::ANY_SERVICE_ID, "sysid1");
+    setStringId(FWObjectDatabase::ANY_INTERVAL_ID, "sysid2");
+    setStringId(FWObjectDatabase::STANDARD_LIB_ID, "syslib000");
+    setStringId(FWObjectDatabase::TEMPLATE_LIB_ID, "syslib100");
+    setStringId(FWObjectDatabase::DELETED_OBJECTS_ID, "sysid99");
+    setStringId(FWObjectDatabase::DUMMY_ADDRESS_ID, "dummyaddressid0");
+    setStringId(FWObjectDatabase::DUMMY_SERVICE_ID, "dummyserviceid0");
+    setStringId(FWObjectDatabase::DUMMY_INTERFACE_ID, "dummyinterfaceid0");
+}
+
+IdRegistry::~IdRegistry()
+{
+}
+
+/*
+ * When both shards have to be locked, shard of the string id is
+ * always locked first.
+ */
+int IdRegistry::registerStringId(const string &s_id)
+{
+    StrShard &ss = strShard(s_id);
+
+    ss.lock.readLock();
+    map<string, int>::iterator i = ss.ids.find(s_id);
+    if (i != ss.ids.end())
+    {
+        int res = i->second;
+        ss.lock.unlock();
+        return res;
+    }
+    ss.lock.unlock();
+
+    ss.lock.writeLock();
+    // another thread could have registered it while we did not hold the lock
+    i = ss.ids.find(s_id);
+    if (i != ss.ids.end())
+    {
+        int res = i->second;
+        ss.lock.unlock();
+        return res;
+    }
+
+    int i_id = generateUniqueId();
+    IntShard &is = intShard(i_id);
+    is.lock.writeLock();
+    is.ids[i_id] = s_id;
+    is.lock.unlock();
+
+    ss.ids[s_id] = i_id;
+    ss.lock.unlock();
+    return i_id;
+}
+
+int IdRegistry::getIntId(const string &s_id)
+{
+    StrShard &ss = strShard(s_id);
+    ss.lock.readLock();
+    map<string, int>::iterator i = ss.ids.find(s_id);
+    int res = (i != ss.ids.end()) ? i->second : -1;
+    ss.lock.unlock();
+    return res;
+}
+
+string IdRegistry::findStringId(int i_id)
+{
+    IntShard &is = intShard(i_id);
+    is.lock.readLock();
+    map<int, string>::iterator i = is.ids.find(i_id);
+    string res = (i != is.ids.end()) ? i->second : string();
+    is.lock.unlock();
+    return res;
+}
+
+string IdRegistry::getStringId(int i_id)
+{
+    IntShard &is = intShard(i_id);
+    is.lock.readLock();
+    map<int, string>::iterator i = is.ids.find(i_id);
+    if (i != is.ids.end())
+    {
+        string res = i->second;
+        is.lock.unlock();
+        return res;
+    }
+    is.lock.unlock();
+
+    // TODO: Use proper GUID algorithm here
+    char id_buf[64];
+    snprintf(id_buf, sizeof(id_buf), "id%dX%d", i_id, cached_pid);
+    string s_id(id_buf);
+
+    StrShard &ss = strShard(s_id);
+    ss.lock.writeLock();
+    is.lock.writeLock();
+    i = is.ids.find(i_id);
+    if (i != is.ids.end())
+    {
+        s_id = i->second;
+    } else
+    {
+        is.ids[i_id] = s_id;
+        ss.ids[s_id] = i_id;
+    }
+    is.lock.unlock();
+    ss.lock.unlock();
+    return s_id;
+}
+
+void IdRegistry::setStringId(int i_id, const string &s_id)
+{
+    StrShard &ss = strShard(s_id);
+    IntShard &is = intShard(i_id);
+    ss.lock.writeLock();
+    is.lock.writeLock();
+    is.ids[i_id] = s_id;
+    ss.ids[s_id] = i_id;
+    is.lock.unlock();
+    ss.lock.unlock();
+}
+
+int IdRegistry::size()
+{
+    int res = 0;
+    for (int n=0; n<NUM_SHARDS; ++n)
+    {
+        int_shards[n].lock.readLock();
+        res += int(int_shards[n].ids.size());
+        int_shards[n].lock.unlock();
+    }
+    return res;
+}
@@ -0,0 +1,152 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  $Id$
+
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#ifndef  __IDREGISTRY_HH_FLAG__
+#define  __IDREGISTRY_HH_FLAG__
+
+#include <string>
+#include <map>
+
+#include "fwbuilder/ThreadTools.h"
+
+
+namespace libfwbuilder
+{
+
+/**
+ * Dictionary that maps integer object ids to string ids used in the
+ * XML file and back. Internally the program operates with integer
+ * ids all the time, string ids are only used when objects are read
+ * from or written to XML.
+ *
+ * Both directions of the mapping are split into NUM_SHARDS shards
+ * selected by hash of the key; each shard is protected by its own
+ * read-write lock, so lookups in different threads almost never wait
+ * for each other and only registration of a new id takes a write
+ * lock.
+ *
+ * Integer ids are allocated from a single process-wide counter
+ * (generateUniqueId()). All databases share the registry returned by
+ * global(), static methods FWObjectDatabase::getIntId(),
+ * getStringId() and registerStringId() work with it.
+ *
+ * There is no registry per database. Those static methods are called
+ * from everywhere, including places that do not know which database
+ * the id belongs to, so a registry that is current only while a
+ * database is loaded or saved registered the same id in different
+ * dictionaries depending on the caller. Integer ids are unique in the
+ * process anyway, sharding takes care of contention between threads
+ * working with different databases. See IdRegistryBench for lookup
+ * throughput.
+ */
+class IdRegistry
+{
+public:
+
+    enum { NUM_SHARDS = 64 };
+
+private:
+
+    struct IntShard
+    {
+        RWLock lock;
+        std::map<int, std::string> ids;
+    };
+
+    struct StrShard
+    {
+        RWLock lock;
+        std::map<std::string, int> ids;
+    };
+
+    IntShard int_shards[NUM_SHARDS];
+    StrShard str_shards[NUM_SHARDS];
+
+    IntShard& intShard(int i_id)
+    { return int_shards[((unsigned int)i_id) % NUM_SHARDS]; }
+    StrShard& strShard(const std::string &s_id)
+    { return str_shards[hash(s_id) % NUM_SHARDS]; }
+
+    static unsigned int hash(const std::string &s);
+
+    IdRegistry(const IdRegistry&);
+    IdRegistry& operator=(const IdRegistry&);
+
+public:
+
+    /**
+     * creates registry with string ids of the "system" objects
+     * (root, sysid0, syslib000 etc) already registered
+     */
+    IdRegistry();
+    virtual ~IdRegistry();
+
+    /**
+     * returns integer id for the string id, allocating new integer
+     * id if this string id has not been seen before
+     */
+    int registerStringId(const std::string &s_id);
+
+    /**
+     * returns integer id for the string id or -1 if it has not been
+     * registered
+     */
+    int getIntId(const std::string &s_id);
+
+    /**
+     * returns string id for the integer id. If there is none yet,
+     * generates unique string id and registers it.
+     */
+    std::string getStringId(int i_id);
+
+    /**
+     * returns string id for the integer id or empty string if there
+     * is none. Never generates new string ids.
+     */
+    std::string findStringId(int i_id);
+
+    /**
+     * assigns new string id to the integer id. Old string id still
+     * maps to the same integer id after this.
+     */
+    void setStringId(int i_id, const std::string &s_id);
+
+    /**
+     * number of integer ids that have string ids
+     */
+    int size();
+
+    /**
+     * process-wide counter of integer ids
+     */
+    static int generateUniqueId();
+
+    static IdRegistry* global();
+};
+
+}
+
+#endif
@@ -73,6 +73,49 @@ extern "C" {
 using namespace std;
 using namespace libfwbuilder;
 
+/*
+ * IPv6 arithmetic works on the address as two 64 bit words in host
+ * byte order: hi holds the first 8 bytes of the address and lo holds
+ * the last 8. This avoids round trips through uint128, which is slow
+ * because its operators are generic (shifts by arbitrary count,
+ * temporaries for every step).
+ */
+static inline void load_in6(const struct in6_addr *a,
+                            uint64_t &hi, uint64_t &lo)
+{
+    const uint32_t *w = (const uint32_t*)(a);
+    hi = (uint64_t(ntohl(w[0])) << 32) | uint64_t(ntohl(w[1]));
+    lo = (uint64_t(ntohl(w[2])) << 32) | uint64_t(ntohl(w[3]));
+}
+
+static inline void store_in6(struct in6_addr *a, uint64_t hi, uint64_t lo)
+{
+    uint32_t *w = (uint32_t*)(a);
+    w[0] = htonl(uint32_t(hi >> 32));
+    w[1] = htonl(uint32_t(hi));
+    w[2] = htonl(uint32_t(lo >> 32));
+    w[3] = htonl(uint32_t(lo));
+}
+
+/*
+ * number of trailing zero bits, n must not be 0
+ */
+static inline int trailing_zeros(uint64_t n)
+{
+#ifdef __GNUC__
+    return __builtin_ctzll(n);
+#else
+    int bits = 0;
+    if ((n & 0xffffffff) == 0) { bits += 32; n >>= 32; }
+    if ((n & 0xffff) == 0) { bits += 16; n >>= 16; }
+    if ((n & 0xff) == 0) { bits += 8; n >>= 8; }
+    if ((n & 0xf) == 0) { bits += 4; n >>= 4; }
+    if ((n & 0x3) == 0) { bits += 2; n >>= 2; }
+    if ((n & 0x1) == 0) { bits += 1; }
+    return bits;
+#endif
+}
+
 /*
  * if data is a string that represents integer number without '.' or ':'
  * in it, call init_from_int
@@ -107,54 +150,30 @@ void InetAddr::init_from_string(const char* data)
 
 void InetAddr::init_from_int(unsigned int len)
 {
-   if (address_family == AF_INET)
-   {
-       if (len > addressLengthBits())
-       {
-           throw FWException(string("Invalid netmask length"));
-       }
-
-       unsigned long nm_bits = 0;
-       int i = len;
-       while (i>0)
-       {
-           nm_bits >>= 1;
-           nm_bits |= 0x80000000;
-           i--;
-       }
-       ipv4.s_addr = htonl(nm_bits);
-   } else
-   {
-       if (len > addressLengthBits())
-       {
-           throw FWException(string("Invalid netmask length"));
-       }
-
-       ((uint32_t *) (&ipv6))[0] = 0xffffffff;
-       ((uint32_t *) (&ipv6))[1] = 0xffffffff;
-       ((uint32_t *) (&ipv6))[2] = 0xffffffff;
-       ((uint32_t *) (&ipv6))[3] = 0xffffffff;
-
-       // bits is number of zeros counting from the right end
-       unsigned int nbits = addressLengthBits() - len;
-       for (int i=3; i>=0; --i)
-       {
-           if (nbits >= 32)
-           {
-               ((uint32_t*)(&ipv6))[i] = 0;
-               nbits -= 32;
-               continue;
-           }
-           uint32_t t = 0xffffffff;
-           for (int k = nbits % 32; k; --k)
-           {
-               t <<= 1;
-               t &= 0xfffffffe;
-           }
-           ((uint32_t*)(&ipv6))[i] = htonl(t);
-           break;
-       }
-   }
+    if (len > addressLengthBits())
+    {
+        throw FWException(string("Invalid netmask length"));
+    }
+
+    if (address_family == AF_INET)
+    {
+        uint32_t nm_bits = (len == 0) ? 0 : (0xffffffff << (32 - len));
+        ipv4.s_addr = htonl(nm_bits);
+    } else
+    {
+        uint64_t all_ones = ~uint64_t(0);
+        uint64_t hi, lo;
+        if (len <= 64)
+        {
+            hi = (len == 0) ? 0 : (all_ones << (64 - len));
+            lo = 0;
+        } else
+        {
+            hi = all_ones;
+            lo = all_ones << (128 - len);
+        }
+        store_in6(&ipv6, hi, lo);
+    }
 }
 
 /*
@@ -181,28 +200,15 @@ bool InetAddr::isValidV4Netmask()
 // uint128 is always in the host order
 void InetAddr::init_from_uint128(uint128 la)
 {
-    ((uint32_t *) (&ipv6))[0] = htonl((la >> 96).to_integer() & 0xffffffff);
-    ((uint32_t *) (&ipv6))[1] = htonl((la >> 64).to_integer() & 0xffffffff);
-    ((uint32_t *) (&ipv6))[2] = htonl((la >> 32).to_integer() & 0xffffffff);
-    ((uint32_t *) (&ipv6))[3] = htonl( la.to_integer() & 0xffffffff);
+    store_in6(&ipv6, (la >> 64).to_base_type(), la.to_base_type());
 }
    
 uint128 InetAddr::to_uint128() const
 {
     assert(isV6());
-    uint128 res;
-    uint128 x = uint64_t(ntohl(((uint32_t *) (&ipv6))[0]));
-    x <<= 96;
-    res |= x;
-    x = uint64_t(ntohl(((uint32_t *) (&ipv6))[1]));
-    x <<= 64;
-    res |= x;
-    x = uint64_t(ntohl(((uint32_t *) (&ipv6))[2]));
-    x <<= 32;
-    res |= x;
-    x = uint64_t(ntohl(((uint32_t *) (&ipv6))[3]));
-    res |= x;
-    return res;
+    uint64_t hi, lo;
+    load_in6(&ipv6, hi, lo);
+    return uint128(lo, hi);
 }
 
 InetAddr::InetAddr(const InetAddr &o)
@@ -277,39 +283,16 @@ int InetAddr::getLength() const
 {
     if (address_family==AF_INET)
     {
-        if (ipv4.s_addr == INADDR_BROADCAST) return addressLengthBits();
         if (ipv4.s_addr == 0) return 0;
-
-        unsigned int n = ntohl(ipv4.s_addr);
-
-        int   i=0;
-        while (n)
-        {
-            n=n<<1;
-            i++;
-        }
-
-        return i;
+        return 32 - trailing_zeros(ntohl(ipv4.s_addr));
     } else
     {
-        int bits = 0;
-        for (int i=3; i>=0; --i)
-        {
-            uint32_t n = ntohl(((uint32_t*)(&ipv6))[i]);
-            if (n==0)
-            {
-                bits += 32;
-                continue;
-            }
-            while ((n & 1) == 0)
-            {
-                bits++;
-                n = n >> 1;
-            }
-            bits = 128 - bits;
-            break;
-        }
-        return bits;
+        uint64_t hi, lo;
+        load_in6(&ipv6, hi, lo);
+        if (lo != 0) return 128 - trailing_zeros(lo);
+        if (hi != 0) return 64 - trailing_zeros(hi);
+        // all zeros, this is what this method always returned for ipv6
+        return 128;
     }
 }
 
@@ -363,6 +346,18 @@ string InetAddr::toString() const
     }
 }
 
+unsigned int InetAddr::_distance_v6(const InetAddr &a2) const
+{
+    uint64_t hi1, lo1, hi2, lo2;
+    load_in6(&ipv6, hi1, lo1);
+    load_in6(&a2.ipv6, hi2, lo2);
+    // only the low 32 bits of the difference are returned, they
+    // do not depend on the borrow from the low word
+    bool lt = (hi1 < hi2 || (hi1 == hi2 && lo1 < lo2));
+    uint64_t res = (lt) ? lo2 - lo1 : lo1 - lo2;
+    return (unsigned int)(res) + 1;
+}
+
 // note that address family of the result is dictated by the address family of
 // "this". Address family of mask must be the same.
 InetAddr InetAddr::opAnd(const InetAddr &mask) const
@@ -374,11 +369,11 @@ InetAddr InetAddr::opAnd(const InetAddr &mask) const
         res.s_addr = htonl(ntohl(ipv4.s_addr) & ntohl(mask.ipv4.s_addr));
         return InetAddr(&res);
     } else {
+        // bitwise operations do not depend on the byte order
         struct in6_addr res;
         for (int i=0; i<4; ++i)
-            ((uint32_t*)(&res))[i] = 
-                htonl(ntohl(((uint32_t*)(&(ipv6)))[i]) &
-                      ntohl(((uint32_t*)(&(mask.ipv6)))[i]));
+            ((uint32_t*)(&res))[i] = ((uint32_t*)(&(ipv6)))[i] &
+                ((uint32_t*)(&(mask.ipv6)))[i];
         return InetAddr(&res);
     }
 }
@@ -395,9 +390,8 @@ InetAddr InetAddr::opOr(const InetAddr &mask) const
     {
         struct in6_addr res;
         for (int i=0; i<4; ++i)
-            ((uint32_t*)(&res))[i] = 
-                htonl(ntohl(((uint32_t*)(&(ipv6)))[i]) |
-                      ntohl(((uint32_t*)(&(mask.ipv6)))[i]));
+            ((uint32_t*)(&res))[i] = ((uint32_t*)(&(ipv6)))[i] |
+                ((uint32_t*)(&(mask.ipv6)))[i];
         return InetAddr(&res);
     }
 }
@@ -411,17 +405,16 @@ InetAddr InetAddr::opPlus(int increment) const
         return InetAddr(&res);
     } else
     {
-        uint128 x = to_uint128();
-        x += increment;
-        InetAddr res(AF_INET6, 0);
-        res.init_from_uint128(x);
-        return res;
-
-//         struct in6_addr res;
-//         InetAddr::_copy_in6_addr(&res, &(ipv6) );
-//         ((uint32_t*)(&res))[3] =
-//             htonl(ntohl( ((uint32_t*)(&(ipv6)))[3]) + increment);
-//         return InetAddr(&res);
+        // increment is sign extended to 128 bits, just like
+        // uint128(int) does it
+        uint64_t hi, lo;
+        load_in6(&ipv6, hi, lo);
+        uint64_t inc = uint64_t(int64_t(increment));
+        uint64_t res_lo = lo + inc;
+        hi += ((increment < 0) ? ~uint64_t(0) : 0) + ((res_lo < lo) ? 1 : 0);
+        struct in6_addr res;
+        store_in6(&res, hi, res_lo);
+        return InetAddr(&res);
     }
 }
 
@@ -434,17 +427,14 @@ InetAddr InetAddr::opMinus(int decrement) const
         return InetAddr(&res);
     } else
     {
-        uint128 x = to_uint128();
-        x -= decrement;
-        InetAddr res(AF_INET6, 0);
-        res.init_from_uint128(x);
-        return res;
-
-//         struct in6_addr res;
-//         InetAddr::_copy_in6_addr(&res, &(ipv6) );
-//         ((uint32_t*)(&res))[3] =
-//             htonl(ntohl( ((uint32_t*)(&(ipv6)))[3]) - decrement);
-//         return InetAddr(&res);
+        uint64_t hi, lo;
+        load_in6(&ipv6, hi, lo);
+        uint64_t dec = uint64_t(int64_t(decrement));
+        uint64_t res_lo = lo - dec;
+        hi -= ((decrement < 0) ? ~uint64_t(0) : 0) + ((lo < dec) ? 1 : 0);
+        struct in6_addr res;
+        store_in6(&res, hi, res_lo);
+        return InetAddr(&res);
     }
 }
 
@@ -456,12 +446,10 @@ bool InetAddr::opLT(const InetAddr &other) const
         return (ntohl( ipv4.s_addr ) < ntohl( other.ipv4.s_addr ));
     } else
     {
-        uint128 a = to_uint128();
-        uint128 b = other.to_uint128();
-        return a < b;
-
-//         return (ntohl(((uint32_t*)(&(ipv6)))[3]) <
-//                 ntohl(((uint32_t*)(&(other.ipv6)))[3]));
+        uint64_t hi1, lo1, hi2, lo2;
+        load_in6(&ipv6, hi1, lo1);
+        load_in6(&other.ipv6, hi2, lo2);
+        return (hi1 < hi2 || (hi1 == hi2 && lo1 < lo2));
     }
 }
 
@@ -473,12 +461,10 @@ bool InetAddr::opGT(const InetAddr &other) const
         return (ntohl( ipv4.s_addr ) > ntohl( other.ipv4.s_addr ));
     } else
     {
-        uint128 a = to_uint128();
-        uint128 b = other.to_uint128();
-        return a > b;
-
-//         return (ntohl(((uint32_t*)(&(ipv6)))[3]) >
-//                 ntohl(((uint32_t*)(&(other.ipv6)))[3]));
+        uint64_t hi1, lo1, hi2, lo2;
+        load_in6(&ipv6, hi1, lo1);
+        load_in6(&other.ipv6, hi2, lo2);
+        return (hi1 > hi2 || (hi1 == hi2 && lo1 > lo2));
     }
 }
 
@@ -516,10 +502,10 @@ InetAddr InetAddr::opCompl() const
     } else
     {
         struct in6_addr res;
-        ((uint32_t *) (&res))[0] = htonl(~(ntohl(((uint32_t *) (&ipv6))[0])));
-        ((uint32_t *) (&res))[1] = htonl(~(ntohl(((uint32_t *) (&ipv6))[1])));
-        ((uint32_t *) (&res))[2] = htonl(~(ntohl(((uint32_t *) (&ipv6))[2])));
-        ((uint32_t *) (&res))[3] = htonl(~(ntohl(((uint32_t *) (&ipv6))[3])));
+        ((uint32_t *) (&res))[0] = ~(((uint32_t *) (&ipv6))[0]);
+        ((uint32_t *) (&res))[1] = ~(((uint32_t *) (&ipv6))[1]);
+        ((uint32_t *) (&res))[2] = ~(((uint32_t *) (&ipv6))[2]);
+        ((uint32_t *) (&res))[3] = ~(((uint32_t *) (&ipv6))[3]);
         return InetAddr(&res);
     }
 }
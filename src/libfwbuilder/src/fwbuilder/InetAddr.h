@@ -90,6 +90,8 @@ class InetAddr
     void init_from_string(const char* data);
     void init_from_int(unsigned int n);
 
+    unsigned int _distance_v6(const InetAddr &a2) const;
+
     public:
     
     explicit InetAddr()
@@ -229,21 +231,7 @@ class InetAddr
         if (address_family==AF_INET)
             return ntohl(a2.ipv4.s_addr) - ntohl(ipv4.s_addr) + 1;
         else
-        {
-            uint128 d1 = to_uint128();
-            uint128 d2 = a2.to_uint128();
-            uint128 res;
-            if (d1 < d2)
-            {
-                res = d2;
-                res -= d1;
-            } else
-            {
-                res = d1;
-                res -= d2;
-            }
-            return res.to_integer()  + 1;
-        }
+            return _distance_v6(a2);
     }
 
     /**
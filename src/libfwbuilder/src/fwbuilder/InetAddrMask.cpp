@@ -189,10 +189,7 @@ unsigned int InetAddrMask::dimension()  const
     int host_part = netmask->addressLengthBits() - masklength;
     if (host_part>=32) return INT_MAX;  // can be >32 if ipv6
 
-    unsigned int u = 1;
-    for (int i=0; i<host_part; ++i) u<<=1;
-
-    return u;
+    return 1u << host_part;
 }
 
 InetAddrMask& InetAddrMask::operator=(const InetAddrMask &o)
@@ -0,0 +1,284 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  $Id$
+
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#include "config.h"
+#include "fwbuilder/libfwbuilder-config.h"
+
+#include "fwbuilder/InetAddrParser.h"
+
+#include <string.h>
+
+using namespace std;
+using namespace libfwbuilder;
+
+
+static inline bool is_digit(char c)
+{
+    return (c >= '0' && c <= '9');
+}
+
+static inline int hex_value(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static inline bool at_end(const char *str, size_t len, size_t pos)
+{
+    return (pos >= len || str[pos] == '/');
+}
+
+/*
+ * Parses dotted decimal ipv4 address starting at str[pos]. Parsing
+ * stops at the end of the string or at '/', pos is left pointing
+ * there, or at the offending character if there was an error.
+ */
+static InetAddrParser::Status parse_v4(const char *str, size_t len,
+                                       size_t &pos, unsigned char *dst,
+                                       int min_parts)
+{
+    int parts = 0;
+    for (;;)
+    {
+        if (pos >= len || !is_digit(str[pos]))
+        {
+            if (at_end(str, len, pos) || str[pos] == '.')
+                return InetAddrParser::INVALID_OCTET;
+            return InetAddrParser::INVALID_CHARACTER;
+        }
+        if (parts == 4) return InetAddrParser::TOO_MANY_PARTS;
+
+        size_t start = pos;
+        unsigned int val = 0;
+        while (pos < len && is_digit(str[pos]))
+        {
+            val = val * 10 + (str[pos] - '0');
+            if (val > 255)
+            {
+                pos = start;
+                return InetAddrParser::INVALID_OCTET;
+            }
+            pos++;
+        }
+        dst[parts++] = (unsigned char)(val);
+
+        if (at_end(str, len, pos)) break;
+        if (str[pos] != '.') return InetAddrParser::INVALID_CHARACTER;
+        pos++;
+    }
+    if (parts < min_parts) return InetAddrParser::TOO_FEW_PARTS;
+    for (int i=parts; i<4; ++i) dst[i] = 0;
+    return InetAddrParser::OK;
+}
+
+/*
+ * Parses ipv6 address starting at str[pos], see parse_v4() for the
+ * meaning of pos.
+ */
+static InetAddrParser::Status parse_v6(const char *str, size_t len,
+                                       size_t &pos, unsigned char *dst)
+{
+    unsigned char tmp[16];
+    int n = 0;
+    int gap = -1;  // where "::" was seen, as offset in tmp
+
+    memset(tmp, 0, sizeof(tmp));
+
+    if (pos < len && str[pos] == ':')
+    {
+        if (pos + 1 >= len || str[pos + 1] != ':')
+            return InetAddrParser::INVALID_CHARACTER;
+        gap = 0;
+        pos += 2;
+    }
+
+    while ( ! (gap == n && at_end(str, len, pos)))
+    {
+        size_t start = pos;
+        unsigned int val = 0;
+        int digits = 0;
+        int h;
+        while (pos < len && (h = hex_value(str[pos])) >= 0)
+        {
+            if (++digits > 4)
+            {
+                pos = start;
+                return InetAddrParser::INVALID_GROUP;
+            }
+            val = (val << 4) | h;
+            pos++;
+        }
+
+        if (pos < len && str[pos] == '.')
+        {
+            // ipv4 address in the last 32 bits, nothing can follow it
+            pos = start;
+            if (n > 12) return InetAddrParser::TOO_MANY_PARTS;
+            InetAddrParser::Status s = parse_v4(str, len, pos, tmp + n, 4);
+            if (s != InetAddrParser::OK) return s;
+            n += 4;
+            break;
+        }
+
+        if (digits == 0)
+        {
+            if (at_end(str, len, pos) || str[pos] == ':')
+                return InetAddrParser::INVALID_GROUP;
+            return InetAddrParser::INVALID_CHARACTER;
+        }
+        if (n == 16)
+        {
+            pos = start;
+            return InetAddrParser::TOO_MANY_PARTS;
+        }
+        tmp[n++] = (unsigned char)(val >> 8);
+        tmp[n++] = (unsigned char)(val & 0xff);
+
+        if (at_end(str, len, pos)) break;
+        if (str[pos] != ':') return InetAddrParser::INVALID_CHARACTER;
+        pos++;
+        if (pos < len && str[pos] == ':')
+        {
+            if (gap >= 0) return InetAddrParser::INVALID_CHARACTER;
+            gap = n;
+            pos++;
+        }
+    }
+
+    if (gap >= 0)
+    {
+        // "::" stands for at least one group of zeros
+        if (n == 16) return InetAddrParser::TOO_MANY_PARTS;
+        int tail = n - gap;
+        memmove(dst + 16 - tail, tmp + gap, tail);
+        memset(dst + gap, 0, 16 - n);
+        memcpy(dst, tmp, gap);
+    } else
+    {
+        if (n < 16) return InetAddrParser::TOO_FEW_PARTS;
+        memcpy(dst, tmp, 16);
+    }
+    return InetAddrParser::OK;
+}
+
+static InetAddrParser::Status parse(int &af, const char *str, size_t len,
+                                    size_t &pos, InetAddr &addr)
+{
+    pos = 0;
+    if (len == 0) return InetAddrParser::EMPTY;
+
+    if (af == AF_UNSPEC)
+        af = (memchr(str, ':', len) != NULL) ? AF_INET6 : AF_INET;
+
+    InetAddrParser::Status s;
+    if (af == AF_INET)
+    {
+        struct in_addr a;
+        s = parse_v4(str, len, pos, (unsigned char*)(&a), 1);
+        if (s == InetAddrParser::OK) addr = InetAddr(&a);
+    } else if (af == AF_INET6)
+    {
+        struct in6_addr a;
+        s = parse_v6(str, len, pos, (unsigned char*)(&a));
+        if (s == InetAddrParser::OK) addr = InetAddr(&a);
+    } else
+        s = InetAddrParser::NOT_SUPPORTED;
+    return s;
+}
+
+InetAddrParser::Status InetAddrParser::parseAddress(
+    int af, const char *str, size_t len, InetAddr &addr, size_t *error_pos)
+{
+    size_t pos;
+    Status s = parse(af, str, len, pos, addr);
+    if (s == OK && pos < len) s = INVALID_CHARACTER;
+    if (s != OK && error_pos != NULL) *error_pos = pos;
+    return s;
+}
+
+InetAddrParser::Status InetAddrParser::parseAddressMask(
+    int af, const char *str, size_t len,
+    InetAddr &addr, InetAddr &netmask, size_t *error_pos)
+{
+    size_t pos;
+    Status s = parse(af, str, len, pos, addr);
+
+    if (s == OK && pos < len)
+    {
+        // str[pos] is '/'
+        pos++;
+        size_t start = pos;
+        if (af == AF_INET && memchr(str + pos, '.', len - pos) != NULL)
+        {
+            struct in_addr nm;
+            s = parse_v4(str, len, pos, (unsigned char*)(&nm), 1);
+            if (s == OK && pos < len) s = INVALID_CHARACTER;
+            if (s == OK) netmask = InetAddr(&nm);
+            else if (s != INVALID_CHARACTER) s = INVALID_NETMASK;
+        } else
+        {
+            int max_bits = (af == AF_INET) ? 32 : 128;
+            int bits = 0;
+            while (pos < len && is_digit(str[pos]) && bits <= max_bits)
+            {
+                bits = bits * 10 + (str[pos] - '0');
+                pos++;
+            }
+            if (pos == start || bits > max_bits)
+            {
+                pos = start;
+                s = INVALID_PREFIX_LENGTH;
+            } else if (pos < len)
+                s = INVALID_CHARACTER;
+            else
+                netmask = InetAddr(af, bits);
+        }
+    } else if (s == OK)
+        netmask = InetAddr::getAllOnes(af);
+
+    if (s != OK && error_pos != NULL) *error_pos = pos;
+    return s;
+}
+
+const char* InetAddrParser::statusString(Status status)
+{
+    switch (status)
+    {
+    case OK: return "no error";
+    case EMPTY: return "empty address";
+    case INVALID_CHARACTER: return "invalid character";
+    case INVALID_OCTET: return "invalid ipv4 octet";
+    case INVALID_GROUP: return "invalid ipv6 group";
+    case TOO_MANY_PARTS: return "address is too long";
+    case TOO_FEW_PARTS: return "address is too short";
+    case INVALID_PREFIX_LENGTH: return "invalid prefix length";
+    case INVALID_NETMASK: return "invalid netmask";
+    case NOT_SUPPORTED: return "address family is not supported";
+    }
+    return "unknown error";
+}
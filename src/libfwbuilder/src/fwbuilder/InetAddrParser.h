@@ -0,0 +1,96 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  $Id$
+
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#ifndef  __INETADDRPARSER_HH_FLAG__
+#define  __INETADDRPARSER_HH_FLAG__
+
+#include <stddef.h>
+
+#include "fwbuilder/InetAddr.h"
+
+
+namespace libfwbuilder
+{
+
+/**
+ * Parser for textual ipv4 and ipv6 addresses, prefixes and netmasks
+ * intended for bulk input such as address table files and object
+ * import. Unlike InetAddr constructors it never throws and never
+ * allocates memory; failure is reported by the status code and the
+ * offset of the character where parsing stopped.
+ *
+ * Accepted ipv4 forms are the same as inet_net_pton() accepts in
+ * decimal notation: one to four octets separated by '.', missing
+ * octets are zero ("10.1" is 10.1.0.0). Accepted ipv6 forms are those
+ * of RFC 4291, including "::" and an ipv4 address in the last 32 bits.
+ * Address may be followed by "/NN" prefix length, and ipv4 address
+ * also by "/a.b.c.d" netmask.
+ */
+class InetAddrParser
+{
+public:
+
+    enum Status
+    {
+        OK = 0,
+        EMPTY,
+        INVALID_CHARACTER,
+        INVALID_OCTET,
+        INVALID_GROUP,
+        TOO_MANY_PARTS,
+        TOO_FEW_PARTS,
+        INVALID_PREFIX_LENGTH,
+        INVALID_NETMASK,
+        NOT_SUPPORTED
+    };
+
+    /**
+     * parses address without prefix length or netmask. If af is
+     * AF_UNSPEC, address family is ipv6 if the string has ':' in it
+     * and ipv4 otherwise. len is the length of the string, the
+     * string does not have to be zero terminated. If error_pos is
+     * not NULL, offset of the character where the error was
+     * detected is stored there.
+     */
+    static Status parseAddress(int af, const char *str, size_t len,
+                               InetAddr &addr, size_t *error_pos=NULL);
+
+    /**
+     * parses address with optional "/NN" prefix length or
+     * "/a.b.c.d" netmask. If there is neither, netmask is set to
+     * the host mask. The address is returned as is, host bits are
+     * not cleared.
+     */
+    static Status parseAddressMask(int af, const char *str, size_t len,
+                                   InetAddr &addr, InetAddr &netmask,
+                                   size_t *error_pos=NULL);
+
+    static const char* statusString(Status status);
+};
+
+}
+
+#endif
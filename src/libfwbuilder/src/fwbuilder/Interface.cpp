@@ -125,6 +125,7 @@ void Interface::duplicateWithIdMapping(const FWObject *src,
     assert(src->getTypeName() == Interface::TYPENAME);
 
     checkReadOnly();
+    _aboutToChange();
 
     shallowDuplicate(src, preserve_id);
 
@@ -346,11 +347,23 @@ bool Interface::isDedicatedFailover() const { return getBool("dedicated_failover
 void Interface::setManagement(bool value) { setBool("mgmt",value); }
 bool Interface::isManagement() const { return (getBool("mgmt")); }
 
-void Interface::setOStatus(bool value) { ostatus=value; }
+void Interface::setOStatus(bool value)
+{
+    _aboutToChange();
+    ostatus = value;
+}
 
-void Interface::setInterfaceType(int _snmp_type) { snmp_type=_snmp_type; }
+void Interface::setInterfaceType(int _snmp_type)
+{
+    _aboutToChange();
+    snmp_type = _snmp_type;
+}
 
-void Interface::setBroadcastBits(int _val) { bcast_bits=_val; }
+void Interface::setBroadcastBits(int _val)
+{
+    _aboutToChange();
+    bcast_bits = _val;
+}
 
 bool  Interface::validateChild(FWObject *o)
 {
@@ -518,6 +531,24 @@ void Interface::replaceReferenceInternal(int old_id, int new_id, int &counter)
     }
 }
 
+void Interface::replaceReferencesInternal(const map<int,int> &id_map,
+                                          int &counter)
+{
+    FWObject::replaceReferencesInternal(id_map, counter);
+
+    string nzid = getStr("network_zone");
+    if (!nzid.empty())
+    {
+        map<int,int>::const_iterator it =
+            id_map.find(FWObjectDatabase::getIntId(nzid));
+        if (it != id_map.end() && it->second != it->first)
+        {
+            setStr("network_zone", FWObjectDatabase::getStringId(it->second));
+            counter++;
+        }
+    }
+}
+
 /*
  * finds all interfaces of the host (or firewall, since class Firewall
  * inherits Host) without scanning whole tree rooted at this. This is
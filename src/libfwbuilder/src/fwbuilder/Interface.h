@@ -68,6 +68,8 @@ private:
 protected:
 
     virtual void replaceReferenceInternal(int oldfw_id, int newfw_id, int &counter);
+    virtual void replaceReferencesInternal(const std::map<int,int> &id_map,
+                                           int &counter);
         
 public:
     
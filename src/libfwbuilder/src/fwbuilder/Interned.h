@@ -0,0 +1,224 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  $Id$
+
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#ifndef  __INTERNED_HH_FLAG__
+#define  __INTERNED_HH_FLAG__
+
+#include <stddef.h>
+#include <string>
+#include <set>
+#include <map>
+#include <ostream>
+
+#include "fwbuilder/ThreadTools.h"
+
+
+namespace libfwbuilder
+{
+
+/**
+ * Immutable handle to a value kept in a process-wide pool of shared
+ * values. Equal values are stored once no matter how many objects
+ * hold them, so copying a handle and comparing two handles costs a
+ * pointer operation. FWObject uses it for names, comments, XML
+ * element names and keyword sets, which repeat a lot in large
+ * databases (e.g. imported address objects).
+ *
+ * Values are reference counted and removed from the pool when the
+ * last handle goes away. The empty value is represented by a NULL
+ * entry and never touches the pool. The pool is shared by all
+ * FWObjectDatabase objects because objects can be moved or copied
+ * from one database to another.
+ *
+ * T must be copyable, have operator< and method empty().
+ */
+template <class T> class Interned
+{
+    class Entry
+    {
+    public:
+        T value;
+        volatile int refs;
+
+        Entry(const T &v) : value(v), refs(1) {}
+    };
+
+    class ValueLess
+    {
+    public:
+        bool operator()(const T *a, const T *b) const { return *a < *b; }
+    };
+
+    typedef std::map<const T*, Entry*, ValueLess> entry_map;
+
+    class Pool
+    {
+    public:
+        Mutex mutex;
+        entry_map entries;
+    };
+
+    Entry *entry;
+
+    // the pool is never destroyed so handles in static objects can
+    // be released at any time during program exit
+    static Pool& pool()
+    {
+        static Pool *p = new Pool();
+        return *p;
+    }
+
+    static const T& emptyValue()
+    {
+        static T *v = new T();
+        return *v;
+    }
+
+    /*
+     * Reference counters are changed with atomic operations, the pool
+     * is locked only to find or insert a value and to remove an entry
+     * whose counter dropped to zero. An entry with zero references is
+     * never revived: acquire() replaces it in the pool with a new one
+     * and the entry is deleted by the thread that released it last.
+     */
+    static Entry* acquire(const T &v)
+    {
+        if (v.empty()) return NULL;
+        Pool &p = pool();
+        p.mutex.lock();
+        Entry *e = NULL;
+        typename entry_map::iterator it = p.entries.find(&v);
+        if (it != p.entries.end())
+        {
+            e = it->second;
+            int refs = e->refs;
+            while (refs > 0)
+            {
+                int prev = __sync_val_compare_and_swap(&(e->refs),
+                                                       refs, refs + 1);
+                if (prev == refs) break;
+                refs = prev;
+            }
+            if (refs <= 0)
+            {
+                p.entries.erase(it);
+                e = NULL;
+            }
+        }
+        if (e == NULL)
+        {
+            e = new Entry(v);
+            p.entries[&(e->value)] = e;
+        }
+        p.mutex.unlock();
+        return e;
+    }
+
+    static void addRef(Entry *e)
+    {
+        if (e != NULL) __sync_add_and_fetch(&(e->refs), 1);
+    }
+
+    static void release(Entry *e)
+    {
+        if (e == NULL || __sync_sub_and_fetch(&(e->refs), 1) != 0) return;
+        Pool &p = pool();
+        p.mutex.lock();
+        typename entry_map::iterator it = p.entries.find(&(e->value));
+        if (it != p.entries.end() && it->second == e) p.entries.erase(it);
+        p.mutex.unlock();
+        delete e;
+    }
+
+public:
+
+    Interned() : entry(NULL) {}
+    Interned(const T &v) : entry(acquire(v)) {}
+    Interned(const Interned &other) : entry(other.entry) { addRef(entry); }
+    ~Interned() { release(entry); }
+
+    Interned& operator=(const Interned &other)
+    {
+        if (entry != other.entry)
+        {
+            addRef(other.entry);
+            release(entry);
+            entry = other.entry;
+        }
+        return *this;
+    }
+
+    Interned& operator=(const T &v)
+    {
+        Entry *e = acquire(v);
+        release(entry);
+        entry = e;
+        return *this;
+    }
+
+    const T& get() const { return (entry) ? entry->value : emptyValue(); }
+    operator const T&() const { return get(); }
+    const T* operator->() const { return &(get()); }
+
+    bool empty() const { return entry == NULL; }
+    const char* c_str() const { return get().c_str(); }
+
+    /**
+     * handles of equal values point to the same entry
+     */
+    bool operator==(const Interned &other) const
+    { return entry == other.entry; }
+    bool operator!=(const Interned &other) const
+    { return entry != other.entry; }
+
+    bool operator==(const T &v) const { return get() == v; }
+    bool operator!=(const T &v) const { return get() != v; }
+
+    /**
+     * number of different values currently in the pool
+     */
+    static int getPoolSize()
+    {
+        Pool &p = pool();
+        p.mutex.lock();
+        int res = int(p.entries.size());
+        p.mutex.unlock();
+        return res;
+    }
+};
+
+template <class T>
+std::ostream& operator<<(std::ostream &str, const Interned<T> &v)
+{
+    return str << v.get();
+}
+
+typedef Interned<std::string> InternedString;
+typedef Interned< std::set<std::string> > InternedStringSet;
+
+}
+
+#endif
@@ -201,6 +201,7 @@ bool PolicyInstallScript::isEnabled() const
 
 void PolicyInstallScript::setEnabled(bool v)
 {
+    _aboutToChange();
     enabled = v;
 }
 
@@ -271,6 +272,7 @@ const string& PolicyInstallScript::getCommand() const
 
 void PolicyInstallScript::setCommand(const string& s)
 {
+    _aboutToChange();
     command = s;
 }
 
@@ -281,6 +283,7 @@ const string& PolicyInstallScript::getArguments() const
 
 void PolicyInstallScript::setArguments(const string& s)
 {
+    _aboutToChange();
     arguments = s;
 }
 
@@ -307,6 +310,7 @@ bool SNMPManagement::isEnabled() const
 
 void SNMPManagement::setEnabled(bool v)
 {
+    _aboutToChange();
     enabled = v;
 }
 
@@ -377,6 +381,7 @@ const string& SNMPManagement::getReadCommunity () const
 
 void SNMPManagement::setReadCommunity (const string& s)
 {
+    _aboutToChange();
     read_community = s;
 }
 
@@ -387,6 +392,7 @@ const string& SNMPManagement::getWriteCommunity() const
 
 void SNMPManagement::setWriteCommunity(const string& s)
 {
+    _aboutToChange();
     write_community = s;
 }
 
@@ -420,6 +426,7 @@ bool FWBDManagement::isEnabled() const
 
 void FWBDManagement::setEnabled(bool v)
 {
+    _aboutToChange();
     enabled = v;
 }
 
@@ -502,6 +509,7 @@ int FWBDManagement::getPort() const
 
 void FWBDManagement::setPort(int x)
 {
+    _aboutToChange();
     port = x;
 }
 
@@ -512,6 +520,7 @@ const string &FWBDManagement::getIdentityId() const
 
 void FWBDManagement::setIdentityId(const string &s)
 {
+    _aboutToChange();
     identity_id = s;
 }
 
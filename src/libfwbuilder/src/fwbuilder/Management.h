@@ -156,7 +156,7 @@ namespace libfwbuilder
 	virtual bool  validateChild(FWObject *o);
 
         const InetAddr& getAddress() const { return addr; }
-        void setAddress(const InetAddr& a) { addr = a; }
+        void setAddress(const InetAddr& a) { _aboutToChange(); addr = a; }
 
         PolicyInstallScript *getPolicyInstallScript();
         SNMPManagement      *getSNMPManagement();
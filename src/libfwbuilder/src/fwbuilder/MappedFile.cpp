@@ -0,0 +1,88 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  $Id$
+
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+
+#include "config.h"
+#include "fwbuilder/libfwbuilder-config.h"
+
+#include "fwbuilder/MappedFile.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+
+#ifndef _WIN32
+#  include <sys/mman.h>
+#  include <unistd.h>
+#endif
+
+#include <fstream>
+#include <sstream>
+
+using namespace std;
+using namespace libfwbuilder;
+
+
+MappedFile::~MappedFile()
+{
+#ifndef _WIN32
+    if (mapped != NULL) munmap(mapped, mapped_size);
+#endif
+}
+
+bool MappedFile::open(const string &path)
+{
+#ifndef _WIN32
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0)
+    {
+        void *p = mmap(NULL, size_t(st.st_size), PROT_READ, MAP_PRIVATE,
+                       fd, 0);
+        if (p != MAP_FAILED)
+        {
+            mapped = p;
+            mapped_size = size_t(st.st_size);
+            data = (const char*)(p);
+            size = mapped_size;
+            close(fd);
+            return true;
+        }
+    }
+    close(fd);
+#endif
+
+    // files that can not be mapped are read the usual way
+    ifstream fs(path.c_str(), ios::in | ios::binary);
+    if (!fs) return false;
+    ostringstream str;
+    str << fs.rdbuf();
+    buffer = str.str();
+    data = buffer.data();
+    size = buffer.size();
+    return true;
+}
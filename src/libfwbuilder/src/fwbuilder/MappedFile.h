@@ -0,0 +1,71 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  $Id$
+
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+
+#ifndef  __MAPPEDFILE_HH_FLAG__
+#define  __MAPPEDFILE_HH_FLAG__
+
+#include <stddef.h>
+#include <string>
+
+
+namespace libfwbuilder
+{
+
+/**
+ * Read-only contents of a file, mapped into memory if possible. Files
+ * that can not be mapped (empty files, pipes, platforms without mmap)
+ * are read into a buffer instead. Either way data and size describe
+ * the whole file until the object is destroyed.
+ */
+class MappedFile
+{
+    std::string buffer;
+    void *mapped;
+    size_t mapped_size;
+
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+
+public:
+
+    const char *data;
+    size_t size;
+
+    MappedFile() : mapped(NULL), mapped_size(0), data(""), size(0) {}
+    ~MappedFile();
+
+    /**
+     * returns false if the file can not be opened
+     */
+    bool open(const std::string &path);
+
+    bool isMapped() const { return mapped != NULL; }
+};
+
+}
+
+#endif
@@ -0,0 +1,182 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  $Id$
+
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#include "config.h"
+#include "fwbuilder/libfwbuilder-config.h"
+
+#include "fwbuilder/MemoryStats.h"
+
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+using namespace libfwbuilder;
+
+
+MemoryStats::MemoryStats()
+{
+    objects = 0;
+    references = 0;
+    referenced_objects = 0;
+    unique_strings = 0;
+    string_bytes = 0;
+    unshared_string_bytes = 0;
+    object_index_bytes = 0;
+    usage_index_bytes = 0;
+    search_index_bytes = 0;
+    arena_bytes = 0;
+}
+
+size_t MemoryStats::stringBytes(const string &str)
+{
+    // short strings are kept inside of the string object
+    size_t res = sizeof(string);
+    if (str.capacity() >= sizeof(string)) res += str.capacity() + 1;
+    return res;
+}
+
+size_t MemoryStats::treeNodeBytes(size_t value_size)
+{
+    // color, parent, left and right, then the value
+    return 4 * sizeof(void*) + value_size;
+}
+
+size_t MemoryStats::getTotalBytes() const
+{
+    size_t res = string_bytes + object_index_bytes + usage_index_bytes +
+        search_index_bytes;
+    for (map<string, TypeStats>::const_iterator i=types.begin();
+         i!=types.end(); ++i)
+        res += i->second.getTotalBytes();
+    return res;
+}
+
+static string kbytes(size_t bytes)
+{
+    ostringstream str;
+    str << fixed << setprecision(1) << double(bytes) / 1024 << " KB";
+    return str.str();
+}
+
+void MemoryStats::print(ostream &str) const
+{
+    ios::fmtflags flags = str.flags();
+    streamsize precision = str.precision();
+
+    str << "Objects: " << objects << endl;
+    str << "References: " << references << " to "
+        << referenced_objects << " objects" << endl;
+    str << "Estimated memory: " << kbytes(getTotalBytes()) << endl;
+    str << "  strings:      " << kbytes(string_bytes)
+        << " in " << unique_strings << " unique values ("
+        << kbytes(unshared_string_bytes) << " if not shared)" << endl;
+    str << "  object index: " << kbytes(object_index_bytes) << endl;
+    str << "  usage index:  " << kbytes(usage_index_bytes) << endl;
+    str << "  search index: " << kbytes(search_index_bytes) << endl;
+    if (arena_bytes)
+        str << "  arena slabs:  " << kbytes(arena_bytes) << endl;
+    str << endl;
+
+    vector< pair<size_t, string> > order;
+    for (map<string, TypeStats>::const_iterator i=types.begin();
+         i!=types.end(); ++i)
+        order.push_back(make_pair(i->second.getTotalBytes(), i->first));
+    sort(order.rbegin(), order.rend());
+
+    str << left << setw(28) << "Type" << right
+        << setw(9) << "Objects"
+        << setw(14) << "Objects, KB"
+        << setw(14) << "Attrs, KB"
+        << setw(14) << "Children, KB"
+        << setw(14) << "Total, KB" << endl;
+    str << fixed << setprecision(1);
+    for (vector< pair<size_t, string> >::iterator i=order.begin();
+         i!=order.end(); ++i)
+    {
+        const TypeStats &ts = types.find(i->second)->second;
+        str << left << setw(28) << i->second << right
+            << setw(9) << ts.objects
+            << setw(14) << double(ts.object_bytes) / 1024
+            << setw(14) << double(ts.attribute_bytes) / 1024
+            << setw(14) << double(ts.child_bytes) / 1024
+            << setw(14) << double(ts.getTotalBytes()) / 1024 << endl;
+    }
+    str << endl;
+
+    order.clear();
+    for (map<string, AttributeStats>::const_iterator i=attributes.begin();
+         i!=attributes.end(); ++i)
+        order.push_back(make_pair(i->second.bytes, i->first));
+    sort(order.rbegin(), order.rend());
+
+    str << left << setw(28) << "Attribute" << right
+        << setw(9) << "Count"
+        << setw(14) << "Total, KB" << endl;
+    for (vector< pair<size_t, string> >::iterator i=order.begin();
+         i!=order.end(); ++i)
+    {
+        const AttributeStats &as = attributes.find(i->second)->second;
+        str << left << setw(28) << i->second << right
+            << setw(9) << as.count
+            << setw(14) << double(as.bytes) / 1024 << endl;
+    }
+    str.flags(flags);
+    str.precision(precision);
+}
+
+void AllocationProfile::print(ostream &str) const
+{
+    ios::fmtflags flags = str.flags();
+    streamsize precision = str.precision();
+
+    size_t live = (live_bytes > 0) ? size_t(live_bytes) : 0;
+    size_t peak = (peak_live_bytes > 0) ? size_t(peak_live_bytes) : 0;
+    str << "Allocations: " << allocations
+        << ", " << kbytes(allocated_bytes) << endl;
+    str << "Deallocations: " << deallocations << endl;
+    str << "Live: " << kbytes(live) << ", peak " << kbytes(peak) << endl;
+
+    if (sample_interval <= 0 || samples.empty()) return;
+
+    long total = 0;
+    for (map<size_t, long>::const_iterator i=samples.begin();
+         i!=samples.end(); ++i)
+        total += i->second;
+
+    str << "Sampled every " << sample_interval << " allocations, "
+        << total << " samples:" << endl;
+    str << right << setw(10) << "Size" << setw(10) << "Samples"
+        << setw(8) << "%" << endl;
+    str << fixed << setprecision(1);
+    for (map<size_t, long>::const_iterator i=samples.begin();
+         i!=samples.end(); ++i)
+        str << setw(10) << i->first << setw(10) << i->second
+            << setw(8) << 100.0 * i->second / total << endl;
+    str.flags(flags);
+    str.precision(precision);
+}
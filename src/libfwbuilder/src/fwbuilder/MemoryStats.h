@@ -0,0 +1,174 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  $Id$
+
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#ifndef  __MEMORYSTATS_HH_FLAG__
+#define  __MEMORYSTATS_HH_FLAG__
+
+#include <stddef.h>
+#include <string>
+#include <map>
+#include <ostream>
+
+
+namespace libfwbuilder
+{
+
+/**
+ * Memory footprint of an object database, filled by
+ * FWObjectDatabase::getMemoryStats().
+ *
+ * Sizes of objects allocated from an arena are the sizes of their
+ * blocks in FWObjectArena, objects allocated from the heap are
+ * counted by the size of their class. Everything objects allocate on
+ * their own (attribute slots, strings, child lists, index entries) is
+ * estimated from the number of elements and the size of the standard
+ * containers used; overhead of the system allocator is not counted.
+ */
+class MemoryStats
+{
+public:
+
+    class TypeStats
+    {
+    public:
+        int objects;
+        size_t object_bytes;
+        /**
+         * attribute slots and their values
+         */
+        size_t attribute_bytes;
+        /**
+         * list of children and child pointer array
+         */
+        size_t child_bytes;
+
+        TypeStats() : objects(0), object_bytes(0), attribute_bytes(0),
+                      child_bytes(0) {}
+        size_t getTotalBytes() const
+        { return object_bytes + attribute_bytes + child_bytes; }
+    };
+
+    class AttributeStats
+    {
+    public:
+        int count;
+        size_t bytes;
+
+        AttributeStats() : count(0), bytes(0) {}
+    };
+
+    int objects;
+    /**
+     * number of FWReference objects and number of objects they point to
+     */
+    int references;
+    int referenced_objects;
+
+    /**
+     * key is the type name
+     */
+    std::map<std::string, TypeStats> types;
+
+    /**
+     * key is the attribute name
+     */
+    std::map<std::string, AttributeStats> attributes;
+
+    /**
+     * Names, comments and keyword sets are interned (see Interned).
+     * unique_strings is the number of different values used by the
+     * objects of this database and string_bytes is what they take;
+     * unshared_string_bytes is what they would take if every object
+     * had its own copy.
+     */
+    int unique_strings;
+    size_t string_bytes;
+    size_t unshared_string_bytes;
+
+    size_t object_index_bytes;
+    size_t usage_index_bytes;
+    size_t search_index_bytes;
+
+    /**
+     * slabs of the arena of the database, if it uses one. Objects
+     * allocated from the arena are included in object_bytes of their
+     * types, so this is not added to the total.
+     */
+    size_t arena_bytes;
+
+    MemoryStats();
+
+    size_t getTotalBytes() const;
+
+    /**
+     * prints human readable report, types and attributes are sorted
+     * by the number of bytes
+     */
+    void print(std::ostream &str) const;
+
+    /**
+     * estimated size of a string, including its heap buffer if it
+     * does not fit in the string object itself
+     */
+    static size_t stringBytes(const std::string &str);
+
+    /**
+     * estimated size of a node of std::map or std::set holding
+     * values of the given size
+     */
+    static size_t treeNodeBytes(size_t value_size);
+};
+
+/**
+ * Counters of allocations of FWObject and derived classes, see
+ * FWObjectArena::startProfiling(). live_bytes is the difference
+ * between allocated and freed bytes since profiling started, it can
+ * be negative if objects created before that are deleted.
+ */
+class AllocationProfile
+{
+public:
+    long allocations;
+    long deallocations;
+    size_t allocated_bytes;
+    long live_bytes;
+    long peak_live_bytes;
+    int sample_interval;
+    /**
+     * sampled allocations: size in bytes -> number of samples
+     */
+    std::map<size_t, long> samples;
+
+    AllocationProfile() : allocations(0), deallocations(0),
+                          allocated_bytes(0), live_bytes(0),
+                          peak_live_bytes(0), sample_interval(0) {}
+
+    void print(std::ostream &str) const;
+};
+
+}
+
+#endif
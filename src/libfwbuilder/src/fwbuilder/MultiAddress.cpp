@@ -35,6 +35,7 @@
 #include "fwbuilder/FWObjectDatabase.h"
 #include "fwbuilder/FWOptions.h"
 #include "fwbuilder/Network.h"
+#include "fwbuilder/NetworkIPv6.h"
 
 #include <iostream>
 #include <fstream>
@@ -49,6 +50,8 @@ const char *MultiAddress::TYPENAME={"MultiAddress"};
 MultiAddress::MultiAddress() : FWObject() 
 {
     setRunTime(false);
+    materialized_v4 = 0;
+    materialized_v6 = 0;
 }
 
 MultiAddress::~MultiAddress()
@@ -89,6 +92,70 @@ bool MultiAddress::validateChild(FWObject *o)
     return ObjectGroup::validateChild(o);
 }
 
+FWObject& MultiAddress::shallowDuplicate(const FWObject *other,
+                                         bool preserve_id) throw(FWException)
+{
+    const MultiAddress *ma_other = MultiAddress::constcast(other);
+    if (ma_other != NULL)
+    {
+        prefixes = ma_other->prefixes;
+        materialized_v4 = ma_other->materialized_v4;
+        materialized_v6 = ma_other->materialized_v6;
+    }
+    return ObjectGroup::shallowDuplicate(other, preserve_id);
+}
+
+void MultiAddress::clearPrefixes(bool ipv6)
+{
+    if (ipv6)
+    {
+        prefixes.clear(AF_INET6);
+        materialized_v6 = 0;
+    } else
+    {
+        prefixes.clear(AF_INET);
+        materialized_v4 = 0;
+    }
+}
+
+string MultiAddress::getMaterializedName(int af, size_t n) const
+{
+    return prefixes.toString(af, n);
+}
+
+void MultiAddress::materialize(bool ipv6)
+{
+    int af = (ipv6) ? AF_INET6 : AF_INET;
+    size_t &done = (ipv6) ? materialized_v6 : materialized_v4;
+    FWObjectDatabase *root = getRoot();
+    InetAddr addr;
+    InetAddr netmask;
+
+    for ( ; done < prefixes.size(af); ++done)
+    {
+        Address *new_addr;
+        if (ipv6) new_addr = root->createNetworkIPv6();
+        else new_addr = root->createNetwork();
+
+        prefixes.get(af, done, addr, netmask);
+        new_addr->setAddress(addr);
+        new_addr->setNetmask(netmask);
+        new_addr->setName(getMaterializedName(af, done));
+        if (validateChild(new_addr))
+        {
+            root->add(new_addr);
+            addRef(new_addr);
+        } else
+            delete new_addr;
+    }
+}
+
+void MultiAddress::aggregatePrefixes(bool ipv6)
+{
+    if (((ipv6) ? materialized_v6 : materialized_v4) != 0) return;
+    prefixes.aggregate((ipv6) ? AF_INET6 : AF_INET);
+}
+
 // ========================================================================
 
 const char *MultiAddressRunTime::TYPENAME={"MultiAddressRunTime"};
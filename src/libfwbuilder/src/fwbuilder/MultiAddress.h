@@ -30,6 +30,7 @@
 #include "fwbuilder/FWObject.h"
 #include "fwbuilder/Address.h"
 #include "fwbuilder/ObjectGroup.h"
+#include "fwbuilder/PrefixArray.h"
 #include <vector>
 
 
@@ -40,6 +41,31 @@ namespace libfwbuilder
 class MultiAddress : public ObjectGroup
 {
     private:
+
+    size_t materialized_v4;
+    size_t materialized_v6;
+
+    protected:
+
+    /**
+     * addresses read from the source by loadFromSource(). These
+     * become Network and NetworkIPv6 objects only when materialize()
+     * is called.
+     */
+    PrefixArray prefixes;
+
+    /**
+     * removes entries of one address family from the prefix array,
+     * called by loadFromSource() before it reads the source. Objects
+     * created from these entries earlier stay where they are.
+     */
+    void clearPrefixes(bool ipv6);
+
+    /**
+     * name of the object materialize() creates for the n-th entry of
+     * the given address family
+     */
+    virtual std::string getMaterializedName(int af, size_t n) const;
       
     public:
 
@@ -55,6 +81,28 @@ class MultiAddress : public ObjectGroup
     virtual void loadFromSource(bool ipv6, FWOptions *options,
                                 bool test_mode=false) throw(FWException) = 0;
 
+    virtual FWObject& shallowDuplicate(const FWObject *obj,
+                                       bool preserve_id = true)
+        throw(FWException);
+
+    const PrefixArray& getPrefixes() const { return prefixes; }
+
+    /**
+     * creates Network or NetworkIPv6 objects for entries of the
+     * prefix array of the given address family, adds them to the
+     * object database and adds references to them to this
+     * object. Entries that have been materialized before are
+     * skipped, so calling this more than once is harmless.
+     */
+    void materialize(bool ipv6);
+
+    /**
+     * aggregates entries of the given address family, see
+     * PrefixArray::aggregate(). Does nothing if some of them have
+     * been materialized already.
+     */
+    void aggregatePrefixes(bool ipv6);
+
     /*
      * functions isCompileTime() and isRunTime() are virtual because
      * some multi-address objects allow the user to set these flags,
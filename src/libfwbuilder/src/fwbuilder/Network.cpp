@@ -104,16 +104,19 @@ bool Network::isValidRoutingNet() const
 
 void Network::setAddress(const InetAddr &a)
 {
+    _aboutToChange();
     inet_addr_mask->setAddress(a);
 }
 
 void Network::setNetmask(const InetAddr &nm)
 {
+    _aboutToChange();
     inet_addr_mask->setNetmask(nm);
 }
 
 void Network::setAddressNetmask(const std::string& s)
 {
+    _aboutToChange();
     delete inet_addr_mask;
     inet_addr_mask = new InetAddrMask(s);
 }
@@ -132,16 +132,19 @@ bool NetworkIPv6::isValidRoutingNet() const
 
 void NetworkIPv6::setAddress(const InetAddr &a)
 {
+    _aboutToChange();
     inet_addr_mask->setAddress(a);
 }
 
 void NetworkIPv6::setNetmask(const InetAddr &nm)
 {
+    _aboutToChange();
     inet_addr_mask->setNetmask(nm);
 }
 
 void NetworkIPv6::setAddressNetmask(const std::string& s)
 {
+    _aboutToChange();
     delete inet_addr_mask;
     inet_addr_mask = new Inet6AddrMask(s);
 }
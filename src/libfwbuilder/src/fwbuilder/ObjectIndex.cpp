@@ -0,0 +1,186 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  $Id$
+
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#include "config.h"
+#include "fwbuilder/libfwbuilder-config.h"
+
+#include "fwbuilder/ObjectIndex.h"
+
+using namespace std;
+using namespace libfwbuilder;
+
+
+#define MIN_CAPACITY 64
+
+ObjectIndex::const_iterator::const_iterator(const vector<Entry> *t, size_t p)
+{
+    table = t;
+    pos = p;
+    skipEmpty();
+}
+
+void ObjectIndex::const_iterator::skipEmpty()
+{
+    while (pos < table->size() && (*table)[pos].id == EMPTY) ++pos;
+}
+
+ObjectIndex::ObjectIndex()
+{
+    count = 0;
+    mask = 0;
+    shift = 32;
+    rehash(MIN_CAPACITY);
+}
+
+ObjectIndex::const_iterator ObjectIndex::begin() const
+{
+    return const_iterator(&table, 0);
+}
+
+ObjectIndex::const_iterator ObjectIndex::end() const
+{
+    return const_iterator(&table, table.size());
+}
+
+/*
+ * new_capacity must be a power of 2
+ */
+void ObjectIndex::rehash(size_t new_capacity)
+{
+    vector<Entry> old_table;
+    old_table.swap(table);
+
+    Entry empty;
+    empty.id = EMPTY;
+    empty.obj = NULL;
+    table.assign(new_capacity, empty);
+    mask = (unsigned int)(new_capacity - 1);
+    shift = 32;
+    for (size_t c=new_capacity; c>1; c>>=1) shift--;
+    count = 0;
+
+    for (vector<Entry>::iterator i=old_table.begin(); i!=old_table.end(); ++i)
+        if (i->id != EMPTY) insert(i->id, i->obj);
+}
+
+void ObjectIndex::reserve(size_t n)
+{
+    size_t needed = n + n / 3 + 1;
+    size_t new_capacity = table.size();
+    while (new_capacity < needed) new_capacity <<= 1;
+    if (new_capacity != table.size()) rehash(new_capacity);
+}
+
+void ObjectIndex::insert(int id, FWObject *obj)
+{
+    if (id < 0) return;
+    if (size_t(count + 1) * 4 > table.size() * 3) rehash(table.size() * 2);
+
+    unsigned int slot = homeSlot(id);
+    for (;;)
+    {
+        Entry &e = table[slot];
+        if (e.id == id)
+        {
+            e.obj = obj;
+            return;
+        }
+        if (e.id == EMPTY)
+        {
+            e.id = id;
+            e.obj = obj;
+            count++;
+            return;
+        }
+        slot = (slot + 1) & mask;
+    }
+}
+
+/*
+ * Backward shift deletion: entries that follow the removed one in the
+ * same cluster are moved back if the hole lies between their home
+ * slot and their current slot.
+ */
+void ObjectIndex::erase(int id)
+{
+    if (id < 0) return;
+    unsigned int slot = homeSlot(id);
+    for (;;)
+    {
+        if (table[slot].id == EMPTY) return;
+        if (table[slot].id == id) break;
+        slot = (slot + 1) & mask;
+    }
+
+    unsigned int hole = slot;
+    unsigned int next = (hole + 1) & mask;
+    while (table[next].id != EMPTY)
+    {
+        unsigned int home = homeSlot(table[next].id);
+        // distance from home to next vs. distance from home to hole,
+        // both measured going forward around the table
+        if (((next - home) & mask) >= ((next - hole) & mask))
+        {
+            table[hole] = table[next];
+            hole = next;
+        }
+        next = (next + 1) & mask;
+    }
+    table[hole].id = EMPTY;
+    table[hole].obj = NULL;
+    count--;
+}
+
+void ObjectIndex::clear()
+{
+    Entry empty;
+    empty.id = EMPTY;
+    empty.obj = NULL;
+    table.assign(table.size(), empty);
+    count = 0;
+}
+
+void ObjectIndex::getStats(ObjectIndexStats &stats) const
+{
+    stats.size = count;
+    stats.capacity = int(table.size());
+    stats.max_probe_length = 0;
+    stats.avg_probe_length = 0;
+    stats.probe_length_histogram.clear();
+
+    double total = 0;
+    for (size_t slot=0; slot<table.size(); ++slot)
+    {
+        if (table[slot].id == EMPTY) continue;
+        int len = int((unsigned int)(slot - homeSlot(table[slot].id)) & mask) + 1;
+        if (int(stats.probe_length_histogram.size()) < len)
+            stats.probe_length_histogram.resize(len, 0);
+        stats.probe_length_histogram[len - 1]++;
+        if (len > stats.max_probe_length) stats.max_probe_length = len;
+        total += len;
+    }
+    if (count > 0) stats.avg_probe_length = total / count;
+}
@@ -0,0 +1,169 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  $Id$
+
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#ifndef  __OBJECTINDEX_HH_FLAG__
+#define  __OBJECTINDEX_HH_FLAG__
+
+#include <stddef.h>
+#include <vector>
+
+
+namespace libfwbuilder
+{
+
+class FWObject;
+
+/**
+ * Index statistics returned by FWObjectDatabase::getIndexStats().
+ * Probe length of an entry is the number of slots lookup has to
+ * examine to find it; 1 means the entry sits in its home slot.
+ */
+class ObjectIndexStats
+{
+public:
+    int size;
+    int capacity;
+    int hits;
+    int misses;
+    int max_probe_length;
+    double avg_probe_length;
+    /**
+     * probe_length_histogram[n] is the number of entries with probe
+     * length n+1
+     */
+    std::vector<int> probe_length_histogram;
+
+    ObjectIndexStats() : size(0), capacity(0), hits(0), misses(0),
+                         max_probe_length(0), avg_probe_length(0) {}
+};
+
+/**
+ * Map of object ids to objects used by FWObjectDatabase.
+ *
+ * This is a flat open addressing hash table with linear probing.
+ * Keys are non-negative integer object ids which are mostly
+ * sequential, so they are scattered by multiplicative (Fibonacci)
+ * hashing. Entries are removed with backward shift, so there are no
+ * tombstones and probe sequences stay short no matter how many
+ * objects are added and deleted. The table grows when it is more
+ * than 3/4 full; use reserve() when the number of objects is known
+ * in advance, e.g. before loading a data file.
+ */
+class ObjectIndex
+{
+    struct Entry
+    {
+        int id;
+        FWObject *obj;
+    };
+
+    std::vector<Entry> table;
+    unsigned int mask;
+    int shift;
+    int count;
+
+    unsigned int homeSlot(int id) const
+    { return (((unsigned int)id) * 2654435761U) >> shift; }
+
+    void rehash(size_t new_capacity);
+
+public:
+
+    enum { EMPTY = -1 };
+
+    class const_iterator
+    {
+        friend class ObjectIndex;
+        const std::vector<Entry> *table;
+        size_t pos;
+        const_iterator(const std::vector<Entry> *t, size_t p);
+        void skipEmpty();
+    public:
+        int getId() const { return (*table)[pos].id; }
+        FWObject* getObject() const { return (*table)[pos].obj; }
+        const_iterator& operator++() { ++pos; skipEmpty(); return *this; }
+        bool operator==(const const_iterator &o) const { return pos == o.pos; }
+        bool operator!=(const const_iterator &o) const { return pos != o.pos; }
+    };
+
+    ObjectIndex();
+
+    /**
+     * adds object or replaces object that is already in the index
+     * with the same id. Ids must be >= 0.
+     */
+    void insert(int id, FWObject *obj);
+
+    /**
+     * returns NULL if there is no object with this id
+     */
+    FWObject* find(int id) const
+    {
+        if (id < 0) return NULL;
+        unsigned int slot = homeSlot(id);
+        for (;;)
+        {
+            const Entry &e = table[slot];
+            if (e.id == id) return e.obj;
+            if (e.id == EMPTY) return NULL;
+            slot = (slot + 1) & mask;
+        }
+    }
+
+    bool contains(int id) const { return find(id) != NULL; }
+
+    void erase(int id);
+
+    /**
+     * removes all entries but keeps allocated table
+     */
+    void clear();
+
+    /**
+     * makes sure n entries can be added without rehashing
+     */
+    void reserve(size_t n);
+
+    int size() const { return count; }
+    int capacity() const { return int(table.size()); }
+
+    /**
+     * memory taken by the table
+     */
+    size_t getBytes() const { return table.capacity() * sizeof(Entry); }
+
+    const_iterator begin() const;
+    const_iterator end() const;
+
+    /**
+     * fills size, capacity and probe length fields of stats
+     */
+    void getStats(ObjectIndexStats &stats) const;
+};
+
+}
+
+#endif
@@ -0,0 +1,684 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  $Id$
+
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#include "config.h"
+#include "fwbuilder/libfwbuilder-config.h"
+
+#include "fwbuilder/PrefixArray.h"
+
+extern "C" {
+#  include "fwbuilder/inet_net.h"
+}
+
+#ifndef _WIN32
+#  include <sys/types.h>
+#  include <netinet/in.h>
+#  include <arpa/inet.h>
+#else
+#  include <winsock2.h>
+#endif
+
+#include <string.h>
+
+#include <algorithm>
+
+using namespace std;
+using namespace libfwbuilder;
+
+
+/*
+ * sets bits of the host part of the prefix of given length
+ */
+static inline void host_bits(int width, int len, uint64_t &hi, uint64_t &lo)
+{
+    int n = width - len;
+    if (n >= 128)
+    {
+        hi = ~uint64_t(0);
+        lo = ~uint64_t(0);
+    } else if (n >= 64)
+    {
+        hi = (n == 64) ? 0 : (~uint64_t(0) >> (128 - n));
+        lo = ~uint64_t(0);
+    } else
+    {
+        hi = 0;
+        lo = (n == 0) ? 0 : (~uint64_t(0) >> (64 - n));
+    }
+}
+
+/*
+ * returns prefix length of the netmask or -1 if netmask is not
+ * contiguous
+ */
+static int netmask_length(int width, uint64_t hi, uint64_t lo)
+{
+    int len = 0;
+    while (len < width)
+    {
+        int bit = width - 1 - len;
+        uint64_t w = (bit >= 64) ? hi : lo;
+        if ((w & (uint64_t(1) << (bit & 63))) == 0) break;
+        len++;
+    }
+    uint64_t h_hi, h_lo;
+    host_bits(width, len, h_hi, h_lo);
+    uint64_t m_hi = (width > 64) ? ~h_hi : 0;
+    uint64_t m_lo = (width > 32) ? ~h_lo : (~h_lo & 0xffffffff);
+    if (hi != m_hi || lo != m_lo) return -1;
+    return len;
+}
+
+/*
+ * Prefixes of both address families are aggregated and searched by the
+ * same code working on 128 bit numbers, ipv4 addresses occupy the low
+ * 32 bits. width is the number of bits in the address. index is the
+ * position of the entry the prefix was made of, or -1 if it has been
+ * changed by aggregation.
+ */
+struct WidePrefix
+{
+    uint64_t hi;
+    uint64_t lo;
+    int len;
+    int index;
+};
+
+static inline bool operator<(const WidePrefix &a, const WidePrefix &b)
+{
+    if (a.hi != b.hi) return a.hi < b.hi;
+    if (a.lo != b.lo) return a.lo < b.lo;
+    if (a.len != b.len) return a.len < b.len;
+    return a.index < b.index;
+}
+
+static inline bool covers(int width, const WidePrefix &a, const WidePrefix &b)
+{
+    if (a.len > b.len) return false;
+    uint64_t h_hi, h_lo;
+    host_bits(width, a.len, h_hi, h_lo);
+    return ((b.hi & ~h_hi) == a.hi && (b.lo & ~h_lo) == a.lo);
+}
+
+/*
+ * if a and b are the two halves of a prefix one bit shorter, stores
+ * that prefix in a and returns true. a and b must have host bits
+ * cleared.
+ */
+static inline bool merge_siblings(int width, WidePrefix &a,
+                                  const WidePrefix &b)
+{
+    if (a.len != b.len || a.len == 0) return false;
+    int n = width - a.len;
+    uint64_t bit_hi = (n >= 64) ? (uint64_t(1) << (n - 64)) : 0;
+    uint64_t bit_lo = (n >= 64) ? 0 : (uint64_t(1) << n);
+    if ((a.hi & bit_hi) != 0 || (a.lo & bit_lo) != 0) return false;
+    if (b.hi != (a.hi | bit_hi) || b.lo != (a.lo | bit_lo)) return false;
+    a.len--;
+    a.index = -1;
+    return true;
+}
+
+static void aggregate_wide(int width, vector<WidePrefix> &prefixes)
+{
+    for (vector<WidePrefix>::iterator i=prefixes.begin();
+         i!=prefixes.end(); ++i)
+    {
+        uint64_t h_hi, h_lo;
+        host_bits(width, i->len, h_hi, h_lo);
+        if ((i->hi & h_hi) != 0 || (i->lo & h_lo) != 0)
+        {
+            i->hi &= ~h_hi;
+            i->lo &= ~h_lo;
+            i->index = -1;
+        }
+    }
+
+    std::sort(prefixes.begin(), prefixes.end());
+
+    /*
+     * prefixes kept so far do not overlap and are sorted, so the only
+     * one that can cover the next prefix or be its sibling is the
+     * last one. Merging two siblings can produce a sibling of the
+     * prefix before them, hence the loop. Of equal prefixes the one
+     * added first is kept.
+     */
+    vector<WidePrefix> res;
+    res.reserve(prefixes.size());
+    for (vector<WidePrefix>::iterator i=prefixes.begin();
+         i!=prefixes.end(); ++i)
+    {
+        if (!res.empty() && covers(width, res.back(), *i)) continue;
+        res.push_back(*i);
+        while (res.size() > 1 &&
+               merge_siblings(width, res[res.size() - 2], res.back()))
+            res.pop_back();
+    }
+    prefixes.swap(res);
+}
+
+
+/*
+ * ipv4 entries are formatted directly, it is done for every line of
+ * the file when the table is loaded. The buffer must have room for
+ * "255.255.255.255/255.255.255.255".
+ */
+static inline char* format_decimal(unsigned v, char *p)
+{
+    if (v >= 100) *p++ = char('0' + v / 100);
+    if (v >= 10) *p++ = char('0' + (v / 10) % 10);
+    *p++ = char('0' + v % 10);
+    return p;
+}
+
+static inline char* format_dotted(uint32_t a, char *p)
+{
+    p = format_decimal((a >> 24) & 0xff, p);
+    *p++ = '.';
+    p = format_decimal((a >> 16) & 0xff, p);
+    *p++ = '.';
+    p = format_decimal((a >> 8) & 0xff, p);
+    *p++ = '.';
+    return format_decimal(a & 0xff, p);
+}
+
+static size_t format4(const PrefixArray::Prefix4 &p, char *buf)
+{
+    char *e = format_dotted(p.addr, buf);
+    if (p.notation == PrefixArray::LENGTH)
+    {
+        *e++ = '/';
+        e = format_decimal(p.len, e);
+    } else if (p.notation == PrefixArray::NETMASK)
+    {
+        *e++ = '/';
+        e = format_dotted(
+            (p.len == 0) ? 0 : (~uint32_t(0) << (32 - p.len)), e);
+    }
+    return size_t(e - buf);
+}
+
+/*
+ * ipv6 entries look the same as InetAddr::toString() prints them. The
+ * buffer must have room for two ipv6 addresses.
+ */
+static char* format_ipv6(uint64_t hi, uint64_t lo, char *p, size_t size)
+{
+    unsigned char a[16];
+    for (int i=0; i<8; ++i)
+    {
+        a[i] = (unsigned char)(hi >> (56 - 8 * i));
+        a[8 + i] = (unsigned char)(lo >> (56 - 8 * i));
+    }
+    if (inet_net_ntop(AF_INET6, a, 128, p, size) == NULL) return p;
+    char *slash = strchr(p, '/');
+    return (slash != NULL) ? slash : p + strlen(p);
+}
+
+static size_t format6(const PrefixArray::Prefix6 &p, char *buf, size_t size)
+{
+    char *e = format_ipv6(p.hi, p.lo, buf, size);
+    if (p.notation == PrefixArray::LENGTH)
+    {
+        *e++ = '/';
+        e = format_decimal(p.len, e);
+    } else if (p.notation == PrefixArray::NETMASK)
+    {
+        *e++ = '/';
+        uint64_t h_hi, h_lo;
+        host_bits(128, p.len, h_hi, h_lo);
+        e = format_ipv6(~h_hi, ~h_lo, e, size - (e - buf));
+    }
+    return size_t(e - buf);
+}
+
+class SourceTextIndexLess
+{
+public:
+    bool operator()(const std::pair<uint32_t, std::string> &t,
+                    uint32_t n) const
+    { return t.first < n; }
+};
+
+
+void PrefixArray::clear()
+{
+    v4.clear();
+    v6.clear();
+    texts4.clear();
+    texts6.clear();
+    aggregated4 = true;
+    aggregated6 = true;
+}
+
+void PrefixArray::clear(int af)
+{
+    if (af == AF_INET6)
+    {
+        v6.clear();
+        texts6.clear();
+        aggregated6 = true;
+    } else
+    {
+        v4.clear();
+        texts4.clear();
+        aggregated4 = true;
+    }
+}
+
+bool PrefixArray::add(const InetAddr &addr, const InetAddr &netmask,
+                      Notation notation, const char *text, size_t text_len)
+{
+    if (addr.addressFamily() != netmask.addressFamily()) return false;
+
+    if (addr.isV6())
+    {
+        Prefix6 p;
+        uint64_t m_hi, m_lo;
+        uint128 a = addr.to_uint128();
+        uint128 m = netmask.to_uint128();
+        p.hi = (a >> 64).to_base_type();
+        p.lo = a.to_base_type();
+        m_hi = (m >> 64).to_base_type();
+        m_lo = m.to_base_type();
+        int len = netmask_length(128, m_hi, m_lo);
+        if (len < 0) return false;
+        p.len = (unsigned char)(len);
+        p.notation = (unsigned char)(notation);
+        v6.push_back(p);
+        aggregated6 = false;
+        if (text != NULL)
+        {
+            char buf[128];
+            size_t n = format6(p, buf, sizeof(buf));
+            if (n != text_len || memcmp(buf, text, text_len))
+                texts6.push_back(make_pair(uint32_t(v6.size() - 1),
+                                           string(text, text_len)));
+        }
+    } else
+    {
+        Prefix4 p;
+        p.addr = ntohl(addr.getV4()->s_addr);
+        int len = netmask_length(32, 0, ntohl(netmask.getV4()->s_addr));
+        if (len < 0) return false;
+        p.len = (unsigned char)(len);
+        p.notation = (unsigned char)(notation);
+        v4.push_back(p);
+        aggregated4 = false;
+        if (text != NULL)
+        {
+            char buf[64];
+            size_t n = format4(p, buf);
+            if (n != text_len || memcmp(buf, text, text_len))
+                texts4.push_back(make_pair(uint32_t(v4.size() - 1),
+                                           string(text, text_len)));
+        }
+    }
+    return true;
+}
+
+void PrefixArray::append(const PrefixArray &other)
+{
+    if (other.empty()) return;
+    uint32_t n4 = uint32_t(v4.size());
+    uint32_t n6 = uint32_t(v6.size());
+    v4.insert(v4.end(), other.v4.begin(), other.v4.end());
+    v6.insert(v6.end(), other.v6.begin(), other.v6.end());
+    if (!other.v4.empty()) aggregated4 = false;
+    if (!other.v6.empty()) aggregated6 = false;
+    for (SourceTexts::const_iterator i=other.texts4.begin();
+         i!=other.texts4.end(); ++i)
+        texts4.push_back(make_pair(i->first + n4, i->second));
+    for (SourceTexts::const_iterator i=other.texts6.begin();
+         i!=other.texts6.end(); ++i)
+        texts6.push_back(make_pair(i->first + n6, i->second));
+}
+
+void PrefixArray::get(int af, size_t n, InetAddr &addr,
+                      InetAddr &netmask) const
+{
+    if (af == AF_INET6)
+    {
+        const Prefix6 &p = v6[n];
+        addr = InetAddr(AF_INET6, 0);
+        addr.init_from_uint128(uint128(p.lo, p.hi));
+        netmask = InetAddr(AF_INET6, p.len);
+    } else
+    {
+        const Prefix4 &p = v4[n];
+        struct in_addr a;
+        a.s_addr = htonl(p.addr);
+        addr = InetAddr(&a);
+        netmask = InetAddr(AF_INET, p.len);
+    }
+}
+
+string PrefixArray::format(int af, size_t n) const
+{
+    char buf[128];
+    size_t len;
+    if (af == AF_INET6) len = format6(v6[n], buf, sizeof(buf));
+    else len = format4(v4[n], buf);
+    return string(buf, len);
+}
+
+string PrefixArray::toString(int af, size_t n) const
+{
+    const SourceTexts &texts = (af == AF_INET6) ? texts6 : texts4;
+    SourceTexts::const_iterator i = std::lower_bound(
+        texts.begin(), texts.end(), uint32_t(n), SourceTextIndexLess());
+    if (i != texts.end() && i->first == n) return i->second;
+    return format(af, n);
+}
+
+/*
+ * moves source text of the entry that was at position from to
+ * position to of the aggregated array
+ */
+static void move_text(const vector<pair<uint32_t, string> > &texts,
+                      int from, uint32_t to,
+                      vector<pair<uint32_t, string> > &new_texts)
+{
+    if (from < 0) return;
+    vector<pair<uint32_t, string> >::const_iterator i = std::lower_bound(
+        texts.begin(), texts.end(), uint32_t(from), SourceTextIndexLess());
+    if (i != texts.end() && i->first == uint32_t(from))
+        new_texts.push_back(make_pair(to, i->second));
+}
+
+void PrefixArray::aggregate(int af)
+{
+    vector<WidePrefix> wide;
+
+    if (af == AF_INET6)
+    {
+        if (aggregated6) return;
+
+        wide.reserve(v6.size());
+        for (size_t n=0; n<v6.size(); ++n)
+        {
+            WidePrefix w;
+            w.hi = v6[n].hi;
+            w.lo = v6[n].lo;
+            w.len = v6[n].len;
+            w.index = int(n);
+            wide.push_back(w);
+        }
+        aggregate_wide(128, wide);
+        vector<Prefix6> new_v6;
+        SourceTexts new_texts6;
+        new_v6.reserve(wide.size());
+        for (vector<WidePrefix>::iterator i=wide.begin(); i!=wide.end(); ++i)
+        {
+            Prefix6 p;
+            if (i->index >= 0) p = v6[i->index];
+            else
+            {
+                p.hi = i->hi;
+                p.lo = i->lo;
+                p.len = (unsigned char)(i->len);
+                p.notation = LENGTH;
+            }
+            move_text(texts6, i->index, uint32_t(new_v6.size()), new_texts6);
+            new_v6.push_back(p);
+        }
+        v6.swap(new_v6);
+        texts6.swap(new_texts6);
+        aggregated6 = true;
+        return;
+    }
+
+    if (aggregated4) return;
+
+    wide.reserve(v4.size());
+    for (size_t n=0; n<v4.size(); ++n)
+    {
+        WidePrefix w;
+        w.hi = 0;
+        w.lo = v4[n].addr;
+        w.len = v4[n].len;
+        w.index = int(n);
+        wide.push_back(w);
+    }
+    aggregate_wide(32, wide);
+    vector<Prefix4> new_v4;
+    SourceTexts new_texts4;
+    new_v4.reserve(wide.size());
+    for (vector<WidePrefix>::iterator i=wide.begin(); i!=wide.end(); ++i)
+    {
+        Prefix4 p;
+        if (i->index >= 0) p = v4[i->index];
+        else
+        {
+            p.addr = uint32_t(i->lo);
+            p.len = (unsigned char)(i->len);
+            p.notation = LENGTH;
+        }
+        move_text(texts4, i->index, uint32_t(new_v4.size()), new_texts4);
+        new_v4.push_back(p);
+    }
+    v4.swap(new_v4);
+    texts4.swap(new_texts4);
+    aggregated4 = true;
+}
+
+void PrefixArray::aggregate()
+{
+    aggregate(AF_INET);
+    aggregate(AF_INET6);
+}
+
+class Prefix4AddrLess
+{
+public:
+    bool operator()(uint32_t a, const PrefixArray::Prefix4 &p) const
+    { return a < p.addr; }
+};
+
+class Prefix6AddrLess
+{
+public:
+    bool operator()(const WidePrefix &a, const PrefixArray::Prefix6 &p) const
+    { return a.hi < p.hi || (a.hi == p.hi && a.lo < p.lo); }
+};
+
+bool PrefixArray::contains(const InetAddr &addr) const
+{
+    uint64_t h_hi, h_lo;
+
+    if (addr.isV6())
+    {
+        uint128 a = addr.to_uint128();
+        WidePrefix x;
+        x.hi = (a >> 64).to_base_type();
+        x.lo = a.to_base_type();
+        x.len = 128;
+        x.index = -1;
+
+        vector<Prefix6>::const_iterator i = v6.begin();
+        vector<Prefix6>::const_iterator end = v6.end();
+        if (aggregated6)
+        {
+            // the only candidate is the last prefix that starts at
+            // or before the address
+            end = std::upper_bound(v6.begin(), v6.end(), x,
+                                   Prefix6AddrLess());
+            if (end == v6.begin()) return false;
+            i = end - 1;
+        }
+        for ( ; i!=end; ++i)
+        {
+            host_bits(128, i->len, h_hi, h_lo);
+            if ((x.hi & ~h_hi) == (i->hi & ~h_hi) &&
+                (x.lo & ~h_lo) == (i->lo & ~h_lo)) return true;
+        }
+        return false;
+    }
+
+    uint32_t x = ntohl(addr.getV4()->s_addr);
+
+    vector<Prefix4>::const_iterator i = v4.begin();
+    vector<Prefix4>::const_iterator end = v4.end();
+    if (aggregated4)
+    {
+        end = std::upper_bound(v4.begin(), v4.end(), x, Prefix4AddrLess());
+        if (end == v4.begin()) return false;
+        i = end - 1;
+    }
+    for ( ; i!=end; ++i)
+    {
+        host_bits(32, i->len, h_hi, h_lo);
+        if ((x & ~uint32_t(h_lo)) == (i->addr & ~uint32_t(h_lo))) return true;
+    }
+    return false;
+}
+
+size_t PrefixArray::getMemoryUsage() const
+{
+    size_t res = sizeof(*this) +
+        v4.capacity() * sizeof(Prefix4) +
+        v6.capacity() * sizeof(Prefix6) +
+        (texts4.capacity() + texts6.capacity()) *
+        sizeof(SourceTexts::value_type);
+    for (SourceTexts::const_iterator i=texts4.begin(); i!=texts4.end(); ++i)
+        res += i->second.capacity();
+    for (SourceTexts::const_iterator i=texts6.begin(); i!=texts6.end(); ++i)
+        res += i->second.capacity();
+    return res;
+}
+
+/*
+ * Header of the file written by write(): magic, byte order mark,
+ * sizes of the entry structures, flags (bit 0 is set if ipv4 entries
+ * are aggregated, bit 1 for ipv6), the number of entries of each
+ * address family and the number of source texts of each address
+ * family. Entries follow the header, then source texts, each is the
+ * index of the entry, length of the text and the text.
+ */
+static const char prefix_array_magic[8] = { 'F','W','B','P','F','X','2','\n' };
+
+struct PrefixArrayHeader
+{
+    char magic[8];
+    uint32_t byte_order;
+    uint32_t prefix4_size;
+    uint32_t prefix6_size;
+    uint32_t flags;
+    uint64_t n4;
+    uint64_t n6;
+    uint64_t n_texts4;
+    uint64_t n_texts6;
+};
+
+static bool write_texts(FILE *f, const vector<pair<uint32_t, string> > &texts)
+{
+    for (vector<pair<uint32_t, string> >::const_iterator i=texts.begin();
+         i!=texts.end(); ++i)
+    {
+        uint32_t rec[2];
+        rec[0] = i->first;
+        rec[1] = uint32_t(i->second.size());
+        if (fwrite(rec, sizeof(rec), 1, f) != 1) return false;
+        if (fwrite(i->second.data(), 1, rec[1], f) != rec[1]) return false;
+    }
+    return true;
+}
+
+static bool read_texts(FILE *f, uint64_t n, size_t n_entries,
+                       vector<pair<uint32_t, string> > &texts)
+{
+    char buf[256];
+    for (uint64_t k=0; k<n; ++k)
+    {
+        uint32_t rec[2];
+        if (fread(rec, sizeof(rec), 1, f) != 1) return false;
+        // source texts are short address strings, anything else
+        // means the file is damaged
+        if (rec[0] >= n_entries || rec[1] > sizeof(buf)) return false;
+        if (!texts.empty() && rec[0] <= texts.back().first) return false;
+        if (fread(buf, 1, rec[1], f) != rec[1]) return false;
+        texts.push_back(make_pair(rec[0], string(buf, rec[1])));
+    }
+    return true;
+}
+
+bool PrefixArray::write(FILE *f) const
+{
+    PrefixArrayHeader h;
+    memcpy(h.magic, prefix_array_magic, sizeof(h.magic));
+    h.byte_order = 0x01020304;
+    h.prefix4_size = sizeof(Prefix4);
+    h.prefix6_size = sizeof(Prefix6);
+    h.flags = ((aggregated4) ? 1 : 0) | ((aggregated6) ? 2 : 0);
+    h.n4 = v4.size();
+    h.n6 = v6.size();
+    h.n_texts4 = texts4.size();
+    h.n_texts6 = texts6.size();
+
+    if (fwrite(&h, sizeof(h), 1, f) != 1) return false;
+    if (!v4.empty() &&
+        fwrite(&v4[0], sizeof(Prefix4), v4.size(), f) != v4.size())
+        return false;
+    if (!v6.empty() &&
+        fwrite(&v6[0], sizeof(Prefix6), v6.size(), f) != v6.size())
+        return false;
+    return write_texts(f, texts4) && write_texts(f, texts6);
+}
+
+bool PrefixArray::read(FILE *f)
+{
+    PrefixArrayHeader h;
+    if (fread(&h, sizeof(h), 1, f) != 1) return false;
+    if (memcmp(h.magic, prefix_array_magic, sizeof(h.magic)) != 0 ||
+        h.byte_order != 0x01020304 ||
+        h.prefix4_size != sizeof(Prefix4) ||
+        h.prefix6_size != sizeof(Prefix6)) return false;
+    // protects against damaged files
+    if (h.n4 > (uint64_t(1) << 26) || h.n6 > (uint64_t(1) << 26)) return false;
+    if (h.n_texts4 > h.n4 || h.n_texts6 > h.n6) return false;
+
+    vector<Prefix4> new_v4(size_t(h.n4));
+    vector<Prefix6> new_v6(size_t(h.n6));
+    SourceTexts new_texts4;
+    SourceTexts new_texts6;
+    if (!new_v4.empty() &&
+        fread(&new_v4[0], sizeof(Prefix4), new_v4.size(), f) != new_v4.size())
+        return false;
+    if (!new_v6.empty() &&
+        fread(&new_v6[0], sizeof(Prefix6), new_v6.size(), f) != new_v6.size())
+        return false;
+    if (!read_texts(f, h.n_texts4, new_v4.size(), new_texts4) ||
+        !read_texts(f, h.n_texts6, new_v6.size(), new_texts6))
+        return false;
+
+    v4.swap(new_v4);
+    v6.swap(new_v6);
+    texts4.swap(new_texts4);
+    texts6.swap(new_texts6);
+    aggregated4 = ((h.flags & 1) != 0);
+    aggregated6 = ((h.flags & 2) != 0);
+    return true;
+}
@@ -0,0 +1,195 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  $Id$
+
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#ifndef  __PREFIXARRAY_HH_FLAG__
+#define  __PREFIXARRAY_HH_FLAG__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+#include <utility>
+
+#include "fwbuilder/InetAddr.h"
+
+
+namespace libfwbuilder
+{
+
+/**
+ * Compact list of ipv4 and ipv6 prefixes. This is how MultiAddress
+ * objects (AddressTable, AttachedNetworks) keep addresses they read
+ * from their source: an entry takes 8 bytes for ipv4 and 24 bytes for
+ * ipv6, compared to a Network object plus a reference to it in the
+ * object tree.
+ *
+ * Entries of each address family are stored in the order they were
+ * added and duplicates are kept, so that objects created from the
+ * array are exactly the same as those created from the source
+ * directly. Call aggregate() to convert the array to the smallest
+ * sorted set of non-overlapping prefixes covering the same addresses;
+ * contains() uses binary search on aggregated arrays.
+ *
+ * Objects are named after the text of the entry in the source. Most
+ * entries are written the way toString() prints them; the array
+ * stores the text only for the few that are not ("10.1/16",
+ * "2001:DB8::1").
+ *
+ * Only contiguous netmasks can be stored.
+ */
+class PrefixArray
+{
+public:
+
+    /**
+     * how the prefix was written in the source, toString() restores
+     * the same notation
+     */
+    enum Notation
+    {
+        BARE = 0,       // "10.1.1.1", host address
+        LENGTH = 1,     // "10.1.1.0/24"
+        NETMASK = 2     // "10.1.1.0/255.255.255.0"
+    };
+
+    struct Prefix4
+    {
+        uint32_t addr;          // host byte order
+        unsigned char len;
+        unsigned char notation;
+    };
+
+    struct Prefix6
+    {
+        uint64_t hi;
+        uint64_t lo;
+        unsigned char len;
+        unsigned char notation;
+    };
+
+private:
+
+    typedef std::vector<std::pair<uint32_t, std::string> > SourceTexts;
+
+    std::vector<Prefix4> v4;
+    std::vector<Prefix6> v6;
+    // text of the entries that toString() can not restore, sorted by
+    // index of the entry
+    SourceTexts texts4;
+    SourceTexts texts6;
+    bool aggregated4;
+    bool aggregated6;
+
+    std::string format(int af, size_t n) const;
+
+public:
+
+    PrefixArray() : aggregated4(true), aggregated6(true) {}
+
+    void clear();
+
+    /**
+     * removes entries of one address family only
+     */
+    void clear(int af);
+
+    /**
+     * adds entry at the end of the array. Returns false and adds
+     * nothing if netmask is not contiguous or its address family
+     * does not match that of the address. text is the entry as it
+     * was written in the source, if given, toString() returns it.
+     */
+    bool add(const InetAddr &addr, const InetAddr &netmask,
+             Notation notation=LENGTH,
+             const char *text=NULL, size_t text_len=0);
+
+    size_t size() const { return v4.size() + v6.size(); }
+    size_t size(int af) const
+    { return (af == AF_INET6) ? v6.size() : v4.size(); }
+    bool empty() const { return v4.empty() && v6.empty(); }
+
+    const std::vector<Prefix4>& getV4() const { return v4; }
+    const std::vector<Prefix6>& getV6() const { return v6; }
+
+    /**
+     * appends all entries of the other array
+     */
+    void append(const PrefixArray &other);
+
+    /**
+     * n-th entry of the given address family
+     */
+    void get(int af, size_t n, InetAddr &addr, InetAddr &netmask) const;
+
+    /**
+     * n-th entry of the given address family as a string: the text
+     * it was added with or, if there was none, the address in the
+     * notation it was added with
+     */
+    std::string toString(int af, size_t n) const;
+
+    /**
+     * clears host bits of all entries, sorts them, removes duplicates
+     * and entries covered by other entries and merges adjacent
+     * prefixes that form a shorter one. Entries that are not changed
+     * keep their notation and source text, new ones are in LENGTH
+     * notation.
+     */
+    void aggregate();
+
+    /**
+     * aggregates entries of one address family only
+     */
+    void aggregate(int af);
+    bool isAggregated(int af) const
+    { return (af == AF_INET6) ? aggregated6 : aggregated4; }
+
+    /**
+     * returns true if the address belongs to one of the prefixes
+     */
+    bool contains(const InetAddr &addr) const;
+
+    /**
+     * approximate amount of memory used by the array, in bytes
+     */
+    size_t getMemoryUsage() const;
+
+    /**
+     * write the array to the file and read it back. The format is
+     * the in-memory layout of the entries and is meant for caches
+     * that are read on the same machine: read() returns false if
+     * the data was written by a program with different byte order
+     * or entry layout, or if the file is truncated.
+     */
+    bool write(FILE *f) const;
+    bool read(FILE *f);
+};
+
+}
+
+#endif
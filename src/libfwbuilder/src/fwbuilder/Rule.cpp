@@ -67,11 +67,27 @@ void Rule::init(FWObjectDatabase*)
 
 FWOptions* Rule::getOptionsObject() const { return NULL; }
 RuleSet* Rule::getBranch() { return NULL; }
-void Rule::setPosition(int n)  { setInt("position", n); }
-int Rule::getPosition() const { return getInt("position"); }
-void Rule::disable() { setBool("disabled",true); }
-void Rule::enable() { setBool("disabled",false); }
-bool Rule::isDisabled() const  { return( getBool("disabled")); }
+/*
+ * rule position and "disabled" flag are read by every rule processor,
+ * use interned attribute names for them.
+ */
+static const AttributeKey& positionKey()
+{
+    static AttributeKey key("position");
+    return key;
+}
+
+static const AttributeKey& disabledKey()
+{
+    static AttributeKey key("disabled");
+    return key;
+}
+
+void Rule::setPosition(int n)  { setInt(positionKey(), n); }
+int Rule::getPosition() const { return getInt(positionKey()); }
+void Rule::disable() { setBool(disabledKey(), true); }
+void Rule::enable() { setBool(disabledKey(), false); }
+bool Rule::isDisabled() const  { return( getBool(disabledKey())); }
 bool Rule::isEmpty() { return false; }
 bool Rule::isDummyRule() { return false; }
 
@@ -183,50 +199,35 @@ bool PolicyRule::cmp(const FWObject *x, bool recursive) throw(FWException)
 RuleElementSrc*  PolicyRule::getSrc()
 {
     if (src_re) return src_re;
-    FWObject::iterator i1 = begin();
-    src_re = RuleElementSrc::cast(*i1);
+    src_re = RuleElementSrc::cast(getChild(0));
     return src_re;
 }
 
 RuleElementDst*  PolicyRule::getDst()
 {
     if (dst_re) return dst_re;
-    FWObject::iterator i1 = begin();
-    i1++;
-    dst_re = RuleElementDst::cast(*i1);
+    dst_re = RuleElementDst::cast(getChild(1));
     return dst_re;
 }
 
 RuleElementSrv*  PolicyRule::getSrv()
 {
     if (srv_re) return srv_re;
-    FWObject::iterator i1 = begin();
-    i1++;
-    i1++;
-    srv_re = RuleElementSrv::cast(*i1);
+    srv_re = RuleElementSrv::cast(getChild(2));
     return srv_re;
 }
 
 RuleElementItf*  PolicyRule::getItf()
 {
     if (itf_re) return itf_re;
-    FWObject::iterator i1 = begin();
-    i1++;
-    i1++;
-    i1++;
-    itf_re = RuleElementItf::cast(*i1);
+    itf_re = RuleElementItf::cast(getChild(3));
     return itf_re;
 }
 
 RuleElementInterval* PolicyRule::getWhen()
 {
     if (when_re) return when_re;
-    FWObject::iterator i1 = begin();
-    i1++;
-    i1++;
-    i1++;
-    i1++;
-    when_re = RuleElementInterval::cast(*i1);
+    when_re = (size() > 4) ? RuleElementInterval::cast(getChild(4)) : NULL;
     return when_re;
 }
 
@@ -306,9 +307,9 @@ void PolicyRule::setDummySource()
     if (!dummySource || (root->getStringId(dummySource->getId()) != "dummyaddressid0"))
         return;
 
-    FWObject::iterator i1 = begin();
-    (*i1)->addRef(dummySource);
-    src_re = RuleElementSrc::cast(*i1);
+    FWObject *re = getChild(0);
+    re->addRef(dummySource);
+    src_re = RuleElementSrc::cast(re);
 }
 
 void PolicyRule::setDummyDestination()
@@ -318,10 +319,9 @@ void PolicyRule::setDummyDestination()
     if (!dummyDestination || (root->getStringId(dummyDestination->getId()) != "dummyaddressid0"))
         return;
 
-    FWObject::iterator i1 = begin();
-    i1++;
-    (*i1)->addRef(dummyDestination);
-    dst_re = RuleElementDst::cast(*i1);
+    FWObject *re = getChild(1);
+    re->addRef(dummyDestination);
+    dst_re = RuleElementDst::cast(re);
 }
 
 void PolicyRule::setDummyService()
@@ -331,11 +331,9 @@ void PolicyRule::setDummyService()
     if (!dummyService || (root->getStringId(dummyService->getId()) != "dummyserviceid0"))
         return;
 
-    FWObject::iterator i1 = begin();
-    i1++;
-    i1++;
-    (*i1)->addRef(dummyService);
-    srv_re = RuleElementSrv::cast(*i1);
+    FWObject *re = getChild(2);
+    re->addRef(dummyService);
+    srv_re = RuleElementSrv::cast(re);
 }
 
 void PolicyRule::setDummyInterface()
@@ -345,12 +343,9 @@ void PolicyRule::setDummyInterface()
     if (!dummyInterface || (root->getStringId(dummyInterface->getId()) != "dummyinterfaceid0"))
         return;
 
-    FWObject::iterator i1 = begin();
-    i1++;
-    i1++;
-    i1++;
-    (*i1)->addRef(dummyInterface);
-    itf_re = RuleElementItf::cast(*i1);
+    FWObject *re = getChild(3);
+    re->addRef(dummyInterface);
+    itf_re = RuleElementItf::cast(re);
 }
 
 bool PolicyRule::isDummyRule()
@@ -360,8 +355,14 @@ bool PolicyRule::isDummyRule()
     return false;
 }
 
-bool   PolicyRule::getLogging() const    { return getBool("log"); }
-void   PolicyRule::setLogging(bool flag) { setBool("log",flag);   }
+static const AttributeKey& logKey()
+{
+    static AttributeKey key("log");
+    return key;
+}
+
+bool   PolicyRule::getLogging() const    { return getBool(logKey()); }
+void   PolicyRule::setLogging(bool flag) { setBool(logKey(), flag);   }
 
 
 void PolicyRule::fromXML(xmlNodePtr root) throw(FWException)
@@ -647,6 +648,25 @@ void PolicyRule::replaceReferenceInternal(int old_id, int new_id, int &counter)
     }
 }
 
+void PolicyRule::replaceReferencesInternal(const map<int,int> &id_map,
+                                           int &counter)
+{
+    FWObject::replaceReferencesInternal(id_map, counter);
+
+    string branch_id = getOptionsObject()->getStr("branch_id");
+    if (!branch_id.empty())
+    {
+        map<int,int>::const_iterator it =
+            id_map.find(FWObjectDatabase::getIntId(branch_id));
+        if (it != id_map.end() && it->second != it->first)
+        {
+            getOptionsObject()->setStr("branch_id",
+                                       FWObjectDatabase::getStringId(it->second));
+            counter++;
+        }
+    }
+}
+
 /***************************************************************************/
 
 const char *NATRule::TYPENAME={"NATRule"};
@@ -247,6 +247,8 @@ public:
      * references to branch rulesets.
      */
     virtual void replaceReferenceInternal(int old_id, int new_id, int &counter);
+    virtual void replaceReferencesInternal(const std::map<int,int> &id_map,
+                                           int &counter);
 
     libfwbuilder::RuleElementSrc*  getSrc() ;
     libfwbuilder::RuleElementDst*  getDst() ;
@@ -255,14 +257,14 @@ public:
     libfwbuilder::RuleElementInterval* getWhen() ;
 
     Action getAction() const { return action; }
-    void   setAction(Action act) { action = act; }
+    void   setAction(Action act) { _aboutToChange(); action = act; }
 
     static std::string getActionAsString(int act);
     std::string getActionAsString() const;
     void   setAction(const std::string& act);
 
     Direction getDirection() const { return direction; }
-    void   setDirection(Direction dir) { direction = dir; }
+    void   setDirection(Direction dir) { _aboutToChange(); direction = dir; }
     std::string getDirectionAsString() const;
     void   setDirection(const std::string& dir);
 
@@ -412,7 +414,7 @@ public:
     libfwbuilder::RuleElementInterval* getWhen();
 
     NATAction getAction() const { return action; }
-    void setAction(NATAction act) { action = act; }
+    void setAction(NATAction act) { _aboutToChange(); action = act; }
 
     static std::string getActionAsString(int act);
     std::string getActionAsString() const;
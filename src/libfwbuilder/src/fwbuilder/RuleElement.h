@@ -93,7 +93,7 @@ public:
     virtual void removeRef(FWObject *obj);
 
     bool getNeg() const { return negation; }
-    void setNeg(bool flag) { negation = flag; }
+    void setNeg(bool flag) { _aboutToChange(); negation = flag; }
     void toggleNeg() { negation = !negation; }
 
     virtual int getDummyElementId() const { return -1; }
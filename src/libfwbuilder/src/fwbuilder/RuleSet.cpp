@@ -164,6 +164,7 @@ Rule* RuleSet::insertRuleAtTop(bool hidden_rule)
     r->setHidden(hidden_rule);
     if (hidden_rule) r->setPosition(-1);
     else r->setPosition(0);
+    _aboutToChange();
     insert(begin(), r);
     _adopt(r);
     renumberRules();
@@ -298,8 +299,10 @@ bool RuleSet::moveRule(int src_rule_n, int dst_rule_n)
   	    }
   	}
   	if ( (*m1)!=NULL && (*m2)!=NULL ) {
+  	    _aboutToChange();
   	    erase(m1);
   	    insert(m2,src);
+  	    _invalidateSubtreeTypes(_getSubtreeTypes());
   	}
   	renumberRules();
   	return(true);
@@ -86,12 +86,12 @@ class RuleSet : public FWObject
         return false;
     }
     
-    void setV4() { ipv4=true; ipv6=false; }
-    void setV6() { ipv4=false; ipv6=true; }
-    void setDual() { ipv4=true; ipv6=true; }
+    void setV4() { _aboutToChange(); ipv4=true; ipv6=false; }
+    void setV6() { _aboutToChange(); ipv4=false; ipv6=true; }
+    void setDual() { _aboutToChange(); ipv4=true; ipv6=true; }
     
     bool isTop() const { return top; }
-    void setTop(bool f) { top=f; }
+    void setTop(bool f) { _aboutToChange(); top=f; }
     
     Rule* getRuleByNum(int n);
     
@@ -0,0 +1,218 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  $Id$
+
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#include "config.h"
+#include "fwbuilder/libfwbuilder-config.h"
+
+#include "fwbuilder/SearchIndex.h"
+#include "fwbuilder/FWObject.h"
+#include "fwbuilder/MemoryStats.h"
+
+using namespace std;
+using namespace libfwbuilder;
+
+
+const SearchIndex::posting_list SearchIndex::empty_list;
+
+SearchIndex::~SearchIndex()
+{
+    clear();
+}
+
+void SearchIndex::clear()
+{
+    // every registered object is on exactly one type list
+    for (type_map::iterator i=by_type.begin(); i!=by_type.end(); ++i)
+    {
+        for (posting_list::iterator j=i->second.begin();
+             j!=i->second.end(); ++j)
+            (*j)->search_index = NULL;
+    }
+    by_type.clear();
+    by_keyword.clear();
+    by_name.clear();
+    type_ids.clear();
+}
+
+template <class K>
+static size_t postingMapBytes(const map<K, SearchIndex::posting_list> &m)
+{
+    size_t res = 0;
+    for (typename map<K, SearchIndex::posting_list>::const_iterator i=m.begin();
+         i!=m.end(); ++i)
+        res += MemoryStats::treeNodeBytes(
+            sizeof(K) + sizeof(SearchIndex::posting_list)) +
+            i->second.capacity() * sizeof(FWObject*);
+    return res;
+}
+
+size_t SearchIndex::getBytes() const
+{
+    size_t res = postingMapBytes(by_type) + postingMapBytes(by_keyword) +
+        postingMapBytes(by_name);
+    // keys of the string maps
+    for (keyword_map::const_iterator i=by_keyword.begin();
+         i!=by_keyword.end(); ++i)
+        res += MemoryStats::stringBytes(i->first) - sizeof(string);
+    for (keyword_map::const_iterator i=by_name.begin(); i!=by_name.end(); ++i)
+        res += MemoryStats::stringBytes(i->first) - sizeof(string);
+    return res;
+}
+
+/*
+ * removes element pos of the list by moving the last element in its
+ * place; pos_of is the member of FWObject that keeps the position of
+ * the object in this kind of list
+ */
+void SearchIndex::removeAt(posting_list &lst, int pos, int FWObject::*pos_of)
+{
+    FWObject *last = lst.back();
+    lst[pos] = last;
+    last->*pos_of = pos;
+    lst.pop_back();
+}
+
+void SearchIndex::insert(FWObject *o)
+{
+    int type_id = o->getTypeId();
+    posting_list &lst = by_type[type_id];
+    if (lst.empty()) type_ids[o->getTypeName()] = type_id;
+    o->search_type_pos = int(lst.size());
+    lst.push_back(o);
+
+    for (set<string>::const_iterator i=o->keywords->begin();
+         i!=o->keywords->end(); ++i)
+        by_keyword[*i].push_back(o);
+
+    insertName(o, o->name);
+
+    o->search_index = this;
+    o->search_index_type = type_id;
+}
+
+/*
+ * Uses type id remembered at the time the object was registered
+ * because this is called from the destructor of FWObject where
+ * virtual getTypeId() does not work anymore
+ */
+void SearchIndex::erase(FWObject *o)
+{
+    type_map::iterator it = by_type.find(o->search_index_type);
+    if (it != by_type.end())
+    {
+        removeAt(it->second, o->search_type_pos, &FWObject::search_type_pos);
+        if (it->second.empty()) by_type.erase(it);
+    }
+
+    for (set<string>::const_iterator i=o->keywords->begin();
+         i!=o->keywords->end(); ++i)
+        removeKeyword(o, *i);
+
+    eraseName(o, o->name);
+
+    o->search_index = NULL;
+}
+
+void SearchIndex::insertName(FWObject *o, const string &name)
+{
+    if (name.empty()) return;
+    posting_list &lst = by_name[name];
+    o->search_name_pos = int(lst.size());
+    lst.push_back(o);
+}
+
+void SearchIndex::eraseName(FWObject *o, const string &name)
+{
+    if (name.empty()) return;
+    keyword_map::iterator it = by_name.find(name);
+    if (it == by_name.end()) return;
+    removeAt(it->second, o->search_name_pos, &FWObject::search_name_pos);
+    if (it->second.empty()) by_name.erase(it);
+}
+
+void SearchIndex::update(FWObject *o, SearchIndex *index)
+{
+    if (o->search_index == index) return;
+    if (o->search_index) o->search_index->erase(o);
+    if (index) index->insert(o);
+}
+
+void SearchIndex::addKeyword(FWObject *o, const string &kw)
+{
+    by_keyword[kw].push_back(o);
+}
+
+void SearchIndex::removeKeyword(FWObject *o, const string &kw)
+{
+    keyword_map::iterator it = by_keyword.find(kw);
+    if (it == by_keyword.end()) return;
+    posting_list &lst = it->second;
+    for (posting_list::size_type i=0; i<lst.size(); ++i)
+    {
+        if (lst[i] == o)
+        {
+            lst[i] = lst.back();
+            lst.pop_back();
+            break;
+        }
+    }
+    if (lst.empty()) by_keyword.erase(it);
+}
+
+void SearchIndex::rename(FWObject *o, const string &old_name,
+                         const string &new_name)
+{
+    eraseName(o, old_name);
+    insertName(o, new_name);
+}
+
+const SearchIndex::posting_list& SearchIndex::getObjectsOfType(
+    int type_id) const
+{
+    type_map::const_iterator it = by_type.find(type_id);
+    return (it == by_type.end()) ? empty_list : it->second;
+}
+
+const SearchIndex::posting_list& SearchIndex::getObjectsOfType(
+    const string &type_name) const
+{
+    map<string, int>::const_iterator it = type_ids.find(type_name);
+    return (it == type_ids.end()) ? empty_list : getObjectsOfType(it->second);
+}
+
+const SearchIndex::posting_list& SearchIndex::getObjectsWithKeyword(
+    const string &kw) const
+{
+    keyword_map::const_iterator it = by_keyword.find(kw);
+    return (it == by_keyword.end()) ? empty_list : it->second;
+}
+
+const SearchIndex::posting_list& SearchIndex::getObjectsWithName(
+    const string &name) const
+{
+    keyword_map::const_iterator it = by_name.find(name);
+    return (it == by_name.end()) ? empty_list : it->second;
+}
@@ -0,0 +1,147 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  $Id$
+
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#ifndef  __SEARCHINDEX_HH_FLAG__
+#define  __SEARCHINDEX_HH_FLAG__
+
+#include <string>
+#include <map>
+#include <vector>
+
+
+namespace libfwbuilder
+{
+
+class FWObject;
+
+/**
+ * Inverted index of the objects of one FWObjectDatabase: type id ->
+ * objects of this type, keyword -> objects that have this keyword,
+ * name -> objects with this name. Every object that has the database
+ * as its root is in the index, including objects that have been
+ * removed from the tree but not deleted yet, so callers that care
+ * should check where the object is. Objects with empty names (rules,
+ * rule elements, references and most other objects that are not
+ * primary objects) are not indexed by name.
+ *
+ * Lists of objects are vectors in no particular order. An object
+ * remembers its position in the lists of its type and of its name so
+ * it can be removed from them in constant time; lists of a keyword
+ * are searched.
+ *
+ * FWObject keeps the index current: the object is registered when
+ * its root changes, keywords are updated by addKeyword(),
+ * removeKeyword(), clearKeywords(), fromXML() and shallowDuplicate(),
+ * names by setName() and shallowDuplicate(), and the object is
+ * removed when it is destroyed.
+ */
+class SearchIndex
+{
+public:
+
+    typedef std::vector<FWObject*> posting_list;
+
+private:
+
+    typedef std::map<int, posting_list> type_map;
+    typedef std::map<std::string, posting_list> keyword_map;
+
+    type_map by_type;
+    keyword_map by_keyword;
+    keyword_map by_name;
+    std::map<std::string, int> type_ids;
+
+    static const posting_list empty_list;
+
+    void insert(FWObject *o);
+    void erase(FWObject *o);
+
+    void insertName(FWObject *o, const std::string &name);
+    void eraseName(FWObject *o, const std::string &name);
+
+    static void removeAt(posting_list &lst, int pos, int FWObject::*pos_of);
+
+    SearchIndex(const SearchIndex&);
+
+public:
+
+    SearchIndex() {}
+    ~SearchIndex();
+
+    /**
+     * does not copy anything, see UsageIndex::operator=()
+     */
+    SearchIndex& operator=(const SearchIndex&) { return *this; }
+
+    /**
+     * removes all entries, objects are not registered anywhere after
+     * this
+     */
+    void clear();
+
+    const posting_list& getObjectsOfType(int type_id) const;
+    const posting_list& getObjectsOfType(const std::string &type_name) const;
+    const posting_list& getObjectsWithKeyword(const std::string &kw) const;
+
+    /**
+     * objects with this name; always empty for the empty name
+     */
+    const posting_list& getObjectsWithName(const std::string &name) const;
+
+    /**
+     * number of different types and keywords in the index
+     */
+    int getTypeCount() const { return int(by_type.size()); }
+    int getKeywordCount() const { return int(by_keyword.size()); }
+
+    /**
+     * estimated memory taken by the index, see MemoryStats
+     */
+    size_t getBytes() const;
+
+    /**
+     * moves object to the given index (or removes it from the index
+     * it is registered in if index is NULL)
+     */
+    static void update(FWObject *o, SearchIndex *index);
+
+    /**
+     * these are called by FWObject when keywords of a registered
+     * object change
+     */
+    void addKeyword(FWObject *o, const std::string &kw);
+    void removeKeyword(FWObject *o, const std::string &kw);
+
+    /**
+     * called by FWObject when name of a registered object changes
+     */
+    void rename(FWObject *o, const std::string &old_name,
+                const std::string &new_name);
+};
+
+}
+
+#endif
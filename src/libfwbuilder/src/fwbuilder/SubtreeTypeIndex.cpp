@@ -0,0 +1,137 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  $Id$
+
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#include "config.h"
+#include "fwbuilder/libfwbuilder-config.h"
+
+#include "fwbuilder/SubtreeTypeIndex.h"
+#include "fwbuilder/FWObject.h"
+
+#include <limits.h>
+
+using namespace std;
+using namespace libfwbuilder;
+
+
+volatile unsigned int SubtreeTypeIndex::versions[NUM_BUCKETS] = { 0 };
+
+#ifndef __GNUC__
+static Mutex versions_mutex;
+#endif
+
+void SubtreeTypeIndex::invalidate(unsigned int type_mask)
+{
+    for (int b=0; type_mask!=0; ++b, type_mask >>= 1)
+    {
+        if ((type_mask & 1) == 0) continue;
+#ifdef __GNUC__
+        __sync_add_and_fetch(&versions[b], 1);
+#else
+        versions_mutex.lock();
+        versions[b]++;
+        versions_mutex.unlock();
+#endif
+    }
+}
+
+SubtreeTypeIndex::~SubtreeTypeIndex()
+{
+    clear();
+}
+
+/*
+ * Same order as FWObject::getByTypeDeep(): direct children first,
+ * then descendants of each child
+ */
+void SubtreeTypeIndex::scan(const FWObject *obj, int type_id,
+                            vector<FWObject*> &res)
+{
+    for (FWObject::const_iterator i=obj->begin(); i!=obj->end(); ++i)
+        if ((*i)->getTypeId() == type_id) res.push_back(*i);
+    for (FWObject::const_iterator i=obj->begin(); i!=obj->end(); ++i)
+        scan(*i, type_id, res);
+}
+
+vector<FWObject*> SubtreeTypeIndex::get(const FWObject *obj, int type_id)
+{
+    unsigned int version = versions[type_id & (NUM_BUCKETS - 1)];
+    SubtreeTypeIndex *previous = NULL;
+    vector<FWObject*> res;
+
+    mutex.lock();
+    if (obj->subtree_index != this)
+    {
+        previous = obj->subtree_index;
+        obj->subtree_index = this;
+    }
+    Entry &entry = entries[make_pair(obj, type_id)];
+    if (!entry.valid ||
+        (entry.version != version &&
+         entry.subtree_version != obj->subtree_version))
+    {
+        entry.objects.clear();
+        scan(obj, type_id, entry.objects);
+        entry.version = version;
+        entry.subtree_version = obj->subtree_version;
+        entry.valid = true;
+    }
+    res = entry.objects;
+    mutex.unlock();
+
+    // the object has moved here from another database
+    if (previous) previous->forget(obj);
+    return res;
+}
+
+void SubtreeTypeIndex::forget(const FWObject *obj)
+{
+    mutex.lock();
+    entry_map::iterator first = entries.lower_bound(make_pair(obj, INT_MIN));
+    entry_map::iterator last = first;
+    while (last != entries.end() && last->first.first == obj) ++last;
+    entries.erase(first, last);
+    mutex.unlock();
+}
+
+void SubtreeTypeIndex::clear()
+{
+    mutex.lock();
+    for (entry_map::iterator i=entries.begin(); i!=entries.end(); ++i)
+    {
+        const FWObject *obj = i->first.first;
+        if (obj->subtree_index == this) obj->subtree_index = NULL;
+    }
+    entries.clear();
+    mutex.unlock();
+}
+
+int SubtreeTypeIndex::size()
+{
+    mutex.lock();
+    int res = int(entries.size());
+    mutex.unlock();
+    return res;
+}
@@ -0,0 +1,142 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  $Id$
+
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#ifndef  __SUBTREETYPEINDEX_HH_FLAG__
+#define  __SUBTREETYPEINDEX_HH_FLAG__
+
+#include <map>
+#include <vector>
+#include <utility>
+
+#include "fwbuilder/ThreadTools.h"
+
+
+namespace libfwbuilder
+{
+
+class FWObject;
+
+/**
+ * Cache of the results of FWObject::getByTypeDeep() for the objects
+ * of one FWObjectDatabase: for a pair (object, type id) it keeps the
+ * vector of descendants of the object of this type.
+ *
+ * Type ids are grouped in NUM_BUCKETS buckets, each bucket has a
+ * process-wide version number; every object also has a subtree
+ * version. Whenever a subtree is added to a parent, removed from it
+ * or children get reordered, FWObject calls invalidate() with the
+ * buckets of types found in the subtree and bumps subtree versions
+ * of the parent and all objects above it. A cached vector is rebuilt
+ * only when both the version of the bucket of its type and the
+ * subtree version of its object have changed since it was built.
+ * Rules added to and removed from rule sets do not touch the bucket
+ * of Interface, and interfaces added to one firewall do not touch
+ * subtree versions of other firewalls.
+ *
+ * An object has entries in at most one index, the one of the
+ * database it was in when it was looked up last. Entries of an object
+ * are dropped when the object is destroyed or is looked up in
+ * another database, all entries are dropped when the database is
+ * destroyed.
+ *
+ * Changes made by manipulating the list of children directly,
+ * bypassing methods of FWObject, are not noticed.
+ */
+class SubtreeTypeIndex
+{
+public:
+
+    enum { NUM_BUCKETS = 32 };
+
+private:
+
+    class Entry
+    {
+    public:
+        bool valid;
+        unsigned int version;
+        unsigned int subtree_version;
+        std::vector<FWObject*> objects;
+
+        Entry() : valid(false), version(0), subtree_version(0) {}
+    };
+
+    typedef std::map<std::pair<const FWObject*, int>, Entry> entry_map;
+
+    entry_map entries;
+    Mutex mutex;
+
+    static volatile unsigned int versions[NUM_BUCKETS];
+
+public:
+
+    SubtreeTypeIndex() {}
+    ~SubtreeTypeIndex();
+
+    /**
+     * cached vectors are never copied: a copy of the database gets
+     * its own objects and starts with an empty index
+     */
+    SubtreeTypeIndex(const SubtreeTypeIndex&) : entries(), mutex() {}
+    SubtreeTypeIndex& operator=(const SubtreeTypeIndex&) { return *this; }
+
+    static unsigned int typeBit(int type_id)
+    { return 1U << (type_id & (NUM_BUCKETS - 1)); }
+
+    /**
+     * bumps versions of the buckets present in the mask
+     */
+    static void invalidate(unsigned int type_mask);
+
+    /**
+     * descendants of obj of given type in the order getByTypeDeep()
+     * returns them, found by walking the tree
+     */
+    static void scan(const FWObject *obj, int type_id,
+                     std::vector<FWObject*> &res);
+
+    /**
+     * same as scan() but the result is taken from the cache. The
+     * vector is copied while the cache is locked.
+     */
+    std::vector<FWObject*> get(const FWObject *obj, int type_id);
+
+    /**
+     * drops cached vectors of the object, called from its destructor
+     */
+    void forget(const FWObject *obj);
+
+    /**
+     * drops all cached vectors
+     */
+    void clear();
+
+    int size();
+};
+
+}
+
+#endif
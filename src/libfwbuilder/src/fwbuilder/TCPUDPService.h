@@ -68,10 +68,10 @@ class TCPUDPService : public Service
     int getDstRangeStart() const { return dst_range_start; }
     int getDstRangeEnd()   const { return dst_range_end; }
 
-    void setSrcRangeStart(int p) { src_range_start = p; }
-    void setSrcRangeEnd(int p) { src_range_end = p; }
-    void setDstRangeStart(int p) { dst_range_start = p; }
-    void setDstRangeEnd(int p) { dst_range_end = p; }
+    void setSrcRangeStart(int p) { _aboutToChange(); src_range_start = p; }
+    void setSrcRangeEnd(int p) { _aboutToChange(); src_range_end = p; }
+    void setDstRangeStart(int p) { _aboutToChange(); dst_range_start = p; }
+    void setDstRangeEnd(int p) { _aboutToChange(); dst_range_end = p; }
     
     virtual bool cmp(const FWObject *obj, bool recursive=false) throw(FWException);
 };
@@ -68,6 +68,31 @@ void Mutex::unlock() const
     pthread_mutex_unlock( (pthread_mutex_t*)&mutex );
 }
 
+RWLock::RWLock()
+{
+    pthread_rwlock_init(&rwlock, NULL);
+}
+
+RWLock::~RWLock()
+{
+    pthread_rwlock_destroy(&rwlock);
+}
+
+void RWLock::readLock() const
+{
+    pthread_rwlock_rdlock( (pthread_rwlock_t*)&rwlock );
+}
+
+void RWLock::writeLock() const
+{
+    pthread_rwlock_wrlock( (pthread_rwlock_t*)&rwlock );
+}
+
+void RWLock::unlock() const
+{
+    pthread_rwlock_unlock( (pthread_rwlock_t*)&rwlock );
+}
+
 Cond::Cond()
 {
     pthread_cond_init( &cond, NULL );
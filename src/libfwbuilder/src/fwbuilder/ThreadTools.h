@@ -72,6 +72,27 @@ class Mutex
 
 };
 
+/**
+ * POSIX read-write lock wrapper class. Any number of threads can
+ * hold the lock for reading at the same time.
+ */
+class RWLock
+{
+    protected:
+
+    pthread_rwlock_t rwlock;
+
+    public:
+
+    RWLock();
+    virtual ~RWLock();
+
+    void readLock() const;
+    void writeLock() const;
+    void unlock() const;
+
+};
+
 /**
  * POSIX Mutex wrapper class.
  */
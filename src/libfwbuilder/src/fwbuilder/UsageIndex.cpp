@@ -0,0 +1,277 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  $Id$
+
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#include "config.h"
+#include "fwbuilder/libfwbuilder-config.h"
+
+#include "fwbuilder/UsageIndex.h"
+#include "fwbuilder/FWObject.h"
+#include "fwbuilder/FWObjectDatabase.h"
+#include "fwbuilder/FWReference.h"
+#include "fwbuilder/MemoryStats.h"
+
+using namespace std;
+using namespace libfwbuilder;
+
+
+static const AttributeKey& branchKey()
+{
+    static AttributeKey key("branch_id");
+    return key;
+}
+
+static const AttributeKey& branchNameKey()
+{
+    static AttributeKey key("branch_name");
+    return key;
+}
+
+static const AttributeKey& tagObjectKey()
+{
+    static AttributeKey key("tagobject_id");
+    return key;
+}
+
+static const AttributeKey& networkZoneKey()
+{
+    static AttributeKey key("network_zone");
+    return key;
+}
+
+bool UsageIndex::isReferenceAttribute(int key_id)
+{
+    return (key_id == branchKey().getId() ||
+            key_id == branchNameKey().getId() ||
+            key_id == tagObjectKey().getId() ||
+            key_id == networkZoneKey().getId());
+}
+
+UsageIndex::~UsageIndex()
+{
+    clear();
+}
+
+static void collectUsers(const map<string, set<FWObject*> > &m,
+                         set<FWObject*> &res)
+{
+    for (map<string, set<FWObject*> >::const_iterator i=m.begin();
+         i!=m.end(); ++i)
+        res.insert(i->second.begin(), i->second.end());
+}
+
+void UsageIndex::clear()
+{
+    // the same object can be registered under several keys
+    set<FWObject*> users;
+    for (id_map::iterator i=by_id.begin(); i!=by_id.end(); ++i)
+        users.insert(i->second.begin(), i->second.end());
+    collectUsers(by_str_id, users);
+    collectUsers(by_name, users);
+
+    for (set<FWObject*>::iterator i=users.begin(); i!=users.end(); ++i)
+    {
+        delete (*i)->usage_record;
+        (*i)->usage_record = NULL;
+    }
+    by_id.clear();
+    by_str_id.clear();
+    by_name.clear();
+}
+
+template <class K>
+static size_t postingMapBytes(const map<K, set<FWObject*> > &m)
+{
+    size_t res = 0;
+    for (typename map<K, set<FWObject*> >::const_iterator i=m.begin();
+         i!=m.end(); ++i)
+        res += MemoryStats::treeNodeBytes(
+            sizeof(K) + sizeof(set<FWObject*>)) +
+            i->second.size() * MemoryStats::treeNodeBytes(sizeof(FWObject*));
+    return res;
+}
+
+size_t UsageIndex::getBytes() const
+{
+    size_t res = postingMapBytes(by_id) + postingMapBytes(by_str_id) +
+        postingMapBytes(by_name);
+    // keys of the string maps
+    for (str_id_map::const_iterator i=by_str_id.begin();
+         i!=by_str_id.end(); ++i)
+        res += MemoryStats::stringBytes(i->first) - sizeof(string);
+    for (str_id_map::const_iterator i=by_name.begin(); i!=by_name.end(); ++i)
+        res += MemoryStats::stringBytes(i->first) - sizeof(string);
+    return res;
+}
+
+void UsageIndex::insert(FWObject *user, Record *rec)
+{
+    for (vector<int>::iterator i=rec->ids.begin(); i!=rec->ids.end(); ++i)
+        by_id[*i].insert(user);
+    for (vector<string>::iterator i=rec->str_ids.begin();
+         i!=rec->str_ids.end(); ++i)
+        by_str_id[*i].insert(user);
+    for (vector<string>::iterator i=rec->names.begin();
+         i!=rec->names.end(); ++i)
+        by_name[*i].insert(user);
+}
+
+void UsageIndex::erase(FWObject *user, Record *rec)
+{
+    for (vector<int>::iterator i=rec->ids.begin(); i!=rec->ids.end(); ++i)
+    {
+        id_map::iterator it = by_id.find(*i);
+        if (it == by_id.end()) continue;
+        it->second.erase(user);
+        if (it->second.empty()) by_id.erase(it);
+    }
+    for (vector<string>::iterator i=rec->str_ids.begin();
+         i!=rec->str_ids.end(); ++i)
+    {
+        str_id_map::iterator it = by_str_id.find(*i);
+        if (it == by_str_id.end()) continue;
+        it->second.erase(user);
+        if (it->second.empty()) by_str_id.erase(it);
+    }
+    for (vector<string>::iterator i=rec->names.begin();
+         i!=rec->names.end(); ++i)
+    {
+        str_id_map::iterator it = by_name.find(*i);
+        if (it == by_name.end()) continue;
+        it->second.erase(user);
+        if (it->second.empty()) by_name.erase(it);
+    }
+}
+
+void UsageIndex::getUsers(int id, set<FWObject*> &res)
+{
+    id_map::iterator it = by_id.find(id);
+    if (it != by_id.end()) res.insert(it->second.begin(), it->second.end());
+
+    // objects that have never been given a string id can not be
+    // referred to by one
+    if (!by_str_id.empty())
+    {
+        string s_id = FWObjectDatabase::findStringId(id);
+        if (s_id.empty()) return;
+        str_id_map::iterator its = by_str_id.find(s_id);
+        if (its != by_str_id.end())
+            res.insert(its->second.begin(), its->second.end());
+    }
+}
+
+void UsageIndex::getUsersByName(const string &name, set<FWObject*> &res)
+{
+    str_id_map::iterator it = by_name.find(name);
+    if (it != by_name.end()) res.insert(it->second.begin(), it->second.end());
+}
+
+/*
+ * Ids of the objects user refers to. If string id can not be
+ * converted to integer id yet, it goes to str_ids.
+ */
+void UsageIndex::getTargets(FWObject *user,
+                            vector<int> &ids,
+                            vector<string> &str_ids,
+                            vector<string> &names)
+{
+    FWReference *ref = FWReference::cast(user);
+    if (ref)
+    {
+        int id = ref->getPointerIdDirect();
+        if (id > -1) ids.push_back(id);
+        else
+        {
+            const string &str_id = ref->getPointerStrIdDirect();
+            if (!str_id.empty()) str_ids.push_back(str_id);
+        }
+        return;
+    }
+
+    if (user->data.empty()) return;
+
+    const int keys[] = { branchKey().getId(),
+                         tagObjectKey().getId(),
+                         networkZoneKey().getId() };
+
+    for (unsigned int k=0; k<sizeof(keys)/sizeof(keys[0]); ++k)
+    {
+        const AttributeStore::Slot *s = user->data.find(keys[k]);
+        if (s == NULL || s->getValue().empty()) continue;
+        int id = FWObjectDatabase::getIntId(s->getValue());
+        if (id > -1) ids.push_back(id);
+        else str_ids.push_back(s->getValue());
+    }
+
+    const AttributeStore::Slot *s = user->data.find(branchNameKey().getId());
+    if (s != NULL && !s->getValue().empty()) names.push_back(s->getValue());
+}
+
+void UsageIndex::update(FWObject *user)
+{
+    FWObjectDatabase *db = user->getRoot();
+    UsageIndex *index = (db) ? db->getUsageIndex() : NULL;
+
+    vector<int> ids;
+    vector<string> str_ids;
+    vector<string> names;
+    if (index) getTargets(user, ids, str_ids, names);
+
+    Record *rec = user->usage_record;
+    if (rec)
+    {
+        if (rec->index == index && rec->ids == ids &&
+            rec->str_ids == str_ids && rec->names == names)
+            return;
+        rec->index->erase(user, rec);
+    }
+
+    if (ids.empty() && str_ids.empty() && names.empty())
+    {
+        delete rec;
+        user->usage_record = NULL;
+        return;
+    }
+
+    if (rec == NULL)
+    {
+        rec = new Record();
+        user->usage_record = rec;
+    }
+    rec->index = index;
+    rec->ids.swap(ids);
+    rec->str_ids.swap(str_ids);
+    rec->names.swap(names);
+    index->insert(user, rec);
+}
+
+void UsageIndex::forget(FWObject *user)
+{
+    Record *rec = user->usage_record;
+    if (rec == NULL) return;
+    rec->index->erase(user, rec);
+    delete rec;
+    user->usage_record = NULL;
+}
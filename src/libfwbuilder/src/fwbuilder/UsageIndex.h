@@ -0,0 +1,161 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  $Id$
+
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#ifndef  __USAGEINDEX_HH_FLAG__
+#define  __USAGEINDEX_HH_FLAG__
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+
+
+namespace libfwbuilder
+{
+
+class FWObject;
+
+/**
+ * Reverse reference index: for every object id it keeps the set of
+ * objects that refer to it. Each FWObjectDatabase has one. Objects
+ * that can refer to other objects are:
+ *
+ * - references (FWReference and derived classes)
+ *
+ * - objects with attributes that hold string id of another object:
+ *   "branch_id" and "tagobject_id" in rule options, "network_zone"
+ *   in interfaces (see isReferenceAttribute()). Rules in old data
+ *   files refer to the branch rule set by name ("branch_name"), these
+ *   are indexed by the name.
+ *
+ * The index is kept up to date by FWObject and FWReference: an
+ * object is (re)registered when its root pointer, pointer id or one
+ * of the reference attributes changes, and removed when it is
+ * destroyed. Each registered object keeps a Record of what it has
+ * been registered for, so it can be removed without recomputing its
+ * targets.
+ *
+ * A reference read from XML may point to an object that has not been
+ * loaded yet; such reference is registered under the string id and
+ * getUsers() looks there as well.
+ *
+ * The index knows nothing about the tree structure. Users returned
+ * by getUsers() may be outside of the tree (e.g. removed from it but
+ * not deleted yet); FWObjectDatabase::findWhereObjectIsUsed() checks
+ * where each one is.
+ */
+class UsageIndex
+{
+public:
+
+    class Record
+    {
+    public:
+        UsageIndex *index;
+        std::vector<int> ids;
+        std::vector<std::string> str_ids;
+        std::vector<std::string> names;
+    };
+
+private:
+
+    typedef std::map<int, std::set<FWObject*> > id_map;
+    typedef std::map<std::string, std::set<FWObject*> > str_id_map;
+
+    id_map by_id;
+    str_id_map by_str_id;
+    str_id_map by_name;
+
+    void insert(FWObject *user, Record *rec);
+    void erase(FWObject *user, Record *rec);
+
+    static void getTargets(FWObject *user,
+                           std::vector<int> &ids,
+                           std::vector<std::string> &str_ids,
+                           std::vector<std::string> &names);
+
+    UsageIndex(const UsageIndex&);
+
+public:
+
+    UsageIndex() {}
+    ~UsageIndex();
+
+    /**
+     * does not copy anything: the index describes objects of its own
+     * database. This makes implicit assignment operator of
+     * FWObjectDatabase (used by its copy constructor) leave the index
+     * of the copy alone; the copy builds its own index as objects
+     * are created in it.
+     */
+    UsageIndex& operator=(const UsageIndex&) { return *this; }
+
+    /**
+     * removes all entries and forgets records kept by objects
+     */
+    void clear();
+
+    /**
+     * estimated memory taken by the index, see MemoryStats
+     */
+    size_t getBytes() const;
+
+    /**
+     * adds objects that refer to object with given id to res
+     */
+    void getUsers(int id, std::set<FWObject*> &res);
+
+    /**
+     * adds objects that refer to an object by its name to res
+     */
+    void getUsersByName(const std::string &name, std::set<FWObject*> &res);
+
+    /**
+     * number of ids that have users
+     */
+    int size() const
+    { return int(by_id.size() + by_str_id.size() + by_name.size()); }
+
+    /**
+     * true if attribute with this key id holds string id of another
+     * object
+     */
+    static bool isReferenceAttribute(int key_id);
+
+    /**
+     * (re)registers the object in the index of its database
+     */
+    static void update(FWObject *user);
+
+    /**
+     * removes object from the index it is registered in
+     */
+    static void forget(FWObject *user);
+};
+
+}
+
+#endif
@@ -62,7 +62,7 @@ class UserService : public Service
     virtual int getProtocolNumber() const;
    
     const std::string& getUserId() const { return userid; } 
-    void setUserId(const std::string& uid) { userid = uid; }
+    void setUserId(const std::string& uid) { _aboutToChange(); userid = uid; }
 };
 
 }
@@ -61,10 +61,13 @@
 #include <libxslt/xsltutils.h>
 
 #include <libxml/xmlmemory.h>
+#include <libxml/xmlreader.h>
+#include <libxml/xmlIO.h>
 
 #include <zlib.h>
 
 #include <iostream>
+#include <map>
 
 #undef FW_XMLTOOLS_VERBOSE
 // #define FW_XMLTOOLS_VERBOSE 1
@@ -97,6 +100,14 @@ Mutex xml_parser_mutex;
  */
 Mutex xslt_processor_mutex;
 
+/*
+ * Compiled stylesheets used by transformDocument(). Data file
+ * conversion applies the same chain of stylesheets to every old file,
+ * so each of them is parsed only once per program run. Protected by
+ * 'xslt_processor_mutex'.
+ */
+static map<string, xsltStylesheetPtr> stylesheet_cache;
+
 static void xslt_error_handler(void *ctx, const char *msg, ...)
 {
     char buf[4096];
@@ -227,9 +238,24 @@ void XMLTools::initXMLTools()
 
 void XMLTools::close()
 {
+    xslt_processor_mutex.lock();
+    for (map<string, xsltStylesheetPtr>::iterator i=stylesheet_cache.begin();
+         i!=stylesheet_cache.end(); ++i)
+        xsltFreeStylesheet(i->second);
+    stylesheet_cache.clear();
+    xslt_processor_mutex.unlock();
+
     xmlCleanupParser();
 }
 
+int XMLTools::getCachedStylesheetCount()
+{
+    xslt_processor_mutex.lock();
+    int res = int(stylesheet_cache.size());
+    xslt_processor_mutex.unlock();
+    return res;
+}
+
 string XMLTools::readFile(const std::string &rfile) throw(FWException)
 {
     string buf;
@@ -253,13 +279,17 @@ string XMLTools::readFile(const std::string &rfile) throw(FWException)
     char *chunk = (char*)malloc(chunk_size);
     if (!chunk) throw FWException("Out of memory");
 
+    // size of the file on disk is a good first guess even if it is
+    // compressed, the string grows geometrically from there
+    struct stat stat_buf;
+    if (stat(rfile.c_str(), &stat_buf) == 0) buf.reserve(stat_buf.st_size);
+
     int  n = 0;
     while(1)
     {
-        n = gzread(gzf, chunk, chunk_size-1);
+        n = gzread(gzf, chunk, chunk_size);
         if (n<=0) break;
-        chunk[n] = '\0';
-        buf = buf + chunk;
+        buf.append(chunk, n);
     }
     int errn = errno;
     free(chunk);
@@ -310,6 +340,55 @@ xmlDocPtr XMLTools::parseFile(const string &file_name,
     return doc;
 }
 
+/*
+ * Reads just enough of the document in the buffer to get to the root
+ * element and returns its name and value of attribute "version".
+ * Returns false if there is no root element. DTD is not loaded.
+ */
+static bool peekRootElement(const string &buffer,
+                            string &name, string &version)
+{
+    xmlTextReaderPtr reader = xmlReaderForMemory(
+        buffer.c_str(), int(buffer.length()), NULL, NULL,
+        XML_PARSE_NOERROR | XML_PARSE_NOWARNING);
+    if (reader == NULL) return false;
+
+    bool res = false;
+    while (xmlTextReaderRead(reader) == 1)
+    {
+        if (xmlTextReaderNodeType(reader) != XML_READER_TYPE_ELEMENT)
+            continue;
+        res = true;
+        name = FROMXMLCAST(xmlTextReaderConstLocalName(reader));
+        const char *v = FROMXMLCAST(
+            xmlTextReaderGetAttribute(reader, TOXMLCAST("version")));
+        if (v)
+        {
+            version = v;
+            FREEXMLBUFF(v);
+        }
+        break;
+    }
+    xmlFreeTextReader(reader);
+    return res;
+}
+
+/*
+ * Writes buffer to the file, the same way saveFile() writes XML tree:
+ * through libxml2 output buffer, so the file is compressed if
+ * xmlSetCompressMode() asks for it
+ */
+static void writeFile(const string &file_name,
+                      const string &buf) throw(FWException)
+{
+    xmlOutputBufferPtr out = xmlOutputBufferCreateFilename(
+        file_name.c_str(), NULL, xmlGetCompressMode());
+    bool ok = (out != NULL &&
+               xmlOutputBufferWrite(out, int(buf.size()), buf.data()) >= 0);
+    if (out != NULL && xmlOutputBufferClose(out) < 0) ok = false;
+    if (!ok) throw FWException("Error saving XML file: "+file_name);
+}
+
 xmlDocPtr XMLTools::loadFile(const string &data_file , 
                              const string &type      ,
                              const string &dtd_file  ,
@@ -350,6 +429,21 @@ xmlDocPtr XMLTools::loadFile(const string &data_file ,
 
     string buf = readFile(data_file);
 
+    // If the root element says the file is of the current version,
+    // there is nothing to convert and the file can be parsed once,
+    // with DTD validation.
+    string root_name, root_version;
+    if (data_file!="-" &&
+        peekRootElement(buf, root_name, root_version) &&
+        root_name == type && !root_version.empty() &&
+        version_compare(current_version, root_version) == 0)
+    {
+#ifdef FW_XMLTOOLS_VERBOSE
+        cerr << "File version is current: " << root_version << endl;
+#endif
+        return parseFile(data_file, buf, true, template_dir); 
+    }
+
     // First load without using DTD to check version
     xmlDocPtr doc = parseFile(data_file, buf, false, template_dir); 
 
@@ -357,7 +451,7 @@ xmlDocPtr XMLTools::loadFile(const string &data_file ,
     cerr << "Parsed file: " << data_file << endl;
 #endif
 
-    // normally we load the file twice, first time to check the version and
+    // file that needs conversion is parsed twice, first time to
     // upgrade it and the second time to generate doc that will be
     // used in the program. We can't do this if data_file is '-' (stdin)
     // 'cause we can't read stdin twice. So in this case we do not 
@@ -403,9 +497,17 @@ in the same directory with extension '.bak'. Are you sure you want to open it?";
                               data_file + "' as '" + backup_file + "'");
         }
 
+        // converted document is serialized once; the same buffer
+        // is written to the file and parsed with DTD validation below
+        xmlChar *out = NULL;
+        int out_size = 0;
+        dumpToMemory(doc, &out, &out_size, type, dtd_file);
+        buf.assign(FROMXMLCAST(out), (out) ? out_size : 0);
+        xmlFree(out);
+
         try
         {
-            saveFile(doc, data_file, type, dtd_file);
+            writeFile(data_file, buf);
         } catch(FWException &ex)
         {
             // Saving converted copy failed
@@ -425,8 +527,9 @@ in the same directory with extension '.bak'. Are you sure you want to open it?";
     //xmlCleanupParser();
 
     // Now we know the version is OK,
-    // let us load for real, checking DTD.
-    doc = parseFile(data_file, readFile(data_file), true, template_dir); 
+    // let us load for real, checking DTD. The buffer holds either
+    // the original file or its converted copy.
+    doc = parseFile(data_file, buf, true, template_dir); 
     
     return doc;
 }
@@ -695,12 +798,19 @@ xmlDocPtr XMLTools::transformDocument(xmlDocPtr doc,
     // bugzilla. To be removed than it is fixed.
     xsltSetGenericDebugFunc(&xslt_errors, xslt_error_handler);
 
-    xmlDoValidityCheckingDefaultValue = 0;
-    xmlLoadExtDtdDefaultValue         = 0;
-    xsltStylesheetPtr ss = xsltParseStylesheetFile(
-        STRTOXMLCAST(stylesheet_file));
-    xmlDoValidityCheckingDefaultValue = 1;
-    xmlLoadExtDtdDefaultValue         = DTD_LOAD_BITS;
+    xsltStylesheetPtr ss = NULL;
+    map<string, xsltStylesheetPtr>::iterator cached =
+        stylesheet_cache.find(stylesheet_file);
+    if (cached != stylesheet_cache.end()) ss = cached->second;
+    else
+    {
+        xmlDoValidityCheckingDefaultValue = 0;
+        xmlLoadExtDtdDefaultValue         = 0;
+        ss = xsltParseStylesheetFile(STRTOXMLCAST(stylesheet_file));
+        xmlDoValidityCheckingDefaultValue = 1;
+        xmlLoadExtDtdDefaultValue         = DTD_LOAD_BITS;
+        if (ss) stylesheet_cache[stylesheet_file] = ss;
+    }
 
     if (!ss)
     {
@@ -719,7 +829,6 @@ xmlDocPtr XMLTools::transformDocument(xmlDocPtr doc,
     
     xmlDocPtr res = xsltApplyStylesheet(ss, doc, params);
 
-    xsltFreeStylesheet(ss);
     xsltSetGenericErrorFunc(NULL, NULL);
     xmlSetGenericErrorFunc (NULL, NULL);
     // Following line is workaround for bug #73088 in Gnome
@@ -83,7 +83,8 @@ class XMLTools
     
     /**
      * Loads given file, performing version conversion
-     * if neccessary.
+     * if neccessary. The file is read once; if its root element has
+     * current version, it is parsed once with DTD validation.
      */
     static xmlDocPtr loadFile(const std::string &file_name, 
                               const std::string &type_name, 
@@ -129,7 +130,9 @@ class XMLTools
     ) throw(FWException);
     
     /**
-     * Performs XSLT transformation of the document in memory
+     * Performs XSLT transformation of the document in memory.
+     * Compiled stylesheet is kept until close() is called, so the
+     * stylesheet file is parsed only the first time it is used.
      * @return new document
      */
     static xmlDocPtr transformDocument(xmlDocPtr doc, 
@@ -137,6 +140,11 @@ class XMLTools
                                        const char **params
     ) throw(FWException);
 
+    /**
+     * number of compiled stylesheets kept by transformDocument()
+     */
+    static int getCachedStylesheetCount();
+
     /**
      * Performs XSLT transformation of the document. Results are
      * stored in dst file.
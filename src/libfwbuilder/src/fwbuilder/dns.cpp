@@ -47,10 +47,13 @@
 
 #include <pthread.h>
 
+#include <time.h>
+
 #include <memory>
 #include <sstream>
 #include <cstdlib>
 #include <cstring>
+#include <vector>
 
 #include "fwbuilder/dns.h"
 #include "fwbuilder/ThreadTools.h"
@@ -197,3 +200,162 @@ list<InetAddr> DNS::getHostByName(const string &name, int type)
 }
 
 
+/*
+ * Cache of host name lookups shared by all threads of the program.
+ * getaddrinfo() does not report TTL of DNS records, so entries live
+ * for a fixed time.
+ */
+struct DNSCacheEntry
+{
+    time_t expires;
+    bool ok;
+    list<InetAddr> addresses;
+    string error;
+};
+
+typedef map<pair<string, int>, DNSCacheEntry> dns_cache_map;
+
+static Mutex dns_cache_mutex;
+static dns_cache_map dns_cache;
+static int dns_positive_ttl = 300;
+static int dns_negative_ttl = 60;
+static DNS::ResolverFunc dns_resolver = DNS::getHostByName;
+
+static bool find_in_cache(const pair<string, int> &key, DNSCacheEntry &res)
+{
+    bool found = false;
+    dns_cache_mutex.lock();
+    dns_cache_map::iterator it = dns_cache.find(key);
+    if (it != dns_cache.end() && it->second.expires > time(NULL))
+    {
+        res = it->second;
+        found = true;
+    }
+    dns_cache_mutex.unlock();
+    return found;
+}
+
+static void resolve_and_store(const pair<string, int> &key,
+                              DNSCacheEntry &res)
+{
+    dns_cache_mutex.lock();
+    DNS::ResolverFunc resolver = dns_resolver;
+    int positive_ttl = dns_positive_ttl;
+    int negative_ttl = dns_negative_ttl;
+    dns_cache_mutex.unlock();
+
+    try
+    {
+        res.addresses = resolver(key.first, key.second);
+        res.ok = true;
+    } catch (const FWException &ex)
+    {
+        res.addresses.clear();
+        res.ok = false;
+        res.error = ex.toString();
+    }
+    res.expires = time(NULL) + ((res.ok) ? positive_ttl : negative_ttl);
+
+    dns_cache_mutex.lock();
+    dns_cache[key] = res;
+    dns_cache_mutex.unlock();
+}
+
+void DNS::setResolver(ResolverFunc func)
+{
+    dns_cache_mutex.lock();
+    dns_resolver = (func != NULL) ? func : DNS::getHostByName;
+    dns_cache_mutex.unlock();
+}
+
+void DNS::setCacheTTL(int positive_ttl, int negative_ttl)
+{
+    dns_cache_mutex.lock();
+    dns_positive_ttl = positive_ttl;
+    dns_negative_ttl = negative_ttl;
+    dns_cache_mutex.unlock();
+}
+
+void DNS::clearCache()
+{
+    dns_cache_mutex.lock();
+    dns_cache.clear();
+    dns_cache_mutex.unlock();
+}
+
+list<InetAddr> DNS::getHostByNameCached(const string &name, int type)
+    throw(FWException)
+{
+    pair<string, int> key(name, type);
+    DNSCacheEntry entry;
+    if (!find_in_cache(key, entry)) resolve_and_store(key, entry);
+    if (!entry.ok) throw FWException(entry.error);
+    return entry.addresses;
+}
+
+/*
+ * Names waiting to be resolved by resolveConcurrently(). Every worker
+ * thread takes the next name from the list until it is exhausted.
+ */
+class ResolverQueue
+{
+public:
+    Mutex mutex;
+    vector<pair<string, int> > names;
+    size_t next;
+
+    ResolverQueue() : next(0) {}
+};
+
+static void* resolver_thread(void *arg)
+{
+    ResolverQueue *queue = (ResolverQueue*)(arg);
+    for (;;)
+    {
+        queue->mutex.lock();
+        if (queue->next >= queue->names.size())
+        {
+            queue->mutex.unlock();
+            break;
+        }
+        pair<string, int> key = queue->names[queue->next++];
+        queue->mutex.unlock();
+
+        DNSCacheEntry entry;
+        resolve_and_store(key, entry);
+    }
+    return NULL;
+}
+
+void DNS::resolveConcurrently(const list<pair<string, int> > &names,
+                              int max_threads)
+{
+    DNS::init();
+
+    ResolverQueue queue;
+    set<pair<string, int> > seen;
+    for (list<pair<string, int> >::const_iterator i=names.begin();
+         i!=names.end(); ++i)
+    {
+        if (!seen.insert(*i).second) continue;
+        DNSCacheEntry entry;
+        if (!find_in_cache(*i, entry)) queue.names.push_back(*i);
+    }
+    if (queue.names.empty()) return;
+
+    int n_threads = int(queue.names.size());
+    if (n_threads > max_threads) n_threads = max_threads;
+
+    vector<pthread_t> threads;
+    for (int i=1; i<n_threads; ++i)
+    {
+        pthread_t tid;
+        if (pthread_create(&tid, NULL, resolver_thread, &queue) != 0) break;
+        threads.push_back(tid);
+    }
+    // the calling thread works too, this also takes care of the
+    // case when threads could not be created
+    resolver_thread(&queue);
+    for (vector<pthread_t>::iterator i=threads.begin(); i!=threads.end(); ++i)
+        pthread_join(*i, NULL);
+}
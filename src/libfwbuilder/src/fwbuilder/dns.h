@@ -60,6 +60,9 @@
 #include <vector>
 #include <map>
 #include <queue>
+#include <list>
+#include <set>
+#include <utility>
 
 #ifndef RES_DFLRETRY 
 #  define RES_DFLRETRY 1
@@ -106,6 +109,40 @@ class DNS
     static HostEnt getHostByAddr(const InetAddr &addr, int type=AF_INET)
         throw(FWException);
 
+    /**
+     * Function that resolves host names for getHostByNameCached()
+     * and resolveConcurrently(), getHostByName() by default. Tests
+     * can install a stub here.
+     */
+    typedef std::list<InetAddr> (*ResolverFunc)(const std::string &name,
+                                                int type);
+    static void setResolver(ResolverFunc func);
+
+    /**
+     * Same as getHostByName() but the result is kept in a process
+     * wide cache. Successful lookups are cached for positive_ttl
+     * seconds, failed ones for negative_ttl seconds (see
+     * setCacheTTL()); cached failure throws FWException with the
+     * original message.
+     */
+    static std::list<InetAddr> getHostByNameCached(const std::string &name,
+                                                   int type=AF_INET)
+        throw(FWException);
+
+    /**
+     * Resolves all names that are not in the cache yet, using at
+     * most max_threads threads at a time, and stores results in the
+     * cache. Every distinct name/type pair is resolved once no
+     * matter how many times it appears in the list. Returns when
+     * all names are resolved or have failed.
+     */
+    static void resolveConcurrently(
+        const std::list<std::pair<std::string, int> > &names,
+        int max_threads=16);
+
+    static void setCacheTTL(int positive_ttl, int negative_ttl);
+    static void clearCache();
+
     private:
 
     static Mutex *gethostbyname_mutex;
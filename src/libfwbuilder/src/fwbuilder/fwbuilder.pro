@@ -10,6 +10,8 @@ INCLUDEPATH += "../../../../"
 #
 SOURCES  = 	InetAddr.cpp \
 			InetAddrMask.cpp \
+			InetAddrParser.cpp \
+			PrefixArray.cpp \
 			Inet6AddrMask.cpp \
 			IPRoute.cpp \
 			Address.cpp \
@@ -26,10 +28,22 @@ SOURCES  = 	InetAddr.cpp \
 			FWException.cpp \
 			FWIntervalReference.cpp \
 			FWObject.cpp \
+			FWObjectArena.cpp \
+			FWObjectList.cpp \
+			IdRegistry.cpp \
+			ObjectIndex.cpp \
+			UsageIndex.cpp \
+			SearchIndex.cpp \
+			SubtreeTypeIndex.cpp \
+			FWObjectSnapshot.cpp \
 			FWObjectDatabase.cpp \
 			FWObjectDatabase_create_object.cpp \
 			FWObjectDatabase_tree_ops.cpp \
 			FWObjectDatabase_search.cpp \
+			FWObjectDatabase_partial_load.cpp \
+			DatabaseCache.cpp \
+			DatabaseSaver.cpp \
+			MemoryStats.cpp \
 			FWObjectReference.cpp \
 			FWOptions.cpp \
 			FWReference.cpp \
@@ -58,6 +72,8 @@ SOURCES  = 	InetAddr.cpp \
 			physAddress.cpp \
             DNSName.cpp\
             AddressTable.cpp\
+            AddressTableLoader.cpp\
+            MappedFile.cpp\
 			Policy.cpp \
 			Resources.cpp \
 			Routing.cpp \
@@ -84,8 +100,11 @@ SOURCES  = 	InetAddr.cpp \
 
 HEADERS  = 	inet_net.h \
 			uint128.h \
+			AttributeStore.h \
 			InetAddr.h \
 			InetAddrMask.h \
+			InetAddrParser.h \
+			PrefixArray.h \
 			Inet6AddrMask.h \
 			Dispatch.h \
 			IPRoute.h \
@@ -102,7 +121,19 @@ HEADERS  = 	inet_net.h \
 			StateSyncClusterGroup.h \
 			FWException.h \
 			FWIntervalReference.h \
+			FWObjectArena.h \
+			FWObjectList.h \
+			Interned.h \
+			IdRegistry.h \
+			ObjectIndex.h \
+			UsageIndex.h \
+			SearchIndex.h \
+			SubtreeTypeIndex.h \
+			FWObjectSnapshot.h \
 			FWObjectDatabase.h \
+			DatabaseCache.h \
+			DatabaseSaver.h \
+			MemoryStats.h \
 			FWObject.h \
 			FWObjectReference.h \
 			FWOptions.h \
@@ -134,6 +165,8 @@ HEADERS  = 	inet_net.h \
 			physAddress.h \
             DNSName.h\
             AddressTable.h\
+            AddressTableLoader.h\
+            MappedFile.h\
 			Policy.h \
 			Pool.h \
 			Resources.h \
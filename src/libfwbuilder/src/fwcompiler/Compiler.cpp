@@ -296,6 +296,10 @@ void Compiler::_expand_group_recursive(FWObject *o, list<FWObject*> &ol)
     if ((Group::cast(o)!=NULL && adt==NULL) ||
         (adt!=NULL && adt->isCompileTime()))
     {
+        // creates objects for the entries of the prefix array that
+        // the preprocessor left there, see Preprocessor_ipt
+        if (adt!=NULL) adt->materialize(ipv6);
+
 	for (FWObject::iterator i2=o->begin(); i2!=o->end(); ++i2)
         {
             FWObject *o1 = FWReference::getObject(*i2);
@@ -1228,8 +1232,12 @@ bool Compiler::recursiveGroupsInRE::processNext()
  */
 int  Compiler::emptyGroupsInRE::countChildren(FWObject *obj)
 {
-    if (obj->size()==0) return 0;
     int n=0;
+    // addresses of compile-time MultiAddress objects may still be in
+    // the prefix array, see Preprocessor_ipt
+    if (MultiAddress::cast(obj)!=NULL)
+        n = int(MultiAddress::cast(obj)->getPrefixes().size());
+    if (obj->size()==0) return n;
     for (FWObject::iterator i=obj->begin(); i!=obj->end(); i++) 
     {
         FWObject *o = FWReference::getObject(*i);
@@ -73,8 +73,9 @@ bool Compiler::complexMatch(Address *obj1, Address *obj2,
  */
 Interface* Compiler::findInterfaceFor(const Address *obj1, const Address *obj2)
 {
-    list<FWObject*> interfaces = obj2->getByTypeDeep(Interface::TYPENAME);
-    list<FWObject*>::iterator j;
+    vector<FWObject*> interfaces =
+        obj2->getByTypeDeepCached(Interface::typeId());
+    vector<FWObject*>::const_iterator j;
     for (j=interfaces.begin(); j!=interfaces.end(); ++j )
     {
 	Interface *iface=Interface::cast(*j);
@@ -111,8 +112,9 @@ Interface* Compiler::findInterfaceFor(const Address *obj1, const Address *obj2)
 
 FWObject* Compiler::findAddressFor(const Address *obj1, const Address *obj2)
 {
-    list<FWObject*> interfaces = obj2->getByTypeDeep(Interface::TYPENAME);
-    list<FWObject*>::iterator j;
+    vector<FWObject*> interfaces =
+        obj2->getByTypeDeepCached(Interface::typeId());
+    vector<FWObject*>::const_iterator j;
     for (j=interfaces.begin(); j!=interfaces.end(); ++j )
     {
 	Interface *iface=Interface::cast(*j);
@@ -112,19 +112,15 @@ bool NATCompiler::checkForShadowing(NATRule &r1, NATRule &r2)
     Address  *odst2;  //=getFirstODst(&r2);
     Service  *osrv2;  //=getFirstOSrv(&r2);
 
-    FWObject::iterator i1 = r1.begin();
-    osrc1 = Address::cast(FWReference::cast((*i1)->front())->getPointer());
-    i1++;
-    odst1 = Address::cast(FWReference::cast((*i1)->front())->getPointer());
-    i1++;
-    osrv1 = Service::cast(FWReference::cast((*i1)->front())->getPointer());
-
-    i1 = r2.begin();
-    osrc2 = Address::cast(FWReference::cast((*i1)->front())->getPointer());
-    i1++;
-    odst2 = Address::cast(FWReference::cast((*i1)->front())->getPointer());
-    i1++;
-    osrv2 = Service::cast(FWReference::cast((*i1)->front())->getPointer());
+    FWObject* const *c1 = r1.getChildArray();
+    osrc1 = Address::cast(FWReference::cast(c1[0]->front())->getPointer());
+    odst1 = Address::cast(FWReference::cast(c1[1]->front())->getPointer());
+    osrv1 = Service::cast(FWReference::cast(c1[2]->front())->getPointer());
+
+    FWObject* const *c2 = r2.getChildArray();
+    osrc2 = Address::cast(FWReference::cast(c2[0]->front())->getPointer());
+    odst2 = Address::cast(FWReference::cast(c2[1]->front())->getPointer());
+    osrv2 = Service::cast(FWReference::cast(c2[2]->front())->getPointer());
 
     if (osrc1==NULL || odst1==NULL || osrv1==NULL)
         throw FWException("Can not compare rules because rule "+r1.getLabel()+" has a group in one of its elements. Aborting.");
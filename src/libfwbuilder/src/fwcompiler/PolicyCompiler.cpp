@@ -149,19 +149,15 @@ bool PolicyCompiler::checkForShadowing(PolicyRule &r1, PolicyRule &r2)
     RuleElement *dstrel2;
     RuleElement *srvrel2;
 
-    FWObject::iterator i1 = r1.begin();
-    srcrel1 = RuleElement::cast(*i1);
-    i1++;
-    dstrel1 = RuleElement::cast(*i1);
-    i1++;
-    srvrel1 = RuleElement::cast(*i1);
-
-    i1 = r2.begin();
-    srcrel2 = RuleElement::cast(*i1);
-    i1++;
-    dstrel2 = RuleElement::cast(*i1);
-    i1++;
-    srvrel2 = RuleElement::cast(*i1);
+    FWObject* const *c1 = r1.getChildArray();
+    srcrel1 = RuleElement::cast(c1[0]);
+    dstrel1 = RuleElement::cast(c1[1]);
+    srvrel1 = RuleElement::cast(c1[2]);
+
+    FWObject* const *c2 = r2.getChildArray();
+    srcrel2 = RuleElement::cast(c2[0]);
+    dstrel2 = RuleElement::cast(c2[1]);
+    srvrel2 = RuleElement::cast(c2[2]);
 
     if (srcrel1->getNeg()) return false;
     if (dstrel1->getNeg()) return false;
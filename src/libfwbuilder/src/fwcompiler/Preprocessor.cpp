@@ -27,6 +27,8 @@
 #include "Preprocessor.h"
 
 #include "fwbuilder/MultiAddress.h"
+#include "fwbuilder/DNSName.h"
+#include "fwbuilder/dns.h"
 #include "fwbuilder/Rule.h"
 #include "fwbuilder/RuleElement.h"
 #include "fwbuilder/Firewall.h"
@@ -42,7 +44,6 @@ using namespace libfwbuilder;
 using namespace fwcompiler;
 using namespace std;
 
-static int infinite_recursion_breaker = 0;
 string Preprocessor::myPlatformName() { return "generic_preprocessor"; }
 
 Preprocessor::~Preprocessor()
@@ -73,7 +74,23 @@ void Preprocessor::convertObject(FWObject *obj)
     MultiAddress *adt = MultiAddress::cast(obj);
     if (adt!=NULL && adt->isCompileTime())
     {
-        adt->loadFromSource(ipv6, getCachedFwOpt(), inTestMode());
+        /*
+         * loadFromSource() only fills the prefix array of the
+         * object. Compilers walk children of groups in many places,
+         * so create network objects right away (Preprocessor_ipt
+         * leaves this to group expansion). If the source could
+         * not be read completely, keep what has been read so far
+         * because compilers go on after the error in test mode.
+         */
+        try
+        {
+            adt->loadFromSource(ipv6, getCachedFwOpt(), inTestMode());
+        } catch (FWException&)
+        {
+            adt->materialize(ipv6);
+            throw;
+        }
+        adt->materialize(ipv6);
     }
 }
 
@@ -82,11 +99,16 @@ int  Preprocessor::prolog()
     return 0;
 }
 
-void Preprocessor::findMultiAddressObjectsUsedInRules(FWObject *top)
+/*
+ * scanned marks objects whose children have been looked at,
+ * collected marks objects that have been added to the list
+ */
+void Preprocessor::findMultiAddressObjectsUsedInRules(FWObject *top,
+                                                      VisitMark &scanned,
+                                                      VisitMark &collected,
+                                                      list<FWObject*> &objects)
 {
-    if (top->getInt(".recursion_breaker") == infinite_recursion_breaker)
-        return;
-    top->setInt(".recursion_breaker", infinite_recursion_breaker);
+    if (!scanned.visit(top)) return;
 
     for (FWObject::iterator i=top->begin(); i!=top->end(); ++i)
     {
@@ -96,33 +118,54 @@ void Preprocessor::findMultiAddressObjectsUsedInRules(FWObject *top)
         {
             RuleSet *branch_ruleset = rule->getBranch();
             if (branch_ruleset)
-                findMultiAddressObjectsUsedInRules(branch_ruleset);
+                findMultiAddressObjectsUsedInRules(branch_ruleset,
+                                                   scanned, collected,
+                                                   objects);
         }
 
         FWReference *ref = FWReference::cast(obj);
         if (ref == NULL)
-            findMultiAddressObjectsUsedInRules(obj);
+            findMultiAddressObjectsUsedInRules(obj, scanned, collected,
+                                               objects);
         else
         {
             FWObject *obj_ptr = FWReference::getObject(obj);
-            if (obj_ptr->getInt(".loaded") == infinite_recursion_breaker)
-                continue;
-            obj_ptr->setInt(".loaded", infinite_recursion_breaker);
-
-            try
-            {
-                convertObject(obj_ptr);
-            } catch (FWException &ex) {
-                abort(ex.toString());
-            }
-
-            // Note that MultiAddress inherits ObjectGroup
+            if (!collected.visit(obj_ptr)) continue;
+
+            objects.push_back(obj_ptr);
+
+            // Note that MultiAddress inherits ObjectGroup. Its
+            // children are created by convertObject() and are never
+            // groups, so it does not matter that this happens before
+            // conversion.
             if (Group::cast(obj_ptr))
-                findMultiAddressObjectsUsedInRules(obj_ptr);
+                findMultiAddressObjectsUsedInRules(obj_ptr, scanned,
+                                                   collected, objects);
         }
     }
 }
 
+/*
+ * compile-time DNSName objects are resolved all at once and in
+ * parallel before the objects are converted one by one, so that a
+ * slow name server does not delay the compiler by its timeout
+ * multiplied by the number of objects. convertObject() finds the
+ * results in the DNS cache.
+ */
+void Preprocessor::resolveDNSNames(const list<FWObject*> &objects)
+{
+    int af = (ipv6) ? AF_INET6 : AF_INET;
+    list<pair<string, int> > names;
+    for (list<FWObject*>::const_iterator i=objects.begin();
+         i!=objects.end(); ++i)
+    {
+        DNSName *dnsname = DNSName::cast(*i);
+        if (dnsname!=NULL && dnsname->isCompileTime())
+            names.push_back(make_pair(dnsname->getSourceName(), af));
+    }
+    if (!names.empty()) DNS::resolveConcurrently(names);
+}
+
 void Preprocessor::compile()
 {
     // find all MultiAddress objects used in rules of this firewall,
@@ -131,20 +174,35 @@ void Preprocessor::compile()
     // in netowrk zone of interfaces and rule actions.
 
     // Note: fw belongs to the original object tree rather than dbcopy
-    infinite_recursion_breaker++;
+    VisitMark scanned;
+    VisitMark collected;
+    list<FWObject*> objects;
     FWObject *rule_copy = NULL;
 
     if (single_rule_mode)
     {
         rule_copy = dbcopy->findInIndex(single_rule_compile_rule->getId());
-        findMultiAddressObjectsUsedInRules(rule_copy);
+        findMultiAddressObjectsUsedInRules(rule_copy, scanned, collected,
+                                           objects);
     } else
     {
         FWObject *fwcopy = dbcopy->findInIndex(fw->getId());
-        findMultiAddressObjectsUsedInRules(fwcopy);
+        findMultiAddressObjectsUsedInRules(fwcopy, scanned, collected,
+                                           objects);
     }
+
+    resolveDNSNames(objects);
+
 /* resolving MultiAddress objects */
-//    convertObjectsRecursively(dbcopy);
+    for (list<FWObject*>::iterator i=objects.begin(); i!=objects.end(); ++i)
+    {
+        try
+        {
+            convertObject(*i);
+        } catch (FWException &ex) {
+            abort(ex.toString());
+        }
+    }
 }
 
 void Preprocessor::epilog()
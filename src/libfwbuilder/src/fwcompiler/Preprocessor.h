@@ -40,12 +40,20 @@
 #include "fwbuilder/FWObjectDatabase.h"
 
 #include <string>
+#include <list>
 
 namespace fwcompiler {
 
     class Preprocessor : public Compiler {
 
-        void findMultiAddressObjectsUsedInRules(libfwbuilder::FWObject *top);
+        void findMultiAddressObjectsUsedInRules(
+            libfwbuilder::FWObject *top,
+            libfwbuilder::VisitMark &scanned,
+            libfwbuilder::VisitMark &collected,
+            std::list<libfwbuilder::FWObject*> &objects);
+
+        void resolveDNSNames(
+            const std::list<libfwbuilder::FWObject*> &objects);
 
 public:
 	virtual std::string myPlatformName();
@@ -268,7 +268,8 @@ void PrintingController::findAllGroups(list<FWObject*> &objects,
         {
             groups.push_back(o);
             if (fwbdebug) qDebug("Add group %s to groups",o->getName().c_str());
-            findAllGroups(*o,groups);
+            list<FWObject*> children(o->begin(), o->end());
+            findAllGroups(children,groups);
         }
     }
 }
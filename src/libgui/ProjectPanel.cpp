@@ -42,6 +42,8 @@
 #include "fwbuilder/RuleSet.h"
 #include "fwbuilder/Rule.h"
 #include "fwbuilder/RuleElement.h"
+#include "fwbuilder/FWObjectSnapshot.h"
+#include "fwbuilder/DatabaseSaver.h"
 
 #include "FWBSettings.h"
 #include "FWBTree.h"
@@ -142,6 +144,8 @@ ProjectPanel::ProjectPanel(QWidget *parent):
     ruleSetRedrawPending(false),
     objdb(0),
     origObjdb(0),
+    origSnapshot(0),
+    saver(0),
     fd(0),
     autosaveTimer(new QTimer(static_cast<QObject*>(this))), ruleSetTabIndex(0),
     visibleFirewall(0),
@@ -179,6 +183,8 @@ ProjectPanel::~ProjectPanel()
 
     undoStack->clear();
     if (rcs) delete rcs;
+    if (origSnapshot) delete origSnapshot;
+    resetSaver();
     if (objdb) delete objdb;
     if (origObjdb) delete origObjdb;
     delete m_panel;
@@ -186,6 +192,50 @@ ProjectPanel::~ProjectPanel()
     if (fwbdebug) qDebug() << "ProjectPanel::~ProjectPanel() done";
 }
 
+/*
+ * Diff viewer compares current tree with the one that was loaded
+ * from the file. Instead of copying the whole tree every time a file
+ * is opened we take a snapshot that only saves objects as they are
+ * modified and build the copy when the diff viewer asks for it.
+ */
+void ProjectPanel::resetOrigDb()
+{
+    if (origSnapshot) delete origSnapshot;
+    if (origObjdb) delete origObjdb;
+    origObjdb = NULL;
+    origSnapshot = new FWObjectSnapshot(objdb);
+}
+
+/*
+ * The saver keeps XML text of the objects it has saved, so it is
+ * created once per database and reused by every save. It must go
+ * away before the database does.
+ */
+void ProjectPanel::resetSaver()
+{
+    if (saver) delete saver;
+    saver = NULL;
+}
+
+DatabaseSaver* ProjectPanel::getSaver()
+{
+    if (saver == NULL) saver = new DatabaseSaver(objdb);
+    return saver;
+}
+
+FWObjectDatabase* ProjectPanel::origDb()
+{
+    if (origObjdb == NULL && origSnapshot != NULL)
+    {
+        origObjdb = origSnapshot->materialize();
+        // the copy is complete, snapshot does not need to track
+        // changes anymore
+        delete origSnapshot;
+        origSnapshot = NULL;
+    }
+    return origObjdb;
+}
+
 QString ProjectPanel::getPageTitle(bool file_path)
 {
     QString default_caption = tr("Untitled");
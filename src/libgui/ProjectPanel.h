@@ -40,6 +40,8 @@
 
 namespace libfwbuilder {
     class FWObjectDatabase;
+    class FWObjectSnapshot;
+    class DatabaseSaver;
     class Firewall;
     class PolicyRule;
     class RuleSet;
@@ -89,6 +91,8 @@ class ProjectPanel: public QWidget {
     bool ready;
     
     libfwbuilder::FWObjectDatabase *objdb, *origObjdb;
+    libfwbuilder::FWObjectSnapshot *origSnapshot;
+    libfwbuilder::DatabaseSaver *saver;
     
     findDialog *fd;
         
@@ -149,7 +153,11 @@ public:
     void loadObjects(libfwbuilder::FWObjectDatabase *db);
     void clearObjects();
     libfwbuilder::FWObjectDatabase* db() { return objdb; };
-    libfwbuilder::FWObjectDatabase* origDb() { return origObjdb; }
+    /**
+     * returns the tree as it was when the file was opened. The copy
+     * is built from the snapshot the first time it is needed.
+     */
+    libfwbuilder::FWObjectDatabase* origDb();
     bool hasObject(libfwbuilder::FWObject* obj)
     { return objdb->findInIndex(obj->getId()); };
 
@@ -253,6 +261,12 @@ public:
 
  private:
 
+    void resetOrigDb();
+    void resetSaver();
+    libfwbuilder::DatabaseSaver* getSaver();
+    void waitForBackgroundSave();
+    void reportSaveError(const QString &err);
+
  public slots:
     void newObject();
     
@@ -298,6 +312,7 @@ public:
     void splitterMoved ( int pos, int index );
 
     virtual void autoSave();
+    void checkBackgroundSave();
     virtual void compileThis();
     virtual void installThis();
     virtual void inspectThis();
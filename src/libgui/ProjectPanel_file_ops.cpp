@@ -38,6 +38,7 @@
 #include <fwbuilder/Interface.h>
 #include <fwbuilder/Library.h>
 #include "fwbuilder/Constants.h"
+#include "fwbuilder/DatabaseSaver.h"
 
 #include "ProjectPanel.h"
 
@@ -87,6 +88,9 @@ bool ProjectPanel::saveIfModified(bool include_discard_button)
 {
     if (fwbdebug) qDebug() << "ProjectPanel::saveIfModified()";
 
+    // if background save has failed, the data is still modified
+    waitForBackgroundSave();
+
     if (db() && db()->isDirty())
 //    if (db() && db()->isDirty() && rcs && !rcs->getFileName().isEmpty())
     {
@@ -278,10 +282,7 @@ bool ProjectPanel::loadFile(const QString &fileName, bool load_rcs_head)
             st->setOpenFileDir(getFileDir(fileName));
 
             // For Diff Viewer
-            if (origObjdb)
-                delete origObjdb;
-            origObjdb = new FWObjectDatabase(*objdb);
-            origObjdb->reIndex();
+            resetOrigDb();
 
             return true;
         }
@@ -309,11 +310,51 @@ void ProjectPanel::fileClose()
  * slot that is called by a timer if user turned on auto-save feature
  * using controls in the Preferences dialog. Need to save only if data
  * was modified (flag "dirty" is set).
+ *
+ * The file is written by a background thread so the GUI does not
+ * freeze while a large file is saved. The saver clears "dirty" flag
+ * right away and sets it again if saving fails.
  */
 void ProjectPanel::autoSave()
 {
-    if (db() && db()->isDirty() && rcs && !rcs->getFileName().isEmpty())
-        fileSave();
+    if (db() && db()->isDirty() && rcs && !rcs->getFileName().isEmpty() &&
+        !rcs->isRO() && !rcs->isTemp())
+    {
+        if (saver && saver->isRunning()) return;
+        try
+        {
+            xmlSetCompressMode(st->getCompression() ? 9 : 0);
+            getSaver()->start(rcs->getFileName().toLocal8Bit().constData());
+            QCoreApplication::postEvent(mw, new updateGUIStateEvent());
+            QTimer::singleShot(200, this, SLOT(checkBackgroundSave()));
+        } catch (FWException &ex)
+        {
+            reportSaveError(ex.toString().c_str());
+        }
+    }
+}
+
+void ProjectPanel::checkBackgroundSave()
+{
+    if (saver && saver->isRunning())
+    {
+        QTimer::singleShot(200, this, SLOT(checkBackgroundSave()));
+        return;
+    }
+    waitForBackgroundSave();
+}
+
+void ProjectPanel::waitForBackgroundSave()
+{
+    if (saver == NULL) return;
+    try
+    {
+        saver->wait();
+    } catch (FWException &ex)
+    {
+        reportSaveError(ex.toString().c_str());
+        QCoreApplication::postEvent(mw, new updateGUIStateEvent());
+    }
 }
 
 void ProjectPanel::fileSave()
@@ -948,6 +989,7 @@ void ProjectPanel::loadStandardObjects()
     {
 // need to drop read-only flag on the database before I load new objects
 
+        resetSaver();
         if (objdb)
         {
             objdb->destroyChildren();
@@ -993,10 +1035,7 @@ void ProjectPanel::loadStandardObjects()
                    ctime(&last_modified), objdb->isDirty());
 
         // For Diff Viewer
-        if (origObjdb)
-            delete origObjdb;
-        origObjdb = new FWObjectDatabase(*objdb);
-        origObjdb->reIndex();
+        resetOrigDb();
 
     } catch(FWException &ex)
     {
@@ -1029,6 +1068,7 @@ bool ProjectPanel::loadFromRCS(RCS *_rcs)
 
         clearObjects();
 
+        resetSaver();
         if (objdb)
         {
             objdb->destroyChildren();
@@ -1485,6 +1525,8 @@ void ProjectPanel::save()
                 } else
                 {
                     QApplication::setOverrideCursor(QCursor( Qt::WaitCursor));
+                    // auto-save may still be writing the same file
+                    waitForBackgroundSave();
                     xmlSetCompressMode(st->getCompression() ? 9 : 0);
                     db()->saveFile(
                         rcs->getFileName().toLocal8Bit().constData());
@@ -1495,23 +1537,27 @@ void ProjectPanel::save()
         catch (FWException &ex)
         {
             QApplication::restoreOverrideCursor();
+            reportSaveError(ex.toString().c_str());
+        }
+    }
+}
 
 /* error saving the file. Since XMLTools does not return any useful
  * error message in the exception, let's check for obvious problems here
  */
-            QString err;
-            if (access(
-                    rcs->getFileName().toLocal8Bit().constData(), W_OK)!=0 &&
-                errno==EACCES)  err=tr("File is read-only");
-            else                err=ex.toString().c_str();
-
-            QMessageBox::critical(
-                this,"Firewall Builder",
-                tr("Error saving file %1: %2")
-                .arg(rcs->getFileName()).arg(err),
-                tr("&Continue"), QString::null, QString::null,
-                0, 1 );
-        }
-    }
+void ProjectPanel::reportSaveError(const QString &error)
+{
+    QString err;
+    if (access(
+            rcs->getFileName().toLocal8Bit().constData(), W_OK)!=0 &&
+        errno==EACCES)  err=tr("File is read-only");
+    else                err=error;
+
+    QMessageBox::critical(
+        this,"Firewall Builder",
+        tr("Error saving file %1: %2")
+        .arg(rcs->getFileName()).arg(err),
+        tr("&Continue"), QString::null, QString::null,
+        0, 1 );
 }
 
@@ -140,7 +140,7 @@ void RuleSetDiffDialog::updateRuleSetList() {
 
     if (!currentFirewall || !originalFirewall) return;
 
-    foreach (FWObject *ruleset, static_cast<list<FWObject *> >(*currentFirewall)) {
+    foreach (FWObject *ruleset, list<FWObject *>(currentFirewall->begin(), currentFirewall->end())) {
         if ((ruleset->getTypeName() == Policy::TYPENAME) ||
                 (ruleset->getTypeName() == NAT::TYPENAME) ||
                 (ruleset->getTypeName() == Routing::TYPENAME))
@@ -44,13 +44,8 @@
 using namespace std;
 using namespace libfwbuilder;
 
-int UsageResolver::search_id_seed = 0;
-
-
 UsageResolver::UsageResolver()
 {
-    search_id = search_id_seed;
-    search_id_seed++;
 }
 
 
@@ -92,11 +87,7 @@ void UsageResolver::findWhereUsedRecursively(
  */
     for (i=resset_tmp_2.begin(); i!=resset_tmp_2.end(); ++i)
     {
-        if ((*i)->getInt(".usage_resolver_seach_id") != search_id)
-        {
-            new_obj_set.insert(*i);
-            (*i)->setInt(".usage_resolver_seach_id", search_id);
-        }
+        if (seen.visit(*i)) new_obj_set.insert(*i);
     }
 
     resset.insert(new_obj_set.begin(), new_obj_set.end());
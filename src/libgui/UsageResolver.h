@@ -38,9 +38,7 @@
 
 class UsageResolver
 {
-    int search_id;
-
-    static int search_id_seed;
+    libfwbuilder::VisitMark seen;
 
 public:
     UsageResolver();
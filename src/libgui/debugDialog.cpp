@@ -121,6 +121,15 @@ debugDialog::debugDialog(QWidget *parent) : QDialog(parent)
         m_dialog->debugText->append( QString("  index size: %1 records").arg(s) );
         m_dialog->debugText->append( QString("  hits: %1").arg(h) );
         m_dialog->debugText->append( QString("  misses: %1").arg(m) );
+
+        libfwbuilder::ObjectIndexStats stats;
+        mw->activeProject()->db()->getIndexStats(stats);
+        m_dialog->debugText->append(
+            QString("  hash table capacity: %1").arg(stats.capacity) );
+        m_dialog->debugText->append(
+            QString("  average probe length: %1").arg(stats.avg_probe_length) );
+        m_dialog->debugText->append(
+            QString("  max probe length: %1").arg(stats.max_probe_length) );
         m_dialog->debugText->append( "\n" );
     }
 
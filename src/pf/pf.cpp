@@ -68,7 +68,7 @@ void usage(const char *name)
 {
     cout << "Firewall Builder:  policy compiler for OpenBSD PF" << endl;
     cout << "Version " << VERSION << endl;
-    cout << "Usage: " << name << " [-x] [-v] [-V] [-f filename.xml] [-o output.fw] [-d destdir] [-D datadir] [-m] [-4|-6] firewall_object_name" << endl;
+    cout << "Usage: " << name << " [-x] [-v] [-V] [-f filename.xml] [-o output.fw] [-d destdir] [-D datadir] [-C cachedir] [-m] [-4|-6] firewall_object_name" << endl;
 }
 
 
@@ -127,6 +127,7 @@ int main(int argc, char **argv)
 
 	/* create database */
 	objdb = new FWObjectDatabase();
+	objdb->setUseArena(true);
 
 	/* load the data file */
 	UpgradePredicate upgrade_predicate; 
@@ -134,10 +135,13 @@ int main(int argc, char **argv)
 	cout << " *** Loading data ...";
 
         objdb->setReadOnly( false );
+        FWObjectDatabase *ndb = new FWObjectDatabase();
+        // cache directory and objects used by the firewall being
+        // compiled; the cache is used for the standard objects too
+        CompilerDriver::prepareLoad(ndb, args);
         objdb->load( Constants::getStandardObjectsFilePath(),
                      &upgrade_predicate, Constants::getDTDDirectory());
         objdb->setFileName("");
-        FWObjectDatabase *ndb = new FWObjectDatabase();
         ndb->load(filename, &upgrade_predicate,  Constants::getDTDDirectory());
         objdb->merge(ndb, NULL);
         delete ndb;
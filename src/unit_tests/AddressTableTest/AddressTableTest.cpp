@@ -38,6 +38,13 @@
 #include "fwbuilder/ObjectGroup.h"
 #include "fwbuilder/AddressTable.h"
 #include "fwbuilder/Network.h"
+#include "fwbuilder/PrefixArray.h"
+#include "fwbuilder/AddressTableLoader.h"
+
+#include <stdio.h>
+#include <unistd.h>
+#include <fstream>
+#include <sstream>
 
 
 using namespace std;
@@ -92,6 +99,16 @@ void AddressTableTest::positiveTest()
     nobj->setSourceName("addresstable-1.txt");
     nobj->loadFromSource(false, NULL, true);
 
+    // addresses stay in the prefix array until materialize() is called
+    CPPUNIT_ASSERT(nobj->size() == 0);
+    CPPUNIT_ASSERT(nobj->getPrefixes().size(AF_INET) == addrset.size());
+
+    nobj->materialize(false);
+    CPPUNIT_ASSERT(nobj->size() == int(addrset.size()));
+    // calling it again does not create new objects
+    nobj->materialize(false);
+    CPPUNIT_ASSERT(nobj->size() == int(addrset.size()));
+
     list<FWObject*>::const_iterator t = nobj->begin();
     Network *net;
     FWReference *ref;
@@ -106,8 +123,172 @@ void AddressTableTest::positiveTest()
     }
 
     CPPUNIT_ASSERT(addrset==addrres);
+
+    // objects are named the way addresses are written in the file
+    t = nobj->begin();
+    CPPUNIT_ASSERT(FWReference::getObject(*t)->getName() == "216.193.197.238");
+    ++t;
+    CPPUNIT_ASSERT(FWReference::getObject(*t)->getName() == "207.46.20.60/24");
 }
 
+void AddressTableTest::prefixArrayTest()
+{
+    PrefixArray pa;
+
+    CPPUNIT_ASSERT(pa.add(InetAddr("10.0.1.0"), InetAddr("255.255.255.0")));
+    CPPUNIT_ASSERT(pa.add(InetAddr("10.0.1.5"), InetAddr(AF_INET, 32),
+                          PrefixArray::BARE));
+    // duplicates and host bits are kept
+    CPPUNIT_ASSERT(pa.add(InetAddr("192.168.1.3"), InetAddr(AF_INET, 30)));
+    CPPUNIT_ASSERT(pa.add(InetAddr("192.168.1.3"), InetAddr(AF_INET, 30)));
+    CPPUNIT_ASSERT(pa.add(InetAddr("10.1.0.0"), InetAddr(AF_INET, 16),
+                          PrefixArray::LENGTH, "10.1/16", 7));
+    CPPUNIT_ASSERT(pa.add(InetAddr("10.2.0.0"), InetAddr("255.255.0.0"),
+                          PrefixArray::NETMASK, "10.2.0.0/255.255.0.0", 20));
+    CPPUNIT_ASSERT(pa.add(InetAddr(AF_INET6, "2001:db8::"),
+                          InetAddr(AF_INET6, 33)));
+    CPPUNIT_ASSERT(pa.add(InetAddr(AF_INET6, "2001:db8::1"),
+                          InetAddr(AF_INET6, 128),
+                          PrefixArray::BARE, "2001:DB8::1", 11));
+
+    // netmask with holes and address family mismatch
+    CPPUNIT_ASSERT(!pa.add(InetAddr("10.1.0.0"), InetAddr("255.0.255.0")));
+    CPPUNIT_ASSERT(!pa.add(InetAddr("10.1.0.0"), InetAddr(AF_INET6, 64)));
+
+    CPPUNIT_ASSERT(pa.size(AF_INET) == 6);
+    CPPUNIT_ASSERT(pa.size(AF_INET6) == 2);
+    CPPUNIT_ASSERT(pa.toString(AF_INET, 0) == "10.0.1.0/24");
+    CPPUNIT_ASSERT(pa.toString(AF_INET, 1) == "10.0.1.5");
+    CPPUNIT_ASSERT(pa.toString(AF_INET, 3) == "192.168.1.3/30");
+    // names come from the source text
+    CPPUNIT_ASSERT(pa.toString(AF_INET, 4) == "10.1/16");
+    CPPUNIT_ASSERT(pa.toString(AF_INET, 5) == "10.2.0.0/255.255.0.0");
+    CPPUNIT_ASSERT(pa.toString(AF_INET6, 0) == "2001:db8::/33");
+    CPPUNIT_ASSERT(pa.toString(AF_INET6, 1) == "2001:DB8::1");
+
+    InetAddr addr, netmask;
+    pa.get(AF_INET, 4, addr, netmask);
+    CPPUNIT_ASSERT(addr.toString() == "10.1.0.0");
+    CPPUNIT_ASSERT(netmask.toString() == "255.255.0.0");
+
+    // source texts move with their entries
+    PrefixArray joined;
+    joined.add(InetAddr("10.3.0.0"), InetAddr(AF_INET, 16),
+               PrefixArray::LENGTH, "10.3/16", 7);
+    joined.append(pa);
+    CPPUNIT_ASSERT(joined.toString(AF_INET, 0) == "10.3/16");
+    CPPUNIT_ASSERT(joined.toString(AF_INET, 5) == "10.1/16");
+    CPPUNIT_ASSERT(joined.toString(AF_INET, 6) == "10.2.0.0/255.255.0.0");
+    CPPUNIT_ASSERT(joined.toString(AF_INET6, 1) == "2001:DB8::1");
+
+    FILE *f = tmpfile();
+    CPPUNIT_ASSERT(f != NULL);
+    CPPUNIT_ASSERT(joined.write(f));
+    rewind(f);
+    PrefixArray copy;
+    CPPUNIT_ASSERT(copy.read(f));
+    fclose(f);
+    CPPUNIT_ASSERT(copy.size(AF_INET) == joined.size(AF_INET));
+    CPPUNIT_ASSERT(copy.size(AF_INET6) == joined.size(AF_INET6));
+    for (size_t i=0; i<joined.size(AF_INET); ++i)
+        CPPUNIT_ASSERT(copy.toString(AF_INET, i) ==
+                       joined.toString(AF_INET, i));
+    CPPUNIT_ASSERT(copy.toString(AF_INET6, 1) == "2001:DB8::1");
+}
+
+void AddressTableTest::aggregateTest()
+{
+    PrefixArray pa;
+
+    CPPUNIT_ASSERT(pa.add(InetAddr("10.0.2.0"), InetAddr(AF_INET, 24),
+                          PrefixArray::LENGTH, "10.0.2/24", 9));
+    CPPUNIT_ASSERT(pa.add(InetAddr("10.0.1.0"), InetAddr(AF_INET, 24)));
+    CPPUNIT_ASSERT(pa.add(InetAddr("10.0.1.5"), InetAddr(AF_INET, 32),
+                          PrefixArray::BARE));
+    CPPUNIT_ASSERT(pa.add(InetAddr("172.16.0.0"), InetAddr("255.240.0.0"),
+                          PrefixArray::NETMASK));
+    CPPUNIT_ASSERT(pa.add(InetAddr("10.0.0.0"), InetAddr(AF_INET, 24)));
+    CPPUNIT_ASSERT(pa.add(InetAddr("192.168.1.3"), InetAddr(AF_INET, 30)));
+    CPPUNIT_ASSERT(pa.add(InetAddr("172.16.0.0"), InetAddr(AF_INET, 12)));
+    CPPUNIT_ASSERT(pa.add(InetAddr(AF_INET6, "2001:db8:8000::"),
+                          InetAddr(AF_INET6, 33)));
+    CPPUNIT_ASSERT(pa.add(InetAddr(AF_INET6, "2001:db8::1"),
+                          InetAddr(AF_INET6, 128), PrefixArray::BARE));
+    CPPUNIT_ASSERT(pa.add(InetAddr(AF_INET6, "2001:db8::"),
+                          InetAddr(AF_INET6, 33)));
+
+    // array that is not aggregated is searched entry by entry
+    CPPUNIT_ASSERT(!pa.isAggregated(AF_INET));
+    CPPUNIT_ASSERT(pa.contains(InetAddr("192.168.1.1")));
+    CPPUNIT_ASSERT(!pa.contains(InetAddr("192.168.1.4")));
+
+    pa.aggregate();
+    CPPUNIT_ASSERT(pa.isAggregated(AF_INET));
+    CPPUNIT_ASSERT(pa.isAggregated(AF_INET6));
+
+    // siblings are merged, covered entries and duplicates removed,
+    // host bits cleared; entries that did not change keep their
+    // source text and notation, of duplicates the first one is kept
+    CPPUNIT_ASSERT(pa.size(AF_INET) == 4);
+    CPPUNIT_ASSERT(pa.toString(AF_INET, 0) == "10.0.0.0/23");
+    CPPUNIT_ASSERT(pa.toString(AF_INET, 1) == "10.0.2/24");
+    CPPUNIT_ASSERT(pa.toString(AF_INET, 2) == "172.16.0.0/255.240.0.0");
+    CPPUNIT_ASSERT(pa.toString(AF_INET, 3) == "192.168.1.0/30");
+    CPPUNIT_ASSERT(pa.size(AF_INET6) == 1);
+    CPPUNIT_ASSERT(pa.toString(AF_INET6, 0) == "2001:db8::/32");
+
+    CPPUNIT_ASSERT(pa.contains(InetAddr("10.0.0.0")));
+    CPPUNIT_ASSERT(pa.contains(InetAddr("10.0.2.255")));
+    CPPUNIT_ASSERT(!pa.contains(InetAddr("10.0.3.0")));
+    CPPUNIT_ASSERT(!pa.contains(InetAddr("9.255.255.255")));
+    CPPUNIT_ASSERT(pa.contains(InetAddr("172.31.255.255")));
+    CPPUNIT_ASSERT(pa.contains(InetAddr("192.168.1.0")));
+    CPPUNIT_ASSERT(!pa.contains(InetAddr("192.168.1.4")));
+    CPPUNIT_ASSERT(pa.contains(InetAddr(AF_INET6, "2001:db8:ffff::1")));
+    CPPUNIT_ASSERT(!pa.contains(InetAddr(AF_INET6, "2001:db9::")));
+
+    // adding to one address family does not affect the other
+    pa.add(InetAddr("10.0.3.0"), InetAddr(AF_INET, 24));
+    CPPUNIT_ASSERT(!pa.isAggregated(AF_INET));
+    CPPUNIT_ASSERT(pa.isAggregated(AF_INET6));
+    pa.aggregate(AF_INET);
+    CPPUNIT_ASSERT(pa.size(AF_INET) == 3);
+    CPPUNIT_ASSERT(pa.toString(AF_INET, 0) == "10.0.0.0/22");
+
+    // the flags survive the cache file
+    FILE *f = tmpfile();
+    CPPUNIT_ASSERT(f != NULL);
+    CPPUNIT_ASSERT(pa.write(f));
+    rewind(f);
+    PrefixArray copy;
+    CPPUNIT_ASSERT(copy.read(f));
+    fclose(f);
+    CPPUNIT_ASSERT(copy.isAggregated(AF_INET));
+    CPPUNIT_ASSERT(copy.isAggregated(AF_INET6));
+    CPPUNIT_ASSERT(copy.contains(InetAddr("10.0.3.1")));
+
+    // address table: 192.168.105.68 and .69 become one /31, the
+    // network with host bits set loses them
+    AddressTable *nobj = AddressTable::cast(
+        objdb->create(AddressTable::TYPENAME, true));
+    address_tables_group->add(nobj);
+    nobj->setName("AggregatedADT");
+    nobj->setSourceName("addresstable-1.txt");
+    nobj->loadFromSource(false, NULL, true);
+    CPPUNIT_ASSERT(nobj->getPrefixes().size(AF_INET) == 12);
+    nobj->aggregatePrefixes(false);
+    CPPUNIT_ASSERT(nobj->getPrefixes().size(AF_INET) == 11);
+    CPPUNIT_ASSERT(nobj->getPrefixes().contains(InetAddr("192.168.105.69")));
+    CPPUNIT_ASSERT(nobj->getPrefixes().contains(InetAddr("207.46.20.1")));
+    nobj->materialize(false);
+    CPPUNIT_ASSERT(nobj->size() == 11);
+    set<string> names;
+    for (FWObject::iterator i=nobj->begin(); i!=nobj->end(); ++i)
+        names.insert(FWReference::getObject(*i)->getName());
+    CPPUNIT_ASSERT(names.count("192.168.105.68/31") == 1);
+    CPPUNIT_ASSERT(names.count("207.46.20.0/24") == 1);
+    CPPUNIT_ASSERT(names.count("216.193.197.238") == 1);
+}
 
 void AddressTableTest::negativeTest1()
 {
@@ -137,3 +318,115 @@ void AddressTableTest::negativeTest2()
     CPPUNIT_ASSERT_THROW(nobj->loadFromSource(false, NULL, true), FWException);
 }
 
+
+static string makeTableFile(const string &file_name, int n_lines, int bad_line)
+{
+    ostringstream str;
+    for (int i=1; i<=n_lines; ++i)
+    {
+        if (i == bad_line) str << "10.0.0.300\n";
+        else if (i % 3 == 0) str << "# comment " << i << "\n";
+        else if (i % 3 == 1)
+            str << "10." << (i >> 16) % 256 << "." << (i >> 8) % 256
+                << "." << i % 256 << " host " << i << "\n";
+        else str << "  2001:db8::" << hex << i % 65536 << dec << "/64\n";
+    }
+    ofstream f(file_name.c_str(), ios::out | ios::trunc);
+    f << str.str();
+    return str.str();
+}
+
+void AddressTableTest::loaderTest()
+{
+    string file_name = "addresstable-loader.txt";
+    int n_lines = 60000;
+    makeTableFile(file_name, n_lines, -1);
+
+    PrefixArray single;
+    PrefixArray parallel;
+    AddressTableLoader::clearCache();
+    AddressTableLoader::setMaxThreads(1);
+    CPPUNIT_ASSERT(AddressTableLoader::load(file_name, false, single));
+    AddressTableLoader::clearCache();
+    AddressTableLoader::setMaxThreads(4);
+    CPPUNIT_ASSERT(AddressTableLoader::load(file_name, false, parallel));
+
+    CPPUNIT_ASSERT(single.size(AF_INET) == size_t(n_lines / 3));
+    CPPUNIT_ASSERT(single.size(AF_INET6) == 0);
+    CPPUNIT_ASSERT(single.getV4().size() == parallel.getV4().size());
+    for (size_t i=0; i<single.size(AF_INET); ++i)
+        CPPUNIT_ASSERT(single.getV4()[i].addr == parallel.getV4()[i].addr);
+
+    PrefixArray v6;
+    CPPUNIT_ASSERT(AddressTableLoader::load(file_name, true, v6));
+    CPPUNIT_ASSERT(v6.size(AF_INET6) == size_t(n_lines / 3));
+    CPPUNIT_ASSERT(v6.toString(AF_INET6, 0) == "2001:db8::2/64");
+
+    // the second load comes from the cache and returns the same
+    PrefixArray cached;
+    CPPUNIT_ASSERT(AddressTableLoader::load(file_name, false, cached));
+    CPPUNIT_ASSERT(cached.size() == parallel.size());
+
+    // error in the middle of the file is reported with correct line
+    // number, addresses that precede it are loaded
+    makeTableFile(file_name, n_lines, 50000);
+    PrefixArray partial;
+    try
+    {
+        AddressTableLoader::load(file_name, false, partial);
+        CPPUNIT_FAIL("invalid address was not detected");
+    } catch (FWException &ex)
+    {
+        CPPUNIT_ASSERT(ex.toString().find(":50000 ") != string::npos);
+    }
+    CPPUNIT_ASSERT(partial.size(AF_INET) == 49999 / 3 + 1);
+
+    // on-disk cache
+    string contents = makeTableFile(file_name, 3000, -1);
+    AddressTableLoader::clearCache();
+    AddressTableLoader::setCacheDirectory(".");
+    PrefixArray from_file;
+    CPPUNIT_ASSERT(AddressTableLoader::load(file_name, false, from_file));
+
+    char cache_name[64];
+    snprintf(cache_name, sizeof(cache_name), "./%016llx.v4",
+             (unsigned long long)(AddressTableLoader::hash(
+                                      contents.data(), contents.size())));
+    CPPUNIT_ASSERT(access(cache_name, R_OK) == 0);
+
+    AddressTableLoader::clearCache();
+    PrefixArray from_cache;
+    CPPUNIT_ASSERT(AddressTableLoader::load(file_name, false, from_cache));
+    CPPUNIT_ASSERT(from_cache.size() == from_file.size());
+    CPPUNIT_ASSERT(from_cache.toString(AF_INET, 0) == "10.0.0.1");
+    unlink(cache_name);
+
+    // abbreviated address keeps its text, also in the on-disk cache
+    {
+        ofstream f(file_name.c_str(), ios::out | ios::trunc);
+        f << "10.1/16\n10.2.0.1\n";
+    }
+    AddressTableLoader::clearCache();
+    PrefixArray short_file;
+    CPPUNIT_ASSERT(AddressTableLoader::load(file_name, false, short_file));
+    CPPUNIT_ASSERT(short_file.toString(AF_INET, 0) == "10.1/16");
+    AddressTableLoader::clearCache();
+    PrefixArray short_cached;
+    CPPUNIT_ASSERT(AddressTableLoader::load(file_name, false, short_cached));
+    CPPUNIT_ASSERT(short_cached.toString(AF_INET, 0) == "10.1/16");
+    CPPUNIT_ASSERT(short_cached.toString(AF_INET, 1) == "10.2.0.1");
+    string short_contents = "10.1/16\n10.2.0.1\n";
+    snprintf(cache_name, sizeof(cache_name), "./%016llx.v4",
+             (unsigned long long)(AddressTableLoader::hash(
+                                      short_contents.data(),
+                                      short_contents.size())));
+    CPPUNIT_ASSERT(access(cache_name, R_OK) == 0);
+
+    AddressTableLoader::setCacheDirectory("");
+    AddressTableLoader::setMaxThreads(0);
+    unlink(cache_name);
+    unlink(file_name.c_str());
+
+    CPPUNIT_ASSERT(!AddressTableLoader::load("addresstable-not-found.txt",
+                                             false, from_file));
+}
@@ -46,6 +46,9 @@ class AddressTableTest : public CppUnit::TestFixture
     CPPUNIT_TEST(positiveTest);
     CPPUNIT_TEST(negativeTest1);
     CPPUNIT_TEST(negativeTest2);
+    CPPUNIT_TEST(prefixArrayTest);
+    CPPUNIT_TEST(aggregateTest);
+    CPPUNIT_TEST(loaderTest);
     CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -53,6 +56,9 @@ public:
     void positiveTest();
     void negativeTest1();
     void negativeTest2();
+    void prefixArrayTest();
+    void aggregateTest();
+    void loaderTest();
     
 };
 
@@ -37,6 +37,12 @@
 #include "fwbuilder/Host.h"
 #include "fwbuilder/Library.h"
 #include "fwbuilder/DNSName.h"
+#include "fwbuilder/dns.h"
+#include "fwbuilder/ThreadTools.h"
+
+#include <unistd.h>
+#include <stdio.h>
+
 #include <algorithm>
 
 using namespace libfwbuilder;
@@ -121,3 +127,106 @@ void DNSTest::runTest()
 
     CPPUNIT_ASSERT(testDNSNameObject(objdb, root, test3[0], &(test3[1])));
 }
+
+static Mutex stub_mutex;
+static int stub_calls = 0;
+static int stub_active = 0;
+static int stub_max_active = 0;
+
+/*
+ * stub resolver: "hostN.test" resolves to 192.0.2.N, everything else
+ * fails. Counts calls and the number of calls running at the same
+ * time. The first call waits (up to 5 sec) for another one to start,
+ * so concurrent resolution always overlaps and serial resolution
+ * never does.
+ */
+static list<InetAddr> stubResolver(const string &name, int)
+{
+    stub_mutex.lock();
+    stub_calls++;
+    stub_active++;
+    if (stub_active > stub_max_active) stub_max_active = stub_active;
+    bool first = (stub_calls == 1);
+    stub_mutex.unlock();
+
+    for (int i=0; first && i<500; ++i)
+    {
+        stub_mutex.lock();
+        bool overlap = (stub_max_active > 1);
+        stub_mutex.unlock();
+        if (overlap) break;
+        usleep(10000);
+    }
+
+    stub_mutex.lock();
+    stub_active--;
+    stub_mutex.unlock();
+
+    int n = 0;
+    if (sscanf(name.c_str(), "host%d.test", &n) != 1)
+        throw FWException("Host or network '" + name + "' not found");
+
+    char buf[32];
+    snprintf(buf, sizeof(buf), "192.0.2.%d", n);
+    list<InetAddr> res;
+    res.push_back(InetAddr(buf));
+    return res;
+}
+
+void DNSTest::cacheTest()
+{
+    DNS::clearCache();
+    DNS::setResolver(stubResolver);
+    DNS::setCacheTTL(300, 300);
+
+    list<pair<string, int> > names;
+    for (int i=1; i<=20; ++i)
+    {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "host%d.test", i);
+        names.push_back(make_pair(string(buf), AF_INET));
+        names.push_back(make_pair(string(buf), AF_INET));
+    }
+    names.push_back(make_pair(string("fail.test"), AF_INET));
+
+    // 21 distinct names, each resolved once by up to 10 threads
+    DNS::resolveConcurrently(names, 10);
+    CPPUNIT_ASSERT(stub_calls == 21);
+    CPPUNIT_ASSERT(stub_max_active > 1 && stub_max_active <= 10);
+
+    // everything comes from the cache now, including the failure
+    list<InetAddr> res = DNS::getHostByNameCached("host3.test", AF_INET);
+    CPPUNIT_ASSERT(res.size() == 1);
+    CPPUNIT_ASSERT(res.front().toString() == "192.0.2.3");
+    CPPUNIT_ASSERT_THROW(DNS::getHostByNameCached("fail.test", AF_INET),
+                         FWException);
+    DNS::resolveConcurrently(names, 10);
+    CPPUNIT_ASSERT(stub_calls == 21);
+
+    // compile-time DNSName object uses the cache
+    FWObjectDatabase *db = new FWObjectDatabase();
+    DNSName *dnsname = DNSName::cast(db->create(DNSName::TYPENAME));
+    db->add(dnsname);
+    dnsname->setSourceName("host5.test");
+    dnsname->setRunTime(false);
+    dnsname->loadFromSource(false, NULL, false);
+    CPPUNIT_ASSERT(stub_calls == 21);
+    CPPUNIT_ASSERT(dnsname->size() == 1);
+    Address *addr = Address::cast(FWReference::getObject(dnsname->front()));
+    CPPUNIT_ASSERT(addr->getAddressPtr()->toString() == "192.0.2.5");
+    delete db;
+
+    // expired entries are resolved again
+    DNS::setCacheTTL(0, 0);
+    DNS::getHostByNameCached("host30.test", AF_INET);
+    DNS::getHostByNameCached("host30.test", AF_INET);
+    CPPUNIT_ASSERT(stub_calls == 23);
+
+    // real resolver, localhost comes from the hosts file
+    DNS::setResolver(NULL);
+    DNS::setCacheTTL(300, 60);
+    DNS::clearCache();
+    res = DNS::getHostByNameCached("localhost", AF_INET);
+    CPPUNIT_ASSERT(std::find(res.begin(), res.end(), InetAddr("127.0.0.1")) !=
+                   res.end());
+}
@@ -44,11 +44,13 @@ class DNSTest : public CppUnit::TestCase
                            char* results[]);
 public:
     void runTest();
+    void cacheTest();
 
     static CppUnit::Test *suite()
     {
       CppUnit::TestSuite *suiteOfTests = new CppUnit::TestSuite( "ObjectMatcherTest" );
       suiteOfTests->addTest( new CppUnit::TestCaller<DNSTest>( "runTest", &DNSTest::runTest ) );
+      suiteOfTests->addTest( new CppUnit::TestCaller<DNSTest>( "cacheTest", &DNSTest::cacheTest ) );
       return suiteOfTests;
     }
 };
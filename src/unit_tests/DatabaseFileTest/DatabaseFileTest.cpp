@@ -0,0 +1,429 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  $Id$
+
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#include "DatabaseFileTest.h"
+#include "ObjectTreeFixture.h"
+
+#include "fwbuilder/FWObjectDatabase.h"
+#include "fwbuilder/DatabaseCache.h"
+#include "fwbuilder/DatabaseSaver.h"
+#include "fwbuilder/AddressTableLoader.h"
+#include "fwbuilder/Constants.h"
+#include "fwbuilder/XMLTools.h"
+#include "fwbuilder/Library.h"
+#include "fwbuilder/Firewall.h"
+#include "fwbuilder/Interface.h"
+#include "fwbuilder/Network.h"
+#include "fwbuilder/IPv4.h"
+#include "fwbuilder/AddressRange.h"
+#include "fwbuilder/ObjectGroup.h"
+#include "fwbuilder/DynamicGroup.h"
+#include "fwbuilder/Policy.h"
+#include "fwbuilder/Rule.h"
+#include "fwbuilder/RuleElement.h"
+
+#include "fwbedit.h"
+
+#include <fstream>
+#include <sstream>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+using namespace libfwbuilder;
+using namespace std;
+
+
+static string dumpDocument(xmlDocPtr doc)
+{
+    xmlChar *buf = NULL;
+    int size = 0;
+    xmlDocDumpMemory(doc, &buf, &size);
+    string res((const char*)(buf), size);
+    xmlFree(buf);
+    return res;
+}
+
+void DatabaseFileTest::databaseCacheTest()
+{
+    const char *xml =
+        "<?xml version=\"1.0\"?>\n"
+        "<FWObjectDatabase version=\"" FWBUILDER_XML_VERSION "\" id=\"root\">\n"
+        "  <Library id=\"lib1\" name=\"a &amp; b\">\n"
+        "    <Network id=\"net1\" name=\"n\" address=\"10.0.0.0\"/>\n"
+        "    <CustomServiceCommand platform=\"ipt\">-m &lt;x&gt;</CustomServiceCommand>\n"
+        "    <ObjectGroup id=\"grp1\" name=\"g\">\n"
+        "      <ObjectRef ref=\"net1\"/>\n"
+        "    </ObjectGroup>\n"
+        "  </Library>\n"
+        "  <Library id=\"lib2\" name=\"empty\"/>\n"
+        "</FWObjectDatabase>\n";
+
+    TemporaryDirectory tmp;
+    string data_file = tmp.file("database_cache_test.fwb");
+    string cache_dir = tmp.getPath();
+    ofstream(data_file.c_str()) << xml;
+
+    xmlDocPtr doc = xmlParseMemory(xml, strlen(xml));
+    CPPUNIT_ASSERT(doc != NULL);
+
+    // disabled by default
+    CPPUNIT_ASSERT(DatabaseCache::load(data_file) == NULL);
+    CPPUNIT_ASSERT(!DatabaseCache::save(data_file, doc));
+
+    DatabaseCache::setCacheDirectory(cache_dir);
+    CPPUNIT_ASSERT(DatabaseCache::load(data_file) == NULL);
+    CPPUNIT_ASSERT(DatabaseCache::save(data_file, doc));
+
+    xmlDocPtr cached = DatabaseCache::load(data_file);
+    CPPUNIT_ASSERT(cached != NULL);
+
+    // white space between elements is not kept, the rest is the same
+    int keep_blanks = xmlKeepBlanksDefault(0);
+    xmlDocPtr expected = xmlParseMemory(xml, strlen(xml));
+    xmlKeepBlanksDefault(keep_blanks);
+    CPPUNIT_ASSERT(dumpDocument(cached) == dumpDocument(expected));
+    xmlFreeDoc(expected);
+    xmlFreeDoc(cached);
+
+    // entry is found by the contents of the file
+    string cache_file;
+    {
+        string contents = readFile(data_file);
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%016llx",
+                 (unsigned long long)(AddressTableLoader::hash(
+                                          contents.data(), contents.size())));
+        cache_file = cache_dir + "/" + buf + ".fwbc";
+    }
+
+    ofstream(data_file.c_str(), ios::app) << "<!-- changed -->\n";
+    CPPUNIT_ASSERT(DatabaseCache::load(data_file) == NULL);
+    ofstream(data_file.c_str()) << xml;
+    cached = DatabaseCache::load(data_file);
+    CPPUNIT_ASSERT(cached != NULL);
+    xmlFreeDoc(cached);
+
+    // damaged entry is ignored
+    {
+        fstream f(cache_file.c_str(), ios::in | ios::out | ios::binary);
+        f.seekp(-3, ios::end);
+        f.write("\xff\xff\xff", 3);
+    }
+    CPPUNIT_ASSERT(DatabaseCache::load(data_file) == NULL);
+    truncate(cache_file.c_str(), 100);
+    CPPUNIT_ASSERT(DatabaseCache::load(data_file) == NULL);
+
+    xmlFreeDoc(doc);
+    DatabaseCache::setCacheDirectory("");
+}
+
+void DatabaseFileTest::partialLoadTest()
+{
+    ObjectTreeFixture tree;
+    FWObjectDatabase *db = tree.db;
+
+    FWObject *net1 = tree.add(Network::TYPENAME);
+    FWObject *net2 = tree.add(Network::TYPENAME);
+    FWObject *net3 = tree.add(Network::TYPENAME);
+    FWObject *grp = tree.add(ObjectGroup::TYPENAME);
+    grp->addRef(net3);
+
+    Firewall *fw[5];
+    for (int i=0; i<5; ++i)
+        fw[i] = tree.addFirewall(string("fw") + char('1' + i));
+    FWObject *intf = tree.add(Interface::TYPENAME, "", fw[1]);
+
+    // fw1 uses net1 and net3 (through the group), interface of fw2
+    // and a rule set of fw4
+    PolicyRule *rule = ObjectTreeFixture::addRule(fw[0]);
+    rule->getSrc()->addRef(net1);
+    rule->getDst()->addRef(grp);
+    rule->getItf()->addRef(intf);
+    RuleSet *branch = RuleSet::cast(tree.add(Policy::TYPENAME, "", fw[3]));
+    rule = ObjectTreeFixture::addRule(fw[0]);
+    rule->setAction(PolicyRule::Branch);
+    rule->setBranch(branch);
+
+    // fw5 uses dynamic group
+    FWObject *dyn = tree.add(DynamicGroup::TYPENAME);
+    ObjectTreeFixture::addRule(fw[4])->getSrc()->addRef(dyn);
+
+    TemporaryDirectory tmp;
+    string data_file = tmp.file("partial_load_test.fwb");
+    db->saveFile(data_file);
+
+    XMLTools::UpgradePredicate upgrade;
+    FWObjectDatabase *pdb = new FWObjectDatabase();
+    pdb->setPartialLoadTarget("fw1");
+    pdb->load(data_file, &upgrade, Constants::getDTDDirectory());
+    CPPUNIT_ASSERT(pdb->isPartiallyLoaded());
+    CPPUNIT_ASSERT(pdb->findInIndex(tree.lib->getId()) != NULL);
+    CPPUNIT_ASSERT(pdb->findInIndex(fw[0]->getId()) != NULL);
+    CPPUNIT_ASSERT(pdb->findInIndex(net1->getId()) != NULL);
+    CPPUNIT_ASSERT(pdb->findInIndex(net2->getId()) == NULL);
+    CPPUNIT_ASSERT(pdb->findInIndex(net3->getId()) != NULL);
+    CPPUNIT_ASSERT(pdb->findInIndex(grp->getId()) != NULL);
+    // firewall is kept as a whole when one of its interfaces is used
+    CPPUNIT_ASSERT(pdb->findInIndex(fw[1]->getId()) != NULL);
+    CPPUNIT_ASSERT(pdb->findInIndex(intf->getId()) != NULL);
+    CPPUNIT_ASSERT(pdb->findInIndex(fw[2]->getId()) == NULL);
+    CPPUNIT_ASSERT(pdb->findInIndex(fw[3]->getId()) != NULL);
+    CPPUNIT_ASSERT(pdb->findInIndex(branch->getId()) != NULL);
+    CPPUNIT_ASSERT(pdb->findInIndex(fw[4]->getId()) == NULL);
+    CPPUNIT_ASSERT(pdb->findInIndex(dyn->getId()) == NULL);
+
+    // target can be given by id of the firewall or one of its rules
+    pdb->setPartialLoadTarget(FWObjectDatabase::getStringId(rule->getId()));
+    pdb->load(data_file, &upgrade, Constants::getDTDDirectory());
+    CPPUNIT_ASSERT(pdb->isPartiallyLoaded());
+    CPPUNIT_ASSERT(pdb->findInIndex(fw[0]->getId()) != NULL);
+    CPPUNIT_ASSERT(pdb->findInIndex(fw[2]->getId()) == NULL);
+
+    CPPUNIT_ASSERT_THROW(pdb->saveFile(data_file), FWException);
+
+    // dynamic group can use any object, the whole file is loaded
+    pdb->setPartialLoadTarget("fw5");
+    pdb->load(data_file, &upgrade, Constants::getDTDDirectory());
+    CPPUNIT_ASSERT(!pdb->isPartiallyLoaded());
+    CPPUNIT_ASSERT(pdb->findInIndex(fw[2]->getId()) != NULL);
+
+    pdb->setPartialLoadTarget("no such firewall");
+    pdb->load(data_file, &upgrade, Constants::getDTDDirectory());
+    CPPUNIT_ASSERT(!pdb->isPartiallyLoaded());
+    CPPUNIT_ASSERT(pdb->findInIndex(net2->getId()) != NULL);
+
+    delete pdb;
+}
+
+void DatabaseFileTest::databaseSaverTest()
+{
+    ObjectTreeFixture tree;
+    FWObjectDatabase *db = tree.db;
+    FWObject *folder = tree.add(ObjectGroup::TYPENAME, "Objects");
+
+    FWObject *net1 = tree.add(Network::TYPENAME, "net1", folder);
+    FWObject *net2 = tree.add(Network::TYPENAME, "", folder);
+    net2->setComment("\xc3\xa9t\xc3\xa9 <a> & b");
+    FWObject *grp = tree.add(ObjectGroup::TYPENAME, "", folder);
+    grp->addRef(net1);
+    Firewall *fw = tree.addFirewall("");
+    ObjectTreeFixture::addRule(fw)->getSrc()->addRef(grp);
+
+    TemporaryDirectory tmp;
+    string expected_file = tmp.file("database_saver_test_1.fwb");
+    string data_file = tmp.file("database_saver_test_2.fwb");
+
+    DatabaseSaver saver(db);
+    saver.save(data_file);
+    db->saveFile(expected_file);
+    CPPUNIT_ASSERT(readFile(data_file) == readFile(expected_file));
+    CPPUNIT_ASSERT(saver.getWrittenCount() == 4);
+    CPPUNIT_ASSERT(saver.getReusedCount() == 0);
+    CPPUNIT_ASSERT(!db->isDirty());
+
+    // saveFile() above modified management object of the firewall
+    saver.save(data_file);
+    CPPUNIT_ASSERT(readFile(data_file) == readFile(expected_file));
+    CPPUNIT_ASSERT(saver.getWrittenCount() == 1);
+    CPPUNIT_ASSERT(saver.getReusedCount() == 3);
+
+    // change deep in the subtree of a unit, new and deleted objects
+    fw->getFirstByType(Policy::TYPENAME)->front()->setBool("disabled", true);
+    FWObject *net3 = tree.add(Network::TYPENAME, "", folder);
+    folder->remove(net2);
+    saver.save(data_file);
+    CPPUNIT_ASSERT(saver.getWrittenCount() == 2);
+    CPPUNIT_ASSERT(saver.getReusedCount() == 2);
+    db->saveFile(expected_file);
+    CPPUNIT_ASSERT(readFile(data_file) == readFile(expected_file));
+
+    // deleted object is replaced with another one with the same id
+    int net1_id = net1->getId();
+    grp->removeRef(net1);
+    folder->remove(net1);
+    FWObject *net4 = db->create(Network::TYPENAME);
+    net4->setId(net1_id);
+    net4->setName("net4");
+    folder->add(net4);
+    grp->addRef(net4);
+
+    saver.start(data_file);
+    CPPUNIT_ASSERT(!db->isDirty());
+    net3->setName("changed while saving");
+    saver.wait();
+    CPPUNIT_ASSERT(!saver.isRunning());
+    CPPUNIT_ASSERT(db->isDirty());
+    string saved = readFile(data_file);
+    CPPUNIT_ASSERT(saved.find("net4") != string::npos);
+    CPPUNIT_ASSERT(saved.find("changed while saving") == string::npos);
+
+    saver.save(data_file);
+    db->saveFile(expected_file);
+    CPPUNIT_ASSERT(readFile(data_file) == readFile(expected_file));
+
+    // failed background save sets "dirty" flag again
+    {
+        QuietXmlErrors quiet;
+        saver.start(tmp.file("no_such_dir/database_saver_test.fwb"));
+        CPPUNIT_ASSERT_THROW(saver.wait(), FWException);
+    }
+    CPPUNIT_ASSERT(db->isDirty());
+}
+
+/*
+ * Address setters do not go through setStr(), the saver must still
+ * see the change and write the object again.
+ */
+void DatabaseFileTest::addressChangeSaveTest()
+{
+    ObjectTreeFixture tree;
+    FWObjectDatabase *db = tree.db;
+    FWObject *folder = tree.add(ObjectGroup::TYPENAME, "Objects");
+
+    Network *net = Network::cast(tree.add(Network::TYPENAME, "net", folder));
+    net->setAddress(InetAddr("10.1.0.0"));
+    net->setNetmask(InetAddr("255.255.0.0"));
+    IPv4 *host = IPv4::cast(tree.add(IPv4::TYPENAME, "host", folder));
+    host->setAddress(InetAddr("10.1.1.1"));
+    AddressRange *range = AddressRange::cast(
+        tree.add(AddressRange::TYPENAME, "range", folder));
+    range->setRangeStart(InetAddr("10.2.0.1"));
+    range->setRangeEnd(InetAddr("10.2.0.9"));
+
+    TemporaryDirectory tmp;
+    string expected_file = tmp.file("address_change_test_1.fwb");
+    string data_file = tmp.file("address_change_test_2.fwb");
+
+    DatabaseSaver saver(db);
+    saver.save(data_file);
+
+    net->setAddress(InetAddr("192.168.0.0"));
+    host->setAddressNetmask("10.3.3.3/255.255.255.0");
+    range->setRangeEnd(InetAddr("10.2.0.99"));
+
+    saver.save(data_file);
+    CPPUNIT_ASSERT(saver.getWrittenCount() == 3);
+    db->saveFile(expected_file);
+    string saved = readFile(data_file);
+    CPPUNIT_ASSERT(saved == readFile(expected_file));
+    CPPUNIT_ASSERT(saved.find("192.168.0.0") != string::npos);
+    CPPUNIT_ASSERT(saved.find("10.3.3.3") != string::npos);
+    CPPUNIT_ASSERT(saved.find("10.2.0.99") != string::npos);
+}
+
+/*
+ * Writes a copy of the data file saved with the previous version of
+ * the data format, it takes one migration stylesheet to upgrade it
+ */
+static void writeOldVersion(const string &contents, const string &file_name)
+{
+    string current = "version=\"" + Constants::getDataFormatVersion() + "\"";
+    char old_version[32];
+    snprintf(old_version, sizeof(old_version), "version=\"%d\"",
+             atoi(Constants::getDataFormatVersion().c_str()) - 1);
+    string res = contents;
+    string::size_type pos = res.find(current);
+    CPPUNIT_ASSERT(pos != string::npos);
+    res.replace(pos, current.length(), old_version);
+    ofstream(file_name.c_str(), ios::binary) << res;
+}
+
+void DatabaseFileTest::upgradeTest()
+{
+    ObjectTreeFixture tree;
+    tree.add(Network::TYPENAME, "net");
+    tree.addFirewall("fw1");
+
+    TemporaryDirectory tmp;
+    string saved_file = tmp.file("upgrade_test.fwb");
+    tree.db->saveFile(saved_file);
+    string saved = readFile(saved_file);
+
+    XMLTools::UpgradePredicate upgrade;
+
+    // every migration stylesheet is compiled once
+    int cached = XMLTools::getCachedStylesheetCount();
+    for (int i=0; i<2; ++i)
+    {
+        string data_file = tmp.file(string("upgrade_test_") + char('a' + i) +
+                                    ".fwb");
+        writeOldVersion(saved, data_file);
+        FWObjectDatabase *db = new FWObjectDatabase();
+        db->load(data_file, &upgrade, Constants::getDTDDirectory());
+        CPPUNIT_ASSERT(db->findFirewallByName("fw1") != NULL);
+        delete db;
+        if (i == 0) cached = max(cached, 1);
+        CPPUNIT_ASSERT(XMLTools::getCachedStylesheetCount() == cached);
+        CPPUNIT_ASSERT(access((data_file + ".bak").c_str(), R_OK) == 0);
+        // converted file is the same as the one saved by saveFile()
+        CPPUNIT_ASSERT(readFile(data_file) == saved);
+    }
+
+    // converted file is compressed if compression is on
+    string gz_file = tmp.file("upgrade_test_gz.fwb");
+    writeOldVersion(saved, gz_file);
+    int compress_mode = xmlGetCompressMode();
+    xmlSetCompressMode(9);
+    FWObjectDatabase *db = new FWObjectDatabase();
+    try
+    {
+        db->load(gz_file, &upgrade, Constants::getDTDDirectory());
+    } catch (FWException &ex)
+    {
+        xmlSetCompressMode(compress_mode);
+        delete db;
+        throw;
+    }
+    xmlSetCompressMode(compress_mode);
+    delete db;
+    string gz = readFile(gz_file);
+    CPPUNIT_ASSERT(gz.size() > 2 && gz[0] == '\x1f' && gz[1] == '\x8b');
+    db = new FWObjectDatabase();
+    db->load(gz_file, &upgrade, Constants::getDTDDirectory());
+    CPPUNIT_ASSERT(db->findFirewallByName("fw1") != NULL);
+    delete db;
+
+    // "fwbedit upgrade -j 2": files are split between two worker
+    // processes, a file that can not be loaded fails alone
+    vector<string> files;
+    for (int i=0; i<3; ++i)
+    {
+        files.push_back(tmp.file(string("upgrade_test_j") + char('a' + i) +
+                                 ".fwb"));
+        writeOldVersion(saved, files.back());
+    }
+    CPPUNIT_ASSERT(upgradeFiles(files, 2) == 0);
+    for (int i=0; i<3; ++i)
+        CPPUNIT_ASSERT(readFile(files[i]) == saved);
+
+    files.push_back(tmp.file("upgrade_test_broken.fwb"));
+    ofstream(files.back().c_str()) << "<FWObjectDatabase";
+    writeOldVersion(saved, files[0]);
+    CPPUNIT_ASSERT(upgradeFiles(files, 2) == 1);
+    CPPUNIT_ASSERT(readFile(files[0]) == saved);
+}
@@ -0,0 +1,66 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  $Id$
+
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#ifndef DATABASEFILETEST_H
+#define DATABASEFILETEST_H
+
+
+#include <cppunit/TestCase.h>
+#include <cppunit/TestSuite.h>
+#include <cppunit/TestCaller.h>
+
+class DatabaseFileTest : public CppUnit::TestCase
+{
+public:
+    void databaseCacheTest();
+    void partialLoadTest();
+    void databaseSaverTest();
+    void addressChangeSaveTest();
+    void upgradeTest();
+
+    static CppUnit::Test *suite()
+    {
+      CppUnit::TestSuite *suiteOfTests = new CppUnit::TestSuite( "DatabaseFileTest" );
+      suiteOfTests->addTest( new CppUnit::TestCaller<DatabaseFileTest>(
+                                   "databaseCacheTest",
+                                   &DatabaseFileTest::databaseCacheTest ) );
+      suiteOfTests->addTest( new CppUnit::TestCaller<DatabaseFileTest>(
+                                   "partialLoadTest",
+                                   &DatabaseFileTest::partialLoadTest ) );
+      suiteOfTests->addTest( new CppUnit::TestCaller<DatabaseFileTest>(
+                                   "databaseSaverTest",
+                                   &DatabaseFileTest::databaseSaverTest ) );
+      suiteOfTests->addTest( new CppUnit::TestCaller<DatabaseFileTest>(
+                                   "addressChangeSaveTest",
+                                   &DatabaseFileTest::addressChangeSaveTest ) );
+      suiteOfTests->addTest( new CppUnit::TestCaller<DatabaseFileTest>(
+                                   "upgradeTest",
+                                   &DatabaseFileTest::upgradeTest ) );
+      return suiteOfTests;
+    }
+};
+
+#endif // DATABASEFILETEST_H
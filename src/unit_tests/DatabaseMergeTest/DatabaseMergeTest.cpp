@@ -0,0 +1,118 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  $Id$
+
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#include "DatabaseMergeTest.h"
+#include "ObjectTreeFixture.h"
+
+#include "fwbuilder/FWObjectDatabase.h"
+#include "fwbuilder/FWReference.h"
+#include "fwbuilder/Library.h"
+#include "fwbuilder/Interface.h"
+#include "fwbuilder/IPv4.h"
+#include "fwbuilder/ObjectGroup.h"
+
+#include <list>
+#include <map>
+#include <sstream>
+#include <vector>
+
+using namespace libfwbuilder;
+using namespace std;
+
+
+class RecordingConflictResolution :
+    public FWObjectDatabase::ConflictResolutionPredicate
+{
+public:
+    list<int> asked;
+    virtual bool askUser(FWObject *o1, FWObject*)
+    {
+        asked.push_back(o1->getId());
+        return true;
+    }
+};
+
+void DatabaseMergeTest::mergeTest()
+{
+    ObjectTreeFixture tree;
+    FWObjectDatabase *db = tree.db;
+    FWObject *folder = tree.add(ObjectGroup::TYPENAME, "Addresses");
+    FWObject *grp = tree.add(ObjectGroup::TYPENAME, "grp");
+
+    vector<FWObject*> addrs;
+    for (int i=0; i<200; ++i)
+    {
+        ostringstream str;
+        str << "h" << i;
+        FWObject *a = tree.add(IPv4::TYPENAME, str.str(), folder);
+        grp->addRef(a);
+        addrs.push_back(a);
+    }
+
+    FWObjectDatabase *ndb = new FWObjectDatabase(*db);
+
+    // order of children does not matter, group must not be reported
+    FWObject *ngrp = ndb->findInIndex(grp->getId());
+    FWObject *first_ref = ngrp->front();
+    ngrp->remove(first_ref, false);
+    ngrp->add(first_ref);
+    CPPUNIT_ASSERT(grp->cmp(ngrp, true));
+
+    ndb->findInIndex(addrs[150]->getId())->setComment("changed");
+    FWObject *new_addr = ndb->create(IPv4::TYPENAME);
+    new_addr->setName("new");
+    ndb->findInIndex(folder->getId())->add(new_addr);
+    int new_addr_id = new_addr->getId();
+
+    RecordingConflictResolution crp;
+    db->merge(ndb, &crp);
+    delete ndb;
+
+    CPPUNIT_ASSERT(crp.asked.size() == 1);
+    CPPUNIT_ASSERT(crp.asked.front() == addrs[150]->getId());
+    CPPUNIT_ASSERT(addrs[150]->getComment() == "changed");
+    CPPUNIT_ASSERT(db->findInIndex(new_addr_id) != NULL);
+    CPPUNIT_ASSERT(db->findInIndex(new_addr_id)->getParent() == folder);
+
+    // all references are replaced in one pass
+    map<int, int> id_map;
+    for (int i=0; i<200; i+=2)
+        id_map[addrs[i]->getId()] = FWObjectDatabase::generateUniqueId();
+    FWObject *iface = tree.add(Interface::TYPENAME);
+    iface->setStr("network_zone",
+                  FWObjectDatabase::getStringId(addrs[0]->getId()));
+
+    CPPUNIT_ASSERT(db->fixReferences(tree.lib, id_map) == 101);
+    int n = 0;
+    for (FWObject::iterator i=grp->begin(); i!=grp->end(); ++i)
+    {
+        int id = FWReference::cast(*i)->getPointerId();
+        if (id_map.count(id) > 0) n++;
+    }
+    CPPUNIT_ASSERT(n == 0);
+    CPPUNIT_ASSERT(FWObjectDatabase::getIntId(iface->getStr("network_zone")) ==
+                   id_map[addrs[0]->getId()]);
+}
@@ -0,0 +1,50 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  $Id$
+
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#ifndef DATABASEMERGETEST_H
+#define DATABASEMERGETEST_H
+
+
+#include <cppunit/TestCase.h>
+#include <cppunit/TestSuite.h>
+#include <cppunit/TestCaller.h>
+
+class DatabaseMergeTest : public CppUnit::TestCase
+{
+public:
+    void mergeTest();
+
+    static CppUnit::Test *suite()
+    {
+      CppUnit::TestSuite *suiteOfTests = new CppUnit::TestSuite( "DatabaseMergeTest" );
+      suiteOfTests->addTest( new CppUnit::TestCaller<DatabaseMergeTest>(
+                                   "mergeTest",
+                                   &DatabaseMergeTest::mergeTest ) );
+      return suiteOfTests;
+    }
+};
+
+#endif // DATABASEMERGETEST_H
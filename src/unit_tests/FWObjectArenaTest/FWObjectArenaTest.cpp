@@ -0,0 +1,144 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  $Id$
+
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#include "FWObjectArenaTest.h"
+#include "ObjectTreeFixture.h"
+
+#include "fwbuilder/FWObjectDatabase.h"
+#include "fwbuilder/FWObjectArena.h"
+#include "fwbuilder/MemoryStats.h"
+#include "fwbuilder/Library.h"
+#include "fwbuilder/Firewall.h"
+#include "fwbuilder/Network.h"
+#include "fwbuilder/IPv4.h"
+#include "fwbuilder/ObjectGroup.h"
+
+#include <sstream>
+#include <vector>
+
+using namespace libfwbuilder;
+using namespace std;
+
+
+void FWObjectArenaTest::arenaTest()
+{
+    ObjectTreeFixture tree(true);
+    FWObjectDatabase *db = tree.db;
+    FWObjectArena *arena = db->getArena();
+    CPPUNIT_ASSERT(arena != NULL);
+
+    for (int i=0; i<100; ++i) tree.addFirewall("fw");
+    long live = arena->getLiveBlocks();
+    CPPUNIT_ASSERT(live > 100);
+
+    // blocks freed by delete are reused
+    FWObject *o = db->create(Network::TYPENAME);
+    delete o;
+    o = db->create(Network::TYPENAME);
+    CPPUNIT_ASSERT(arena->getLiveBlocks() == live + 1);
+    delete o;
+
+    // blocks have no header, blocks of one size follow each other
+    FWObject *net1 = db->create(Network::TYPENAME);
+    FWObject *net2 = db->create(Network::TYPENAME);
+    size_t size = FWObjectArena::getAllocatedSize(dynamic_cast<void*>(net1));
+    CPPUNIT_ASSERT(size >= sizeof(Network));
+    CPPUNIT_ASSERT(size < sizeof(Network) + FWObjectArena::GRANULARITY);
+    CPPUNIT_ASSERT((char*)dynamic_cast<void*>(net2) -
+                   (char*)dynamic_cast<void*>(net1) == ptrdiff_t(size));
+    delete net1;
+    delete net2;
+    CPPUNIT_ASSERT(arena->getLiveBlocks() == live);
+
+    // objects created without an arena come from the heap and can be
+    // added to the tree and deleted with it
+    FWObject *heap_net = new Network();
+    CPPUNIT_ASSERT(FWObjectArena::getAllocatedSize(
+                       dynamic_cast<void*>(heap_net)) == 0);
+    tree.lib->add(heap_net);
+    CPPUNIT_ASSERT(arena->getLiveBlocks() == live);
+
+    // copy of the database gets its own arena, which has the copy of
+    // the heap object too
+    FWObjectDatabase *db2 = new FWObjectDatabase(*db);
+    CPPUNIT_ASSERT(db2->getArena() != NULL);
+    CPPUNIT_ASSERT(db2->getArena() != arena);
+    CPPUNIT_ASSERT(db2->getArena()->getLiveBlocks() == live + 1);
+
+    // object created in one database can outlive it
+    FWObject *net = db2->create(Network::TYPENAME);
+    delete db2;
+    net->setName("net");
+    delete net;
+}
+
+void FWObjectArenaTest::memoryStatsTest()
+{
+    FWObjectArena::startProfiling(1);
+
+    ObjectTreeFixture tree;
+    FWObjectDatabase *db = tree.db;
+    FWObject *grp = tree.add(ObjectGroup::TYPENAME);
+    vector<FWObject*> addrs;
+    for (int i=0; i<3; ++i)
+    {
+        FWObject *a = tree.add(IPv4::TYPENAME, "addr");
+        a->setStr("key", "value");
+        addrs.push_back(a);
+    }
+    grp->addRef(addrs[0]);
+    grp->addRef(addrs[1]);
+
+    FWObjectArena::stopProfiling();
+
+    // database, library, group, three addresses and two references
+    AllocationProfile profile;
+    FWObjectArena::getProfile(profile);
+    CPPUNIT_ASSERT(profile.allocations == 8);
+    CPPUNIT_ASSERT(profile.deallocations == 0);
+    CPPUNIT_ASSERT(profile.live_bytes == long(profile.allocated_bytes));
+    CPPUNIT_ASSERT(profile.samples.size() > 0);
+
+    // database without an arena allocates objects from the heap
+    CPPUNIT_ASSERT(
+        FWObjectArena::getAllocatedSize(dynamic_cast<void*>(addrs[0])) == 0);
+
+    MemoryStats stats;
+    db->getMemoryStats(stats);
+    CPPUNIT_ASSERT(stats.objects == 8);
+    CPPUNIT_ASSERT(stats.types["IPv4"].objects == 3);
+    CPPUNIT_ASSERT(stats.types["IPv4"].object_bytes == 3 * sizeof(IPv4));
+    CPPUNIT_ASSERT(stats.types["ObjectRef"].objects == 2);
+    CPPUNIT_ASSERT(stats.attributes["key"].count == 3);
+    CPPUNIT_ASSERT(stats.references == 2);
+    CPPUNIT_ASSERT(stats.referenced_objects == 2);
+    CPPUNIT_ASSERT(stats.object_index_bytes > 0);
+    CPPUNIT_ASSERT(stats.getTotalBytes() > stats.string_bytes);
+
+    ostringstream str;
+    stats.print(str);
+    CPPUNIT_ASSERT(str.str().find("IPv4") != string::npos);
+}
@@ -0,0 +1,53 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  $Id$
+
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+
+#include <cppunit/ui/text/TestRunner.h>
+#include <cppunit/CompilerOutputter.h>
+#include "FWObjectArenaTest.h"
+#include "fwbuilder/FWObjectDatabase.h"
+
+#include <string>
+
+using namespace libfwbuilder;
+
+int fwbdebug = 0;
+//QString user_name;
+std::string platform;
+
+int main( int, char** argv)
+{
+    //init(argv);
+    init();
+
+    CppUnit::TextUi::TestRunner runner;
+    runner.addTest( FWObjectArenaTest::suite() );
+    runner.setOutputter( new CppUnit::CompilerOutputter( &runner.result(),
+                                                         std::cerr ) );
+
+    runner.run();
+    return 0;
+}
@@ -0,0 +1,136 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  $Id$
+
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#include "FWObjectSnapshotTest.h"
+#include "ObjectTreeFixture.h"
+
+#include "fwbuilder/FWObjectDatabase.h"
+#include "fwbuilder/FWObjectSnapshot.h"
+#include "fwbuilder/Library.h"
+#include "fwbuilder/Host.h"
+#include "fwbuilder/Interface.h"
+#include "fwbuilder/ObjectGroup.h"
+#include "fwbuilder/Network.h"
+#include "fwbuilder/IPv4.h"
+#include "fwbuilder/AddressRange.h"
+#include "fwbuilder/InetAddr.h"
+
+using namespace libfwbuilder;
+using namespace std;
+
+
+void FWObjectSnapshotTest::snapshotTest()
+{
+    ObjectTreeFixture tree;
+    FWObjectDatabase *db = tree.db;
+    FWObject *folder = tree.add(ObjectGroup::TYPENAME, "Hosts");
+    FWObject *h1 = tree.add(Host::TYPENAME, "h1", folder);
+    FWObject *eth0 = tree.add(Interface::TYPENAME, "eth0", h1);
+    FWObject *h2 = tree.add(Host::TYPENAME, "h2", folder);
+    int h1_id = h1->getId();
+    int h2_id = h2->getId();
+    int eth0_id = eth0->getId();
+
+    FWObjectSnapshot *snap = new FWObjectSnapshot(db);
+    CPPUNIT_ASSERT(snap->isValid());
+    CPPUNIT_ASSERT(snap->getSavedCount() == 0);
+
+    h2->setName("renamed");
+    h2->setComment("new comment");
+    eth0->setName("eth1");
+    folder->remove(h1, true);
+    FWObject *h3 = tree.add(Host::TYPENAME, "h3", folder);
+
+    FWObjectDatabase *old = snap->materialize();
+    CPPUNIT_ASSERT(old != NULL);
+    CPPUNIT_ASSERT(old->findInIndex(h3->getId()) == NULL);
+    FWObject *old_h1 = old->findInIndex(h1_id);
+    CPPUNIT_ASSERT(old_h1 != NULL);
+    CPPUNIT_ASSERT(old_h1->getName() == "h1");
+    FWObject *old_eth0 = old->findInIndex(eth0_id);
+    CPPUNIT_ASSERT(old_eth0 != NULL);
+    CPPUNIT_ASSERT(old_eth0->getName() == "eth0");
+    CPPUNIT_ASSERT(old_eth0->getParent() == old_h1);
+    FWObject *old_h2 = old->findInIndex(h2_id);
+    CPPUNIT_ASSERT(old_h2 != NULL);
+    CPPUNIT_ASSERT(old_h2->getName() == "h2");
+    CPPUNIT_ASSERT(old_h2->getComment() == "");
+    CPPUNIT_ASSERT(old_h2->getParent()->size() == 2);
+    delete old;
+
+    // the live tree is not affected
+    CPPUNIT_ASSERT(db->findInIndex(h2_id)->getName() == "renamed");
+    CPPUNIT_ASSERT(db->findInIndex(h1_id) == NULL);
+
+    delete tree.release();
+    CPPUNIT_ASSERT(!snap->isValid());
+    CPPUNIT_ASSERT(snap->materialize() == NULL);
+    delete snap;
+}
+
+/*
+ * address of Address objects is not an attribute, setters must save
+ * the object before they change it
+ */
+void FWObjectSnapshotTest::addressChangeTest()
+{
+    ObjectTreeFixture tree;
+    Network *net = Network::cast(tree.add(Network::TYPENAME, "net"));
+    net->setAddressNetmask("10.0.0.0/8");
+    IPv4 *addr = IPv4::cast(tree.add(IPv4::TYPENAME, "addr"));
+    addr->setAddress(InetAddr("10.0.0.1"));
+    AddressRange *range =
+        AddressRange::cast(tree.add(AddressRange::TYPENAME, "range"));
+    range->setRangeStart(InetAddr("10.0.0.1"));
+    range->setRangeEnd(InetAddr("10.0.0.10"));
+    Interface *intf = Interface::cast(tree.add(Interface::TYPENAME, "eth0"));
+    intf->setOStatus(true);
+
+    FWObjectSnapshot snap(tree.db);
+
+    net->setAddress(InetAddr("192.168.0.0"));
+    net->setNetmask(InetAddr("255.255.0.0"));
+    addr->setAddressNetmask("192.168.0.1/32");
+    range->setRangeEnd(InetAddr("10.0.0.20"));
+    intf->setOStatus(false);
+    CPPUNIT_ASSERT(snap.getSavedCount() == 4);
+
+    FWObjectDatabase *old = snap.materialize();
+    CPPUNIT_ASSERT(old != NULL);
+    Network *old_net = Network::cast(old->findInIndex(net->getId()));
+    CPPUNIT_ASSERT(old_net->getAddressPtr()->toString() == "10.0.0.0");
+    CPPUNIT_ASSERT(old_net->getNetmaskPtr()->toString() == "255.0.0.0");
+    IPv4 *old_addr = IPv4::cast(old->findInIndex(addr->getId()));
+    CPPUNIT_ASSERT(old_addr->getAddressPtr()->toString() == "10.0.0.1");
+    AddressRange *old_range =
+        AddressRange::cast(old->findInIndex(range->getId()));
+    CPPUNIT_ASSERT(old_range->getRangeEnd().toString() == "10.0.0.10");
+    Interface *old_intf = Interface::cast(old->findInIndex(intf->getId()));
+    CPPUNIT_ASSERT(old_intf->isUp());
+    delete old;
+
+    CPPUNIT_ASSERT(net->getAddressPtr()->toString() == "192.168.0.0");
+}
@@ -24,6 +24,7 @@
 */
 
 #include "FWObjectTest.h"
+#include "ObjectTreeFixture.h"
 
 #include "fwbuilder/FWObjectDatabase.h"
 #include "fwbuilder/XMLTools.h"
@@ -39,6 +40,15 @@
 #include "fwbuilder/Host.h"
 #include "fwbuilder/Firewall.h"
 #include "fwbuilder/Group.h"
+#include "fwbuilder/ObjectGroup.h"
+#include "fwbuilder/RuleElement.h"
+#include "fwbuilder/Library.h"
+#include "fwbuilder/Policy.h"
+#include "fwbuilder/Rule.h"
+
+#include <sstream>
+#include <vector>
+#include <pthread.h>
 
 using namespace libfwbuilder;
 using namespace std;
@@ -59,7 +69,6 @@ void FWObjectTest::cmpTest()
     obj1->remStr("key");
     CPPUNIT_ASSERT(obj2->cmp(obj1) == true);
 
-
     FWObject *ch1 = db.create(Interface::TYPENAME);
     FWObject *ch2 = db.create(Interface::TYPENAME);
     FWObject *ch3 = db.create(Interface::TYPENAME);
@@ -86,3 +95,318 @@ void FWObjectTest::cmpTest()
 
     CPPUNIT_ASSERT(obj1->cmp(obj2, true) == true);
 }
+
+void FWObjectTest::attributesTest()
+{
+    FWObjectDatabase db;
+    FWObject *obj = db.create(Firewall::TYPENAME);
+
+    CPPUNIT_ASSERT(obj->exists("key") == false);
+    CPPUNIT_ASSERT(obj->getStr("key") == "");
+    CPPUNIT_ASSERT(obj->getInt("key") == -1);
+    CPPUNIT_ASSERT(obj->getBool("key") == false);
+
+    obj->setStr("key", " 1 2\n");
+    CPPUNIT_ASSERT(obj->getStr("key") == " 1 2\n");
+    CPPUNIT_ASSERT(obj->getInt("key") == 12);
+    CPPUNIT_ASSERT(obj->getBool("key") == false);
+
+    obj->setStr("key", " TRUE");
+    CPPUNIT_ASSERT(obj->getBool("key") == true);
+    CPPUNIT_ASSERT(obj->getInt("key") == 0);
+
+    obj->setInt("key", 42);
+    CPPUNIT_ASSERT(obj->getStr("key") == "42");
+    CPPUNIT_ASSERT(obj->getInt("key") == 42);
+
+    obj->setBool("key", true);
+    CPPUNIT_ASSERT(obj->getStr("key") == "True");
+    CPPUNIT_ASSERT(obj->getBool("key") == true);
+
+    // interned key and its name refer to the same attribute
+    AttributeKey key("key");
+    CPPUNIT_ASSERT(obj->getBool(key) == true);
+    obj->setInt(key, 1);
+    CPPUNIT_ASSERT(obj->getStr("key") == "1");
+    CPPUNIT_ASSERT(obj->getBool("key") == true);
+
+    // references returned by getStr() survive insertion of other attributes
+    const string &val = obj->getStr("key");
+    for (int i=0; i<100; ++i)
+    {
+        ostringstream str;
+        str << "attr" << i;
+        obj->setInt(str.str(), i);
+    }
+    CPPUNIT_ASSERT(val == "1");
+    CPPUNIT_ASSERT(obj->getInt("attr50") == 50);
+
+    obj->remStr("key");
+    CPPUNIT_ASSERT(obj->exists(key) == false);
+    CPPUNIT_ASSERT(obj->getInt(key) == -1);
+
+    // internal attributes do not make database dirty
+    db.setDirty(false);
+    obj->setInt(".internal", 1);
+    CPPUNIT_ASSERT(db.isDirty() == false);
+    obj->setInt("external", 1);
+    CPPUNIT_ASSERT(db.isDirty() == true);
+
+    // names registered in bulk are found before and after the
+    // dictionary has been rebuilt
+    for (int k=0; k<2; ++k)
+    {
+        for (int i=0; i<1000; ++i)
+        {
+            ostringstream str;
+            str << ".bulk" << i;
+            int id = AttributeKey::intern(str.str());
+            CPPUNIT_ASSERT(AttributeKey::lookup(str.str()) == id);
+            CPPUNIT_ASSERT(AttributeKey::name(id) == str.str());
+            CPPUNIT_ASSERT(AttributeKey::isInternal(id));
+        }
+    }
+    CPPUNIT_ASSERT(AttributeKey::lookup("never-registered") == -1);
+
+    // removing unknown attribute does not register its name
+    int count = AttributeKey::count();
+    obj->remStr("never-registered");
+    CPPUNIT_ASSERT(AttributeKey::count() == count);
+    CPPUNIT_ASSERT(AttributeKey::lookup("never-registered") == -1);
+}
+
+void FWObjectTest::castTest()
+{
+    FWObjectDatabase db;
+    FWObject *fw = db.create(Firewall::TYPENAME);
+    FWObject *net = db.create(Network::TYPENAME);
+    FWObject *re = db.create(RuleElementSrc::TYPENAME);
+
+    CPPUNIT_ASSERT(Firewall::isA(fw));
+    CPPUNIT_ASSERT(!Host::isA(fw));
+    CPPUNIT_ASSERT(!Firewall::isA(NULL));
+    CPPUNIT_ASSERT(Firewall::typeId() != Host::typeId());
+    CPPUNIT_ASSERT(fw->getTypeId() == Firewall::typeId());
+
+    // repeat to make sure cached results are the same as the first ones
+    for (int i=0; i<2; ++i)
+    {
+        CPPUNIT_ASSERT(Host::cast(fw) == dynamic_cast<Host*>(fw));
+        CPPUNIT_ASSERT(Address::cast(fw) == dynamic_cast<Address*>(fw));
+        CPPUNIT_ASSERT(Address::cast(net) == dynamic_cast<Address*>(net));
+        CPPUNIT_ASSERT(Host::cast(net) == NULL);
+        CPPUNIT_ASSERT(Interface::cast(NULL) == NULL);
+
+        // RuleElementSrc inherits FWObject virtually through two bases
+        CPPUNIT_ASSERT(RuleElement::cast(re) != NULL);
+        CPPUNIT_ASSERT(RuleElement::cast(re) == dynamic_cast<RuleElement*>(re));
+        CPPUNIT_ASSERT(Group::cast(re) == dynamic_cast<Group*>(re));
+        CPPUNIT_ASSERT(ObjectGroup::cast(re) == dynamic_cast<ObjectGroup*>(re));
+        CPPUNIT_ASSERT(RuleElementSrc::constcast(re) ==
+                       dynamic_cast<const RuleElementSrc*>(re));
+        CPPUNIT_ASSERT(RuleElement::cast(net) == NULL);
+    }
+}
+
+void FWObjectTest::visitMarkTest()
+{
+    ObjectTreeFixture tree;
+    FWObject *net = tree.add(Network::TYPENAME);
+
+    {
+        VisitMark mark;
+        CPPUNIT_ASSERT(!mark.isVisited(net));
+        CPPUNIT_ASSERT(mark.visit(net));
+        CPPUNIT_ASSERT(mark.isVisited(net));
+        CPPUNIT_ASSERT(!mark.visit(net));
+
+        // marks of nested traversals are independent, including
+        // ones that do not get a slot
+        VisitMark *nested[FWObject::VISIT_MARK_SLOTS + 1];
+        for (int i=0; i<FWObject::VISIT_MARK_SLOTS + 1; ++i)
+        {
+            nested[i] = new VisitMark();
+            CPPUNIT_ASSERT(!nested[i]->isVisited(net));
+            CPPUNIT_ASSERT(nested[i]->visit(net));
+        }
+        for (int i=0; i<FWObject::VISIT_MARK_SLOTS + 1; ++i)
+            delete nested[i];
+        CPPUNIT_ASSERT(mark.isVisited(net));
+    }
+
+    // new traversal starts with nothing marked
+    VisitMark mark;
+    CPPUNIT_ASSERT(!mark.isVisited(net));
+    CPPUNIT_ASSERT(net->getStr(".searchId").empty());
+
+    // groups that include each other
+    Group *grp1 = Group::cast(tree.add(ObjectGroup::TYPENAME));
+    Group *grp2 = Group::cast(tree.add(ObjectGroup::TYPENAME));
+    grp1->addRef(grp2);
+    grp2->addRef(grp1);
+    grp2->addRef(net);
+    set<FWObject*> res;
+    tree.db->findObjectsInGroup(grp1, res);
+    CPPUNIT_ASSERT(res.size() == 1);
+    CPPUNIT_ASSERT(res.count(net) == 1);
+    res.clear();
+    tree.db->findObjectsInGroup(grp1, res);
+    CPPUNIT_ASSERT(res.size() == 1);
+}
+
+static bool childArrayMatches(FWObject *obj)
+{
+    FWObject* const *array = obj->getChildArray();
+    int n = 0;
+    for (FWObject::iterator i=obj->begin(); i!=obj->end(); ++i, ++n)
+        if (array[n] != *i) return false;
+    return true;
+}
+
+void FWObjectTest::childArrayTest()
+{
+    ObjectTreeFixture tree;
+    FWObject *grp = tree.add(ObjectGroup::TYPENAME);
+
+    vector<FWObject*> nets;
+    for (int i=0; i<20; ++i)
+    {
+        ostringstream str;
+        str << "net" << (i * 7) % 20;
+        nets.push_back(tree.add(Network::TYPENAME, str.str(), grp));
+        CPPUNIT_ASSERT(childArrayMatches(grp));
+    }
+    CPPUNIT_ASSERT(grp->getChild(0) == nets[0]);
+    CPPUNIT_ASSERT(grp->getChild(19) == nets[19]);
+    CPPUNIT_ASSERT(grp->indexOf(nets[19]) == 19);
+
+    grp->remove(nets[5], false);
+    CPPUNIT_ASSERT(childArrayMatches(grp));
+    CPPUNIT_ASSERT(grp->getChild(5) == nets[6]);
+    CPPUNIT_ASSERT(grp->indexOf(nets[6]) == 5);
+    CPPUNIT_ASSERT(grp->indexOf(nets[5]) == -1);
+
+    grp->insert_before(nets[0], nets[5]);
+    CPPUNIT_ASSERT(grp->getChild(0) == nets[5]);
+    CPPUNIT_ASSERT(childArrayMatches(grp));
+    CPPUNIT_ASSERT(grp->indexOf(nets[5]) == 0);
+    CPPUNIT_ASSERT(grp->indexOf(nets[0]) == 1);
+
+    grp->swapObjects(nets[5], nets[19]);
+    CPPUNIT_ASSERT(grp->getChild(0) == nets[19]);
+    CPPUNIT_ASSERT(childArrayMatches(grp));
+
+    grp->sortChildrenByName(false);
+    CPPUNIT_ASSERT(childArrayMatches(grp));
+
+    // objects whose children are never accessed by index have no array
+    CPPUNIT_ASSERT(nets[1]->getStorageBytes() == 0);
+
+    // list methods redefined by FWObjectList
+    FWObject *last = grp->back();
+    grp->pop_back();
+    CPPUNIT_ASSERT(childArrayMatches(grp));
+    grp->push_front(last);
+    CPPUNIT_ASSERT(grp->getChild(0) == last);
+    CPPUNIT_ASSERT(childArrayMatches(grp));
+
+    grp->clearChildren();
+    CPPUNIT_ASSERT(grp->size() == 0);
+    CPPUNIT_ASSERT(childArrayMatches(grp));
+
+    // rules moved by RuleSet::moveRule()
+    Firewall *fw = tree.addFirewall("fw");
+    RuleSet *policy = RuleSet::cast(tree.add(Policy::TYPENAME, "", fw));
+    Rule *r0 = policy->appendRuleAtBottom();
+    policy->appendRuleAtBottom();
+    Rule *r2 = policy->appendRuleAtBottom();
+    CPPUNIT_ASSERT(childArrayMatches(policy));
+    policy->moveRule(2, 0);
+    CPPUNIT_ASSERT(childArrayMatches(policy));
+
+    // the first child is RuleSetOptions
+    CPPUNIT_ASSERT(policy->getChild(1) == r2);
+    CPPUNIT_ASSERT(policy->getChild(2) == r0);
+}
+
+static void* copyInternedStrings(void *p)
+{
+    const vector<InternedString> *values = (const vector<InternedString>*)p;
+    for (int k=0; k<20000; ++k)
+    {
+        // copies of shared handles and values released and
+        // interned again while other threads hold them
+        InternedString copy = (*values)[k % values->size()];
+        InternedString other(string("interned-thread-") + char('a' + k % 4));
+        copy = other;
+        InternedString again = copy;
+        if (again != other) return p;
+    }
+    return NULL;
+}
+
+void FWObjectTest::internedStringTest()
+{
+    int pool_size = InternedString::getPoolSize();
+
+    ObjectTreeFixture *tree = new ObjectTreeFixture();
+    FWObject *net1 = tree->add(Network::TYPENAME);
+    FWObject *net2 = tree->add(Network::TYPENAME);
+    int db_pool_size = InternedString::getPoolSize();
+
+    // equal names share the same storage
+    net1->setName("interned-test-net");
+    net2->setName(string("interned-test-") + "net");
+    CPPUNIT_ASSERT(&(net1->getName()) == &(net2->getName()));
+    CPPUNIT_ASSERT(InternedString::getPoolSize() == db_pool_size + 1);
+
+    net2->setName("interned-test-other");
+    CPPUNIT_ASSERT(net1->getName() == "interned-test-net");
+    CPPUNIT_ASSERT(net2->getName() == "interned-test-other");
+    CPPUNIT_ASSERT(&(net1->getName()) != &(net2->getName()));
+    CPPUNIT_ASSERT(InternedString::getPoolSize() == db_pool_size + 2);
+
+    net1->setComment("");
+    CPPUNIT_ASSERT(net1->getComment().empty());
+
+    net1->addKeyword("kw1");
+    net1->addKeyword("kw2");
+    net2->addKeyword("kw2");
+    net2->addKeyword("kw1");
+    CPPUNIT_ASSERT(&(net1->getKeywords()) == &(net2->getKeywords()));
+    net2->removeKeyword("kw1");
+    CPPUNIT_ASSERT(net1->getKeywords().size() == 2);
+    CPPUNIT_ASSERT(net2->getKeywords().size() == 1);
+    CPPUNIT_ASSERT(net1->getAllKeywords().size() == 2);
+
+    // copies compare equal
+    FWObject *net3 = tree->db->create(Network::TYPENAME);
+    net3->duplicate(net1);
+    CPPUNIT_ASSERT(net3->cmp(net1));
+    CPPUNIT_ASSERT(&(net3->getName()) == &(net1->getName()));
+    delete net3;
+
+    // values go away with the last object that uses them
+    delete tree;
+    CPPUNIT_ASSERT(InternedString::getPoolSize() == pool_size);
+
+    // reference counters survive concurrent copies and releases
+    vector<InternedString> values;
+    values.push_back(InternedString("interned-thread-a"));
+    values.push_back(InternedString("interned-thread-b"));
+    vector<pthread_t> threads(4);
+    for (size_t t=0; t<threads.size(); ++t)
+        pthread_create(&threads[t], NULL, copyInternedStrings, &values);
+    for (size_t t=0; t<threads.size(); ++t)
+    {
+        void *res = NULL;
+        pthread_join(threads[t], &res);
+        CPPUNIT_ASSERT(res == NULL);
+    }
+    CPPUNIT_ASSERT(values[0] == "interned-thread-a");
+    CPPUNIT_ASSERT(values[1] == "interned-thread-b");
+    CPPUNIT_ASSERT(InternedString::getPoolSize() == pool_size + 2);
+    values.clear();
+    CPPUNIT_ASSERT(InternedString::getPoolSize() == pool_size);
+}
+
@@ -35,6 +35,11 @@ class FWObjectTest : public CppUnit::TestCase
 {
 public:
     void cmpTest();
+    void attributesTest();
+    void castTest();
+    void visitMarkTest();
+    void childArrayTest();
+    void internedStringTest();
 
     static CppUnit::Test *suite()
     {
@@ -42,6 +47,21 @@ public:
       suiteOfTests->addTest( new CppUnit::TestCaller<FWObjectTest>(
                                    "cmpTest",
                                    &FWObjectTest::cmpTest ) );
+      suiteOfTests->addTest( new CppUnit::TestCaller<FWObjectTest>(
+                                   "attributesTest",
+                                   &FWObjectTest::attributesTest ) );
+      suiteOfTests->addTest( new CppUnit::TestCaller<FWObjectTest>(
+                                   "castTest",
+                                   &FWObjectTest::castTest ) );
+      suiteOfTests->addTest( new CppUnit::TestCaller<FWObjectTest>(
+                                   "visitMarkTest",
+                                   &FWObjectTest::visitMarkTest ) );
+      suiteOfTests->addTest( new CppUnit::TestCaller<FWObjectTest>(
+                                   "childArrayTest",
+                                   &FWObjectTest::childArrayTest ) );
+      suiteOfTests->addTest( new CppUnit::TestCaller<FWObjectTest>(
+                                   "internedStringTest",
+                                   &FWObjectTest::internedStringTest ) );
       return suiteOfTests;
     }
 };
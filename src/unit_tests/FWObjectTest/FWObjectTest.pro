@@ -9,9 +9,9 @@ TEMPLATE = app
 QMAKE_CXXFLAGS += $$CPPUNIT_CFLAGS
 LIBS += $$CPPUNIT_LIBS
 
-SOURCES += main.cpp FWObjectTest.cpp
-HEADERS += FWObjectTest.h
-INCLUDEPATH += ../../.. ../../libfwbuilder/src
+SOURCES += main.cpp FWObjectTest.cpp ../ObjectTreeFixture.cpp
+HEADERS += FWObjectTest.h ../ObjectTreeFixture.h
+INCLUDEPATH += .. ../../.. ../../libfwbuilder/src
 DEPENDPATH  += ../../libfwbuilder/src
 LIBS = ../../libfwbuilder/src/fwbuilder/libfwbuilder.a $$LIBS
 run_tests.commands = echo "Running tests..." && ./${TARGET}
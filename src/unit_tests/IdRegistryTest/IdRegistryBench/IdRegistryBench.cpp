@@ -0,0 +1,134 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  $Id$
+
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+/*
+ * Lookup throughput of IdRegistry. Not a test: prints the number of
+ * getIntId() + getStringId() lookups per second done by 1, 2, 4 ...
+ * max_threads threads working with the same registry.
+ *
+ * Usage: IdRegistryBench [max_threads [lookups_per_thread]]
+ */
+
+#include "fwbuilder/IdRegistry.h"
+
+#include <pthread.h>
+#include <sys/time.h>
+#include <stdlib.h>
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <string>
+
+using namespace libfwbuilder;
+using namespace std;
+
+
+class ThreadArg
+{
+public:
+    IdRegistry *reg;
+    const vector<string> *ids;
+    int thread_num;
+    int iterations;
+    int errors;
+};
+
+static void* lookupIds(void *p)
+{
+    ThreadArg *arg = (ThreadArg*)p;
+    int n = int(arg->ids->size());
+    int errors = 0;
+    for (int k=0; k<arg->iterations; ++k)
+    {
+        const string &s_id = (*(arg->ids))[(k * 7 + arg->thread_num) % n];
+        int i_id = arg->reg->getIntId(s_id);
+        if (i_id < 0 || arg->reg->getStringId(i_id) != s_id) errors++;
+    }
+    arg->errors = errors;
+    return NULL;
+}
+
+static double now()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return double(tv.tv_sec) + double(tv.tv_usec) / 1000000.0;
+}
+
+int main(int argc, char **argv)
+{
+    int max_threads = (argc > 1) ? atoi(argv[1]) : 8;
+    int iterations = (argc > 2) ? atoi(argv[2]) : 500000;
+    if (max_threads < 1 || iterations < 1)
+    {
+        cerr << "Usage: " << argv[0]
+             << " [max_threads [lookups_per_thread]]" << endl;
+        return 1;
+    }
+
+    IdRegistry reg;
+    vector<string> ids;
+    for (int i=0; i<50000; ++i)
+    {
+        ostringstream str;
+        str << "id" << (0x3DB1F000 + i);
+        ids.push_back(str.str());
+        reg.registerStringId(ids.back());
+    }
+
+    int res = 0;
+    for (int num_threads=1; num_threads<=max_threads; num_threads*=2)
+    {
+        vector<ThreadArg> args(num_threads);
+        vector<pthread_t> threads(num_threads);
+        for (int t=0; t<num_threads; ++t)
+        {
+            args[t].reg = &reg;
+            args[t].ids = &ids;
+            args[t].thread_num = t;
+            args[t].iterations = iterations;
+            args[t].errors = 0;
+        }
+
+        double start = now();
+        for (int t=0; t<num_threads; ++t)
+            pthread_create(&threads[t], NULL, lookupIds, &args[t]);
+        for (int t=0; t<num_threads; ++t)
+            pthread_join(threads[t], NULL);
+        double elapsed = now() - start;
+
+        for (int t=0; t<num_threads; ++t)
+            if (args[t].errors != 0) res = 1;
+
+        cout << "threads: " << num_threads
+             << "  lookups/sec: "
+             << (long)(double(num_threads) * iterations * 2 / elapsed)
+             << endl;
+    }
+    if (res != 0) cerr << "Lookup returned wrong id" << endl;
+    return res;
+}
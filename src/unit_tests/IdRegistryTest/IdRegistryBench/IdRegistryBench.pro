@@ -0,0 +1,13 @@
+include(../../../../qmake.inc)
+
+QT -= core gui
+
+TARGET = IdRegistryBench
+CONFIG += console
+CONFIG -= app_bundle
+TEMPLATE = app
+
+SOURCES += IdRegistryBench.cpp
+INCLUDEPATH += ../../../.. ../../../libfwbuilder/src
+DEPENDPATH  += ../../../libfwbuilder/src
+LIBS = ../../../libfwbuilder/src/fwbuilder/libfwbuilder.a $$LIBS
@@ -0,0 +1,194 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  $Id$
+
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#include "IdRegistryTest.h"
+
+#include "fwbuilder/FWObjectDatabase.h"
+#include "fwbuilder/IdRegistry.h"
+
+#include <pthread.h>
+
+#include <sstream>
+#include <vector>
+#include <set>
+
+using namespace libfwbuilder;
+using namespace std;
+
+
+void IdRegistryTest::lookupTest()
+{
+    IdRegistry reg;
+
+    CPPUNIT_ASSERT(reg.getIntId("root") == FWObjectDatabase::ROOT_ID);
+    CPPUNIT_ASSERT(reg.getStringId(FWObjectDatabase::STANDARD_LIB_ID) ==
+                   "syslib000");
+    CPPUNIT_ASSERT(reg.getIntId("no-such-id") == -1);
+
+    int id1 = reg.registerStringId("id3DB1F7D6");
+    CPPUNIT_ASSERT(id1 >= 1000);
+    CPPUNIT_ASSERT(reg.registerStringId("id3DB1F7D6") == id1);
+    CPPUNIT_ASSERT(reg.getIntId("id3DB1F7D6") == id1);
+    CPPUNIT_ASSERT(reg.getStringId(id1) == "id3DB1F7D6");
+
+    // string id is generated for integer id that does not have one,
+    // but only by getStringId()
+    int id2 = IdRegistry::generateUniqueId();
+    CPPUNIT_ASSERT(reg.findStringId(id2).empty());
+    CPPUNIT_ASSERT(reg.findStringId(id1) == "id3DB1F7D6");
+    string s_id = reg.getStringId(id2);
+    CPPUNIT_ASSERT(reg.findStringId(id2) == s_id);
+    CPPUNIT_ASSERT(!s_id.empty());
+    CPPUNIT_ASSERT(reg.getStringId(id2) == s_id);
+    CPPUNIT_ASSERT(reg.getIntId(s_id) == id2);
+
+    reg.setStringId(id1, "id1");
+    CPPUNIT_ASSERT(reg.getStringId(id1) == "id1");
+    CPPUNIT_ASSERT(reg.getIntId("id1") == id1);
+}
+
+/*
+ * static methods of FWObjectDatabase work with the shared registry
+ */
+void IdRegistryTest::globalRegistryTest()
+{
+    int id1 = FWObjectDatabase::registerStringId("global-test-id");
+    CPPUNIT_ASSERT(IdRegistry::global()->getIntId("global-test-id") == id1);
+    CPPUNIT_ASSERT(FWObjectDatabase::getStringId(id1) == "global-test-id");
+
+    // integer ids are unique across registries
+    IdRegistry reg;
+    CPPUNIT_ASSERT(reg.registerStringId("global-test-id") != id1);
+}
+
+
+class ThreadArg
+{
+public:
+    IdRegistry *reg;
+    const vector<string> *ids;
+    int thread_num;
+    int iterations;
+    bool register_ids;
+    vector<int> results;
+    int errors;
+};
+
+static void* registerIds(void *p)
+{
+    ThreadArg *arg = (ThreadArg*)p;
+    for (vector<string>::const_iterator i=arg->ids->begin();
+         i!=arg->ids->end(); ++i)
+        arg->results.push_back(arg->reg->registerStringId(*i));
+    return NULL;
+}
+
+static void* lookupIds(void *p)
+{
+    ThreadArg *arg = (ThreadArg*)p;
+    int n = int(arg->ids->size());
+    int errors = 0;
+    for (int k=0; k<arg->iterations; ++k)
+    {
+        const string &s_id = (*(arg->ids))[(k * 7 + arg->thread_num) % n];
+        int i_id = arg->reg->getIntId(s_id);
+        if (i_id < 0 || arg->reg->getStringId(i_id) != s_id) errors++;
+    }
+    arg->errors = errors;
+    return NULL;
+}
+
+static void makeIds(vector<string> &ids, int n)
+{
+    for (int i=0; i<n; ++i)
+    {
+        ostringstream str;
+        str << "id" << (0x3DB1F000 + i);
+        ids.push_back(str.str());
+    }
+}
+
+static void runThreads(int num_threads, void* (*func)(void*),
+                       vector<ThreadArg> &args)
+{
+    vector<pthread_t> threads(num_threads);
+    for (int t=0; t<num_threads; ++t)
+        pthread_create(&threads[t], NULL, func, &args[t]);
+    for (int t=0; t<num_threads; ++t)
+        pthread_join(threads[t], NULL);
+}
+
+void IdRegistryTest::concurrentRegistrationTest()
+{
+    IdRegistry reg;
+    vector<string> ids;
+    makeIds(ids, 20000);
+
+    int num_threads = 8;
+    vector<ThreadArg> args(num_threads);
+    for (int t=0; t<num_threads; ++t)
+    {
+        args[t].reg = &reg;
+        args[t].ids = &ids;
+        args[t].thread_num = t;
+    }
+    runThreads(num_threads, registerIds, args);
+
+    // all threads must have got the same integer id for each string id
+    set<int> unique_ids;
+    for (unsigned int i=0; i<ids.size(); ++i)
+    {
+        for (int t=1; t<num_threads; ++t)
+            CPPUNIT_ASSERT(args[t].results[i] == args[0].results[i]);
+        CPPUNIT_ASSERT(reg.getStringId(args[0].results[i]) == ids[i]);
+        unique_ids.insert(args[0].results[i]);
+    }
+    CPPUNIT_ASSERT(unique_ids.size() == ids.size());
+}
+
+void IdRegistryTest::concurrentLookupTest()
+{
+    IdRegistry reg;
+    vector<string> ids;
+    makeIds(ids, 20000);
+    for (vector<string>::iterator i=ids.begin(); i!=ids.end(); ++i)
+        reg.registerStringId(*i);
+
+    int num_threads = 8;
+    vector<ThreadArg> args(num_threads);
+    for (int t=0; t<num_threads; ++t)
+    {
+        args[t].reg = &reg;
+        args[t].ids = &ids;
+        args[t].thread_num = t;
+        args[t].iterations = 100000;
+        args[t].errors = 0;
+    }
+    runThreads(num_threads, lookupIds, args);
+
+    for (int t=0; t<num_threads; ++t)
+        CPPUNIT_ASSERT(args[t].errors == 0);
+}
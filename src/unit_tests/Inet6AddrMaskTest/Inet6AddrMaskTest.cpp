@@ -25,8 +25,11 @@
 
 #include "Inet6AddrMaskTest.h"
 #include <fwbuilder/Inet6AddrMask.h>
+#include <fwbuilder/InetAddrParser.h>
 #include <fwbuilder/uint128.h>
 
+#include <string.h>
+
 using namespace libfwbuilder;
 using namespace std;
 
@@ -249,3 +252,132 @@ void Inet6AddrMaskTest::testStringToInetAddrMask()
     CPPUNIT_ASSERT(sa=="ffff:ffff:ffff:ffff::");
 
 }
+
+/*
+ * InetAddr does ipv6 arithmetic on 64 bit words, check it against
+ * uint128, including carry and borrow across the word boundary
+ */
+void Inet6AddrMaskTest::testInet6Arithmetic()
+{
+    InetAddr a1(AF_INET6, "fe80::ffff:ffff:ffff:ffff");
+    CPPUNIT_ASSERT((a1 + 1).toString() == "fe80:0:0:1::");
+    CPPUNIT_ASSERT((a1 + 1 - 1) == a1);
+    CPPUNIT_ASSERT((a1 + 2 - 3).toString() == "fe80::ffff:ffff:ffff:fffe");
+    CPPUNIT_ASSERT((a1 + (-1)).toString() == "fe80::ffff:ffff:ffff:fffe");
+    CPPUNIT_ASSERT((a1 + 1) > a1);
+    CPPUNIT_ASSERT(a1 < (a1 + 1));
+    CPPUNIT_ASSERT(a1.distance(a1 + 10) == 11);
+    CPPUNIT_ASSERT((a1 + 10).distance(a1) == 11);
+
+    InetAddr a2(AF_INET6, "ffff:ffff:ffff:ffff:ffff:ffff:ffff:ffff");
+    CPPUNIT_ASSERT((a2 + 1).toString() == "::");
+    CPPUNIT_ASSERT((InetAddr(AF_INET6, "::") - 1) == a2);
+
+    InetAddr a3(AF_INET6, "1::ffff:ffff:ffff:ffff");
+    InetAddr a4(AF_INET6, "::ffff:ffff:ffff:ffff:ffff");
+    CPPUNIT_ASSERT(a3 > a4);
+    CPPUNIT_ASSERT(a4 < a3);
+    CPPUNIT_ASSERT(!(a3 < a4));
+    CPPUNIT_ASSERT(!(a3 < a3) && !(a3 > a3));
+
+    for (int len=0; len<=128; ++len)
+    {
+        InetAddr nm(AF_INET6, len);
+        uint128 x = (len == 0) ? uint128(0) : ~uint128(0) << (128 - len);
+        CPPUNIT_ASSERT(nm.to_uint128() == x);
+        if (len > 0) CPPUNIT_ASSERT(nm.getLength() == len);
+    }
+
+    const char *addrs[] = {
+        "::", "::1", "::ffff:ffff", "::1:0:0:0", "::ffff:ffff:ffff:ffff",
+        "1::", "fe80::21d:9ff:fe8b:8e94", "fe80::ffff:ffff:ffff:fff0",
+        "ffff:ffff:ffff:ffff::", "ffff:ffff:ffff:ffff:ffff:ffff:ffff:fff0",
+        NULL };
+    int increments[] = { 0, 1, -1, 16, -16, 65536, 2147483647, -2147483647 };
+
+    for (int i=0; addrs[i]!=NULL; ++i)
+    {
+        InetAddr a(AF_INET6, addrs[i]);
+        for (unsigned int k=0; k<sizeof(increments)/sizeof(int); ++k)
+        {
+            int inc = increments[k];
+
+            uint128 x = a.to_uint128();
+            x += inc;
+            CPPUNIT_ASSERT_MESSAGE(a.toString(), (a + inc).to_uint128() == x);
+
+            x = a.to_uint128();
+            x -= inc;
+            CPPUNIT_ASSERT_MESSAGE(a.toString(), (a - inc).to_uint128() == x);
+        }
+
+        for (int j=0; addrs[j]!=NULL; ++j)
+        {
+            InetAddr b(AF_INET6, addrs[j]);
+            uint128 x = a.to_uint128();
+            uint128 y = b.to_uint128();
+            CPPUNIT_ASSERT((a < b) == (x < y));
+            CPPUNIT_ASSERT((a > b) == (x > y));
+        }
+    }
+}
+
+void Inet6AddrMaskTest::testInet6AddrParser()
+{
+    InetAddr addr;
+    InetAddr netmask;
+    size_t pos;
+
+    const char *good[] = {
+        "::", "::1", "1::", "fe80::21d:9ff:fe8b:8e94", "FE80::21D:9FF:FE8B:8E94",
+        "1:2:3:4:5:6:7:8", "1:2:3:4:5:6::8", "1::3:4:5:6:7:8",
+        "::ffff:192.168.1.1", "64:ff9b::10.0.0.1", "1:2:3:4:5:6:1.2.3.4",
+        NULL };
+    for (int i=0; good[i]!=NULL; ++i)
+    {
+        CPPUNIT_ASSERT_MESSAGE(
+            good[i],
+            InetAddrParser::parseAddress(
+                AF_INET6, good[i], strlen(good[i]), addr) ==
+            InetAddrParser::OK);
+        CPPUNIT_ASSERT_MESSAGE(good[i], addr == InetAddr(AF_INET6, good[i]));
+    }
+
+    const char *s = "fe80::21d:9ff:fe8b:8e94/64";
+    CPPUNIT_ASSERT(InetAddrParser::parseAddressMask(
+                       AF_UNSPEC, s, strlen(s), addr, netmask) ==
+                   InetAddrParser::OK);
+    CPPUNIT_ASSERT(addr.isV6());
+    CPPUNIT_ASSERT(addr.toString() == "fe80::21d:9ff:fe8b:8e94");
+    CPPUNIT_ASSERT(netmask.getLength() == 64);
+
+    s = "2001:db8::";
+    CPPUNIT_ASSERT(InetAddrParser::parseAddressMask(
+                       AF_INET6, s, strlen(s), addr, netmask) ==
+                   InetAddrParser::OK);
+    CPPUNIT_ASSERT(netmask.isHostMask());
+
+    struct { const char *str; InetAddrParser::Status status; size_t pos; }
+    bad[] = {
+        { ":1", InetAddrParser::INVALID_CHARACTER, 0 },
+        { "1:", InetAddrParser::INVALID_GROUP, 2 },
+        { "1::2::3", InetAddrParser::INVALID_CHARACTER, 5 },
+        { "12345::", InetAddrParser::INVALID_GROUP, 0 },
+        { "1:2:3:4:5:6:7", InetAddrParser::TOO_FEW_PARTS, 13 },
+        { "1:2:3:4:5:6:7:8:9", InetAddrParser::TOO_MANY_PARTS, 16 },
+        { "1:2:3:4::5:6:7:8", InetAddrParser::TOO_MANY_PARTS, 16 },
+        { "1:2:3:4:5:6:7:1.2.3.4", InetAddrParser::TOO_MANY_PARTS, 14 },
+        { "::1.2.3", InetAddrParser::TOO_FEW_PARTS, 7 },
+        { "fe80::g", InetAddrParser::INVALID_CHARACTER, 6 },
+        { "fe80::/129", InetAddrParser::INVALID_PREFIX_LENGTH, 7 },
+        { NULL, InetAddrParser::OK, 0 }
+    };
+    for (int i=0; bad[i].str!=NULL; ++i)
+    {
+        pos = 1000;
+        InetAddrParser::Status st = InetAddrParser::parseAddressMask(
+            AF_INET6, bad[i].str, strlen(bad[i].str), addr, netmask, &pos);
+        CPPUNIT_ASSERT_MESSAGE(bad[i].str, st == bad[i].status);
+        CPPUNIT_ASSERT_MESSAGE(bad[i].str, pos == bad[i].pos);
+    }
+}
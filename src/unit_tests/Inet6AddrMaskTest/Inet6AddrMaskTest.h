@@ -38,6 +38,8 @@ public:
     void testInet6AddressOps();
     void testUInt128ToInetAddr6();
     void testInetAddr6ToUInt128();
+    void testInet6Arithmetic();
+    void testInet6AddrParser();
 
     CPPUNIT_TEST_SUITE(Inet6AddrMaskTest);
 
@@ -48,6 +50,8 @@ public:
     CPPUNIT_TEST(testStringToInetAddr6);
     CPPUNIT_TEST(testStringToInetAddrMask);
     CPPUNIT_TEST(testInet6AddressOps);
+    CPPUNIT_TEST(testInet6Arithmetic);
+    CPPUNIT_TEST(testInet6AddrParser);
     
     CPPUNIT_TEST_SUITE_END();
 
@@ -25,6 +25,9 @@
 
 #include "InetAddrMaskTest.h"
 #include <fwbuilder/InetAddrMask.h>
+#include <fwbuilder/InetAddrParser.h>
+
+#include <string.h>
 
 using namespace libfwbuilder;
 using namespace std;
@@ -330,3 +333,78 @@ void InetAddrMaskTest::testIPv4Overlap()
     CPPUNIT_ASSERT(res=="10.0.0.2/255.255.255.254 ");
 
 }
+
+void InetAddrMaskTest::testInetAddrParser()
+{
+    InetAddr addr;
+    InetAddr netmask;
+    size_t pos;
+
+    const char *good[] = {
+        "0.0.0.0", "1.2.3.4", "255.255.255.255", "10.1", "192.168.001.010",
+        NULL };
+    for (int i=0; good[i]!=NULL; ++i)
+    {
+        CPPUNIT_ASSERT_MESSAGE(
+            good[i],
+            InetAddrParser::parseAddress(
+                AF_INET, good[i], strlen(good[i]), addr) == InetAddrParser::OK);
+        CPPUNIT_ASSERT_MESSAGE(good[i], addr == InetAddr(good[i]));
+    }
+
+    const char *s = "192.168.1.0/24";
+    CPPUNIT_ASSERT(InetAddrParser::parseAddressMask(
+                       AF_INET, s, strlen(s), addr, netmask) ==
+                   InetAddrParser::OK);
+    CPPUNIT_ASSERT(addr.toString() == "192.168.1.0");
+    CPPUNIT_ASSERT(netmask.toString() == "255.255.255.0");
+
+    s = "192.168.1.5/255.255.0.0";
+    CPPUNIT_ASSERT(InetAddrParser::parseAddressMask(
+                       AF_INET, s, strlen(s), addr, netmask) ==
+                   InetAddrParser::OK);
+    CPPUNIT_ASSERT(addr.toString() == "192.168.1.5");
+    CPPUNIT_ASSERT(netmask.toString() == "255.255.0.0");
+
+    s = "10.0.0.1";
+    CPPUNIT_ASSERT(InetAddrParser::parseAddressMask(
+                       AF_UNSPEC, s, strlen(s), addr, netmask) ==
+                   InetAddrParser::OK);
+    CPPUNIT_ASSERT(addr.isV4() && netmask.isHostMask());
+
+    // the string does not have to be zero terminated
+    s = "10.0.0.1/8 trailing text";
+    CPPUNIT_ASSERT(InetAddrParser::parseAddressMask(
+                       AF_INET, s, 10, addr, netmask) == InetAddrParser::OK);
+    CPPUNIT_ASSERT(netmask.getLength() == 8);
+
+    struct { const char *str; InetAddrParser::Status status; size_t pos; }
+    bad[] = {
+        { "", InetAddrParser::EMPTY, 0 },
+        { "1.2.3.256", InetAddrParser::INVALID_OCTET, 6 },
+        { "1.2.3.4.5", InetAddrParser::TOO_MANY_PARTS, 8 },
+        { "1.2..4", InetAddrParser::INVALID_OCTET, 4 },
+        { "1.2.3.", InetAddrParser::INVALID_OCTET, 6 },
+        { "1.2.3.a", InetAddrParser::INVALID_CHARACTER, 6 },
+        { "host.example.com", InetAddrParser::INVALID_CHARACTER, 0 },
+        { "1.2.3.4/33", InetAddrParser::INVALID_PREFIX_LENGTH, 8 },
+        { "1.2.3.4/", InetAddrParser::INVALID_PREFIX_LENGTH, 8 },
+        { "1.2.3.4/24x", InetAddrParser::INVALID_CHARACTER, 10 },
+        { "1.2.3.4/255.255.256.0", InetAddrParser::INVALID_NETMASK, 16 },
+        { NULL, InetAddrParser::OK, 0 }
+    };
+    for (int i=0; bad[i].str!=NULL; ++i)
+    {
+        pos = 1000;
+        InetAddrParser::Status st = InetAddrParser::parseAddressMask(
+            AF_INET, bad[i].str, strlen(bad[i].str), addr, netmask, &pos);
+        CPPUNIT_ASSERT_MESSAGE(bad[i].str, st == bad[i].status);
+        CPPUNIT_ASSERT_MESSAGE(bad[i].str, pos == bad[i].pos);
+    }
+
+    s = "1.2.3.4/24";
+    CPPUNIT_ASSERT(InetAddrParser::parseAddress(
+                       AF_INET, s, strlen(s), addr, &pos) ==
+                   InetAddrParser::INVALID_CHARACTER);
+    CPPUNIT_ASSERT(pos == 7);
+}
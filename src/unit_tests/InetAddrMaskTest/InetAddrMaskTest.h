@@ -46,6 +46,7 @@ public:
     void testStringToInetAddrMask();
     void testInetAddressOps();
     void testIPv4Overlap();
+    void testInetAddrParser();
 
     CPPUNIT_TEST_SUITE(InetAddrMaskTest);
 
@@ -55,6 +56,7 @@ public:
     CPPUNIT_TEST(testStringToInetAddrMask);
     CPPUNIT_TEST(testInetAddressOps);
     CPPUNIT_TEST(testIPv4Overlap);
+    CPPUNIT_TEST(testInetAddrParser);
     
     CPPUNIT_TEST_SUITE_END();
 
@@ -0,0 +1,417 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  $Id$
+
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#include "ObjectIndexTest.h"
+#include "ObjectTreeFixture.h"
+
+#include "fwbuilder/FWObjectDatabase.h"
+#include "fwbuilder/ObjectIndex.h"
+#include "fwbuilder/UsageIndex.h"
+#include "fwbuilder/SearchIndex.h"
+#include "fwbuilder/SubtreeTypeIndex.h"
+#include "fwbuilder/Library.h"
+#include "fwbuilder/Firewall.h"
+#include "fwbuilder/Host.h"
+#include "fwbuilder/Interface.h"
+#include "fwbuilder/IPv4.h"
+#include "fwbuilder/IPv6.h"
+#include "fwbuilder/Network.h"
+#include "fwbuilder/ObjectGroup.h"
+#include "fwbuilder/DynamicGroup.h"
+#include "fwbuilder/FWReference.h"
+#include "fwbuilder/Policy.h"
+#include "fwbuilder/Rule.h"
+
+#include <map>
+#include <set>
+#include <list>
+#include <vector>
+#include <algorithm>
+#include <stdlib.h>
+
+using namespace libfwbuilder;
+using namespace std;
+
+
+void ObjectIndexTest::indexTest()
+{
+    ObjectIndex index;
+    map<int, FWObject*> ref;
+
+    // compare with std::map while adding and removing lots of ids
+    srand(1);
+    for (int i=0; i<200000; ++i)
+    {
+        int id = rand() % 20000;
+        FWObject *o = (FWObject*)(size_t)(id * 16 + 16);
+        if (rand() % 3 == 0)
+        {
+            index.erase(id);
+            ref.erase(id);
+        } else
+        {
+            index.insert(id, o);
+            ref[id] = o;
+        }
+    }
+    CPPUNIT_ASSERT(index.size() == int(ref.size()));
+    for (int id=0; id<20000; ++id)
+    {
+        map<int, FWObject*>::iterator it = ref.find(id);
+        FWObject *expected = (it == ref.end()) ? NULL : it->second;
+        CPPUNIT_ASSERT(index.find(id) == expected);
+    }
+    int n = 0;
+    for (ObjectIndex::const_iterator it=index.begin(); it!=index.end(); ++it)
+    {
+        CPPUNIT_ASSERT(ref[it.getId()] == it.getObject());
+        n++;
+    }
+    CPPUNIT_ASSERT(n == int(ref.size()));
+
+    ObjectIndexStats stats;
+    index.getStats(stats);
+    CPPUNIT_ASSERT(stats.size == index.size());
+    CPPUNIT_ASSERT(stats.max_probe_length >= 1);
+    CPPUNIT_ASSERT(stats.avg_probe_length >= 1.0);
+
+    index.clear();
+    CPPUNIT_ASSERT(index.size() == 0);
+    CPPUNIT_ASSERT(index.find(ref.begin()->first) == NULL);
+
+    // index of the database
+    ObjectTreeFixture tree;
+    FWObject *net = tree.add(Network::TYPENAME);
+    CPPUNIT_ASSERT(tree.db->findInIndex(net->getId()) == net);
+    tree.db->getIndexStats(stats);
+    CPPUNIT_ASSERT(stats.size >= 2);
+    CPPUNIT_ASSERT(stats.capacity > stats.size);
+}
+
+void ObjectIndexTest::usageIndexTest()
+{
+    ObjectTreeFixture tree;
+    FWObjectDatabase *db = tree.db;
+    FWObject *lib = tree.lib;
+    FWObject *net = tree.add(Network::TYPENAME);
+    FWObject *grp = tree.add(ObjectGroup::TYPENAME);
+
+    set<FWObject*> res;
+    db->findWhereObjectIsUsed(net, db, res);
+    CPPUNIT_ASSERT(res.size() == 1);
+    CPPUNIT_ASSERT(res.count(lib) == 1);
+
+    grp->addRef(net);
+    FWObject *ref = grp->front();
+    res.clear();
+    db->findWhereObjectIsUsed(net, db, res);
+    CPPUNIT_ASSERT(res.size() == 2);
+    CPPUNIT_ASSERT(res.count(ref) == 1);
+
+    // search is limited to the subtree
+    res.clear();
+    db->findWhereObjectIsUsed(net, grp, res);
+    CPPUNIT_ASSERT(res.size() == 1);
+    CPPUNIT_ASSERT(res.count(ref) == 1);
+
+    grp->removeRef(net);
+    res.clear();
+    db->findWhereObjectIsUsed(net, db, res);
+    CPPUNIT_ASSERT(res.size() == 1);
+
+    // branch rule set is stored in rule options
+    Firewall *fw = tree.addFirewall("fw");
+    FWObject *policy = tree.add(Policy::TYPENAME, "", fw);
+    RuleSet *branch = RuleSet::cast(tree.add(Policy::TYPENAME, "", fw));
+    PolicyRule *rule = PolicyRule::cast(
+        tree.add(PolicyRule::TYPENAME, "", policy));
+    rule->setAction(PolicyRule::Branch);
+    rule->setBranch(branch);
+    res.clear();
+    db->findWhereObjectIsUsed(branch, db, res);
+    CPPUNIT_ASSERT(res.count(rule) == 1);
+
+    rule->setBranch(NULL);
+    res.clear();
+    db->findWhereObjectIsUsed(branch, db, res);
+    CPPUNIT_ASSERT(res.count(rule) == 0);
+
+    // network zone of an interface
+    FWObject *intf = tree.add(Interface::TYPENAME, "", fw);
+    tree.add(IPv4::TYPENAME, "", intf);
+    intf->setStr("network_zone", FWObjectDatabase::getStringId(grp->getId()));
+    res.clear();
+    db->findWhereObjectIsUsed(grp, db, res);
+    CPPUNIT_ASSERT(res.count(intf) == 1);
+
+    // looking for users of an object does not give it a string id,
+    // even when there are references by string ids not known yet
+    FWObject *intf2 = tree.add(Interface::TYPENAME, "", fw);
+    intf2->setStr("network_zone", "usage-test-unknown-id");
+    FWObject *net3 = tree.add(Network::TYPENAME);
+    CPPUNIT_ASSERT(FWObjectDatabase::findStringId(net3->getId()).empty());
+    res.clear();
+    db->findWhereObjectIsUsed(net3, db, res);
+    CPPUNIT_ASSERT(res.size() == 1);
+    CPPUNIT_ASSERT(FWObjectDatabase::findStringId(net3->getId()).empty());
+
+    // copy of the database has index of its own
+    grp->addRef(net);
+    FWObjectDatabase *db2 = new FWObjectDatabase(*db);
+    FWObject *net2 = db2->findInIndex(net->getId());
+    CPPUNIT_ASSERT(net2 != NULL && net2 != net);
+    res.clear();
+    db2->findWhereObjectIsUsed(net2, db2, res);
+    CPPUNIT_ASSERT(res.size() == 2);
+    for (set<FWObject*>::iterator i=res.begin(); i!=res.end(); ++i)
+        CPPUNIT_ASSERT((*i)->getRoot() == db2);
+
+    // deleted objects are removed from the index
+    FWObject *ref2 = grp->front();
+    grp->remove(ref2, true);
+    res.clear();
+    db->findWhereObjectIsUsed(net, db, res);
+    CPPUNIT_ASSERT(res.size() == 1);
+
+    delete db2;
+}
+
+void ObjectIndexTest::searchIndexTest()
+{
+    ObjectTreeFixture tree;
+    FWObjectDatabase *db = tree.db;
+    SearchIndex *index = db->getSearchIndex();
+    FWObject *folder = tree.add(ObjectGroup::TYPENAME);
+    FWObject *subfolder = tree.add(ObjectGroup::TYPENAME, "", folder);
+
+    FWObject *net1 = tree.add(Network::TYPENAME, "", subfolder);
+    FWObject *host = tree.add(Host::TYPENAME, "", subfolder);
+    FWObject *net2 = tree.add(Network::TYPENAME, "", subfolder);
+
+    CPPUNIT_ASSERT(index->getObjectsOfType(Network::TYPENAME).size() == 2);
+    const SearchIndex::posting_list &nets =
+        index->getObjectsOfType(Network::typeId());
+    CPPUNIT_ASSERT(std::find(nets.begin(), nets.end(), net1) != nets.end());
+    CPPUNIT_ASSERT(index->getObjectsOfType(IPv6::TYPENAME).empty());
+
+    net1->addKeyword("dmz");
+    net2->addKeyword("dmz");
+    host->addKeyword("dmz");
+    host->addKeyword("web");
+    CPPUNIT_ASSERT(index->getObjectsWithKeyword("dmz").size() == 3);
+    CPPUNIT_ASSERT(index->getObjectsWithKeyword("web").size() == 1);
+    host->removeKeyword("web");
+    CPPUNIT_ASSERT(index->getObjectsWithKeyword("web").empty());
+
+    // members are added in the tree order
+    DynamicGroup *dyn = DynamicGroup::cast(
+        tree.add(DynamicGroup::TYPENAME, "", folder));
+    list<string> filter;
+    filter.push_back("Network,dmz");
+    dyn->setFilter(filter);
+    dyn->loadFromSource(false, NULL, true);
+    CPPUNIT_ASSERT(dyn->size() == 2);
+    CPPUNIT_ASSERT(FWReference::getObject(dyn->front()) == net1);
+    CPPUNIT_ASSERT(FWReference::getObject(dyn->back()) == net2);
+
+    // members at different depths
+    FWObject *net3 = tree.add(Network::TYPENAME, "", folder);
+    FWObject *net0 = tree.add(Network::TYPENAME, "", folder);
+    folder->remove(net0, false);
+    folder->insert_before(subfolder, net0);
+    net0->addKeyword("lan");
+    net1->addKeyword("lan");
+    net3->addKeyword("lan");
+    filter.clear();
+    filter.push_back("Network,lan");
+    dyn->setFilter(filter);
+    dyn->clearChildren();
+    dyn->loadFromSource(false, NULL, true);
+    CPPUNIT_ASSERT(dyn->size() == 3);
+    CPPUNIT_ASSERT(FWReference::getObject(dyn->getChild(0)) == net0);
+    CPPUNIT_ASSERT(FWReference::getObject(dyn->getChild(1)) == net1);
+    CPPUNIT_ASSERT(FWReference::getObject(dyn->getChild(2)) == net3);
+
+    // objects removed from the tree are not members
+    subfolder->remove(net2, false);
+    filter.clear();
+    filter.push_back("any,dmz");
+    dyn->setFilter(filter);
+    dyn->clearChildren();
+    dyn->loadFromSource(false, NULL, true);
+    CPPUNIT_ASSERT(dyn->size() == 2);
+    CPPUNIT_ASSERT(FWReference::getObject(dyn->front()) == net1);
+    CPPUNIT_ASSERT(FWReference::getObject(dyn->back()) == host);
+    delete net2;
+    CPPUNIT_ASSERT(index->getObjectsWithKeyword("dmz").size() == 2);
+
+    // copy of the database has index of its own
+    FWObjectDatabase *db2 = new FWObjectDatabase(*db);
+    const SearchIndex::posting_list &lst =
+        db2->getSearchIndex()->getObjectsWithKeyword("dmz");
+    CPPUNIT_ASSERT(lst.size() == 2);
+    for (SearchIndex::posting_list::const_iterator i=lst.begin();
+         i!=lst.end(); ++i)
+        CPPUNIT_ASSERT((*i)->getRoot() == db2);
+
+    delete db2;
+
+    // removing an object moves another one in its place in the lists
+    // of type and name
+    FWObject *a = tree.add(IPv6::TYPENAME, "addr", folder);
+    FWObject *b = tree.add(IPv6::TYPENAME, "addr", folder);
+    FWObject *c = tree.add(IPv6::TYPENAME, "addr", folder);
+    folder->remove(a, false);
+    delete a;
+    CPPUNIT_ASSERT(index->getObjectsOfType(IPv6::TYPENAME).size() == 2);
+    CPPUNIT_ASSERT(index->getObjectsWithName("addr").size() == 2);
+    b->setName("addr2");
+    CPPUNIT_ASSERT(index->getObjectsWithName("addr").size() == 1);
+    CPPUNIT_ASSERT(index->getObjectsWithName("addr").front() == c);
+    folder->remove(c, false);
+    delete c;
+    CPPUNIT_ASSERT(index->getObjectsOfType(IPv6::TYPENAME).size() == 1);
+    CPPUNIT_ASSERT(index->getObjectsOfType(IPv6::TYPENAME).front() == b);
+    CPPUNIT_ASSERT(index->getObjectsWithName("addr").empty());
+}
+
+void ObjectIndexTest::subtreeTypeIndexTest()
+{
+    ObjectTreeFixture tree;
+    FWObject *lib = tree.lib;
+    Firewall *fw = tree.addFirewall("fw");
+    FWObject *eth0 = tree.add(Interface::TYPENAME, "", fw);
+    FWObject *eth1 = tree.add(Interface::TYPENAME, "", fw);
+    FWObject *vlan = tree.add(Interface::TYPENAME, "", eth0);
+    FWObject *eth2 = tree.add(Interface::TYPENAME, "", fw);
+
+    // direct children first, then descendants of each child
+    vector<FWObject*> ifaces =
+        fw->getByTypeDeepCached(Interface::typeId());
+    CPPUNIT_ASSERT(ifaces.size() == 4);
+    CPPUNIT_ASSERT(ifaces[0] == eth0);
+    CPPUNIT_ASSERT(ifaces[1] == eth1);
+    CPPUNIT_ASSERT(ifaces[2] == eth2);
+    CPPUNIT_ASSERT(ifaces[3] == vlan);
+
+    list<FWObject*> l = fw->getByTypeDeep(Interface::TYPENAME);
+    CPPUNIT_ASSERT(vector<FWObject*>(l.begin(), l.end()) == ifaces);
+    CPPUNIT_ASSERT(lib->getByTypeDeepCached(Interface::typeId()).size() == 4);
+
+    // rules are not interfaces
+    RuleSet *policy = RuleSet::cast(fw->getFirstByType(Policy::TYPENAME));
+    if (policy == NULL)
+        policy = RuleSet::cast(tree.add(Policy::TYPENAME, "", fw));
+    policy->insertRuleAtTop();
+    CPPUNIT_ASSERT(fw->getByTypeDeepCached(Interface::typeId()).size() == 4);
+
+    // removing and adding interfaces does
+    eth0->remove(vlan);
+    CPPUNIT_ASSERT(fw->getByTypeDeepCached(Interface::typeId()).size() == 3);
+    CPPUNIT_ASSERT(lib->getByTypeDeepCached(Interface::typeId()).size() == 3);
+    tree.add(Interface::TYPENAME, "", eth1);
+    CPPUNIT_ASSERT(fw->getByTypeDeepCached(Interface::typeId()).size() == 4);
+    CPPUNIT_ASSERT(lib->getByTypeDeepCached(Interface::typeId()).size() == 4);
+
+    FWObject *ipv4 = tree.add(IPv4::TYPENAME, "", eth2);
+    CPPUNIT_ASSERT(fw->getByTypeDeepCached(IPv4::typeId()).size() == 1);
+    CPPUNIT_ASSERT(fw->getByTypeDeepCached(IPv4::typeId())[0] == ipv4);
+
+    // moving rules changes the order of the cached vector
+    Rule *r2 = policy->appendRuleAtBottom();
+    Rule *r3 = policy->appendRuleAtBottom();
+    vector<FWObject*> rules = policy->getByTypeDeepCached(r2->getTypeId());
+    CPPUNIT_ASSERT(rules.size() == 3);
+    CPPUNIT_ASSERT(rules[1] == r2 && rules[2] == r3);
+    policy->moveRule(2, 0);
+    rules = policy->getByTypeDeepCached(r2->getTypeId());
+    CPPUNIT_ASSERT(rules.size() == 3);
+    CPPUNIT_ASSERT(rules[0] == r3 && rules[2] == r2);
+    l = policy->getByTypeDeep(r2->getTypeName());
+    CPPUNIT_ASSERT(vector<FWObject*>(l.begin(), l.end()) == rules);
+
+    // interfaces of one firewall are not affected by another
+    Firewall *fw2 = tree.addFirewall("fw2");
+    FWObject *fw2_eth0 = tree.add(Interface::TYPENAME, "", fw2);
+    CPPUNIT_ASSERT(fw2->getByTypeDeepCached(Interface::typeId()).size() == 1);
+    tree.add(Interface::TYPENAME, "", fw);
+    CPPUNIT_ASSERT(fw2->getByTypeDeepCached(Interface::typeId()).size() == 1);
+    CPPUNIT_ASSERT(fw2->getByTypeDeepCached(Interface::typeId())[0] == fw2_eth0);
+    CPPUNIT_ASSERT(fw->getByTypeDeepCached(Interface::typeId()).size() == 5);
+
+    // results are cached in the database of the object and dropped
+    // together with the object
+    SubtreeTypeIndex *index = tree.db->getSubtreeTypeIndex();
+    int n = index->size();
+    CPPUNIT_ASSERT(n > 0);
+    fw2->getParent()->remove(fw2);
+    CPPUNIT_ASSERT(index->size() < n);
+}
+
+void ObjectIndexTest::nameIndexTest()
+{
+    ObjectTreeFixture tree;
+    FWObjectDatabase *db = tree.db;
+    FWObject *folder = tree.add(ObjectGroup::TYPENAME, "Firewalls");
+    FWObject *fw1 = tree.addFirewall("fw1", folder);
+    FWObject *fw2 = tree.addFirewall("fw/2", folder);
+    FWObject *eth0 = tree.add(Interface::TYPENAME, "eth0", fw1);
+
+    CPPUNIT_ASSERT(db->getSearchIndex()->getObjectsWithName("fw1").size() == 1);
+    CPPUNIT_ASSERT(db->findFirewallByName("fw1") == fw1);
+    CPPUNIT_ASSERT(db->findObjectByName(Interface::TYPENAME, "eth0") == eth0);
+    CPPUNIT_ASSERT(fw2->findObjectByName(Interface::TYPENAME, "eth0") == NULL);
+
+    list<FWObject*> res;
+    db->findObjectsByPath("/FWObjectDatabase/User/Firewalls/fw1/eth0", res);
+    CPPUNIT_ASSERT(res.size() == 1 && res.front() == eth0);
+    res.clear();
+    db->findObjectsByPath("/FWObjectDatabase/User/Firewalls/fw/2", res);
+    CPPUNIT_ASSERT(res.size() == 1 && res.front() == fw2);
+    res.clear();
+    db->findObjectsByPath("/FWObjectDatabase/User/fw1", res);
+    CPPUNIT_ASSERT(res.empty());
+
+    // renamed objects are found by the new name only
+    fw1->setName("gw");
+    CPPUNIT_ASSERT(db->findFirewallByName("gw") == fw1);
+    CPPUNIT_ASSERT(db->getSearchIndex()->getObjectsWithName("fw1").empty());
+    db->findObjectsByPath("/FWObjectDatabase/User/Firewalls/gw/eth0", res);
+    CPPUNIT_ASSERT(res.size() == 1 && res.front() == eth0);
+
+    // two firewalls with the same name: the first one in the tree wins
+    fw2->setName("gw");
+    CPPUNIT_ASSERT(db->findFirewallByName("gw") == fw1);
+
+    // objects without names, such as rules, are not indexed by name
+    tree.addRule(Firewall::cast(fw1));
+    CPPUNIT_ASSERT(db->getSearchIndex()->getObjectsWithName("").empty());
+
+    // removed objects are not found
+    fw1->remove(eth0, false);
+    CPPUNIT_ASSERT(db->findObjectByName(Interface::TYPENAME, "eth0") == NULL);
+    delete eth0;
+}
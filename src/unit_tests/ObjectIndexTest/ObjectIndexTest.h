@@ -0,0 +1,66 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  $Id$
+
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#ifndef OBJECTINDEXTEST_H
+#define OBJECTINDEXTEST_H
+
+
+#include <cppunit/TestCase.h>
+#include <cppunit/TestSuite.h>
+#include <cppunit/TestCaller.h>
+
+class ObjectIndexTest : public CppUnit::TestCase
+{
+public:
+    void indexTest();
+    void usageIndexTest();
+    void searchIndexTest();
+    void subtreeTypeIndexTest();
+    void nameIndexTest();
+
+    static CppUnit::Test *suite()
+    {
+      CppUnit::TestSuite *suiteOfTests = new CppUnit::TestSuite( "ObjectIndexTest" );
+      suiteOfTests->addTest( new CppUnit::TestCaller<ObjectIndexTest>(
+                                   "indexTest",
+                                   &ObjectIndexTest::indexTest ) );
+      suiteOfTests->addTest( new CppUnit::TestCaller<ObjectIndexTest>(
+                                   "usageIndexTest",
+                                   &ObjectIndexTest::usageIndexTest ) );
+      suiteOfTests->addTest( new CppUnit::TestCaller<ObjectIndexTest>(
+                                   "searchIndexTest",
+                                   &ObjectIndexTest::searchIndexTest ) );
+      suiteOfTests->addTest( new CppUnit::TestCaller<ObjectIndexTest>(
+                                   "subtreeTypeIndexTest",
+                                   &ObjectIndexTest::subtreeTypeIndexTest ) );
+      suiteOfTests->addTest( new CppUnit::TestCaller<ObjectIndexTest>(
+                                   "nameIndexTest",
+                                   &ObjectIndexTest::nameIndexTest ) );
+      return suiteOfTests;
+    }
+};
+
+#endif // OBJECTINDEXTEST_H
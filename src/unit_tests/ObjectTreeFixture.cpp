@@ -0,0 +1,153 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  $Id$
+
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#include "ObjectTreeFixture.h"
+
+#include "fwbuilder/FWObjectDatabase.h"
+#include "fwbuilder/Library.h"
+#include "fwbuilder/Firewall.h"
+#include "fwbuilder/Policy.h"
+#include "fwbuilder/Rule.h"
+#include "fwbuilder/FWException.h"
+
+#include <libxml/globals.h>
+
+#include <fstream>
+#include <sstream>
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <dirent.h>
+
+using namespace libfwbuilder;
+using namespace std;
+
+
+ObjectTreeFixture::ObjectTreeFixture(bool use_arena)
+{
+    db = new FWObjectDatabase();
+    if (use_arena) db->setUseArena(true);
+    lib = db->create(Library::TYPENAME);
+    lib->setName("User");
+    db->add(lib);
+}
+
+ObjectTreeFixture::~ObjectTreeFixture()
+{
+    delete db;
+}
+
+FWObject* ObjectTreeFixture::add(const string &type_name, const string &name,
+                                 FWObject *parent)
+{
+    FWObject *obj = db->create(type_name);
+    if (!name.empty()) obj->setName(name);
+    ((parent != NULL) ? parent : lib)->add(obj);
+    return obj;
+}
+
+Firewall* ObjectTreeFixture::addFirewall(const string &name, FWObject *parent)
+{
+    return Firewall::cast(add(Firewall::TYPENAME, name, parent));
+}
+
+PolicyRule* ObjectTreeFixture::addRule(Firewall *fw)
+{
+    RuleSet *policy = RuleSet::cast(fw->getFirstByType(Policy::TYPENAME));
+    PolicyRule *rule = PolicyRule::cast(policy->insertRuleAtTop());
+    rule->setLogging(false);
+    return rule;
+}
+
+FWObjectDatabase* ObjectTreeFixture::release()
+{
+    FWObjectDatabase *res = db;
+    db = NULL;
+    lib = NULL;
+    return res;
+}
+
+
+TemporaryDirectory::TemporaryDirectory()
+{
+    const char *tmp = getenv("TMPDIR");
+    string tmpl = string((tmp != NULL && *tmp != '\0') ? tmp : "/tmp") +
+        "/fwbtestXXXXXX";
+    char *buf = strdup(tmpl.c_str());
+    if (mkdtemp(buf) == NULL)
+    {
+        free(buf);
+        throw FWException("Can not create temporary directory " + tmpl);
+    }
+    path = buf;
+    free(buf);
+}
+
+TemporaryDirectory::~TemporaryDirectory()
+{
+    DIR *dir = opendir(path.c_str());
+    if (dir != NULL)
+    {
+        struct dirent *ent;
+        while ((ent = readdir(dir)) != NULL)
+        {
+            string name = ent->d_name;
+            if (name == "." || name == "..") continue;
+            unlink(file(name).c_str());
+        }
+        closedir(dir);
+    }
+    rmdir(path.c_str());
+}
+
+
+static void ignoreXmlError(void*, xmlErrorPtr)
+{
+}
+
+QuietXmlErrors::QuietXmlErrors()
+{
+    saved_func = xmlStructuredError;
+    saved_context = xmlStructuredErrorContext;
+    xmlSetStructuredErrorFunc(NULL, ignoreXmlError);
+    xmlThrDefSetStructuredErrorFunc(NULL, ignoreXmlError);
+}
+
+QuietXmlErrors::~QuietXmlErrors()
+{
+    xmlSetStructuredErrorFunc(saved_context, saved_func);
+    xmlThrDefSetStructuredErrorFunc(NULL, NULL);
+}
+
+
+string readFile(const string &file_name)
+{
+    ifstream in(file_name.c_str(), ios::in | ios::binary);
+    ostringstream str;
+    str << in.rdbuf();
+    return str.str();
+}
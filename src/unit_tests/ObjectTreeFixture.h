@@ -0,0 +1,114 @@
+/*
+
+                          Firewall Builder
+
+                 Copyright (C) 2011 NetCitadel, LLC
+
+  Author:  Vadim Kurland     vadim@fwbuilder.org
+
+  $Id$
+
+
+  This program is free software which we release under the GNU General Public
+  License. You may redistribute and/or modify this program under the terms
+  of that license as published by the Free Software Foundation; either
+  version 2 of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  To get a copy of the GNU General Public License, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+*/
+
+#ifndef OBJECTTREEFIXTURE_H
+#define OBJECTTREEFIXTURE_H
+
+#include <string>
+
+#include <libxml/xmlerror.h>
+
+namespace libfwbuilder
+{
+    class FWObject;
+    class FWObjectDatabase;
+    class Firewall;
+    class PolicyRule;
+}
+
+/**
+ * Object tree shared by libfwbuilder unit tests: a database with one
+ * library named "User". The database is deleted with the fixture
+ * unless the test takes it over with release().
+ */
+class ObjectTreeFixture
+{
+public:
+
+    libfwbuilder::FWObjectDatabase *db;
+    libfwbuilder::FWObject *lib;
+
+    ObjectTreeFixture(bool use_arena=false);
+    ~ObjectTreeFixture();
+
+    /**
+     * creates object of the given type and adds it to parent, or to
+     * the library if parent is NULL. Name is set only if not empty.
+     */
+    libfwbuilder::FWObject* add(const std::string &type_name,
+                                const std::string &name="",
+                                libfwbuilder::FWObject *parent=NULL);
+
+    libfwbuilder::Firewall* addFirewall(const std::string &name,
+                                        libfwbuilder::FWObject *parent=NULL);
+
+    /**
+     * inserts new rule at the top of the policy of the firewall
+     */
+    static libfwbuilder::PolicyRule* addRule(libfwbuilder::Firewall *fw);
+
+    libfwbuilder::FWObjectDatabase* release();
+};
+
+/**
+ * Unique directory for the files a test creates. The directory and
+ * files in it are removed by the destructor.
+ */
+class TemporaryDirectory
+{
+    std::string path;
+
+public:
+
+    TemporaryDirectory();
+    ~TemporaryDirectory();
+
+    const std::string& getPath() const { return path; }
+    std::string file(const std::string &name) const
+    { return path + "/" + name; }
+};
+
+/**
+ * Suppresses error messages libxml2 prints to stderr, in the calling
+ * thread and in threads created while the object exists. Use it
+ * around code that is expected to fail. Structured error handler is
+ * used because libfwbuilder resets the generic one while it works
+ * with XML documents.
+ */
+class QuietXmlErrors
+{
+    xmlStructuredErrorFunc saved_func;
+    void *saved_context;
+
+public:
+
+    QuietXmlErrors();
+    ~QuietXmlErrors();
+};
+
+std::string readFile(const std::string &file_name);
+
+#endif // OBJECTTREEFIXTURE_H